@@ -0,0 +1,115 @@
+/**
+ * @file                  autotuner.h
+ * @brief                 Interfaccia dell'autotuning del server. Ad intervalli regolari vengono osservati il tempo di
+ *                        attesa dei task nella coda del threadpool, l'utilizzo dei thread workers e la contesa sulle
+ *                        lock associate ai files; in base a questi vengono adeguati il numero di thread workers e il
+ *                        numero di lock, entro i limiti specificati nel file di configurazione. Ogni decisione viene
+ *                        registrata nel file di log.
+ */
+
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+#include <stdbool.h>
+#include <sys/time.h>
+
+#include <config_parser.h>
+#include <logger.h>
+#include <storage_server.h>
+#include <threadpool.h>
+
+/* Rapporto tra l'attesa media in coda e il tempo medio di esecuzione dei task oltre il quale, se i workers sono saturi, 
+   il loro numero viene aumentato */
+#define AUTOTUNE_WAIT_RATIO 1.0
+/* Attesa media in coda (in microsecondi) sotto la quale il numero di workers non viene aumentato */
+#define AUTOTUNE_WAIT_HIGH_USEC 200
+/* Attesa media in coda (in microsecondi) sotto la quale, se i workers sono poco utilizzati, il loro numero viene
+   ridotto */
+#define AUTOTUNE_WAIT_LOW_USEC 50
+/* Utilizzo dei workers oltre il quale sono considerati saturi */
+#define AUTOTUNE_UTIL_HIGH 0.8
+/* Utilizzo dei workers sotto il quale sono considerati poco utilizzati */
+#define AUTOTUNE_UTIL_LOW 0.3
+/* Minimo numero di acquisizioni delle lock in un intervallo per poter valutare la contesa */
+#define AUTOTUNE_MIN_ACQUISITIONS 1000
+/* Frazione di acquisizioni contese oltre la quale il numero di lock viene raddoppiato */
+#define AUTOTUNE_CONTENTION_HIGH 0.05
+/* Frazione di acquisizioni contese sotto la quale il numero di lock viene dimezzato */
+#define AUTOTUNE_CONTENTION_LOW 0.005
+/* Massimo numero di millisecondi di attesa della terminazione dei task in esecuzione per modificare le lock */
+#define AUTOTUNE_PAUSE_TIMEOUT_MSEC 100
+
+/* Struttura che rappresenta lo stato dell'autotuning */
+typedef struct autotuner autotuner_t;
+
+/**
+ * @function              autotuner_create()
+ * @brief                 Crea lo stato dell'autotuning.
+ *
+ * @param config          Valori di configurazione (intervallo e limiti dell'autotuning)
+ * @param max_locks       Numero di lock con cui è stato creato lo storage (il valore di max_locks letto all'avvio, 
+ *                        limite superiore dell'autotuning)
+ * @param pool            Threadpool dei workers
+ * @param storage         Struttura storage
+ * @param logger          Logger
+ *
+ * @return                Lo stato dell'autotuning in caso di successo, @c NULL in caso di fallimento ed errno settato
+ *                        ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se config, pool, storage o logger sono @c NULL o l'autotuning è disabilitato
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da malloc(),
+ *                        threadpool_get_stats() e storage_lock_stats().
+ */
+autotuner_t* autotuner_create(config_t* config, size_t max_locks, threadpool_t* pool, storage_t* storage,
+	logger_t* logger);
+
+/**
+ * @function              autotuner_timeout()
+ * @brief                 Calcola il tempo mancante al prossimo passo dell'autotuning.
+ *
+ * @param tuner           Lo stato dell'autotuning
+ * @param timeout         Il riferimento in cui memorizzare il tempo mancante (0 se il passo è già dovuto)
+ */
+void autotuner_timeout(autotuner_t* tuner, struct timeval* timeout);
+
+/**
+ * @function              autotuner_due()
+ * @brief                 Stabilisce se è trascorso l'intervallo tra due passi dell'autotuning.
+ *
+ * @param tuner           Lo stato dell'autotuning
+ *
+ * @return                true se il prossimo passo è dovuto, false altrimenti.
+ */
+bool autotuner_due(autotuner_t* tuner);
+
+/**
+ * @function              autotuner_step()
+ * @brief                 Esegue un passo dell'autotuning: confronta le statistiche del threadpool e delle lock con
+ *                        quelle del passo precedente e, se necessario, modifica il numero di workers e di lock.
+ *                        Per modificare le lock sospende il threadpool, attendendo al più AUTOTUNE_PAUSE_TIMEOUT_MSEC
+ *                        millisecondi la terminazione dei task in esecuzione (se non terminano la modifica viene
+ *                        rimandata al passo successivo).
+ * @warning               Deve essere invocata dal thread che aggiunge i task al threadpool, quando nessun altro thread
+ *                        esterno al pool accede allo storage.
+ *
+ * @param tuner           Lo stato dell'autotuning
+ * @param exclusive       false se è in corso una riconfigurazione del server (le statistiche vengono campionate ma
+ *                        non vengono prese decisioni)
+ *
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se tuner è @c NULL
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da
+ *                        threadpool_get_stats(), threadpool_resize(), threadpool_resume() e storage_lock_stats().
+ */
+int autotuner_step(autotuner_t* tuner, bool exclusive);
+
+/**
+ * @function              autotuner_destroy()
+ * @brief                 Distrugge lo stato dell'autotuning.
+ *
+ * @param tuner           Lo stato dell'autotuning
+ */
+void autotuner_destroy(autotuner_t* tuner);
+
+#endif /* AUTOTUNER_H */
@@ -1,6 +1,11 @@
 /**
  * @file              client_api.h
- * @brief             Api del client. L'implementazione delle funzioni non è thread safe.
+ * @brief             Api del client. Le funzioni con prefisso fss_ operano sulla connessione rappresentata da un handle 
+ *                    fss_conn_t e sono thread safe: un processo può aprire più connessioni e più thread possono 
+ *                    utilizzare la stessa connessione (le operazioni su una connessione vengono servite una alla volta). 
+ *                    Le restanti funzioni operano su una connessione di default, aperta con openConnection(), e non sono 
+ *                    thread safe; enable_printing(), enable_compression(), enable_checksum() e enable_cache() devono 
+ *                    essere invocate prima di aprire le connessioni.
  */
 
 #ifndef CLIENT_API_H
@@ -18,9 +23,35 @@
 /* Flag per l'apertura di un file con modalità "lock" */
 #define O_LOCK 10
 
+/* Massimo numero di richieste inviate in pipeline in attesa di risposta */
+#define MAX_PENDING_REQUESTS 256
+
+/**
+ * @struct            fss_conn_t
+ * @brief             Handle (opaco) che rappresenta una connessione con il server.
+ */
+typedef struct fss_conn fss_conn_t;
+
+/**
+ * @typedef           fss_callback_t
+ * @brief             Funzione invocata da fss_poll() al completamento di una richiesta inviata con le funzioni 
+ *                    fss_async*().
+ * 
+ * @param req_id      Identificativo della richiesta completata
+ * @param result      0 se la richiesta ha avuto successo, -1 altrimenti
+ * @param err         Valore di errno che indica l'esito negativo della richiesta (come in receiveResponse()), 0 in 
+ *                    caso di successo
+ * @param buf         Contenuto del file letto da una richiesta di lettura terminata con successo (@c NULL altrimenti), 
+ *                    allocato sullo heap e da deallocare da parte della callback
+ * @param size        La size di buf
+ * @param arg         Argomento specificato all'invio della richiesta
+ */
+typedef void (*fss_callback_t)(int req_id, int result, int err, void* buf, size_t size, void* arg);
+
 /**
  * @def               PRINT()
- * @brief             Stampa sullo stdout con il formato fmt se le stampe sono abilitate.
+ * @brief             Stampa sullo stdout con il formato fmt se le stampe sono abilitate (se il thread ha invocato 
+ *                    begin_print_buffering() la stampa viene accumulata, come in print_fmt()).
  * 
  * @param fmt         Formato della stampa come in printf
  * @param ...         Argomenti della stampa
@@ -29,7 +60,7 @@
 	do { \
 	if (is_printing_enable()) { \
 		int errnosv = errno; \
-		printf(fmt, ##__VA_ARGS__); \
+		print_fmt(fmt, ##__VA_ARGS__); \
 		errno = errnosv; \
 	} \
 	} while(0); \
@@ -50,6 +81,107 @@ int enable_printing();
  */
 bool is_printing_enable();
 
+/**
+ * @function          begin_print_buffering()
+ * @brief             Fa sì che le stampe successive del thread chiamante vengano accumulate in un buffer anzichè essere 
+ *                    effettuate sullo stdout, finchè il thread non invoca end_print_buffering(). Consente a più thread 
+ *                    di effettuare richieste in parallelo senza che le loro stampe si sovrappongano.
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    EALREADY se le stampe del thread vengono già accumulate
+ * @note              Può fallire e settare errno se si verificano gli errori specificati da calloc(), 
+ *                    pthread_once(), pthread_key_create() e pthread_setspecific().
+ */
+int begin_print_buffering();
+
+/**
+ * @function          end_print_buffering()
+ * @brief             Effettua sullo stdout, con un'unica scrittura, le stampe accumulate dal thread chiamante dopo 
+ *                    l'invocazione di begin_print_buffering() e ripristina le stampe dirette.
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    EINVAL se le stampe del thread non vengono accumulate
+ * @note              Può fallire e settare errno se si verificano gli errori specificati da fwrite().
+ */
+int end_print_buffering();
+
+/**
+ * @function          print_fmt()
+ * @brief             Stampa sullo stdout con il formato fmt o, se il thread chiamante ha invocato 
+ *                    begin_print_buffering(), accumula la stampa nel buffer del thread.
+ * 
+ * @param fmt         Formato della stampa come in printf
+ * @param ...         Argomenti della stampa
+ */
+void print_fmt(const char* fmt, ...);
+
+/**
+ * @function          enable_compression()
+ * @brief             Abilita la richiesta di compressione del contenuto dei file, negoziata con il server alla successiva 
+ *                    openConnection(). Su una connessione con compressione il contenuto dei file scambiati viene 
+ *                    suddiviso in blocchi, ciascuno compresso se questo ne riduce la dimensione.
+ * 
+ * @return            0 in caso di successo, -1 se la compressione era già abilitata.
+ */
+int enable_compression();
+
+/**
+ * @function          is_compression_enable()
+ * @brief             Consente di stabilire se la richiesta di compressione del contenuto dei file è abilitata.
+ * 
+ * @return            @c true se la compressione è abilitata, @c false altrimenti.
+ */
+bool is_compression_enable();
+
+/**
+ * @function          enable_checksum()
+ * @brief             Abilita la verifica dell'integrità dei file letti, negoziata con il server alla successiva 
+ *                    openConnection(). Sulla connessione il server invia, insieme al contenuto dei file letti con 
+ *                    readFile(), openReadCloseFile(), readFileIfNewer() e sendReadFile(), il loro CRC32C, che viene 
+ *                    confrontato con quello del contenuto ricevuto.
+ * 
+ * @return            0 in caso di successo, -1 se la verifica era già abilitata.
+ */
+int enable_checksum();
+
+/**
+ * @function          is_checksum_enable()
+ * @brief             Consente di stabilire se la verifica dell'integrità dei file letti è abilitata.
+ * 
+ * @return            @c true se la verifica è abilitata, @c false altrimenti.
+ */
+bool is_checksum_enable();
+
+/**
+ * @function          enable_cache()
+ * @brief             Abilita, sulle connessioni aperte successivamente, una cache dei file letti per intero con 
+ *                    readFile(), openReadCloseFile() e readFileIfNewer(), negoziata con il server. Il server notifica 
+ *                    al client la modifica, la rimozione, l'espulsione o il blocco da parte di un altro client dei file 
+ *                    letti. Dopo la prima lettura di un file aperto, le successive readFile() del file vengono servite 
+ *                    dalla cache senza contattare il server finchè il file non viene chiuso o non viene ricevuta una 
+ *                    notifica per il file. Le altre letture di un file presente in cache inviano al server la versione 
+ *                    in cache: il server effettua gli stessi controlli della lettura (ad esempio l'apertura del file o 
+ *                    la presenza di una lock di un altro client) e, se la versione è quella corrente, risponde senza 
+ *                    inviare il contenuto, che viene letto dalla cache. Quando la dimensione 
+ *                    complessiva dei file in cache supererebbe max_bytes vengono rimossi i file utilizzati meno 
+ *                    recentemente. Ogni connessione ha la propria cache, deallocata alla chiusura della connessione.
+ * 
+ * @param max_bytes   Il numero massimo di bytes dei file memorizzati nella cache di una connessione
+ * 
+ * @return            0 in caso di successo, -1 se la cache era già abilitata o max_bytes è 0.
+ */
+int enable_cache(size_t max_bytes);
+
+/**
+ * @function          is_cache_enable()
+ * @brief             Consente di stabilire se la cache dei file letti è abilitata.
+ * 
+ * @return            @c true se la cache è abilitata, @c false altrimenti.
+ */
+bool is_cache_enable();
+
 /**
  * @function          errno_to_str()
  * @brief             Restitusce una descrizione dell'errno settato dalle funzioni della api.
@@ -61,11 +193,13 @@ char* errno_to_str(int err);
 
 /**
  * @function          openConnection()
- * @brief             Apre una connessione AF_UNIX al socket file sockname. Se il server non accetta immediatamente la 
- *                    richiesta di connessione, la connessione da parte del client viene ripetuta dopo msec millisecondi e 
- *                    fino allo scadere del tempo assoluto abstime. 
+ * @brief             Apre una connessione AF_UNIX al socket file sockname o, se sockname è nella forma tcp:host:porta, 
+ *                    una connessione TCP (con TCP_NODELAY, le parti di ogni richiesta sono accumulate con TCP_CORK e 
+ *                    trasmesse insieme). Se il server non accetta immediatamente la richiesta di connessione, la 
+ *                    connessione da parte del client viene ripetuta dopo msec millisecondi e fino allo scadere del tempo 
+ *                    assoluto abstime. 
  * 
- * @param sockname    Il path del socket file
+ * @param sockname    Il path del socket file o tcp:host:porta
  * @param msec        Il numero di millisecondi da attendere dopo un tentativo di connessione fallito
  * @param abstime     Il tempo assoluto entro cui è possibile ritentare la connessione
  * 
@@ -73,17 +207,21 @@ char* errno_to_str(int err);
  *                    In caso di fallimento errno può assumere i seguenti valori:
  *                    ECOMM        se si è verificato un errore lato client che non ha reso possibile effettuare l'operazione
  *                    EINTR        se è stata ricevuta un'interruzione
- *                    EINVAL       se sockname è @c NULL o la sua lunghezza è 0 o è > UNIX_PATH_MAX-1,
+ *                    EINVAL       se sockname è @c NULL o la sua lunghezza è 0 o è > UNIX_PATH_MAX-1, se sockname 
+ *                                 inizia con tcp: ma host o porta non sono validi,
  *                                 se msec < 0, se abstime.tv_sec < 0 o abstime.tv_nsec < 0 o >= 1000000000
  *                    EISCONN      se il client è già connesso alla socket
  *                    ETIMEDOUT    se non è stato possibile instaurare una connessione con il server entro il tempo assoluto 
  *                                 abstime
+ *                    Se la compressione o la verifica dell'integrità sono abilitate la connessione viene chiusa se 
+ *                    fallisce la negoziazione con il server, in tal caso errno può assumere anche i valori EBADRQC, 
+ *                    EBUSY, ECONNRESET ed EPROTO.
  */
 int openConnection(const char* sockname, int msec, const struct timespec abstime);
 
 /**
  * @function          closeConnection()
- * @brief             Chiude la connessione AF_UNIX associata al socket file sockname.
+ * @brief             Chiude la connessione associata a sockname.
  * 
  * @param sockname    Il paht del socket file
  * 
@@ -121,6 +259,7 @@ int closeConnection(const char* sockname);
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
  *                    EEXIST       se è stato usato il flag O_CREATE e il server ha risposto che il file è già esistente
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o è lungo 0 o > PATH_MAX-1, se pathname non è un path assoluto o 
  *                                 se contiene ','
  *                    ENAMETOOLONG se il server ha risposto che il path del file è troppo lungo
@@ -144,11 +283,14 @@ int openFile(const char* pathname, int flags);
  * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
  *                    In caso di fallimento errno può assumere i seguenti valori:
  *                    EBADF        se il server ha risposto che il path del file non è valido (è vuoto o contiene ',')
+ *                    EBADMSG      se la verifica dell'integrità è abilitata e il checksum ricevuto non corrisponde al 
+ *                                 contenuto del file
  *                    EBADRQC      se il server ha risposto che l'operazione richiesta non è stata riconosciuta
  *                    EBUSY        se il server ha risposto di essere troppo occupato
  *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o è lungo 0 o > PATH_MAX, se pathname non è un path assoluto o 
  *                                 se contiene ',', 
  *                                 se buf è @c NULL o se size è @c NULL
@@ -160,6 +302,63 @@ int openFile(const char* pathname, int flags);
  */
 int readFile(const char* pathname, void** buf, size_t* size);
 
+/**
+ * @function          openReadCloseFile()
+ * @brief             Legge tutto il contenuto del file pathname dal server con un'unica richiesta, equivalente alla 
+ *                    sequenza openFile(pathname, 0), readFile(), closeFile() ma servita dal server in modo atomico.
+ *                    Non è necessario che il client abbia aperto il file e l'eventuale apertura precedente non viene 
+ *                    modificata. In caso di errore, buf e size non sono validi.
+ *
+ * @param pathname    Il path del file da leggere
+ * @param buf         Il buffer in cui memorizzare il contenuto del file ricevuto dal server
+ * @param size        La size del buffer buf
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i valori documentati per readFile(), ad eccezione di EPERM 
+ *                    che indica che il file è bloccato da un altro client.
+ */
+int openReadCloseFile(const char* pathname, void** buf, size_t* size);
+
+/**
+ * @function          readFileRange()
+ * @brief             Legge dal server al più length bytes del file pathname a partire da offset, ritornando un puntatore 
+ *                    ad un'area allocata sullo heap nel parametro buf, mentre size conterrà il numero di bytes letti 
+ *                    (minore di length se il file termina prima). Il client deve aver precedentemente aperto il file.
+ *                    In caso di errore, buf e size non sono validi.
+ *
+ * @param pathname    Il path del file da leggere
+ * @param offset      L'offset da cui iniziare la lettura
+ * @param length      Il numero massimo di bytes da leggere
+ * @param buf         Il buffer in cui memorizzare i bytes ricevuti dal server
+ * @param size        La size del buffer buf
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i valori documentati per readFile() e inoltre:
+ *                    ERANGE       se il server ha risposto che offset supera la size del file
+ */
+int readFileRange(const char* pathname, size_t offset, size_t length, void** buf, size_t* size);
+
+/**
+ * @function          readFileIfNewer()
+ * @brief             Legge dal server il contenuto del file pathname solo se la sua versione è diversa da *version, 
+ *                    la versione posseduta dal client (0 se il client non ne possiede alcuna). Il server assegna al file 
+ *                    una nuova versione a ogni creazione o modifica. In caso di lettura il contenuto viene restituito 
+ *                    come in readFile() e *version viene aggiornato con la versione corrente del file, se il file non è 
+ *                    stato modificato buf viene settato a @c NULL e size a 0. Il client deve aver precedentemente aperto 
+ *                    il file.
+ *
+ * @param pathname    Il path del file da leggere
+ * @param version     La versione del file posseduta dal client, aggiornata con quella ricevuta dal server
+ * @param buf         Il buffer in cui memorizzare il contenuto del file ricevuto dal server
+ * @param size        La size del buffer buf
+ * 
+ * @return            0 se il contenuto del file è stato ricevuto, 1 se il server ha risposto che il file non è stato 
+ *                    modificato, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i valori documentati per readFile() e inoltre:
+ *                    EINVAL       se version è @c NULL
+ */
+int readFileIfNewer(const char* pathname, size_t* version, void** buf, size_t* size);
+
 /**
  * @function          readNFiles()
  * @brief             Richiede al server la lettura di N files qualsiasi da memorizzare nella directory dirname lato client. 
@@ -184,10 +383,35 @@ int readFile(const char* pathname, void** buf, size_t* size);
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
  *                    EFAULT       se non è stato possibile scrivere tutti i file ricevuti nella directory dirname
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EPROTO       se si sono verificati errori di protocollo
  */
 int readNFiles(int N, const char* dirname);
 
+/**
+ * @function          readNFilesCursor()
+ * @brief             Legge dal server, in modo incrementale, un batch di file da memorizzare nella directory dirname lato 
+ *                    client. Il batch contiene i file memorizzati dal server dopo quelli identificati da *cursor (0 per 
+ *                    iniziare la scansione) e termina quando ne sono stati letti N o quando il file successivo farebbe 
+ *                    superare max_bytes bytes (viene comunque letto almeno un file). Al termine *cursor viene aggiornato 
+ *                    con il cursore da cui riprendere la scansione, 0 se non ci sono altri file da leggere.
+ *                    Ogni batch è una richiesta indipendente: tra due batch il client può effettuare altre operazioni e i 
+ *                    file rimossi o espulsi nel frattempo non invalidano il cursore (i file creati dopo l'inizio della 
+ *                    scansione vengono letti nei batch successivi).
+ * 
+ * @param cursor      Il cursore da cui riprendere la scansione, aggiornato con quello ricevuto dal server
+ * @param N           Il numero massimo di file da leggere nel batch, se <= 0 non c'è limite sul numero di file
+ * @param max_bytes   Il numero massimo di bytes da leggere nel batch, se 0 non c'è limite sul numero di bytes
+ * @param dirname     La directory in cui vengono memorizzati i file ricevuti dal server, 
+ *                    se è @c NULL i file ricevuti non vengono memorizzati 
+ * 
+ * @return            Il numero di file letti nel batch in caso di successo, -1 in caso di fallimento ed errno settato ad 
+ *                    indicare l'errore. In caso di fallimento errno può assumere i valori documentati per readNFiles() e 
+ *                    inoltre:
+ *                    EINVAL       se cursor è @c NULL
+ */
+int readNFilesCursor(size_t* cursor, int N, size_t max_bytes, const char* dirname);
+
 /**
  * @function          writeFile()
  * @brief             Scrive tutto il file puntato da pathname nel file server. Ritorna successo solo se la precedente 
@@ -210,6 +434,7 @@ int readNFiles(int N, const char* dirname);
  *                                 inviato
  *                    EFBIG        se il server ha risposto che la size del file è troppo grande perchè possa essere 
  *                                 memorizzato
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è NULL o la sua lunghezza è 0 o > PATH_MAX-1
  *                                 se pathname non è un path assoluto o contiene ','
  *                                 se la open del file pathname fallisce settando errno con EACCES, EISDIR, ELOOP, 
@@ -225,9 +450,30 @@ int readNFiles(int N, const char* dirname);
  *                                 O_CREATE| O_LOCK)) o che lo storage ha raggiunto la capacità massima e non è stato 
  *                                 possibile espellere file
  *                    EPROTO       se si sono verificati errori di protocollo
+ * 
+ * @note              Il contenuto del file viene letto dal disco e inviato a blocchi di dimensione fissata, senza caricare 
+ *                    l'intero file in memoria. Se la lettura del file fallisce dopo averne iniziato l'invio la 
+ *                    connessione viene chiusa (errno è settato a ECOMM).
  */
 int writeFile(const char* pathname, const char* dirname);
 
+/**
+ * @function          openWriteCloseFile()
+ * @brief             Crea il file pathname nel server e vi scrive tutto il contenuto del file locale pathname con un'unica 
+ *                    richiesta, equivalente alla sequenza openFile(pathname, O_CREATE|O_LOCK), writeFile(), closeFile() 
+ *                    ma servita dal server in modo atomico. Al termine il file non è aperto nè bloccato dal client.
+ *                    Se dirname è diverso da NULL, i file eventualmente espulsi dal server per far posto al file 
+ *                    pathname vengono scritti in dirname.
+ * 
+ * @param pathname    Il path del file da scrivere nel server
+ * @param dirname     Il path della directory in cui memorizzare gli eventuali file espulsi dal server
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento con errno settato a indicare l'errore.
+ *                    In caso di fallimento errno può assumere i valori documentati per writeFile() e inoltre:
+ *                    EEXIST       se il server ha risposto che il file è già esistente
+ */
+int openWriteCloseFile(const char* pathname, const char* dirname);
+
 /**
  * @function          appendToFile()
  * @brief             Richiesta di scrivere in append al file pathname i size bytes contenuti nel buffer buf. 
@@ -251,6 +497,7 @@ int writeFile(const char* pathname, const char* dirname);
  *                    EFAULT       se non è stato possibile scrivere in dirname tutti i file che il server ha espulso e 
  *                                 inviato
  *                    EFBIG        se il server ha risposto che il file diverrebbe troppo grande per essere memorizzato
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o la sua lunghezza è 0 o > PATH_MAX-1
  *                                 se pathname non è un path assoluto o contiene ','
  *                                 se size non è 0 e buf è @c NULL
@@ -265,6 +512,43 @@ int writeFile(const char* pathname, const char* dirname);
  */
 int appendToFile(const char* pathname, void* buf, size_t size, const char* dirname);
 
+/**
+ * @function          appendFileToFile()
+ * @brief             Richiesta di scrivere in append al file pathname tutto il contenuto del file locale source. 
+ *                    Valgono le stesse condizioni di appendToFile() e, se dirname è diverso da NULL, i file 
+ *                    eventualmente espulsi dal server vengono scritti in dirname.
+ * 
+ * @param pathname    Il path del file su cui effettura l'operazione di append
+ * @param source      Il path del file locale il cui contenuto deve essere scritto in append
+ * @param dirname     Il path della directory in cui memorizzare gli eventuali file espulsi dal server 
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i valori documentati per appendToFile() e inoltre:
+ *                    EINVAL       se source è @c NULL, se non esiste o non è un file regolare
+ * 
+ * @note              Il contenuto del file viene inviato come in writeFile(), senza caricare l'intero file in memoria.
+ */
+int appendFileToFile(const char* pathname, const char* source, const char* dirname);
+
+/**
+ * @function          writeFileAt()
+ * @brief             Richiesta di scrivere nel file pathname i size bytes contenuti nel buffer buf a partire da offset, 
+ *                    sovrascrivendo i bytes esistenti ed estendendo il file se necessario. L'operazione è garantita 
+ *                    essere atomica dal file server. Valgono le stesse condizioni di appendToFile() e, se dirname è 
+ *                    diverso da NULL, i file eventualmente espulsi dal server vengono scritti in dirname.
+ * 
+ * @param pathname    Il path del file su cui scrivere
+ * @param offset      L'offset da cui scrivere, non può superare la size del file
+ * @param buf         Il buffer con i byte da scrivere
+ * @param size        La size del buffer buf
+ * @param dirname     Il path della directory in cui memorizzare gli eventuali file espulsi dal server 
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i valori documentati per appendToFile() e inoltre:
+ *                    ERANGE       se il server ha risposto che offset supera la size del file
+ */
+int writeFileAt(const char* pathname, size_t offset, void* buf, size_t size, const char* dirname);
+
 /**
  * @function          lockFile()
  * @brief             In caso di successo setta il flag O_LOCK al file. Se il file era stato aperto/creato dal client 
@@ -283,6 +567,7 @@ int appendToFile(const char* pathname, void* buf, size_t size, const char* dirna
  *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o la sua lunghezza è 0 o > PATH_MAX-1
  *                                 se pathname non è un path assoluto o contiene ','
  *                    ENAMETOOLONG se il server ha risposto che il path del file è troppo lungo
@@ -308,6 +593,7 @@ int lockFile(const char* pathname);
  *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o la sua lunghezza è 0 o > PATH_MAX-1
  *                                 se pathname non è un path assoluto o contiene ','
  *                    ENAMETOOLONG se il server ha risposto che il path del file è troppo lungo
@@ -333,6 +619,7 @@ int unlockFile(const char* pathname);
  *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o la sua lunghezza è 0 o > PATH_MAX-1
  *                                 se pathname non è un path assoluto o contiene ','
  *                    ENAMETOOLONG se il server ha risposto che il path del file è troppo lungo
@@ -358,6 +645,7 @@ int closeFile(const char* pathname);
  *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
  *                                 l'operazione
  *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINPROGRESS  se ci sono richieste inviate con le funzioni send*() in attesa di risposta
  *                    EINVAL       se pathname è @c NULL o la sua lunghezza è 0 o > PATH_MAX-1
  *                                 se pathname non è un path assoluto o contiene ','
  *                    ENAMETOOLONG se il server ha risposto che il path del file è troppo lungo
@@ -368,4 +656,327 @@ int closeFile(const char* pathname);
  */
 int removeFile(const char* pathname);
 
+/**
+ * @function          sendOpenFile()
+ * @brief             Invia una richiesta di apertura o di creazione di un file senza attenderne la risposta.
+ *                    La risposta deve essere ricevuta con receiveResponse(). Le richieste inviate senza attenderne la 
+ *                    risposta possono essere servite dal server in un ordine qualsiasi, se una richiesta dipende 
+ *                    dall'esito di un'altra è necessario attendere la risposta alla prima prima di inviare la seconda.
+ *                    Finchè ci sono richieste in attesa di risposta le altre funzioni della api (ad eccezione di 
+ *                    closeConnection()) falliscono con errno settato a EINPROGRESS.
+ * 
+ * @param pathname    Path del file da aprire
+ * @param flags       Flag con cui aprire il file (come in openFile())
+ * 
+ * @return            L'identificativo (> 0) della richiesta in caso di successo, -1 in caso di fallimento con errno 
+ *                    settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    EAGAIN       se ci sono già MAX_PENDING_REQUESTS richieste in attesa di risposta
+ *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
+ *                                 l'operazione
+ *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINVAL       se pathname è @c NULL o è lungo 0 o > PATH_MAX-1, se pathname non è un path assoluto, 
+ *                                 se contiene ',' o se flags non è valido
+ */
+int sendOpenFile(const char* pathname, int flags);
+
+/**
+ * @function          sendReadFile()
+ * @brief             Invia una richiesta di lettura di un file senza attenderne la risposta (vedi sendOpenFile()).
+ * 
+ * @param pathname    Path del file da leggere
+ * 
+ * @return            Come sendOpenFile().
+ */
+int sendReadFile(const char* pathname);
+
+/**
+ * @function          sendLockFile()
+ * @brief             Invia una richiesta di lock di un file senza attenderne la risposta (vedi sendOpenFile()).
+ *                    Mentre la lock è in attesa di essere acquisita il server continua a servire le altre richieste 
+ *                    inviate dal client.
+ * 
+ * @param pathname    Path del file da bloccare
+ * 
+ * @return            Come sendOpenFile().
+ */
+int sendLockFile(const char* pathname);
+
+/**
+ * @function          sendUnlockFile()
+ * @brief             Invia una richiesta di unlock di un file senza attenderne la risposta (vedi sendOpenFile()).
+ * 
+ * @param pathname    Path del file da sbloccare
+ * 
+ * @return            Come sendOpenFile().
+ */
+int sendUnlockFile(const char* pathname);
+
+/**
+ * @function          sendCloseFile()
+ * @brief             Invia una richiesta di chiusura di un file senza attenderne la risposta (vedi sendOpenFile()).
+ * 
+ * @param pathname    Path del file da chiudere
+ * 
+ * @return            Come sendOpenFile().
+ */
+int sendCloseFile(const char* pathname);
+
+/**
+ * @function          sendRemoveFile()
+ * @brief             Invia una richiesta di rimozione di un file senza attenderne la risposta (vedi sendOpenFile()).
+ * 
+ * @param pathname    Path del file da rimuovere
+ * 
+ * @return            Come sendOpenFile().
+ */
+int sendRemoveFile(const char* pathname);
+
+/**
+ * @function          receiveResponse()
+ * @brief             Riceve la prossima risposta a una delle richieste inviate con le funzioni send*(). Le risposte 
+ *                    possono arrivare in un ordine diverso da quello di invio delle richieste.
+ *                    Se la risposta si riferisce a una richiesta di lettura terminata con successo e buf e size non sono 
+ *                    @c NULL, in buf viene restituito un puntatore ad un'area allocata sullo heap con il contenuto del 
+ *                    file e in size la sua dimensione, altrimenti il contenuto viene scartato.
+ * 
+ * @param req_id      Identificativo della richiesta a cui si riferisce la risposta, NO_REQ_ID se non è stato possibile 
+ *                    stabilirlo
+ * @param buf         Il buffer in cui memorizzare il contenuto del file letto (può essere @c NULL)
+ * @param size        La size del buffer buf (può essere @c NULL)
+ * 
+ * @return            0 se la richiesta req_id ha avuto successo, -1 in caso di fallimento con errno settato ad 
+ *                    indicare l'errore. Se *req_id è diverso da NO_REQ_ID errno indica l'esito negativo della richiesta 
+ *                    con i valori documentati per le corrispondenti funzioni sincrone.
+ *                    Se *req_id è NO_REQ_ID errno può assumere i seguenti valori:
+ *                    ECOMM        se si sono verificati errori lato client che non hanno reso possibile completare 
+ *                                 l'operazione
+ *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EINVAL       se req_id è @c NULL
+ *                    ENOMSG       se non ci sono richieste in attesa di risposta
+ *                    EPROTO       se si sono verificati errori di protocollo
+ */
+int receiveResponse(int* req_id, void** buf, size_t* size);
+
+/**
+ * @function          getPendingRequests()
+ * @brief             Restituisce il numero di richieste inviate con le funzioni send*() in attesa di risposta.
+ * 
+ * @return            Il numero di richieste in attesa di risposta.
+ */
+int getPendingRequests();
+
+/**
+ * @function          fss_connect()
+ * @brief             Apre una connessione con il server come openConnection() e ne restituisce l'handle.
+ * 
+ * @param sockname    Il path del socket file o tcp:host:porta
+ * @param msec        Il numero di millisecondi da attendere dopo un tentativo di connessione fallito
+ * @param abstime     Il tempo assoluto entro cui è possibile ritentare la connessione
+ * 
+ * @return            L'handle della connessione in caso di successo, @c NULL in caso di fallimento ed errno settato ad 
+ *                    indicare l'errore (come in openConnection()).
+ */
+fss_conn_t* fss_connect(const char* sockname, int msec, const struct timespec abstime);
+
+/**
+ * @function          fss_disconnect()
+ * @brief             Chiude la connessione conn e dealloca l'handle, che non deve essere più utilizzato.
+ * 
+ * @param conn        Handle della connessione
+ * 
+ * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    EINVAL       se conn è @c NULL
+ *                    ECOMM        se si è verificato un errore nella chiusura del socket (l'handle viene comunque 
+ *                                 deallocato)
+ */
+int fss_disconnect(fss_conn_t* conn);
+
+/*
+ * Le funzioni seguenti si comportano come le corrispondenti funzioni senza prefisso fss_ ma operano sulla connessione 
+ * conn. Se conn è @c NULL o è stata chiusa a seguito di un errore falliscono con errno settato a ECOMM.
+ */
+
+int fss_openFile(fss_conn_t* conn, const char* pathname, int flags);
+
+int fss_readFile(fss_conn_t* conn, const char* pathname, void** buf, size_t* size);
+
+int fss_openReadCloseFile(fss_conn_t* conn, const char* pathname, void** buf, size_t* size);
+
+int fss_readFileRange(fss_conn_t* conn, const char* pathname, size_t offset, size_t length, void** buf, size_t* size);
+
+int fss_readFileIfNewer(fss_conn_t* conn, const char* pathname, size_t* version, void** buf, size_t* size);
+
+int fss_readNFiles(fss_conn_t* conn, int N, const char* dirname);
+
+int fss_readNFilesCursor(fss_conn_t* conn, size_t* cursor, int N, size_t max_bytes, const char* dirname);
+
+int fss_writeFile(fss_conn_t* conn, const char* pathname, const char* dirname);
+
+int fss_openWriteCloseFile(fss_conn_t* conn, const char* pathname, const char* dirname);
+
+int fss_appendToFile(fss_conn_t* conn, const char* pathname, void* buf, size_t size, const char* dirname);
+
+int fss_appendFileToFile(fss_conn_t* conn, const char* pathname, const char* source, const char* dirname);
+
+int fss_writeFileAt(fss_conn_t* conn, const char* pathname, size_t offset, void* buf, size_t size, const char* dirname);
+
+int fss_lockFile(fss_conn_t* conn, const char* pathname);
+
+int fss_unlockFile(fss_conn_t* conn, const char* pathname);
+
+int fss_closeFile(fss_conn_t* conn, const char* pathname);
+
+int fss_removeFile(fss_conn_t* conn, const char* pathname);
+
+int fss_sendOpenFile(fss_conn_t* conn, const char* pathname, int flags);
+
+int fss_sendReadFile(fss_conn_t* conn, const char* pathname);
+
+int fss_sendLockFile(fss_conn_t* conn, const char* pathname);
+
+int fss_sendUnlockFile(fss_conn_t* conn, const char* pathname);
+
+int fss_sendCloseFile(fss_conn_t* conn, const char* pathname);
+
+int fss_sendRemoveFile(fss_conn_t* conn, const char* pathname);
+
+int fss_receiveResponse(fss_conn_t* conn, int* req_id, void** buf, size_t* size);
+
+int fss_getPendingRequests(fss_conn_t* conn);
+
+/**
+ * @function          fss_getFd()
+ * @brief             Restituisce il file descriptor del socket della connessione conn, che diventa leggibile quando 
+ *                    arriva la risposta a una richiesta in attesa. Può essere utilizzato in un event loop (select(), 
+ *                    poll(), epoll) per invocare fss_poll() solo quando ci sono risposte da ricevere; il file 
+ *                    descriptor non deve essere letto, scritto o chiuso direttamente.
+ * 
+ * @param conn        Handle della connessione
+ * 
+ * @return            Il file descriptor in caso di successo, -1 in caso di fallimento con errno settato a ECOMM se 
+ *                    conn è @c NULL o è stata chiusa a seguito di un errore.
+ */
+int fss_getFd(fss_conn_t* conn);
+
+/**
+ * @function          fss_asyncOpenFile()
+ * @brief             Invia una richiesta di apertura o di creazione di un file come fss_sendOpenFile(); al 
+ *                    completamento della richiesta fss_poll() invocherà callback con argomento arg. Le funzioni 
+ *                    fss_async*() consentono a un unico thread di mantenere fino a MAX_PENDING_REQUESTS richieste in 
+ *                    attesa di risposta per ogni connessione, senza bloccarsi in attesa delle risposte.
+ * 
+ * @param conn        Handle della connessione
+ * @param pathname    Path del file da aprire
+ * @param flags       Flag con cui aprire il file (come in openFile())
+ * @param callback    Funzione da invocare al completamento della richiesta
+ * @param arg         Argomento da passare a callback
+ * 
+ * @return            L'identificativo (> 0) della richiesta in caso di successo, -1 in caso di fallimento con errno 
+ *                    settato ad indicare l'errore (come in sendOpenFile(), EINVAL anche se callback è @c NULL).
+ */
+int fss_asyncOpenFile(fss_conn_t* conn, const char* pathname, int flags, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncReadFile()
+ * @brief             Invia una richiesta di lettura di un file (vedi fss_asyncOpenFile()). In caso di successo il 
+ *                    contenuto del file viene passato a callback.
+ * 
+ * @return            Come fss_asyncOpenFile().
+ */
+int fss_asyncReadFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncLockFile()
+ * @brief             Invia una richiesta di lock di un file (vedi fss_asyncOpenFile() e sendLockFile()).
+ * 
+ * @return            Come fss_asyncOpenFile().
+ */
+int fss_asyncLockFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncUnlockFile()
+ * @brief             Invia una richiesta di unlock di un file (vedi fss_asyncOpenFile()).
+ * 
+ * @return            Come fss_asyncOpenFile().
+ */
+int fss_asyncUnlockFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncCloseFile()
+ * @brief             Invia una richiesta di chiusura di un file (vedi fss_asyncOpenFile()).
+ * 
+ * @return            Come fss_asyncOpenFile().
+ */
+int fss_asyncCloseFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncRemoveFile()
+ * @brief             Invia una richiesta di rimozione di un file (vedi fss_asyncOpenFile()).
+ * 
+ * @return            Come fss_asyncOpenFile().
+ */
+int fss_asyncRemoveFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncWriteFile()
+ * @brief             Invia una richiesta di scrittura del file locale pathname nel file server (vedi 
+ *                    fss_asyncOpenFile() e writeFile()). Il contenuto del file viene inviato prima di ritornare, mentre 
+ *                    gli eventuali file espulsi dal server vengono ricevuti da fss_poll() e memorizzati in dirname, se 
+ *                    diverso da NULL, prima di invocare callback (err vale EFAULT se non è stato possibile scriverli). 
+ *                    Poichè durante l'invio del contenuto non vengono ricevute le risposte alle richieste in attesa, 
+ *                    file di grandi dimensioni dovrebbero essere inviati senza letture di grandi file in attesa di 
+ *                    risposta sulla stessa connessione.
+ * 
+ * @param conn        Handle della connessione
+ * @param pathname    Il path del file da scrivere nel server
+ * @param dirname     Il path della directory in cui memorizzare gli eventuali file espulsi dal server
+ * @param callback    Funzione da invocare al completamento della richiesta
+ * @param arg         Argomento da passare a callback
+ * 
+ * @return            Come fss_asyncOpenFile(); EINVAL anche nei casi documentati per writeFile().
+ */
+int fss_asyncWriteFile(fss_conn_t* conn, const char* pathname, const char* dirname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_asyncAppendToFile()
+ * @brief             Invia una richiesta di scrittura in append dei size bytes di buf nel file pathname (vedi 
+ *                    fss_asyncWriteFile() e appendToFile()). buf può essere riutilizzato al ritorno della funzione.
+ * 
+ * @param conn        Handle della connessione
+ * @param pathname    Il path del file su cui scrivere
+ * @param buf         Il buffer con i bytes da scrivere
+ * @param size        La size del buffer buf
+ * @param dirname     Il path della directory in cui memorizzare gli eventuali file espulsi dal server
+ * @param callback    Funzione da invocare al completamento della richiesta
+ * @param arg         Argomento da passare a callback
+ * 
+ * @return            Come fss_asyncOpenFile(); EINVAL anche nei casi documentati per appendToFile().
+ */
+int fss_asyncAppendToFile(fss_conn_t* conn, const char* pathname, void* buf, size_t size, const char* dirname, fss_callback_t callback, void* arg);
+
+/**
+ * @function          fss_poll()
+ * @brief             Riceve le risposte alle richieste in attesa sulla connessione conn e per ciascuna invoca la 
+ *                    callback specificata all'invio della richiesta. Attende al più timeout millisecondi (-1 senza 
+ *                    limite, 0 nessuna attesa) l'arrivo della prima risposta, quindi riceve quelle già disponibili 
+ *                    senza attendere. Le callback vengono invocate senza mantenere la mutex della connessione e possono 
+ *                    quindi inviare nuove richieste, ma non devono invocare fss_disconnect(). Le risposte alle 
+ *                    richieste inviate con fss_send*() vengono scartate.
+ * 
+ * @param conn        Handle della connessione
+ * @param timeout     Il numero di millisecondi da attendere per la prima risposta
+ * 
+ * @return            Il numero di risposte ricevute (0 se è scaduto il timeout, se non ci sono richieste in attesa o se 
+ *                    l'attesa è stata interrotta da un segnale), -1 in caso di fallimento con errno settato ad indicare 
+ *                    l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    ECOMM        se conn è @c NULL, se è stata chiusa a seguito di un errore o se si sono verificati 
+ *                                 errori lato client che non hanno reso possibile ricevere una risposta
+ *                    ECONNRESET   se il server ha chiuso la connessione
+ *                    EPROTO       se si sono verificati errori di protocollo
+ */
+int fss_poll(fss_conn_t* conn, int timeout);
+
 #endif /* CLIENT_API_H */
\ No newline at end of file
@@ -22,6 +22,8 @@
  * @var time                   Tempo da attendere in millisecondi dopo la ricezione della risposta (significativo se 
  *                             è stata specificata -t)
  * @var n                      Valore del parametro n (significativo se l'operazione è -w o -R)
+ * @var jobs                   Numero di connessioni con cui scrivere i file in parallelo (significativo se è stata 
+ *                             specificata -j, 0 altrimenti)
  */
 typedef struct cmdline_operation {
 	char operation;
@@ -31,6 +33,7 @@ typedef struct cmdline_operation {
 	char* source_file;
 	long time;
 	int n;
+	int jobs;
 } cmdline_operation_t;
 
 /**
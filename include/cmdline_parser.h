@@ -16,6 +16,8 @@
  * @param argc          Il numero di argomenti della linea di comando
  * @param argv          Gli argomenti della linea di comando
  * @param socket_path   Il riferimento al path della socket
+ * @param rate          Il riferimento in cui memorizzare il numero di richieste al secondo da inviare a ciclo aperto 
+ *                      (-O), che deve valere 0 e resta 0 se l'opzione non è specificata
  * 
  * @return              Una lista di cmdline_operation in caso di successo, 
  *                      NULL in caso di fallimento ed errno settato ad indicare l'errore.
@@ -25,6 +27,6 @@
  *                      list_create(), calloc(), cmdline_operation_create(), list_head_insert(), list_tail_insert(), 
  *                      list_head_remove(), list_reverse().
  */
-list_t* cmdline_parser(int argc, char* argv[], char** socket_path);
+list_t* cmdline_parser(int argc, char* argv[], char** socket_path, long* rate);
 
 #endif /* CMDLINE_PARSER_H */
\ No newline at end of file
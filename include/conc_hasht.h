@@ -10,6 +10,7 @@
 
 #include <hasht.h>
 #include <pthread.h>
+#include <stdbool.h>
 
 /**
  * @struct                    conc_hasht_t
@@ -19,12 +20,18 @@
  * @var nsegments             Numero di segmenti in cui la tabella è suddivisa
  * @var mutexs                Array di mutex associate ai segmenti
  * @var mutex_attrs           Array di attributi delle mutex associate ai segmenti
+ * @var acquisitions          Array dei contatori delle acquisizioni delle lock dei segmenti
+ * @var contentions           Array dei contatori delle acquisizioni delle lock dei segmenti possedute da un altro thread
+ * @var lock_stats            Flag che indica se le acquisizioni delle lock dei segmenti vengono contate
  */
 typedef struct conc_hasht {
 	hasht_t* ht;
 	size_t nsegments;
 	pthread_mutex_t* mutexs;
 	pthread_mutexattr_t* mutex_attrs;
+	size_t* acquisitions;
+	size_t* contentions;
+	bool lock_stats;
 } conc_hasht_t;
 
 /**
@@ -278,4 +285,57 @@ void* conc_hasht_delete_and_get(conc_hasht_t *cht, void* key, void (*free_key)(v
  */
 void* conc_hasht_atomic_delete_and_get(conc_hasht_t *cht, void* key, void (*free_key)(void*));
 
+/**
+ * @function                  conc_hasht_enable_lock_stats()
+ * @brief                     Abilita il conteggio delle acquisizioni delle lock dei segmenti, restituito da 
+ *                            conc_hasht_lock_stats(). Se non è abilitato le lock vengono acquisite senza verificare se 
+ *                            sono possedute da un altro thread.
+ * @warning                   Questa funzione deve essere invocata prima che la tabella venga acceduta concorrentemente.
+ *
+ * @param cht                 Oggetto che rappresenta la tabella hash thread safe
+ *
+ * @return                    0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                            In caso di fallimento errno può assumere i seguenti valori:
+ *                            EINVAL se cht è @c NULL
+ */
+int conc_hasht_enable_lock_stats(conc_hasht_t* cht);
+
+/**
+ * @function                  conc_hasht_lock_stats()
+ * @brief                     Restituisce il numero di acquisizioni delle lock dei segmenti e il numero di quelle che 
+ *                            hanno trovato la lock posseduta da un altro thread, a partire dalla creazione della tabella 
+ *                            o dall'ultima invocazione di conc_hasht_restripe(). Può essere invocata concorrentemente 
+ *                            agli accessi alla tabella (i valori restituiti sono approssimati). Se il conteggio non è 
+ *                            stato abilitato con conc_hasht_enable_lock_stats() entrambi i valori sono 0.
+ *
+ * @param cht                 Oggetto che rappresenta la tabella hash thread safe
+ * @param acquisitions        Riferimento in cui memorizzare il numero di acquisizioni
+ * @param contentions         Riferimento in cui memorizzare il numero di acquisizioni contese
+ *
+ * @return                    0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                            In caso di fallimento errno può assumere i seguenti valori:
+ *                            EINVAL se cht, acquisitions o contentions sono @c NULL
+ */
+int conc_hasht_lock_stats(conc_hasht_t* cht, size_t* acquisitions, size_t* contentions);
+
+/**
+ * @function                  conc_hasht_restripe()
+ * @brief                     Suddivide la tabella in n_segments segmenti, sostituendo le lock dei segmenti e azzerando i 
+ *                            contatori delle acquisizioni. Le entry della tabella non vengono spostate.
+ * @warning                   Questa funzione deve essere invocata quando nessun thread possiede o sta attendendo la lock 
+ *                            di un segmento della tabella.
+ *
+ * @param cht                 Oggetto che rappresenta la tabella hash thread safe
+ * @param n_segments          Numero di segmenti, se maggiore del numero di buckets la tabella verrà suddivisa in 
+ *                            tanti segmenti quanti sono i buckets
+ *
+ * @return                    0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore 
+ *                            (in tal caso la suddivisione della tabella resta invariata).
+ *                            In caso di fallimento errno può assumere i seguenti valori:
+ *                            EINVAL se cht è @c NULL o n_segments è 0
+ * @note                      Può fallire e settare errno se si verificano gli errori specificati da malloc(), calloc(), 
+ *                            pthread_mutexattr_init(), pthread_mutexattr_settype() e pthread_mutex_init().
+ */
+int conc_hasht_restripe(conc_hasht_t* cht, size_t n_segments);
+
 #endif /* CONC_HASHT_H */
\ No newline at end of file
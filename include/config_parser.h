@@ -24,10 +24,23 @@
 #define EXPECTED_CLIENTS_STR "expected_clients"
 /* Chiave riconosciuta nel file di configurazione per il path della socket */
 #define SOCKET_PATH_STR "socket_file_path"
+/* Chiave riconosciuta nel file di configurazione per la porta TCP su cui accettare connessioni */
+#define TCP_PORT_STR "tcp_port"
+/* Chiave riconosciuta nel file di configurazione per l'indirizzo su cui accettare connessioni TCP */
+#define TCP_ADDRESS_STR "tcp_address"
 /* Chiave riconosciuta nel file di configurazione per il path del file di log */
 #define LOG_FILE_STR "log_file_path"
 /* Chiave riconosciuta nel file di configurazione per la politica di espulsione */
 #define EVICTION_POLICY_STR "eviction_policy"
+/* Chiave riconosciuta nel file di configurazione per l'intervallo in millisecondi tra due passi dell'autotuning */
+#define AUTOTUNE_INTERVAL_STR "autotune_interval"
+/* Chiave riconosciuta nel file di configurazione per il minimo numero di thread workers durante l'autotuning */
+#define MIN_WORKERS_STR "min_workers"
+/* Chiave riconosciuta nel file di configurazione per il massimo numero di thread workers durante l'autotuning */
+#define MAX_WORKERS_STR "max_workers"
+/* Chiave riconosciuta nel file di configurazione per il minimo numero di lock per l'accesso ai files durante 
+   l'autotuning */
+#define MIN_LOCKS_STR "min_locks"
 
 /* Path di default del file di configurazione */
 #define DEFAULT_CONFIG_PATH "./config.txt"
@@ -44,10 +57,26 @@
 #define DEFAULT_MAX_LOCKS 100
 /* Valore di default del numero atteso di client contemporaneamente connessi */
 #define DEFAULT_EXPECTED_CLIENTS 10
+/* Valore di default della porta TCP (0 = connessioni TCP non accettate) */
+#define DEFAULT_TCP_PORT 0
+/* Massimo valore della porta TCP */
+#define MAX_TCP_PORT 65535
+/* Valore di default dell'indirizzo su cui accettare connessioni TCP */
+#define DEFAULT_TCP_ADDRESS "127.0.0.1"
 /* Valore di default del path del file di log */
 #define DEFAULT_LOG_PATH "./log.csv"
 /* Valore di default della politica di espulsione */
 #define DEFAULT_EVICTION_POLICY FIFO
+/* Valore di default dell'intervallo tra due passi dell'autotuning (0 = autotuning disabilitato) */
+#define DEFAULT_AUTOTUNE_INTERVAL 0
+/* Massimo valore dell'intervallo tra due passi dell'autotuning */
+#define MAX_AUTOTUNE_INTERVAL 3600000
+/* Valore di default del minimo numero di thread workers durante l'autotuning */
+#define DEFAULT_MIN_WORKERS 1
+/* Valore di default del massimo numero di thread workers durante l'autotuning */
+#define DEFAULT_MAX_WORKERS 64
+/* Valore di default del minimo numero di lock per l'accesso ai files durante l'autotuning */
+#define DEFAULT_MIN_LOCKS 1
 
 /* Massima dimensione di una linea del file di configurazione */
 #define CONFIG_LINE_SIZE 1024
@@ -63,8 +92,14 @@
  * @var max_locks            Massimo numero di lock da utilizzare per l'accesso ai files
  * @var expected_clients     Numero atteso di client contemporaneamente connessi
  * @var socket_path          Path della socket per la connessione con i clienti
+ * @var tcp_port             Porta TCP per la connessione con i clienti (0 se non vengono accettate connessioni TCP)
+ * @var tcp_address          Indirizzo su cui accettare connessioni TCP
  * @var log_file_path        Path del file di log
  * @var eviction_policy      Politica di espulsione
+ * @var autotune_interval    Intervallo in millisecondi tra due passi dell'autotuning (0 se disabilitato)
+ * @var min_workers          Minimo numero di thread workers durante l'autotuning
+ * @var max_workers          Massimo numero di thread workers durante l'autotuning
+ * @var min_locks            Minimo numero di lock per l'accesso ai files durante l'autotuning (il massimo è max_locks)
  */
 typedef struct config {
 	size_t n_workers;
@@ -74,8 +109,14 @@ typedef struct config {
 	size_t max_locks;
 	size_t expected_clients;
 	char* socket_path;
+	size_t tcp_port;
+	char* tcp_address;
 	char* log_file_path;
 	eviction_policy_t eviction_policy;
+	size_t autotune_interval;
+	size_t min_workers;
+	size_t max_workers;
+	size_t min_locks;
 } config_t;
 
 /**
@@ -0,0 +1,103 @@
+/**
+ * @file              conn_pool.h
+ * @brief             Interfaccia del pool di connessioni con il server, costruito sulle funzioni fss_ dell'api del
+ *                    client. Il pool mantiene più connessioni con lo stesso server e serve ogni operazione su una
+ *                    connessione libera, in modo che i thread di un processo possano effettuare operazioni in parallelo.
+ *                    Poiché il server associa i file aperti e le lock al client che li ha ottenuti, un file aperto
+ *                    tramite il pool resta legato alla connessione con cui è stato aperto fino alla sua chiusura o
+ *                    rimozione: tutte le operazioni su tale file vengono servite da quella connessione, il pool si
+ *                    comporta quindi nei confronti del server come un unico client. Le funzioni sono thread safe.
+ */
+
+#ifndef CONN_POOL_H
+#define CONN_POOL_H
+
+#include <time.h>
+
+#include <client_api.h>
+
+/* Numero di bucket della tabella dei file legati alle connessioni del pool */
+#define POOL_BOUND_FILES_BUCKETS 256
+
+/**
+ * @struct            fss_pool_t
+ * @brief             Handle (opaco) che rappresenta un pool di connessioni con il server.
+ */
+typedef struct fss_pool fss_pool_t;
+
+/**
+ * @function          fss_pool_create()
+ * @brief             Apre n connessioni con il server, come fss_connect(), e restituisce il pool che le contiene.
+ *
+ * @param sockname    Il path del socket file o tcp:host:porta
+ * @param n           Il numero di connessioni del pool
+ * @param msec        Il numero di millisecondi da attendere dopo un tentativo di connessione fallito
+ * @param abstime     Il tempo assoluto entro cui è possibile ritentare le connessioni
+ *
+ * @return            Il pool in caso di successo, @c NULL in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    EINVAL       se n non è positivo o gli altri argomenti non sono validi (come in openConnection())
+ *                    ENOMEM       se non è stato possibile allocare il pool
+ *                    i valori di errno settati da fss_connect()
+ */
+fss_pool_t* fss_pool_create(const char* sockname, int n, int msec, const struct timespec abstime);
+
+/**
+ * @function          fss_pool_destroy()
+ * @brief             Chiude le connessioni del pool e lo dealloca. Nessun thread deve utilizzare il pool durante e
+ *                    dopo l'invocazione.
+ *
+ * @param pool        Il pool di connessioni
+ *
+ * @return            0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                    In caso di fallimento errno può assumere i seguenti valori:
+ *                    EINVAL       se pool è @c NULL
+ *                    ECOMM        se si è verificato un errore nella chiusura di una connessione (il pool viene
+ *                                 comunque deallocato)
+ */
+int fss_pool_destroy(fss_pool_t* pool);
+
+/*
+ * Le funzioni seguenti si comportano come le corrispondenti funzioni fss_ ma vengono servite da una connessione del pool:
+ * quella a cui è legato il file pathname, se aperto tramite il pool, altrimenti una connessione libera (se non ce ne
+ * sono il thread attende che una si liberi). Se pool è @c NULL falliscono con errno settato a EINVAL. Se una connessione
+ * subisce un errore di comunicazione (ECOMM) o viene chiusa dal server (ECONNRESET) e non ha file legati viene riaperta
+ * al successivo utilizzo, altrimenti le operazioni sui file legati ad essa falliscono finchè questi non vengono chiusi
+ * con fss_pool_closeFile(); se nessuna connessione è utilizzabile le operazioni falliscono con errno settato a ECOMM.
+ */
+
+int fss_pool_openFile(fss_pool_t* pool, const char* pathname, int flags);
+
+int fss_pool_readFile(fss_pool_t* pool, const char* pathname, void** buf, size_t* size);
+
+int fss_pool_openReadCloseFile(fss_pool_t* pool, const char* pathname, void** buf, size_t* size);
+
+int fss_pool_readFileRange(fss_pool_t* pool, const char* pathname, size_t offset, size_t length, void** buf,
+	size_t* size);
+
+int fss_pool_readFileIfNewer(fss_pool_t* pool, const char* pathname, size_t* version, void** buf, size_t* size);
+
+int fss_pool_readNFiles(fss_pool_t* pool, int N, const char* dirname);
+
+int fss_pool_readNFilesCursor(fss_pool_t* pool, size_t* cursor, int N, size_t max_bytes, const char* dirname);
+
+int fss_pool_writeFile(fss_pool_t* pool, const char* pathname, const char* dirname);
+
+int fss_pool_openWriteCloseFile(fss_pool_t* pool, const char* pathname, const char* dirname);
+
+int fss_pool_appendToFile(fss_pool_t* pool, const char* pathname, void* buf, size_t size, const char* dirname);
+
+int fss_pool_appendFileToFile(fss_pool_t* pool, const char* pathname, const char* source, const char* dirname);
+
+int fss_pool_writeFileAt(fss_pool_t* pool, const char* pathname, size_t offset, void* buf, size_t size,
+	const char* dirname);
+
+int fss_pool_lockFile(fss_pool_t* pool, const char* pathname);
+
+int fss_pool_unlockFile(fss_pool_t* pool, const char* pathname);
+
+int fss_pool_closeFile(fss_pool_t* pool, const char* pathname);
+
+int fss_pool_removeFile(fss_pool_t* pool, const char* pathname);
+
+#endif /* CONN_POOL_H */
@@ -0,0 +1,27 @@
+/**
+ * @file                   crc32c.h
+ * @brief                  Interfaccia per il calcolo del CRC32C (polinomio di Castagnoli).
+ *                         Sui processori x86 che supportano SSE4.2 il calcolo viene effettuato con l'istruzione crc32, 
+ *                         altrimenti viene utilizzata un'implementazione software basata su tabella.
+ */
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @function               crc32c()
+ * @brief                  Aggiorna il CRC32C crc con i size bytes di buf. Il CRC32C di una sequenza vuota è 0, per cui 
+ *                         il CRC32C della concatenazione di due sequenze a e b si ottiene come crc32c(crc32c(0, a), b).
+ * 
+ * @param crc              CRC32C dei bytes precedenti a buf (0 se buf è l'inizio della sequenza)
+ * @param buf              Bytes con cui aggiornare crc
+ * @param size             Numero di bytes di buf
+ * 
+ * @return                 Il CRC32C aggiornato.
+ */
+uint32_t crc32c(uint32_t crc, const void* buf, size_t size);
+
+#endif /* CRC32C_H */
@@ -0,0 +1,121 @@
+/**
+ * @file                     latency_hist.h
+ * @brief                    Interfaccia dell'istogramma log-lineare delle latenze utilizzato dagli strumenti di
+ *                           misurazione delle prestazioni del server (fssbench, fssreplay). Ogni potenza di 2 è
+ *                           suddivisa in 2^HIST_SUB_BITS bucket, l'errore relativo dei percentili è quindi al più
+ *                           2^-HIST_SUB_BITS.
+ */
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+#include <time.h>
+
+/* Bit di precisione dell'istogramma delle latenze */
+#define HIST_SUB_BITS 5
+/* Numero di bucket in cui è suddivisa ogni potenza di 2 */
+#define HIST_SUB (1 << HIST_SUB_BITS)
+/* Numero di bucket dell'istogramma (copre latenze fino a 2^64-1 microsecondi) */
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) * HIST_SUB + HIST_SUB)
+
+/**
+ * @struct                   hist_t
+ * @brief                    Istogramma delle latenze, in microsecondi, di un'operazione.
+ *
+ * @var buckets              Contatori dei bucket
+ * @var count                Numero di latenze registrate
+ * @var errors               Numero di operazioni fallite
+ * @var sum                  Somma delle latenze registrate
+ * @var max                  Latenza massima registrata
+ */
+typedef struct hist {
+	uint64_t buckets[HIST_BUCKETS];
+	uint64_t count;
+	uint64_t errors;
+	uint64_t sum;
+	uint64_t max;
+} hist_t;
+
+/**
+ * @function                 ts_to_usec()
+ * @brief                    Converte t in microsecondi.
+ *
+ * @param t                  Il tempo da convertire
+ *
+ * @return                   Il numero di microsecondi.
+ */
+uint64_t ts_to_usec(const struct timespec* t);
+
+/**
+ * @function                 usec_to_ts()
+ * @brief                    Converte usec microsecondi in una struct timespec.
+ *
+ * @param usec               Il numero di microsecondi
+ * @param t                  La struct timespec in cui memorizzare il risultato
+ */
+void usec_to_ts(uint64_t usec, struct timespec* t);
+
+/**
+ * @function                 now_usec()
+ * @brief                    Restituisce il tempo corrente del clock monotonico in microsecondi.
+ *
+ * @return                   Il tempo corrente in microsecondi.
+ */
+uint64_t now_usec();
+
+/**
+ * @function                 sleep_until_usec()
+ * @brief                    Sospende il thread chiamante fino all'istante usec del clock monotonico.
+ *
+ * @param usec               L'istante in microsecondi
+ */
+void sleep_until_usec(uint64_t usec);
+
+/**
+ * @function                 hist_record()
+ * @brief                    Registra nell'istogramma h la latenza v.
+ *
+ * @param h                  L'istogramma
+ * @param v                  La latenza in microsecondi
+ */
+void hist_record(hist_t* h, uint64_t v);
+
+/**
+ * @function                 hist_merge()
+ * @brief                    Somma all'istogramma dst l'istogramma src.
+ *
+ * @param dst                L'istogramma destinazione
+ * @param src                L'istogramma sorgente
+ */
+void hist_merge(hist_t* dst, const hist_t* src);
+
+/**
+ * @function                 hist_percentile()
+ * @brief                    Calcola il percentile p delle latenze registrate nell'istogramma h.
+ *
+ * @param h                  L'istogramma
+ * @param p                  Il percentile (in [0, 100])
+ *
+ * @return                   La latenza in microsecondi (0 se l'istogramma è vuoto).
+ */
+uint64_t hist_percentile(const hist_t* h, double p);
+
+/**
+ * @function                 hist_print_header()
+ * @brief                    Stampa sullo stdout l'intestazione della tabella stampata da hist_print_row().
+ */
+void hist_print_header();
+
+/**
+ * @function                 hist_print_row()
+ * @brief                    Stampa sullo stdout il numero di operazioni, il numero di errori, il throughput e la
+ *                           latenza media, i percentili 50, 90, 99 e 99.9 e la latenza massima dell'istogramma h.
+ *
+ * @param name               Il nome dell'operazione
+ * @param h                  L'istogramma
+ * @param elapsed            La durata della misurazione in secondi
+ */
+void hist_print_row(const char* name, const hist_t* h, double elapsed);
+
+#endif /* LATENCY_HIST_H */
@@ -25,5 +25,9 @@
 #define SHUT_DOWN "SHUT_DOWN"
 /* Stringa che indica l'avvenuta ricezione del segnale SIGINT o SIGQUIT */
 #define SHUT_DOWN_NOW "SHUT_DOWN_NOW"
+/* Stringa che indica la rilettura del file di configurazione a seguito del segnale SIGUSR2 */
+#define RECONFIGURATION "RECONFIGURATION"
+/* Stringa che indica una decisione dell'autotuning */
+#define AUTOTUNE "AUTOTUNE"
 
 #endif /* LOG_FORMAT_H */
\ No newline at end of file
@@ -0,0 +1,51 @@
+/**
+ * @file                   lz.h
+ * @brief                  Interfaccia di un compressore della famiglia LZ77 per blocchi di dati in memoria.
+ *                         Il formato è composto da sequenze, ciascuna formata da un token (4 bit per il numero di 
+ *                         literal e 4 bit per la lunghezza del match - LZ_MIN_MATCH, il valore 15 indica che la 
+ *                         lunghezza prosegue in byte successivi), dai literal, dall'offset del match (2 bytes little 
+ *                         endian) e dall'eventuale estensione della lunghezza del match. L'ultima sequenza contiene 
+ *                         solo literal.
+ */
+
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+
+/* Lunghezza minima di un match */
+#define LZ_MIN_MATCH 4
+
+/* Massima distanza tra un match e la sua occorrenza precedente */
+#define LZ_MAX_OFFSET 65535
+
+/**
+ * @function               lz_compress()
+ * @brief                  Comprime i src_size bytes di src scrivendo il risultato in dst.
+ * 
+ * @param src              Dati da comprimere
+ * @param src_size         Dimensione dei dati da comprimere
+ * @param dst              Buffer in cui scrivere i dati compressi
+ * @param dst_capacity     Dimensione del buffer dst
+ * 
+ * @return                 La dimensione dei dati compressi in caso di successo, 
+ *                         0 se src o dst sono @c NULL o se i dati compressi non entrano in dst_capacity bytes.
+ */
+size_t lz_compress(const void* src, size_t src_size, void* dst, size_t dst_capacity);
+
+/**
+ * @function               lz_decompress()
+ * @brief                  Decomprime i src_size bytes di src, prodotti da lz_compress(), scrivendo il risultato in dst.
+ * 
+ * @param src              Dati compressi
+ * @param src_size         Dimensione dei dati compressi
+ * @param dst              Buffer in cui scrivere i dati decompressi
+ * @param dst_size         Dimensione attesa dei dati decompressi
+ * 
+ * @return                 0 in caso di successo, 
+ *                         -1 se src o dst sono @c NULL, se i dati compressi non sono validi o se la loro dimensione 
+ *                         una volta decompressi è diversa da dst_size.
+ */
+int lz_decompress(const void* src, size_t src_size, void* dst, size_t dst_size);
+
+#endif /* LZ_H */
@@ -12,9 +12,72 @@
 /* Massima dimensione del path del socket file */
 #define UNIX_PATH_MAX 108
 
+/* Prefisso del nome di una socket che indica una connessione TCP, nella forma tcp:host:porta (gli interi del 
+   protocollo sono trasmessi nella rappresentazione della macchina, client e server devono quindi condividerla) */
+#define TCP_SOCKNAME_PREFIX "tcp:"
+
+/*
+ * Ogni richiesta è preceduta da un identificativo (int > 0) scelto dal client e ogni risposta è preceduta
+ * dall'identificativo della richiesta a cui si riferisce. Un client può quindi inviare più richieste senza attendere
+ * le risposte e il server può rispondere in un ordine diverso da quello di invio (ad esempio rispondere a una LOCK
+ * in attesa dopo aver servito le richieste successive).
+ */
+
+/* Identificativo di richiesta non valido */
+#define NO_REQ_ID 0
+
+/*
+ * Con la richiesta NEGOTIATE (payload: int con le capacità richieste dal client) il client negozia le capacità della 
+ * connessione, il server risponde OK seguito da un int con le capacità accettate. Se la connessione usa la compressione 
+ * (CAP_COMPRESSION) il contenuto dei file, in entrambe le direzioni, è preceduto come di consueto dalla sua dimensione 
+ * ed è suddiviso in blocchi di COMPRESSION_BLOCK_SIZE bytes (l'ultimo eventualmente più corto); ogni blocco è preceduto 
+ * dalla dimensione con cui è trasmesso (size_t): se è minore della dimensione del blocco il blocco è compresso con 
+ * lz_compress(), altrimenti è trasmesso così com'è.
+ */
+
+/* Capacità di una connessione: compressione del contenuto dei file */
+#define CAP_COMPRESSION 1
+
+/* Capacità di una connessione: nelle risposte a READ, OPEN_READ_CLOSE e READ_IF_NEWER il contenuto del file è seguito 
+   dal suo CRC32C (uint32_t), calcolato dal server a ogni scrittura */
+#define CAP_CHECKSUM 2
+
+/* Capacità di una connessione: il server tiene traccia dei file letti per intero dal client (con READ, OPEN_READ_CLOSE 
+   e READ_IF_NEWER) e quando uno di essi viene modificato, rimosso, espulso o bloccato da un altro client invia al 
+   client una notifica di invalidazione, cioè una risposta con identificativo NO_REQ_ID e codice INVALIDATED seguita 
+   dal path del file (size_t con la lunghezza del path, incluso il terminatore, e il path). Le notifiche vengono 
+   inviate prima della risposta al client che ha effettuato la richiesta che le ha causate e possono precedere 
+   qualsiasi risposta; dopo una notifica il client non viene più notificato per lo stesso file finchè non lo legge 
+   nuovamente. Finchè non riceve una notifica per un file aperto e già letto, il client può quindi leggerlo dalla 
+   propria cache senza contattare il server (tali letture non aggiornano i metadati usati dalla politica di espulsione).
+   Nelle richieste READ e OPEN_READ_CLOSE al path segue la versione del file in cache (0 se il client non ha il file in 
+   cache): se coincide con la versione corrente il server, dopo aver effettuato gli stessi controlli della lettura, 
+   risponde NOT_MODIFIED. Nelle risposte OK a READ e OPEN_READ_CLOSE il contenuto del file è preceduto dalla sua 
+   versione, come in READ_IF_NEWER */
+#define CAP_INVALIDATION 4
+
+/* Dimensione dei blocchi in cui è suddiviso il contenuto dei file su una connessione con compressione */
+#define COMPRESSION_BLOCK_SIZE 65536
+
+/* Dimensione minima di un blocco perchè si tenti di comprimerlo */
+#define COMPRESSION_MIN_SIZE 512
+
 /**
  * @enum          request_code_t
  * @brief         Codici di richiesta.
+ *                OPEN_WRITE_CLOSE e OPEN_READ_CLOSE sono richieste composte, servite dal server in modo atomico con 
+ *                un'unica risposta: la prima equivale alla sequenza OPEN_CREATE_LOCK, WRITE, CLOSE (il payload è 
+ *                quello di WRITE), la seconda alla sequenza OPEN_NO_FLAGS, READ, CLOSE (il payload è quello di READ).
+ *                READ_RANGE legge al più length bytes del file a partire da offset (al path seguono offset e length), 
+ *                WRITE_AT scrive il contenuto a partire da offset, eventualmente estendendo il file (al path seguono 
+ *                offset e il contenuto come in WRITE). In entrambi i casi offset non può superare la size del file.
+ *                READ_IF_NEWER legge il file solo se la sua versione è diversa da quella posseduta dal client (al path 
+ *                segue la versione, 0 se il client non possiede il file), altrimenti il server risponde NOT_MODIFIED; 
+ *                in caso di OK il contenuto del file è preceduto dalla sua versione corrente.
+ *                READN_CURSOR è una READN incrementale: il payload è composto dal cursore (0 per iniziare la scansione), 
+ *                dal numero massimo di file n (int, <= 0 nessun limite) e dal numero massimo di bytes del batch (0 nessun 
+ *                limite, in ogni caso viene inviato almeno un file). In caso di OK i file sono preceduti dal cursore da 
+ *                usare per richiedere il batch successivo, 0 se la scansione è terminata.
  */
 typedef enum request_code {
 	MIN_REQ_CODE		= 0,
@@ -30,7 +93,14 @@ typedef enum request_code {
 	UNLOCK 		= 9,
 	REMOVE 		= 10,
 	CLOSE 			= 11,
-	MAX_REQ_CODE 		= 11
+	OPEN_WRITE_CLOSE 	= 12,
+	OPEN_READ_CLOSE 	= 13,
+	READ_RANGE 		= 14,
+	WRITE_AT 		= 15,
+	READ_IF_NEWER 		= 16,
+	READN_CURSOR 		= 17,
+	NEGOTIATE 		= 18,
+	MAX_REQ_CODE 		= 18
 } request_code_t;
 
 /**
@@ -51,7 +121,10 @@ typedef enum response_code {
 	OPERATION_NOT_PERMITTED 	= 9,
 	TEMPORARILY_UNAVAILABLE 	= 10,
 	COULD_NOT_EVICT		= 11,
-	MAX_RES_CODE 			= 11
+	INVALID_OFFSET 		= 12,
+	NOT_MODIFIED 			= 13,
+	INVALIDATED 			= 14,
+	MAX_RES_CODE 			= 14
 } response_code_t;
 
 /**
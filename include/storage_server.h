@@ -6,6 +6,8 @@
 #ifndef STORAGE_SERVER_H
 #define STORAGE_SERVER_H
 
+#include <stdbool.h>
+
 #include <protocol.h>
 #include <config_parser.h>
 #include <logger.h>
@@ -30,18 +32,33 @@ typedef struct storage storage_t;
  * @struct                request_t
  * @brief                 Struttura che raccoglie gli argomenti di una richiesta.
  * 
+ * @var id                Identificativo della richiesta
  * @var code              Codice della richiesta
  * @var file_path         Path del file
  * @var content_size      Size del contenuto del file
  * @var content           Contenuto del file
  * @var n                 Valore dell'argomento n
+ * @var offset            Offset nel file (READ_RANGE e WRITE_AT)
+ * @var length            Numero massimo di bytes da leggere (READ_RANGE)
+ * @var version           Versione del file posseduta dal client (READ_IF_NEWER, READ e OPEN_READ_CLOSE con 
+ *                        CAP_INVALIDATION)
+ * @var cursor            Cursore da cui riprendere la scansione dei file (READN_CURSOR)
+ * @var max_bytes         Numero massimo di bytes da inviare nel batch (READN_CURSOR)
+ * @var capabilities      Capacità della connessione richieste dal client (NEGOTIATE)
  */
 typedef struct request {
+	int id;
 	request_code_t code;
 	char* file_path;
 	size_t content_size;
 	void* content;
 	int n;
+	size_t offset;
+	size_t length;
+	size_t version;
+	size_t cursor;
+	size_t max_bytes;
+	int capabilities;
 } request_t;
 
 /**
@@ -78,6 +95,8 @@ void storage_destroy(storage_t* storage);
  * 
  * @param storage         Struttura storage
  * @param client_fd       Descrittore del nuovo client connesso
+ * @param tcp             Flag che indica se il client è connesso tramite TCP (in tal caso le parti di ogni risposta 
+ *                        vengono accumulate con TCP_CORK e trasmesse insieme)
  * 
  * @return                0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
  *                        In caso di fallimento errno può assumere i seguenti valori:
@@ -85,7 +104,8 @@ void storage_destroy(storage_t* storage);
  *                        EALREADY se client_fd è il descrittore di un client già connesso
  */
 int new_connection_handler(storage_t* storage,
-				int client_fd);
+				int client_fd,
+				bool tcp);
 
 /**
  * @function              read_request()
@@ -125,13 +145,13 @@ int rejected_task_handler(storage_t* storage,
 /**
  * @function              open_file_handler()
  * @brief                 Serve la richiesta di apertura di un file.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificato del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file da aprire
  * @param mode            Modalità di aperura (OPEN_NO_FLAGS | OPEN_CREATE | OPEN_LOCK | OPEN_CREATE_LOCK)
  * 
@@ -143,88 +163,116 @@ int open_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
+				int req_id,
 				char* file_path,
 				request_code_t mode);
 
 /**
  * @function              write_file_handler()
- * @brief                 Serve la richiesta di write o append di un file.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ * @brief                 Serve la richiesta di write, append o write_at di un file o la richiesta composta 
+ *                        OPEN_WRITE_CLOSE, che crea il file e ne scrive il contenuto senza lasciarlo aperto nè bloccato.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificato del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file da scrivere
  * @param content         Contenuto del file da scrivere
  * @param content_size    Size del file da scrivere
- * @param mode            Modalità di scrittura (WRITE | APPEND)
+ * @param offset          Offset da cui scrivere il contenuto (considerato solo per WRITE_AT)
+ * @param mode            Modalità di scrittura (WRITE | APPEND | OPEN_WRITE_CLOSE | WRITE_AT)
  * 
  * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi, file_path è 
- *                        @c NULL o la sua lunghezza è 0 o mode è diversa da WRITE e APPEND.
+ *                        @c NULL o la sua lunghezza è 0 o mode è diversa da WRITE, APPEND, OPEN_WRITE_CLOSE e WRITE_AT.
  */
 int write_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
+				int req_id,
 				char* file_path,
 				void* content,
 				size_t content_size,
+				size_t offset,
 				request_code_t mode);
 
 /**
  * @function              read_file_handler()
- * @brief                 Serve la richiesta di read di un file.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ * @brief                 Serve la richiesta di read, read_range o read_if_newer di un file o la richiesta composta 
+ *                        OPEN_READ_CLOSE, che legge il file senza che il client debba averlo aperto.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificato del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file da leggere
+ * @param offset          Offset da cui leggere il file (considerato solo per READ_RANGE)
+ * @param length          Numero massimo di bytes da leggere (considerato solo per READ_RANGE)
+ * @param version         Versione del file posseduta dal client (non considerata per READ_RANGE, per READ e 
+ *                        OPEN_READ_CLOSE è la versione in cache, 0 se il client non ha il file in cache)
+ * @param mode            Modalità di lettura (READ | OPEN_READ_CLOSE | READ_RANGE | READ_IF_NEWER)
  * 
  * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi, file_path è 
- *                        @c NULL o la sua lunghezza è 0.
+ *                        @c NULL o la sua lunghezza è 0 o mode è diversa da READ, OPEN_READ_CLOSE, READ_RANGE e 
+ *                        READ_IF_NEWER.
  */
 int read_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
-				char* file_path);
+				int req_id,
+				char* file_path,
+				size_t offset,
+				size_t length,
+				size_t version,
+				request_code_t mode);
 
 /**
  * @function              readn_file_handler()
- * @brief                 Serve la richiesta di readn.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ * @brief                 Serve la richiesta di readn (READN) o di readn incrementale (READN_CURSOR).
+ *                        In caso di READN_CURSOR vengono considerati solo i file inseriti nello storage dopo quello 
+ *                        identificato da cursor e il batch termina al raggiungimento di n file o di max_bytes bytes; 
+ *                        al client viene inviato il cursore da cui riprendere la scansione (0 se è terminata).
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificativo del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param n               Numero di file da leggere, se <= 0 indica una richiesta di lettura di tutti i file (leggibili) 
  *                        dello storage
+ * @param cursor          Cursore da cui riprendere la scansione, 0 per iniziarla (considerato solo per READN_CURSOR)
+ * @param max_bytes       Numero massimo di bytes del batch, 0 se illimitato (considerato solo per READN_CURSOR)
+ * @param mode            Modalità di lettura (READN | READN_CURSOR)
  * 
- * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi.
+ * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi o mode non 
+ *                        è valido.
  */
 int readn_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
-				int n);
+				int req_id,
+				int n,
+				size_t cursor,
+				size_t max_bytes,
+				request_code_t mode);
 
 /**
  * @function              lock_file_handler()
  * @brief                 Serve la richiesta di lock di un file.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificativo del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file su cui effettuare l'operazione di lock
  * 
  * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi, file_path è 
@@ -234,18 +282,19 @@ int lock_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
+				int req_id,
 				char* file_path);
 
 /**
  * @function              unlock_file_handler()
  * @brief                 Server la richiesta di unlock di un file.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificativo del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file su cui effettuare l'operazione di unlock
  * 
  * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi, file_path è 
@@ -255,18 +304,19 @@ int unlock_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
+				int req_id,
 				char* file_path);
 
 /**
  * @function              remove_file_handler()
  * @brief                 Serve la richiesta di remove di un file. 
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificativo del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file da rimuovere
  * 
  * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi, file_path è 
@@ -276,18 +326,19 @@ int remove_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
+				int req_id,
 				char* file_path);
 
 /**
  * @function              close_file_handler()
  * @brief                 Server la richiesta di close di un file.
- *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd), 
- *                        altrimenti scrive client_fd.
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
  * 
  * @param storage         Struttura storage
  * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
  * @param client_fd       Descrittore del client che ha effettuato la richiesta
  * @param worker_id       Identificativo del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
  * @param file_path       Path del file da chiudere
  * 
  * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi, file_path è 
@@ -297,8 +348,134 @@ int close_file_handler(storage_t* storage,
 				int master_fd,
 				int client_fd,
 				int worker_id,
+				int req_id,
 				char* file_path);
 
+/**
+ * @function              negotiate_handler()
+ * @brief                 Serve la richiesta di negoziazione delle capacità della connessione, accettando tra quelle 
+ *                        richieste dal client quelle supportate dal server (CAP_COMPRESSION e CAP_CHECKSUM).
+ *                        Se riscontra che client_fd si è disconesso scrive a master_fd -(client_fd).
+ * 
+ * @param storage         Struttura storage
+ * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
+ * @param client_fd       Descrittore del client che ha effettuato la richiesta
+ * @param worker_id       Identificativo del worker che serve la richiesta
+ * @param req_id          Identificativo della richiesta
+ * @param capabilities    Capacità richieste dal client
+ * 
+ * @return                0 in caso di successo, -1 se storage è @c NULL , master_fd o client_fd sono negativi.
+ */
+int negotiate_handler(storage_t* storage,
+				int master_fd,
+				int client_fd,
+				int worker_id,
+				int req_id,
+				int capabilities);
+
+/**
+ * @function              storage_set_capacity()
+ * @brief                 Modifica il numero massimo di file e di bytes memorizzabili nello storage.
+ *                        Se lo storage eccede la nuova capacità i file non vengono espulsi immediatamente, ma 
+ *                        gradualmente tramite storage_evict_excess() o dalle successive scritture.
+ * 
+ * @param storage         Struttura storage
+ * @param max_files       Il nuovo numero massimo di file memorizzabili
+ * @param max_bytes       Il nuovo numero massimo di bytes memorizzabili
+ * 
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se storage è @c NULL, max_files o max_bytes sono 0
+ */
+int storage_set_capacity(storage_t* storage, size_t max_files, size_t max_bytes);
+
+/**
+ * @function              storage_evict_excess()
+ * @brief                 Espelle al più max_evictions file dallo storage, secondo la politica di espulsione corrente, 
+ *                        fino a che il numero di file e di bytes memorizzati non rientrano nella capacità dello storage.
+ *                        Lo storage resta bloccato solo per l'espulsione di max_evictions file, in modo che invocando 
+ *                        ripetutamente la funzione le richieste dei client possano essere servite tra un'invocazione e 
+ *                        la successiva. Ai client in attesa di acquisire la lock sui file espulsi viene risposto che 
+ *                        il file non esiste; se riscontra che un client si è disconesso scrive a master_fd -(client_fd).
+ * 
+ * @param storage         Struttura storage
+ * @param master_fd       Descrittore del master thread per la comunicazione tra master e workers
+ * @param worker_id       Identificativo del thread che effettua le espulsioni
+ * @param max_evictions   Numero massimo di file da espellere
+ * 
+ * @return                Il numero di file espulsi (0 se lo storage rientra nella sua capacità) in caso di successo, 
+ *                        -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se storage è @c NULL, master_fd è negativo o max_evictions è 0
+ */
+int storage_evict_excess(storage_t* storage, int master_fd, int worker_id, size_t max_evictions);
+
+/**
+ * @function              storage_set_eviction_policy()
+ * @brief                 Modifica la politica di espulsione dei file dallo storage. Se i contatori degli utilizzi dei 
+ *                        file memorizzati devono essere ricostruiti la ricostruzione viene solo avviata, va completata 
+ *                        invocando storage_rebuild_usage_counters(); nel frattempo i contatori non ancora ricostruiti 
+ *                        non vengono aggiornati e sono ricostruiti quando il file è valutato per l'espulsione.
+ * 
+ * @param storage         Struttura storage
+ * @param policy          La nuova politica di espulsione
+ * 
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se storage è @c NULL
+ */
+int storage_set_eviction_policy(storage_t* storage, eviction_policy_t policy);
+
+/**
+ * @function              storage_rebuild_usage_counters()
+ * @brief                 Prosegue la ricostruzione dei contatori degli utilizzi avviata da 
+ *                        storage_set_eviction_policy(), considerando al più max_files file. Lo storage resta bloccato 
+ *                        solo per la ricostruzione dei contatori di max_files file, in modo che invocando ripetutamente 
+ *                        la funzione le richieste dei client possano essere servite tra un'invocazione e la successiva.
+ * 
+ * @param storage         Struttura storage
+ * @param max_files       Numero massimo di file da considerare
+ * 
+ * @return                Il numero di file considerati (0 se la ricostruzione è completa) in caso di successo, 
+ *                        -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se storage è @c NULL o max_files è 0
+ */
+int storage_rebuild_usage_counters(storage_t* storage, size_t max_files);
+
+/**
+ * @function              storage_lock_stats()
+ * @brief                 Restituisce il numero di acquisizioni delle lock associate ai files e il numero di quelle che 
+ *                        hanno trovato la lock già posseduta da un altro thread, a partire dalla creazione dello 
+ *                        storage o dall'ultima invocazione di storage_restripe(). Le acquisizioni vengono contate solo 
+ *                        se l'autotuning è abilitato (altrimenti entrambi i valori sono 0).
+ * 
+ * @param storage         Struttura storage
+ * @param acquisitions    Riferimento in cui memorizzare il numero di acquisizioni
+ * @param contentions     Riferimento in cui memorizzare il numero di acquisizioni contese
+ * 
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se storage, acquisitions o contentions sono @c NULL
+ */
+int storage_lock_stats(storage_t* storage, size_t* acquisitions, size_t* contentions);
+
+/**
+ * @function              storage_restripe()
+ * @brief                 Modifica il numero di lock associate ai files, convertendo max_locks come in storage_create().
+ * @warning               Questa funzione deve essere invocata quando nessun altro thread sta accedendo allo storage.
+ * 
+ * @param storage         Struttura storage
+ * @param max_locks       Il nuovo numero massimo di lock da utilizzare per l'accesso ai files
+ * 
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore 
+ *                        (in tal caso le lock associate ai files restano invariate).
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se storage è @c NULL o max_locks è 0
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da conc_hasht_restripe().
+ */
+int storage_restripe(storage_t* storage, size_t max_locks);
+
 /**
  * @function              print_statistics()
  * @brief                 Stampa le statistiche sullo stato dello storage.
@@ -8,6 +8,8 @@
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 
 /**
 * @struct                 taskfun_node_t
@@ -17,11 +19,13 @@
 *                         (il secondo argomento della funzione è l'identificativo del thread worker)
 * @var arg                Argomento della funzione
 * @var next               Puntatore al task successivo da eseguire
+* @var enqueue_time       Istante di inserimento del task nella lista di task pendenti
 */
 typedef struct taskfun_node {
 	void (*fun)(void *, int);
 	void *arg;
 	struct taskfun_node* next;
+	struct timespec enqueue_time;
 } taskfun_node_t;
 
 /**
@@ -30,28 +34,61 @@ typedef struct taskfun_node {
  * 
  * @var lock              Mutua esclusione nell'accesso all'oggetto
  * @var cond              Variabile di condizione usata per notificare un worker thread 
+ * @var park_cond         Variabile di condizione su cui attendono i worker thread disattivati
+ * @var idle_cond         Variabile di condizione usata per notificare la terminazione dei task in esecuzione a 
+ *                        threadpool_pause()
  * @var threads           Array di workers
  * @var numthreads        Numero di thread (size dell'array threads)
+ * @var activethreads     Numero di thread attivi (i thread con identificativo maggiore sono sospesi)
  * @var lhead             Testa della lista dinamica di task pendenti
  * @var ltail             Coda della lista dinamica di task pendenti
  * @var queue_size        Massima size della lista di task pendenti
  * @var taskonthefly      Numero di task attualmente in esecuzione 
  * @var count             Numero di task nella lista di task pendenti
  * @var exiting           true se è iniziato il protocollo di uscita, false atrimenti
+ * @var paused            true se il pool è sospeso (i task pendenti non vengono estratti dalla lista), false altrimenti
+ * @var completed         Numero di task eseguiti
+ * @var wait_usec         Somma dei microsecondi trascorsi dai task nella lista di task pendenti
+ * @var busy_usec         Somma dei microsecondi impiegati dai thread per eseguire i task
  */
 typedef struct threadpool {
 	pthread_mutex_t lock;
 	pthread_cond_t cond;
+	pthread_cond_t park_cond;
 	pthread_t* threads;
 	size_t numthreads;
+	size_t activethreads;
 	taskfun_node_t* lhead;
 	taskfun_node_t* ltail;
 	size_t queue_size;
 	size_t taskonthefly;
 	size_t count;
 	bool exiting;
+	bool paused;
+	pthread_cond_t idle_cond;
+	size_t completed;
+	uint64_t wait_usec;
+	uint64_t busy_usec;
 } threadpool_t;
 
+/**
+ * @struct                threadpool_stats_t
+ * @brief                 Statistiche sull'utilizzo del threadpool (i contatori sono cumulativi dalla creazione del pool).
+ *
+ * @var activethreads     Numero di thread attivi
+ * @var pending           Numero di task nella lista di task pendenti
+ * @var completed         Numero di task eseguiti
+ * @var wait_usec         Somma dei microsecondi trascorsi dai task nella lista di task pendenti
+ * @var busy_usec         Somma dei microsecondi impiegati dai thread per eseguire i task
+ */
+typedef struct threadpool_stats {
+	size_t activethreads;
+	size_t pending;
+	size_t completed;
+	uint64_t wait_usec;
+	uint64_t busy_usec;
+} threadpool_stats_t;
+
 /**
 * @struct                 worker_args_t
 * @brief                  Argomenti del thread worker del pool.
@@ -115,4 +152,66 @@ int threadpool_destroy(threadpool_t *pool);
  */
 int threadpool_add(threadpool_t *pool, void (*f)(void *, int), void *arg);
 
+/**
+ * @function              threadpool_resize()
+ * @brief                 Modifica il numero di thread attivi e la size della lista di richieste pendenti del pool.
+ *                        Se il numero di thread diminuisce i thread in eccesso, terminato l'eventuale task in esecuzione, 
+ *                        vengono sospesi (e riattivati da un successivo ridimensionamento) fino alla distruzione del 
+ *                        pool; se aumenta vengono riattivati i thread sospesi e creati i thread mancanti.
+ *                        Se la size della lista diminuisce i task già in coda vengono comunque eseguiti.
+ * @param pool            L'oggetto thread pool
+ * @param numthreads      Il nuovo numero di thread attivi
+ * @param pending_size    La nuova size della lista di richieste pendenti
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se pool è @c NULL, numthreads o pending_size sono 0 o è iniziato il protocollo di uscita
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da pthread_mutex_lock(), 
+ *                        pthread_mutex_unlock(), pthread_cond_broadcast(), realloc(), malloc() e pthread_create().
+ *                        Se la creazione di un thread fallisce il numero di thread attivi resta invariato.
+ */
+int threadpool_resize(threadpool_t *pool, size_t numthreads, size_t pending_size);
+
+/**
+ * @function              threadpool_get_stats()
+ * @brief                 Restituisce le statistiche sull'utilizzo del pool.
+ * @param pool            L'oggetto thread pool
+ * @param stats           Il riferimento in cui memorizzare le statistiche
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se pool o stats sono @c NULL
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da pthread_mutex_lock() e 
+ *                        pthread_mutex_unlock().
+ */
+int threadpool_get_stats(threadpool_t *pool, threadpool_stats_t *stats);
+
+/**
+ * @function              threadpool_pause()
+ * @brief                 Sospende l'estrazione dei task pendenti e attende, al più per timeout_msec millisecondi, la 
+ *                        terminazione dei task in esecuzione. I task aggiunti durante la sospensione vengono accodati.
+ *                        Se i task in esecuzione non terminano entro il tempo limite l'estrazione dei task riprende.
+ * @param pool            L'oggetto thread pool
+ * @param timeout_msec    Il massimo numero di millisecondi da attendere
+ * @return                0 se il pool è sospeso e nessun task è in esecuzione, -1 in caso di fallimento ed errno settato 
+ *                        ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se pool è @c NULL, timeout_msec è negativo, il pool è già sospeso o è iniziato il 
+ *                        protocollo di uscita
+ *                        ETIMEDOUT se i task in esecuzione non sono terminati entro timeout_msec millisecondi
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da pthread_mutex_lock(), 
+ *                        pthread_mutex_unlock(), pthread_cond_timedwait() e pthread_cond_broadcast().
+ */
+int threadpool_pause(threadpool_t *pool, long timeout_msec);
+
+/**
+ * @function              threadpool_resume()
+ * @brief                 Riprende l'estrazione dei task pendenti del pool sospeso da threadpool_pause().
+ * @param pool            L'oggetto thread pool
+ * @return                0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                        In caso di fallimento errno può assumere i seguenti valori:
+ *                        EINVAL se pool è @c NULL
+ * @note                  Può fallire e settare errno se si verificano gli errori specificati da pthread_mutex_lock(), 
+ *                        pthread_mutex_unlock() e pthread_cond_broadcast().
+ */
+int threadpool_resume(threadpool_t *pool);
+
 #endif /* THREADPOOL_H */
\ No newline at end of file
@@ -0,0 +1,236 @@
+/**
+ * @file                     autotuner.c
+ * @brief                    Implementazione dell'autotuning del server.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+
+#include <autotuner.h>
+#include <log_format.h>
+#include <util.h>
+
+/**
+ * @struct                   autotuner_t
+ * @brief                    Stato dell'autotuning.
+ *
+ * @var config               Valori di configurazione correnti
+ * @var pool                 Threadpool dei workers
+ * @var storage              Struttura storage
+ * @var logger               Logger
+ * @var interval             Intervallo tra due passi in microsecondi
+ * @var next                 Istante (in microsecondi) del prossimo passo
+ * @var max_locks            Massimo numero di lock associate ai files (il valore di max_locks letto all'avvio)
+ * @var locks                Numero corrente di lock associate ai files
+ * @var last_time            Istante (in microsecondi) dell'ultimo campionamento
+ * @var last_pool            Statistiche del threadpool all'ultimo campionamento
+ * @var last_acquisitions    Acquisizioni delle lock all'ultimo campionamento
+ * @var last_contentions     Acquisizioni contese delle lock all'ultimo campionamento
+ */
+struct autotuner {
+	config_t* config;
+	threadpool_t* pool;
+	storage_t* storage;
+	logger_t* logger;
+	uint64_t interval;
+	uint64_t next;
+	size_t max_locks;
+	size_t locks;
+	uint64_t last_time;
+	threadpool_stats_t last_pool;
+	size_t last_acquisitions;
+	size_t last_contentions;
+};
+
+/**
+ * @function                 monotonic_usec()
+ * @brief                    Ritorna l'istante corrente del clock monotono in microsecondi.
+ */
+static uint64_t monotonic_usec() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+autotuner_t* autotuner_create(config_t* config, size_t max_locks, threadpool_t* pool, storage_t* storage,
+	logger_t* logger) {
+	if (!config || !pool || !storage || !logger || config->autotune_interval == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	autotuner_t* tuner = malloc(sizeof(autotuner_t));
+	if (!tuner)
+		return NULL;
+
+	tuner->config = config;
+	tuner->pool = pool;
+	tuner->storage = storage;
+	tuner->logger = logger;
+	tuner->interval = (uint64_t) config->autotune_interval * 1000;
+	tuner->max_locks = max_locks;
+	tuner->locks = max_locks;
+	tuner->last_time = monotonic_usec();
+	tuner->next = tuner->last_time + tuner->interval;
+	if (threadpool_get_stats(pool, &tuner->last_pool) == -1 ||
+		storage_lock_stats(storage, &tuner->last_acquisitions, &tuner->last_contentions) == -1) {
+		int errnosv = errno;
+		free(tuner);
+		errno = errnosv;
+		return NULL;
+	}
+
+	return tuner;
+}
+
+void autotuner_timeout(autotuner_t* tuner, struct timeval* timeout) {
+	uint64_t now = monotonic_usec();
+	uint64_t remaining = tuner->next > now ? tuner->next - now : 0;
+	timeout->tv_sec = remaining / 1000000;
+	timeout->tv_usec = remaining % 1000000;
+}
+
+bool autotuner_due(autotuner_t* tuner) {
+	return monotonic_usec() >= tuner->next;
+}
+
+/**
+ * @function                 tune_workers()
+ * @brief                    Adegua il numero di workers in base all'attesa media dei task in coda e all'utilizzo dei
+ *                           workers nell'intervallo trascorso dall'ultimo campionamento.
+ *
+ * @param tuner              Lo stato dell'autotuning
+ * @param stats              Statistiche correnti del threadpool
+ * @param elapsed            Microsecondi trascorsi dall'ultimo campionamento
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int tune_workers(autotuner_t* tuner, threadpool_stats_t* stats, uint64_t elapsed) {
+	size_t workers = stats->activethreads;
+	size_t completed = stats->completed - tuner->last_pool.completed;
+	uint64_t wait = stats->wait_usec - tuner->last_pool.wait_usec;
+	uint64_t busy = stats->busy_usec - tuner->last_pool.busy_usec;
+	if (elapsed == 0 || workers == 0)
+		return 0;
+
+	// se nessun task è stato estratto ma la coda non è vuota l'attesa media è considerata illimitata
+	double avg_wait = completed > 0 ? (double) wait / completed : (stats->pending > 0 ? UINT64_MAX : 0);
+	double avg_service = completed > 0 ? (double) busy / completed : 0;
+	double util = (double) busy / ((double) elapsed * workers);
+
+	size_t new_workers = workers;
+	if (avg_wait > AUTOTUNE_WAIT_HIGH_USEC && avg_wait > AUTOTUNE_WAIT_RATIO * avg_service && 
+		util > AUTOTUNE_UTIL_HIGH && workers < tuner->config->max_workers) {
+		/* i workers sono saturi e i task attendono in coda più a lungo di quanto vengano eseguiti: aumento i workers 
+		   della metà */
+		size_t inc = workers / 2 > 0 ? workers / 2 : 1;
+		new_workers = tuner->config->max_workers - workers > inc ? workers + inc : tuner->config->max_workers;
+	}
+	else if (avg_wait < AUTOTUNE_WAIT_LOW_USEC && util < AUTOTUNE_UTIL_LOW && workers > tuner->config->min_workers) {
+		// i workers sono poco utilizzati: ne sospendo uno
+		new_workers = workers - 1;
+	}
+	if (new_workers == workers)
+		return 0;
+
+	if (threadpool_resize(tuner->pool, new_workers, tuner->config->dim_workers_queue) == -1)
+		return -1;
+	tuner->config->n_workers = new_workers;
+	LOG(log_record(tuner->logger, "%d,%s,%s,,%zu->%zu wait=%.0fus service=%.0fus util=%.2f",
+		MASTER_ID, AUTOTUNE, "WORKERS", workers, new_workers, avg_wait, avg_service, util));
+	return 0;
+}
+
+/**
+ * @function                 tune_locks()
+ * @brief                    Adegua il numero di lock associate ai files in base alla frazione di acquisizioni contese
+ *                           nell'intervallo trascorso dall'ultimo campionamento.
+ *
+ * @param tuner              Lo stato dell'autotuning
+ * @param acquisitions       Acquisizioni delle lock nell'intervallo
+ * @param contentions        Acquisizioni contese delle lock nell'intervallo
+ *
+ * @return                   1 se il numero di lock è stato modificato, 0 se non è stato modificato,
+ *                           -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int tune_locks(autotuner_t* tuner, size_t acquisitions, size_t contentions) {
+	if (acquisitions < AUTOTUNE_MIN_ACQUISITIONS)
+		return 0;
+
+	double contention = (double) contentions / acquisitions;
+	size_t new_locks = tuner->locks;
+	if (contention > AUTOTUNE_CONTENTION_HIGH && tuner->locks < tuner->max_locks) {
+		new_locks = tuner->max_locks / 2 > tuner->locks ? tuner->locks * 2 : tuner->max_locks;
+	}
+	else if (contention < AUTOTUNE_CONTENTION_LOW && tuner->locks > tuner->config->min_locks) {
+		new_locks = tuner->locks / 2 > tuner->config->min_locks ? tuner->locks / 2 : tuner->config->min_locks;
+	}
+	if (new_locks == tuner->locks)
+		return 0;
+
+	// attendo che i workers terminino i task in esecuzione, in modo che nessuno possieda o attenda una lock
+	if (threadpool_pause(tuner->pool, AUTOTUNE_PAUSE_TIMEOUT_MSEC) == -1) {
+		if (errno != ETIMEDOUT)
+			return -1;
+		LOG(log_record(tuner->logger, "%d,%s,%s,,%zu->%zu contention=%.4f postponed",
+			MASTER_ID, AUTOTUNE, "LOCKS", tuner->locks, new_locks, contention));
+		return 0;
+	}
+	int r = storage_restripe(tuner->storage, new_locks);
+	int errnosv = errno;
+	if (threadpool_resume(tuner->pool) == -1)
+		return -1;
+	if (r == -1) {
+		errno = errnosv;
+		return -1;
+	}
+
+	LOG(log_record(tuner->logger, "%d,%s,%s,,%zu->%zu contention=%.4f",
+		MASTER_ID, AUTOTUNE, "LOCKS", tuner->locks, new_locks, contention));
+	tuner->locks = new_locks;
+	return 1;
+}
+
+int autotuner_step(autotuner_t* tuner, bool exclusive) {
+	if (!tuner) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uint64_t now = monotonic_usec();
+	tuner->next = now + tuner->interval;
+
+	threadpool_stats_t stats;
+	size_t acquisitions, contentions;
+	if (threadpool_get_stats(tuner->pool, &stats) == -1 ||
+		storage_lock_stats(tuner->storage, &acquisitions, &contentions) == -1)
+		return -1;
+
+	int r = 0;
+	if (exclusive) {
+		if (tune_workers(tuner, &stats, now - tuner->last_time) == -1)
+			return -1;
+		r = tune_locks(tuner, acquisitions - tuner->last_acquisitions, contentions - tuner->last_contentions);
+		if (r == -1)
+			return -1;
+	}
+
+	tuner->last_time = now;
+	tuner->last_pool = stats;
+	if (r == 1) {
+		// la modifica delle lock azzera i contatori delle acquisizioni
+		tuner->last_acquisitions = tuner->last_contentions = 0;
+	}
+	else {
+		tuner->last_acquisitions = acquisitions;
+		tuner->last_contentions = contentions;
+	}
+	return 0;
+}
+
+void autotuner_destroy(autotuner_t* tuner) {
+	free(tuner);
+}
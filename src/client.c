@@ -4,6 +4,9 @@
  *                             invoca le funzioni dell'API per interagire con il server.
  */
 
+/* necessario per d_type e le costanti DT_* di struct dirent */
+#define _DEFAULT_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <signal.h>
@@ -12,13 +15,18 @@
 #include <stdbool.h>
 #include <limits.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <pthread.h>
 
 #include <client_api.h>
+#include <conn_pool.h>
 #include <cmdline_operation.h>
 #include <cmdline_parser.h>
 #include <list.h>
 #include <filesys_util.h>
+#include <latency_hist.h>
 #include <util.h>
 
 /* Secondi da dedicare ai tentativi di connessione verso il server */
@@ -30,6 +38,8 @@
 /* Millisecondi da attendere tra una richiesta che ha ricevuto come risposta TEMPORARILY_UNAVAILABLE e il tentativo di 
    richiesta successivo*/
 #define RETRY_REQ_AFTER_MSEC 1000
+/* Massimo numero di bytes da ricevere con ciascuna richiesta nella lettura di tutti i file del server ('R' con n <= 0) */
+#define READN_BATCH_BYTES 1048576
 
 /**
  * @def                        RETRY_IF_BUSY()
@@ -43,6 +53,7 @@
 	do { \
 		int try = 0; \
 		bool sleep_fail = 0; \
+		uint64_t intended = pace_wait(); \
 		while ((ret = (X)) == -1 && errno == EBUSY) { \
 			try ++; \
 			if (try >= MAX_REQ_TRIES) break; \
@@ -56,8 +67,77 @@
 		} \
 		if (!sleep_fail) \
 			PRINT(" : %s", ret == -1 ? errno_to_str(errno) : "OK"); \
+		if (intended) \
+			pace_record(intended, ret); \
 	} while(0);
 
+/**
+ * @struct                     pacer_t
+ * @brief                      Secchio di gettoni che limita le richieste inviate a ciclo aperto (-O). I gettoni vengono 
+ *                             generati a intervalli regolari e ogni richiesta ne consuma uno, attendendone la 
+ *                             generazione se il secchio è vuoto; i gettoni non consumati non vengono scartati, in 
+ *                             modo che le richieste ritardate dalle risposte del server vengano inviate appena 
+ *                             possibile. La latenza di ciascuna richiesta è misurata dall'istante di generazione del suo 
+ *                             gettone, cioè da quando avrebbe dovuto essere inviata, e include quindi anche il tempo 
+ *                             trascorso in attesa delle richieste precedenti.
+ *
+ * @var interval               Microsecondi tra la generazione di due gettoni (0 se le richieste sono a ciclo chiuso)
+ * @var start                  Istante di generazione del primo gettone in microsecondi
+ * @var next                   Istante di generazione del prossimo gettone in microsecondi
+ * @var hist                   Istogramma delle latenze delle richieste
+ * @var mutex                  Mutex per l'accesso in mutua esclusione da parte dei thread di upload (-j)
+ */
+typedef struct pacer {
+	double interval;
+	uint64_t start;
+	double next;
+	hist_t hist;
+	pthread_mutex_t mutex;
+} pacer_t;
+
+/* Secchio di gettoni delle richieste a ciclo aperto */
+static pacer_t pacer = {0, 0, 0, {{0}}, PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @function                   pace_wait()
+ * @brief                      Consuma un gettone del secchio, attendendone la generazione se non è ancora disponibile.
+ *
+ * @return                     L'istante in microsecondi in cui la richiesta avrebbe dovuto essere inviata,
+ *                             0 se le richieste sono a ciclo chiuso.
+ */
+static uint64_t pace_wait() {
+	if (pacer.interval == 0)
+		return 0;
+	pthread_mutex_lock(&pacer.mutex);
+	uint64_t intended = (uint64_t) pacer.next;
+	pacer.next += pacer.interval;
+	pthread_mutex_unlock(&pacer.mutex);
+	// se la richiesta è in ritardo sull'istante previsto viene inviata immediatamente
+	sleep_until_usec(intended);
+	return intended;
+}
+
+/**
+ * @function                   pace_record()
+ * @brief                      Registra la latenza di una richiesta a ciclo aperto misurata dall'istante intended in cui 
+ *                             avrebbe dovuto essere inviata e, se le stampe sono abilitate, la stampa. Preserva errno.
+ *
+ * @param intended             L'istante in microsecondi ritornato da pace_wait()
+ * @param ret                  Il valore ritornato dalla chiamata dell'API
+ */
+static void pace_record(uint64_t intended, int ret) {
+	int errnosv = errno;
+	uint64_t latency = now_usec() - intended;
+	pthread_mutex_lock(&pacer.mutex);
+	if (ret == -1)
+		pacer.hist.errors ++;
+	else
+		hist_record(&pacer.hist, latency);
+	pthread_mutex_unlock(&pacer.mutex);
+	PRINT(" (%lu us)", (unsigned long) latency);
+	errno = errnosv;
+}
+
 /**
  * @function                   should_exit()
  * @brief                      Consente di stabilire in base al codice di errore err settato nell'API se il processo deve
@@ -72,29 +152,47 @@ static inline bool should_exit(int err) {
 	return false;
 }
 
+/**
+ * @def                        file_visitor_t
+ * @brief                      Funzione invocata da visit_dir() per ogni file regolare visitato.
+ * 
+ * @param pathname             Il path del file visitato (allocato dinamicamente, la funzione ne acquisisce la proprietà)
+ * @param arg                  L'argomento passato a visit_dir()
+ * 
+ * @return                     0 se la visita deve proseguire, -1 se si è verificato un errore che dovrà essere gestito 
+ *                             terminando il processo (la visita viene interrotta).
+ */
+typedef int (*file_visitor_t)(char* pathname, void* arg);
+
 /**
  * @function                   visit_dir()
- * @brief                      Visita ricorsivamente la directory dirname fino ad aver visitato limit file regolari. 
- *                             Se la directory presenta un numero di file regolari minore di limit o limit vale 0 
- *                             visita ricrosivamente tutta la directory. Memorizza i path dei file visitati nella lista
- *                             files.
+ * @brief                      Visita ricorsivamente la directory dirname, associata al descrittore dir_fd, fino ad aver 
+ *                             visitato limit file regolari. Se la directory presenta un numero di file regolari minore di 
+ *                             limit o limit vale 0 visita ricorsivamente tutta la directory. Per ogni file visitato 
+ *                             invoca visit, in modo che il file possa essere elaborato prima del termine della visita.
+ *                             Le sottodirectory vengono aperte e i metadati dei file recuperati relativamente al 
+ *                             descrittore della directory che li contiene, e il tipo dei file viene ricavato, se 
+ *                             disponibile, da d_type senza recuperarne i metadati.
  * 
- * @param dirname              Il path della directory da visitare
+ * @param dir_fd               Il descrittore della directory da visitare, che viene chiuso al termine della visita
+ * @param dirname              Il path della directory da visitare (utilizzato per costruire i path dei file visitati)
  * @param limit                Il massimo numero di file da visitare, 0 se si intende visitare tutto il contenuto della 
  *                             directory
- * @param files                La lista in cui vengono memorizzati i files visitati
+ * @param visit                La funzione da invocare per ogni file visitato
+ * @param arg                  L'argomento da passare a visit
  * 
  * @return                     Il numero di file visitati in caso di successo, 
  *                             altrimenti in caso di fallimento ritorna -1 se si è verificato un errore che dovrà essere 
  *                             gestito terminando il processo, -2 se si è verificato un errore ma è possibile effettuare le
  *                             eventuali operazioni successive.
  */
-static int visit_dir(char* dirname, size_t limit, list_t* files) {
+static int visit_dir(int dir_fd, const char* dirname, size_t limit, file_visitor_t visit, void* arg) {
 	int r = 0;
-	// apro la directory dirname
-	DIR* dir = opendir(dirname);
+	// apro lo stream della directory a partire dal suo descrittore
+	DIR* dir = fdopendir(dir_fd);
 	if (!dir) {
-		PERRFMT("\nERR: opendir di '%s' (%s)\n", dirname, strerror(errno));
+		PERRFMT("\nERR: fdopendir di '%s' (%s)\n", dirname, strerror(errno));
+		close(dir_fd);
 		if (errno == ENOMEM)
 			return -1;
 		return -2;
@@ -102,6 +200,7 @@ static int visit_dir(char* dirname, size_t limit, list_t* files) {
 
 	struct dirent* file;
 	size_t file_visited = 0;
+	int len1 = strlen(dirname);
 
 	/* continuo a leggere il contenuto della directory fino a che non ho letto limit file oppure se limit è 0 o la 
 	   directory presenta un numero di file minore di limit fino ad avere letto tutto il contenuto */
@@ -110,8 +209,33 @@ static int visit_dir(char* dirname, size_t limit, list_t* files) {
 		if (is_dot(file->d_name))
 			continue;
 
+		// ricavo il tipo del file da d_type, se disponibile, altrimenti dai metadati (seguendo i link simbolici)
+		bool is_dir = false, is_reg = false, known = false;
+#ifdef DT_DIR
+		if (file->d_type != DT_UNKNOWN && file->d_type != DT_LNK) {
+			is_dir = file->d_type == DT_DIR;
+			is_reg = file->d_type == DT_REG;
+			known = true;
+		}
+#endif
+		if (!known) {
+			struct stat statbuf;
+			if (fstatat(dirfd(dir), file->d_name, &statbuf, 0) == -1) {
+				PERRFMT("\nERR: fstatat di '%s' in '%s' (%s)\n", file->d_name, dirname, strerror(errno));
+				if (errno == ENOMEM) {
+					closedir(dir);
+					return -1;
+				}
+				continue;
+			}
+			is_dir = S_ISDIR(statbuf.st_mode);
+			is_reg = S_ISREG(statbuf.st_mode);
+		}
+		// se il file corrente non è nè una directory nè un file regolare lo ignoro
+		if (!is_dir && !is_reg)
+			continue;
+
 		// costruisco il path del file corrente
-		int len1 = strlen(dirname);
 		int len2 = strlen(file->d_name);
 		if ((len1 + len2 + 2) > PATH_MAX) {
 			PERRFMT("\nERR: il filepath '%s' è troppo lungo\n", file->d_name);
@@ -120,6 +244,7 @@ static int visit_dir(char* dirname, size_t limit, list_t* files) {
 		char* pathname = NULL;
 		if ((pathname = calloc(len1 + len2 + 2, sizeof(char))) == NULL) {
 			PERRFMT("\nERR: calloc (%s)\n", strerror(errno));
+			closedir(dir);
 			return -1;
 		}
 		strcpy(pathname, dirname);
@@ -127,37 +252,30 @@ static int visit_dir(char* dirname, size_t limit, list_t* files) {
 			strcat(pathname, "/");
 		strcat(pathname, file->d_name);
 
-		// recupero i metadati del file corrente
-		struct stat statbuf;
-		if (stat(pathname, &statbuf) == -1) {
-			PERRFMT("\nERR: stat di '%s' (%s)\n", pathname, strerror(errno));
-			free(pathname);
-			if (errno == ENOMEM)
-				return -1;
-			continue;
-		}
-
 		// se il file corrente è una directory la visito ricorsivamente modificando limit
-		if (S_ISDIR(statbuf.st_mode)) {
-			int ret = visit_dir(pathname, limit - file_visited, files);
+		if (is_dir) {
+			int child_fd = openat(dirfd(dir), file->d_name, O_RDONLY | O_DIRECTORY);
+			if (child_fd == -1) {
+				PERRFMT("\nERR: openat di '%s' (%s)\n", pathname, strerror(errno));
+				free(pathname);
+				continue;
+			}
+			int ret = visit_dir(child_fd, pathname, limit == 0 ? 0 : limit - file_visited, visit, arg);
 			free(pathname);
-			if (ret < 0)
+			if (ret < 0) {
+				closedir(dir);
 				return ret;
+			}
 			// incremento il numero di file visitati con quelli visitati nella chiamata ricorsiva
 			file_visited += ret;
 		}
 		else {
-			// se il file corrente non è un file regolare lo ignoro
-			if (!S_ISREG(statbuf.st_mode))
-				continue;
-			// inserisco il file corrente nella lista dei file visitati
-			if ((r = list_tail_insert(files, pathname)) != 0) {
-				PERRFMT("\nERR: list_tail_insert (%s)\n", strerror(errno));
-				free(pathname);
+			// incremento il numero di file visitati ed elaboro il file corrente
+			file_visited += 1;
+			if (visit(pathname, arg) == -1) {
+				closedir(dir);
 				return -1;
 			}
-			// incremento il numero di file visitati
-			file_visited += 1;
 		}
 	}
 	// controllo se la visita della directory è terminata con successo o se si è verificato un errore
@@ -175,77 +293,311 @@ static int visit_dir(char* dirname, size_t limit, list_t* files) {
 	return r;
 }
 
+/**
+ * @function                   write_one_file()
+ * @brief                      Effettua la richiesta di scrittura al server del file filepath, invocando le funzioni 
+ *                             dell'API o, se pool è diverso da @c NULL, le funzioni del pool di connessioni.
+ * 
+ * @param pool                 Il pool di connessioni con cui scrivere il file (@c NULL per la connessione di default)
+ * @param filepath             Il path del file da scrivere
+ * @param dirname_out          La directory in cui memorizzare i file espulsi dal server
+ * 
+ * @return                     0 in caso di successo o se si è verificato un errore ma è possibile effettuare le eventuali 
+ *                             operazioni successive, -1 se si è verificato un errore che dovrà essere gestito terminando 
+ *                             il processo.
+ */
+static int write_one_file(fss_pool_t* pool, const char* filepath, const char* dirname_out) {
+	int ret;
+	// ottengo il path assoluto del file
+	char* abspath = get_absolute_path(filepath);
+	if (!abspath) {
+		PERRFMT("\nERR: get_absolute_path di '%s' (%s)\n", 
+			filepath, strerror(errno));
+		if (errno == ENOMEM) return -1;
+		return 0;
+	}
+
+	/* invoco la funzione dell'API per creare, scrivere e chiudere il file con un'unica richiesta (se il file viene 
+	   scritto con il pool e le stampe sono abilitate le stampe vengono accumulate ed effettuate al termine della 
+	   richiesta, in modo che le stampe dei diversi thread non si sovrappongano senza serializzarne le richieste) */
+	bool buffered = pool && is_printing_enable() && begin_print_buffering() == 0;
+	PRINT("\nopenWriteCloseFile(pathname = %s)", abspath);
+	if (pool) {
+		RETRY_IF_BUSY(fss_pool_openWriteCloseFile(pool, abspath, dirname_out), ret);
+	}
+	else {
+		RETRY_IF_BUSY(openWriteCloseFile(abspath, dirname_out), ret);
+	}
+	if (buffered) {
+		int errnosv = errno;
+		end_print_buffering();
+		errno = errnosv;
+	}
+	free(abspath);
+	if (ret == -1 && errno != EFAULT && should_exit(errno))
+		return -1;
+	return 0;
+}
+
+/**
+ * @struct                     upload_t
+ * @brief                      Stato condiviso dai thread che scrivono in parallelo i file di un'operazione -w o -W.
+ *
+ * @var pool                   Pool di connessioni con il server
+ * @var files                  Coda dei path dei file ancora da scrivere
+ * @var dirname_out            Directory in cui memorizzare i file espulsi dal server
+ * @var done                   Flag che indica che non verranno inseriti altri file nella coda
+ * @var fail                   Flag che indica se si è verificato un errore che dovrà essere gestito terminando il processo
+ * @var threads                Thread che scrivono i file
+ * @var threads_num            Numero di thread avviati
+ * @var mutex                  Mutex per l'accesso a files, done e fail
+ * @var cond                   Variabile di condizione su cui i thread attendono l'inserimento di file nella coda
+ */
+typedef struct upload {
+	fss_pool_t* pool;
+	list_t* files;
+	const char* dirname_out;
+	bool done;
+	bool fail;
+	pthread_t* threads;
+	int threads_num;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} upload_t;
+
+/**
+ * @function                   upload_worker()
+ * @brief                      Funzione eseguita dai thread che scrivono in parallelo i file: estrae un file alla volta 
+ *                             dalla coda e lo scrive con una connessione libera del pool, finchè la coda non è vuota e 
+ *                             non verranno inseriti altri file o non si è verificato un errore che richiede la 
+ *                             terminazione del processo.
+ * 
+ * @param arg                  Lo stato condiviso upload_t
+ */
+static void* upload_worker(void* arg) {
+	upload_t* upload = arg;
+	while (true) {
+		// estraggo il prossimo file da scrivere, attendendo che ne venga inserito uno se la coda è vuota
+		pthread_mutex_lock(&upload->mutex);
+		while (!upload->fail && !upload->done && list_is_empty(upload->files))
+			pthread_cond_wait(&upload->cond, &upload->mutex);
+		char* filepath = upload->fail ? NULL : list_head_remove(upload->files);
+		pthread_mutex_unlock(&upload->mutex);
+		if (!filepath)
+			break;
+
+		int r = write_one_file(upload->pool, filepath, upload->dirname_out);
+		free(filepath);
+		if (r == -1) {
+			pthread_mutex_lock(&upload->mutex);
+			upload->fail = true;
+			pthread_cond_broadcast(&upload->cond);
+			pthread_mutex_unlock(&upload->mutex);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @function                   upload_start()
+ * @brief                      Apre un pool di jobs connessioni con il server e avvia altrettanti thread che scrivono i 
+ *                             file inseriti con upload_push().
+ * 
+ * @param sockname             Il path del socket file o tcp:host:porta
+ * @param jobs                 Il numero di connessioni e di thread
+ * @param dirname_out          La directory in cui memorizzare i file espulsi dal server
+ * 
+ * @return                     Lo stato condiviso dai thread in caso di successo, @c NULL in caso di fallimento.
+ */
+static upload_t* upload_start(const char* sockname, int jobs, const char* dirname_out) {
+	upload_t* upload = calloc(1, sizeof(upload_t));
+	if (!upload) {
+		PERRFMT("\nERR: calloc (%s)\n", strerror(errno));
+		return NULL;
+	}
+	upload->dirname_out = dirname_out;
+	upload->files = list_create((int (*)(void*, void*))strcmp, free);
+	upload->threads = malloc(jobs * sizeof(pthread_t));
+	if (!upload->files || !upload->threads) {
+		PERRFMT("\nERR: allocazione dello stato dei thread (%s)\n", strerror(errno));
+		if (upload->files)
+			list_destroy(upload->files, LIST_FREE_DATA);
+		if (upload->threads)
+			free(upload->threads);
+		free(upload);
+		return NULL;
+	}
+	if (pthread_mutex_init(&upload->mutex, NULL) != 0 || pthread_cond_init(&upload->cond, NULL) != 0) {
+		PERRFMT("%s", "\nERR: inizializzazione della mutex o della variabile di condizione\n");
+		list_destroy(upload->files, LIST_FREE_DATA);
+		free(upload->threads);
+		free(upload);
+		return NULL;
+	}
+
+	// apro le connessioni del pool
+	struct timespec abstime;
+	abstime.tv_nsec = 0;
+	abstime.tv_sec = time(NULL) + TRY_CONN_FOR_SEC;
+	upload->pool = fss_pool_create(sockname, jobs, RETRY_CONN_AFTER_MSEC, abstime);
+	PRINT("\nfss_pool_create(sockname = %s, n = %d) : %s",
+		sockname, jobs, upload->pool == NULL ? errno_to_str(errno) : "OK");
+	if (!upload->pool) {
+		pthread_mutex_destroy(&upload->mutex);
+		pthread_cond_destroy(&upload->cond);
+		list_destroy(upload->files, LIST_FREE_DATA);
+		free(upload->threads);
+		free(upload);
+		return NULL;
+	}
+
+	// avvio i thread (se non è possibile avviarne nessuno i file vengono scritti da upload_finish())
+	while (upload->threads_num < jobs && 
+		pthread_create(&upload->threads[upload->threads_num], NULL, upload_worker, upload) == 0)
+		upload->threads_num ++;
+	return upload;
+}
+
+/**
+ * @function                   upload_push()
+ * @brief                      Inserisce il file pathname nella coda dei file da scrivere. Può essere utilizzata come 
+ *                             file_visitor_t.
+ * 
+ * @param pathname             Il path del file da scrivere (la funzione ne acquisisce la proprietà)
+ * @param arg                  Lo stato condiviso upload_t
+ * 
+ * @return                     0 in caso di successo, -1 se si è verificato un errore che dovrà essere gestito terminando 
+ *                             il processo.
+ */
+static int upload_push(char* pathname, void* arg) {
+	upload_t* upload = arg;
+	pthread_mutex_lock(&upload->mutex);
+	if (upload->fail) {
+		pthread_mutex_unlock(&upload->mutex);
+		free(pathname);
+		return -1;
+	}
+	if (list_tail_insert(upload->files, pathname) == -1) {
+		PERRFMT("\nERR: list_tail_insert (%s)\n", strerror(errno));
+		upload->fail = true;
+		pthread_cond_broadcast(&upload->cond);
+		pthread_mutex_unlock(&upload->mutex);
+		free(pathname);
+		return -1;
+	}
+	pthread_cond_signal(&upload->cond);
+	pthread_mutex_unlock(&upload->mutex);
+	return 0;
+}
+
+/**
+ * @function                   upload_finish()
+ * @brief                      Attende la scrittura dei file inseriti nella coda, termina i thread, chiude le connessioni 
+ *                             del pool e dealloca upload.
+ * 
+ * @param upload               Lo stato condiviso dai thread
+ * 
+ * @return                     0 in caso di successo, -1 se si è verificato un errore che dovrà essere gestito terminando 
+ *                             il processo.
+ */
+static int upload_finish(upload_t* upload) {
+	pthread_mutex_lock(&upload->mutex);
+	upload->done = true;
+	pthread_cond_broadcast(&upload->cond);
+	pthread_mutex_unlock(&upload->mutex);
+
+	// se non è stato avviato nessun thread scrivo i file con il thread corrente
+	if (upload->threads_num == 0)
+		upload_worker(upload);
+	for (int i = 0; i < upload->threads_num; i++)
+		pthread_join(upload->threads[i], NULL);
+
+	// chiudo le connessioni del pool
+	int r = fss_pool_destroy(upload->pool);
+	PRINT("\nfss_pool_destroy() : %s", r == -1 ? errno_to_str(errno) : "OK");
+	bool fail = upload->fail;
+	pthread_mutex_destroy(&upload->mutex);
+	pthread_cond_destroy(&upload->cond);
+	list_destroy(upload->files, LIST_FREE_DATA);
+	free(upload->threads);
+	free(upload);
+	return fail ? -1 : 0;
+}
+
 /**
  * @function                   write_file_list()
  * @brief                      Effettua la richiesta di scrittura al server, invocando le funzioni dell'API, 
- *                             per ogni file della lista cmdline_operation->files.
+ *                             per ogni file della lista cmdline_operation->files. Se è stata specificata l'opzione -j i 
+ *                             file vengono scritti in parallelo su più connessioni.
  * 
  * @param cmdline_operation    L'operazione della linea di comando e i suoi argomenti
+ * @param sockname             Il path del socket file o tcp:host:porta
  * 
  * @return                     0 in caso di successo, in caso di fallimento ritorna -1 se si è verificato un errore che 
  *                             dovrà essere gestito terminando il processo, 1 se si è verificato un errore ma è possibile 
  *                             effettuare le eventuali operazioni successive.
  */
-static int write_file_list(cmdline_operation_t* cmdline_operation) {
+static int write_file_list(cmdline_operation_t* cmdline_operation, const char* sockname) {
 	if (!cmdline_operation || !cmdline_operation->files) {
 		PERRFMT("\nERR: argomenti non validi nella funzione '%s'\n", __func__);
 		return 1;
 	}
-	int ret;
-	char* filepath;
-	// itero sui file che devono essere scritti
-	list_for_each(cmdline_operation->files, filepath) {
-		// ottengo il path assoluto del file
-		char* abspath = get_absolute_path(filepath);
-		if (!abspath) {
-			PERRFMT("\nERR: get_absolute_path di '%s' (%s)\n", 
-				filepath, strerror(errno));
-			if (errno == ENOMEM) return -1;
-			continue;
-		}
 
-		// invoco la funzione dell'API per aprire il file
-		PRINT("\nopenFile(pathname = %s, flags = O_CREATE|O_LOCK)", abspath);
-		RETRY_IF_BUSY(openFile(abspath, O_CREATE|O_LOCK), ret);
-		if (ret == -1) { 
-			free(abspath);
-			if (should_exit(errno)) return -1;
-			continue;
-		}
-
-		// invoco la funzione dell'API per scrivere il file 
-		PRINT("\nwriteFile(pathname = %s)", abspath);
-		RETRY_IF_BUSY(writeFile(abspath, cmdline_operation->dirname_out), ret);
-		if (ret == -1 && errno != EFAULT) {
-			free(abspath);
-			if (should_exit(errno)) return -1;
-			continue;
+	char* filepath;
+	if (cmdline_operation->jobs == 0) {
+		// itero sui file che devono essere scritti
+		list_for_each(cmdline_operation->files, filepath) {
+			if (write_one_file(NULL, filepath, cmdline_operation->dirname_out) == -1)
+				return -1;
 		}
+		return 0;
+	}
 
-		// invoco la funzione dell'API per chiudere il file
-		PRINT("\ncloseFile(pathname = %s)", abspath);
-		RETRY_IF_BUSY(closeFile(abspath), ret);
-		if (ret == -1) {
-			free(abspath);
-			if (should_exit(errno)) return -1;
-			continue;
-		}
-		free(abspath);
+	// non apro più connessioni dei file da scrivere
+	int jobs = cmdline_operation->jobs;
+	if (list_get_length(cmdline_operation->files) < jobs)
+		jobs = list_get_length(cmdline_operation->files);
+	if (jobs == 0)
+		return 0;
+	upload_t* upload = upload_start(sockname, jobs, cmdline_operation->dirname_out);
+	if (!upload)
+		return -1;
+	// inserisco i file nella coda dei file da scrivere
+	while ((filepath = list_head_remove(cmdline_operation->files)) != NULL) {
+		if (upload_push(filepath, upload) == -1)
+			break;
 	}
-	return 0;
+	return upload_finish(upload);
+}
+
+/**
+ * @function                   write_visited_file()
+ * @brief                      Scrive con la connessione di default il file pathname visitato da visit_dir().
+ * 
+ * @param pathname             Il path del file da scrivere (la funzione ne acquisisce la proprietà)
+ * @param arg                  La directory in cui memorizzare i file espulsi dal server
+ * 
+ * @return                     Come write_one_file().
+ */
+static int write_visited_file(char* pathname, void* arg) {
+	int r = write_one_file(NULL, pathname, (const char*) arg);
+	free(pathname);
+	return r;
 }
 
 /**
  * @function                   write_files_dir()
- * @brief                      Esegue l'operazione 'W'.
+ * @brief                      Esegue l'operazione 'w'. I file vengono scritti man mano che vengono visitati, in parallelo 
+ *                             su più connessioni se è stata specificata l'opzione -j.
  * 
  * @param cmdline_operation    L'operazione della linea di comando e i suoi argomenti
+ * @param sockname             Il path del socket file o tcp:host:porta
  * 
  * @return                     0 in caso di successo, in caso di fallimento ritorna -1 se si è verificato un errore che 
  *                             dovrà essere gestito terminando il processo, 1 se si è verificato un errore ma è possibile 
  *                             effettuare le eventuali operazioni successive.
  */
-static int write_files_dir(cmdline_operation_t* cmdline_operation) {
+static int write_files_dir(cmdline_operation_t* cmdline_operation, const char* sockname) {
 	if (!cmdline_operation || !cmdline_operation->dirname_in) {
 		PERRFMT("%s", "\nERR: argomenti non validi per l'opzione -w\n");
 		return 1;
@@ -253,19 +605,36 @@ static int write_files_dir(cmdline_operation_t* cmdline_operation) {
 	if (cmdline_operation->n < 0)
 		cmdline_operation->n = 0;
 
-	// inizializzo una lista in cui salvare i path dei file durante la visita della directory
-	cmdline_operation->files = list_create((int (*)(void*, void*))strcmp, free);
-	if (!cmdline_operation->files) {
-		PERRFMT("\nERR: list_create (%s)\n", strerror(errno));
-		return -1;
+	// apro la directory da visitare
+	int dir_fd = open(cmdline_operation->dirname_in, O_RDONLY | O_DIRECTORY);
+	if (dir_fd == -1) {
+		PERRFMT("\nERR: open di '%s' (%s)\n", cmdline_operation->dirname_in, strerror(errno));
+		if (errno == ENOMEM)
+			return -1;
+		return 1;
+	}
+
+	// visito la directory scrivendo i file man mano che vengono visitati
+	int ret;
+	if (cmdline_operation->jobs == 0) {
+		ret = visit_dir(dir_fd, cmdline_operation->dirname_in, cmdline_operation->n, 
+			write_visited_file, cmdline_operation->dirname_out);
+	}
+	else {
+		upload_t* upload = upload_start(sockname, cmdline_operation->jobs, cmdline_operation->dirname_out);
+		if (!upload) {
+			close(dir_fd);
+			return -1;
+		}
+		ret = visit_dir(dir_fd, cmdline_operation->dirname_in, cmdline_operation->n, upload_push, upload);
+		if (upload_finish(upload) == -1)
+			ret = -1;
 	}
-	// visito la directory salvando i path dei file incontrati
-	int ret = visit_dir(cmdline_operation->dirname_in, cmdline_operation->n, cmdline_operation->files);
 	if (ret < 0) {
 		if (ret == -1) return -1;
 		return 1;
 	}
-	return write_file_list(cmdline_operation);
+	return 0;
 }
 
 /**
@@ -284,63 +653,19 @@ static int append_file_list(cmdline_operation_t* cmdline_operation) {
 		return 1;
 	}
 
-	// apro il file il cui contenuto deve essere scritto in append
-	FILE * file = fopen(cmdline_operation->source_file, "r+");
-	if (!file) {
-		PERRFMT("\nERR: fopen di '%s' con modalità r+ (%s)\n",
-			cmdline_operation->source_file, strerror(errno));
-		if (errno == ENOMEM) return -1;
-		return 1;
-	}
-
-	void* buf = NULL;
-	size_t size = 0;
-	bool fail = false;
-
-	// leggo la dimensione del file
+	// controllo che il file il cui contenuto deve essere scritto in append sia un file regolare
 	struct stat statbuf;
 	if (stat(cmdline_operation->source_file, &statbuf) == -1) {
 		PERRFMT("\nERR: stat di '%s' (%s)\n",
 				cmdline_operation->source_file, strerror(errno));
-		fail = true; 
-	}
-	else {
-		size += statbuf.st_size;
-		// controllo se è un file regolare
-		if (!S_ISREG(statbuf.st_mode)) {
-			PERRFMT("\nERR: il file '%s' non è un file regolare\n",
-				cmdline_operation->source_file);
-			fail = true; 
-		}
-		if (!fail && size != 0) {
-			// alloco un buffer per la lettura del file
-			buf = malloc(size);
-			if (!buf) {
-				PERRFMT("\nERR: malloc per la lettura del file '%s' (%s)\n",
-					cmdline_operation->source_file, strerror(errno));
-				fail = true;
-			}
-		}
-	}
-	if (size != 0 && !fail) {
-		// leggo il file
-		if (fread(buf, 1, size, file) != size) {
-			PERRFMT("\nERR: fread di '%s' (%s)\n",
-				cmdline_operation->source_file, strerror(errno));
-			fail = true;
-		}
-	}
-	// chiudo il file
-	if (fclose(file) == -1) {
-		PERRFMT("\nERR: fclose di '%s' (%s)\n",
-			cmdline_operation->source_file, strerror(errno));
-	}
-	if (fail) {
-		if (buf)
-			free(buf);
 		if (errno == ENOMEM) return -1;
 		return 1;
 	}
+	if (!S_ISREG(statbuf.st_mode)) {
+		PERRFMT("\nERR: il file '%s' non è un file regolare\n",
+			cmdline_operation->source_file);
+		return 1;
+	}
 
 	int ret;
 	char* filepath;
@@ -364,9 +689,9 @@ static int append_file_list(cmdline_operation_t* cmdline_operation) {
 			continue;
 		}
 
-		// invoco la funzione dell'API per effettuare l'operazione di append
-		PRINT("\nappendToFile(pathname = %s)", abspath);
-		RETRY_IF_BUSY(appendToFile(abspath, buf, size, cmdline_operation->dirname_out), ret);
+		// invoco la funzione dell'API per effettuare l'operazione di append (il file viene inviato dal disco)
+		PRINT("\nappendFileToFile(pathname = %s, source = %s)", abspath, cmdline_operation->source_file);
+		RETRY_IF_BUSY(appendFileToFile(abspath, cmdline_operation->source_file, cmdline_operation->dirname_out), ret);
 		if (ret == -1 && errno != EFAULT) { 
 			if (should_exit(errno)) {
 				free(abspath);
@@ -384,8 +709,6 @@ static int append_file_list(cmdline_operation_t* cmdline_operation) {
 		}
 		free(abspath);
 	}
-	if (buf)
-		free(buf);
 	return 0;
 }
 
@@ -429,21 +752,12 @@ static int read_file_list(cmdline_operation_t* cmdline_operation) {
 			continue;
 		}
 
-		// invoco la funzione dell'API per aprire il file
+		// invoco la funzione dell'API per aprire, leggere e chiudere il file con un'unica richiesta
 		int ret;
-		PRINT("\nopenFile(pathname = %s, flags = 0)", abspath);
-		RETRY_IF_BUSY(openFile(abspath, 0), ret);
-		if (ret == -1 && errno != EALREADY) { 
-			free(abspath);
-			if (should_exit(errno)) return -1;
-			continue;
-		}
-
-		// invoco la funzione dell'API per leggere il file
 		void* buf = NULL;
 		size_t size = 0;
-		PRINT("\nreadFile(pathname = %s)", abspath);
-		RETRY_IF_BUSY(readFile(abspath, &buf, &size), ret);
+		PRINT("\nopenReadCloseFile(pathname = %s)", abspath);
+		RETRY_IF_BUSY(openReadCloseFile(abspath, &buf, &size), ret);
 		if (ret == -1) { 
 			if (should_exit(errno)) {
 				free(abspath);
@@ -491,18 +805,9 @@ static int read_file_list(cmdline_operation_t* cmdline_operation) {
 		}
 		if (buf) 
 			free(buf);
+		free(abspath);
 		if (errno == ENOMEM)
 			return -1;
-
-		// invoco la funzione dell'API per chiudere il file
-		PRINT("\ncloseFile(pathname = %s)", abspath);
-		RETRY_IF_BUSY(closeFile(abspath), ret);
-		if (ret == -1) {
-			free(abspath);
-			if (should_exit(errno)) return -1;
-			continue;
-		}
-		free(abspath);
 	}
 	return 0;
 }
@@ -532,8 +837,24 @@ int read_n_files(cmdline_operation_t* cmdline_operation) {
 		}
 	}
 
-	// invoco la funzione dell'API per effettuare la readn
 	int ret;
+	if (cmdline_operation->n <= 0) {
+		/* leggo tutti i file del server in batch di al più READN_BATCH_BYTES bytes, in modo da non occupare il server 
+		   e la connessione con un'unica risposta */
+		size_t cursor = 0;
+		do {
+			PRINT("\nreadNFilesCursor(cursor = %zu, max_bytes = %d)", cursor, READN_BATCH_BYTES);
+			RETRY_IF_BUSY(readNFilesCursor(&cursor, 0, READN_BATCH_BYTES, cmdline_operation->dirname_out), ret);
+			if (ret == -1) { 
+				if (should_exit(errno)) return -1;
+				return 1;
+			}
+			PRINT(" (%d file ricevuti)", ret);
+		} while (cursor != 0);
+		return 0;
+	}
+
+	// invoco la funzione dell'API per effettuare la readn
 	PRINT("\nreadNFiles(N = %d)", cmdline_operation->n);
 	RETRY_IF_BUSY(readNFiles(cmdline_operation->n, cmdline_operation->dirname_out), ret);
 	if (ret == -1) { 
@@ -710,8 +1031,9 @@ int main(int argc, char* argv[]) {
 
 	// effettuo il parsing degli argomenti della linea di comando
 	char* sockname = NULL;
+	long rate = 0;
 	list_t* cmdline_operation_list = NULL;
-	cmdline_operation_list = cmdline_parser(argc, argv, &sockname);
+	cmdline_operation_list = cmdline_parser(argc, argv, &sockname, &rate);
 	if (!cmdline_operation_list) {
 		if (errno != 0)
 			extval = EXIT_FAILURE;
@@ -731,6 +1053,12 @@ int main(int argc, char* argv[]) {
 		printf("============= OPERAZIONI RICHIESTE =============\n");
 		printf("-f %s\n", sockname);
 		printf("-p\n");
+		if (is_compression_enable())
+			printf("-z\n");
+		if (is_checksum_enable())
+			printf("-k\n");
+		if (rate > 0)
+			printf("-O %ld\n", rate);
 		list_for_each(cmdline_operation_list, cmdline_operation) {
 			cmdline_operation_print(cmdline_operation);
 		}
@@ -768,14 +1096,21 @@ int main(int argc, char* argv[]) {
 		goto exit;
 	}
 
+	// se è stata specificata l'opzione -O il primo gettone viene generato prima di iniziare le operazioni
+	if (rate > 0) {
+		pacer.interval = 1000000.0 / rate;
+		pacer.start = now_usec();
+		pacer.next = pacer.start;
+	}
+
 	// itero sulle operazioni specificate dalla linea di comando e le eseguo
 	list_for_each(cmdline_operation_list, cmdline_operation) {
 		switch (cmdline_operation->operation) {
 			case 'w':
-				r = write_files_dir(cmdline_operation);
+				r = write_files_dir(cmdline_operation, sockname);
 				break;
 			case 'W':
-				r = write_file_list(cmdline_operation);
+				r = write_file_list(cmdline_operation, sockname);
 				break;
 			case 'a':
 				r = append_file_list(cmdline_operation);
@@ -807,6 +1142,14 @@ int main(int argc, char* argv[]) {
 		errno = 0;
 	}
 	
+	// stampo le latenze delle richieste inviate a ciclo aperto
+	if (rate > 0) {
+		double elapsed = (now_usec() - pacer.start) / 1000000.0;
+		printf("\n============= RICHIESTE A CICLO APERTO (%ld op/s) =============\n", rate);
+		hist_print_header();
+		hist_print_row("request", &pacer.hist, elapsed);
+	}
+
 	// invoco la funzione dell'API per la chiusura della connessione con il server
 	r = closeConnection(sockname);
 	PRINT("\ncloseConnection(sockname = %s) : %s\n",
@@ -5,27 +5,155 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/sendfile.h>
+#include <poll.h>
+#include <pthread.h>
 
 #include <client_api.h>
 #include <protocol.h>
 #include <filesys_util.h>
+#include <lz.h>
+#include <crc32c.h>
+#include <hasht.h>
 #include <util.h>
 
-/* File descriptor associato al socket */
-static int g_socket_fd = -1;
-/* Path del socket file */
-static char g_sockname[UNIX_PATH_MAX];
 /* Flag che indica se le stampe sullo stdout sono abilitate */
 static bool print_enable = false;
+/* Chiave del buffer in cui vengono accumulate le stampe di un thread (@c NULL se le stampe non vengono accumulate) */
+static pthread_key_t print_buffer_key;
+/* Controllo per la creazione della chiave del buffer delle stampe */
+static pthread_once_t print_buffer_once = PTHREAD_ONCE_INIT;
+/* Esito della creazione della chiave del buffer delle stampe */
+static int print_buffer_key_err = 0;
+/* Flag che indica se la compressione deve essere richiesta all'apertura di una connessione */
+static bool compression_enable = false;
+/* Flag che indica se la verifica del checksum deve essere richiesta all'apertura di una connessione */
+static bool checksum_enable = false;
+/* Numero massimo di bytes dei file memorizzati nella cache di una connessione (0 se la cache non è abilitata) */
+static size_t cache_max_bytes = 0;
+/* Numero di bucket della tabella hash della cache dei file letti di una connessione */
+#define CACHE_BUCKETS 256
+/* Dimensione dei blocchi con cui il contenuto di un file viene letto dal disco e inviato al server 
+   (coincide con quella dei blocchi compressi, in modo che ogni blocco letto sia compresso separatamente) */
+#define WRITE_CHUNK_SIZE COMPRESSION_BLOCK_SIZE
+/* Dimensione dei blocchi con cui il contenuto dei file ricevuti dal server viene scritto su disco (coincide con quella 
+   dei blocchi compressi, in modo che ogni blocco ricevuto sia decompresso separatamente) */
+#define READ_CHUNK_SIZE COMPRESSION_BLOCK_SIZE
+
+/**
+ * @struct                 pending_request_t
+ * @brief                  Struttura che rappresenta una richiesta inviata in pipeline in attesa di risposta.
+ *
+ * @var id                 Identificativo della richiesta (NO_REQ_ID se la posizione è libera)
+ * @var code               Codice della richiesta
+ * @var callback           Funzione da invocare al completamento della richiesta (@c NULL se inviata con send*())
+ * @var arg                Argomento da passare a callback
+ * @var dirname            Directory in cui memorizzare i file espulsi dal server in seguito a una richiesta WRITE o 
+ *                         APPEND (@c NULL se i file espulsi devono essere scartati)
+ */
+typedef struct pending_request {
+	int id;
+	request_code_t code;
+	fss_callback_t callback;
+	void* arg;
+	char* dirname;
+} pending_request_t;
+
+/**
+ * @struct                 print_buffer_t
+ * @brief                  Struttura che rappresenta il buffer in cui vengono accumulate le stampe di un thread.
+ *
+ * @var data               Stampe accumulate
+ * @var len                Numero di caratteri accumulati
+ * @var capacity           Dimensione di data
+ */
+typedef struct print_buffer {
+	char* data;
+	size_t len;
+	size_t capacity;
+} print_buffer_t;
+
+/**
+ * @struct                 cache_entry_t
+ * @brief                  Struttura che rappresenta un file memorizzato nella cache dei file letti di una connessione.
+ *
+ * @var pathname           Path del file
+ * @var content            Contenuto del file
+ * @var size               Dimensione del contenuto del file
+ * @var version            Versione del file
+ * @var readable           Flag che indica se il file può essere letto dalla cache senza contattare il server: il file 
+ *                         è stato letto dal server dopo essere stato aperto, non è stato chiuso e da allora non è stata 
+ *                         ricevuta una notifica di invalidazione per il file
+ * @var prev               File utilizzato più recentemente (@c NULL se è il primo della lista)
+ * @var next               File utilizzato meno recentemente (@c NULL se è l'ultimo della lista)
+ */
+typedef struct cache_entry {
+	char* pathname;
+	void* content;
+	size_t size;
+	size_t version;
+	bool readable;
+	struct cache_entry* prev;
+	struct cache_entry* next;
+} cache_entry_t;
+
+/**
+ * @struct                 fss_conn
+ * @brief                  Struttura che rappresenta una connessione con il server.
+ *
+ * @var fd                 File descriptor associato al socket (-1 se la connessione è stata chiusa a seguito di un 
+ *                         errore)
+ * @var sockname           Path del socket file o tcp:host:porta
+ * @var tcp                Flag che indica se la connessione è una connessione TCP
+ * @var corked             Flag che indica se sulla connessione TCP è abilitato TCP_CORK (una richiesta è in corso di 
+ *                         invio)
+ * @var compression        Flag che indica se la connessione usa la compressione del contenuto dei file
+ * @var checksum           Flag che indica se sulla connessione il server invia il checksum dei file letti
+ * @var invalidation       Flag che indica se sulla connessione il server invia le notifiche di invalidazione dei file 
+ *                         letti (e quindi se la cache dei file letti è in uso)
+ * @var cache              Tabella hash della cache dei file letti, con chiave il path del file (@c NULL se la cache non 
+ *                         è abilitata)
+ * @var cache_head         File in cache utilizzato più recentemente
+ * @var cache_tail         File in cache utilizzato meno recentemente
+ * @var cache_bytes        Dimensione complessiva dei file in cache
+ * @var next_req_id        Identificativo da assegnare alla prossima richiesta
+ * @var pending            Richieste inviate in pipeline in attesa di risposta
+ * @var pending_num        Numero di richieste inviate in pipeline in attesa di risposta
+ * @var mutex              Mutex per l'utilizzo in mutua esclusione della connessione
+ */
+struct fss_conn {
+	int fd;
+	char sockname[UNIX_PATH_MAX];
+	bool tcp;
+	bool corked;
+	bool compression;
+	bool checksum;
+	bool invalidation;
+	hasht_t* cache;
+	cache_entry_t* cache_head;
+	cache_entry_t* cache_tail;
+	size_t cache_bytes;
+	int next_req_id;
+	pending_request_t pending[MAX_PENDING_REQUESTS];
+	int pending_num;
+	pthread_mutex_t mutex;
+};
+
+/* Connessione di default, utilizzata dalle funzioni dell'api senza handle */
+static fss_conn_t* g_conn = NULL;
 
 char* errno_to_str(int err) {
 	switch (err) {
@@ -63,6 +191,16 @@ char* errno_to_str(int err) {
 			return "Connessione già effettuata";
 		case EFAULT:
 			return "Non tutti i file ricevuti sono stati scritti su disco";
+		case EINPROGRESS:
+			return "Richieste in attesa di risposta";
+		case EAGAIN:
+			return "Troppe richieste in attesa di risposta";
+		case ENOMSG:
+			return "Nessuna richiesta in attesa di risposta";
+		case ERANGE:
+			return "Offset oltre la fine del file";
+		case EBADMSG:
+			return "Checksum del file non valido";
 		case 0:
 			return "OK";
 		default:
@@ -107,6 +245,10 @@ static void set_errno(response_code_t code) {
 		case TEMPORARILY_UNAVAILABLE:
 			errno = EBUSY;
 			break;
+		case INVALID_OFFSET:
+			errno = ERANGE;
+			break;
+		case NOT_MODIFIED: // non è un errore, viene gestito da chi ha effettuato la richiesta
 		case OK:
 			errno = 0;
 			break;
@@ -115,19 +257,261 @@ static void set_errno(response_code_t code) {
 	}
 }
 
+/**
+ * @function               cache_unlink()
+ * @brief                  Rimuove entry dalla lista dei file in cache della connessione conn.
+ * 
+ * @param conn             Connessione con il server
+ * @param entry            File in cache da rimuovere dalla lista
+ */
+static void cache_unlink(fss_conn_t* conn, cache_entry_t* entry) {
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		conn->cache_head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		conn->cache_tail = entry->prev;
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+/**
+ * @function               cache_push_front()
+ * @brief                  Inserisce entry in testa alla lista dei file in cache della connessione conn.
+ * 
+ * @param conn             Connessione con il server
+ * @param entry            File in cache da inserire nella lista
+ */
+static void cache_push_front(fss_conn_t* conn, cache_entry_t* entry) {
+	entry->prev = NULL;
+	entry->next = conn->cache_head;
+	if (conn->cache_head)
+		conn->cache_head->prev = entry;
+	else
+		conn->cache_tail = entry;
+	conn->cache_head = entry;
+}
+
+/**
+ * @function               free_cache_entry()
+ * @brief                  Dealloca un file in cache.
+ * 
+ * @param entry            File in cache da deallocare
+ */
+static void free_cache_entry(cache_entry_t* entry) {
+	if (entry->content)
+		free(entry->content);
+	free(entry->pathname);
+	free(entry);
+}
+
+/**
+ * @function               cache_get()
+ * @brief                  Cerca il file pathname nella cache della connessione conn e, se presente, lo segna come 
+ *                         utilizzato più recentemente.
+ * 
+ * @param conn             Connessione con il server
+ * @param pathname         Path del file da cercare
+ * 
+ * @return                 Il file in cache, @c NULL se non è presente.
+ */
+static cache_entry_t* cache_get(fss_conn_t* conn, const char* pathname) {
+	cache_entry_t* entry = hasht_get_value(conn->cache, (void*) pathname);
+	if (entry && entry != conn->cache_head) {
+		cache_unlink(conn, entry);
+		cache_push_front(conn, entry);
+	}
+	return entry;
+}
+
+/**
+ * @function               cache_remove()
+ * @brief                  Rimuove, se presente, il file pathname dalla cache della connessione conn.
+ * 
+ * @param conn             Connessione con il server
+ * @param pathname         Path del file da rimuovere
+ */
+static void cache_remove(fss_conn_t* conn, const char* pathname) {
+	cache_entry_t* entry = hasht_delete_and_get(conn->cache, (void*) pathname, NULL);
+	if (!entry)
+		return;
+	cache_unlink(conn, entry);
+	conn->cache_bytes -= entry->size;
+	free_cache_entry(entry);
+}
+
+/**
+ * @function               cache_put()
+ * @brief                  Memorizza una copia del contenuto del file pathname nella cache della connessione conn, 
+ *                         rimuovendo i file utilizzati meno recentemente se necessario. Se il file è più grande della 
+ *                         cache o non è possibile allocarne la copia il file non viene memorizzato (la cache è solo 
+ *                         un'ottimizzazione, il fallimento non viene segnalato).
+ * 
+ * @param conn             Connessione con il server
+ * @param pathname         Path del file
+ * @param content          Contenuto del file
+ * @param size             Dimensione del contenuto del file
+ * @param version          Versione del file
+ * 
+ * @return                 Il file in cache, @c NULL se il file non è stato memorizzato.
+ */
+static cache_entry_t* cache_put(fss_conn_t* conn, const char* pathname, void* content, size_t size, size_t version) {
+	cache_remove(conn, pathname);
+	if (size > cache_max_bytes)
+		return NULL;
+	// rimuovo i file utilizzati meno recentemente finchè non c'è spazio per il nuovo file
+	while (conn->cache_tail && conn->cache_bytes + size > cache_max_bytes)
+		cache_remove(conn, conn->cache_tail->pathname);
+
+	cache_entry_t* entry = calloc(1, sizeof(cache_entry_t));
+	if (!entry)
+		return NULL;
+	entry->pathname = malloc(strlen(pathname) + 1);
+	if (size != 0)
+		entry->content = malloc(size);
+	if (!entry->pathname || (size != 0 && !entry->content)) {
+		if (entry->pathname)
+			free(entry->pathname);
+		if (entry->content)
+			free(entry->content);
+		free(entry);
+		return NULL;
+	}
+	strcpy(entry->pathname, pathname);
+	if (size != 0)
+		memcpy(entry->content, content, size);
+	entry->size = size;
+	entry->version = version;
+	if (hasht_insert(conn->cache, entry->pathname, entry) == -1) {
+		free_cache_entry(entry);
+		return NULL;
+	}
+	cache_push_front(conn, entry);
+	conn->cache_bytes += size;
+	return entry;
+}
+
+/**
+ * @function               cache_unreadable()
+ * @brief                  Impedisce, se presente nella cache della connessione conn, che il file pathname venga letto 
+ *                         dalla cache senza contattare il server. Il contenuto in cache rimane utilizzabile per le 
+ *                         letture condizionali, per cui il server verifica che la versione sia ancora quella corrente.
+ * 
+ * @param conn             Connessione con il server
+ * @param pathname         Path del file
+ */
+static void cache_unreadable(fss_conn_t* conn, const char* pathname) {
+	if (!conn->cache)
+		return;
+	cache_entry_t* entry = hasht_get_value(conn->cache, (void*) pathname);
+	if (entry)
+		entry->readable = false;
+}
+
+/**
+ * @function               cache_read()
+ * @brief                  Memorizza in buf una copia del contenuto del file in cache entry e in size la sua dimensione.
+ * 
+ * @param entry            File in cache
+ * @param buf              Il buffer in cui memorizzare il contenuto del file
+ * @param size             La size del buffer buf
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato a ECOMM.
+ */
+static int cache_read(cache_entry_t* entry, void** buf, size_t* size) {
+	*buf = NULL;
+	*size = 0;
+	if (entry->size != 0) {
+		*buf = malloc(entry->size);
+		if (!*buf) {
+			errno = ECOMM;
+			return -1;
+		}
+		memcpy(*buf, entry->content, entry->size);
+	}
+	*size = entry->size;
+	return 0;
+}
+
+
+/**
+ * @function               cache_destroy()
+ * @brief                  Dealloca la cache dei file letti della connessione conn.
+ * 
+ * @param conn             Connessione con il server
+ */
+static void cache_destroy(fss_conn_t* conn) {
+	if (!conn->cache)
+		return;
+	cache_entry_t* entry = conn->cache_head;
+	while (entry) {
+		cache_entry_t* next = entry->next;
+		free_cache_entry(entry);
+		entry = next;
+	}
+	hasht_destroy(conn->cache, NULL, NULL);
+	conn->cache = NULL;
+	conn->cache_head = NULL;
+	conn->cache_tail = NULL;
+	conn->cache_bytes = 0;
+}
+
+/**
+ * @function               new_request_id()
+ * @brief                  Restituisce un nuovo identificativo di richiesta.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 L'identificativo (> 0) da associare alla prossima richiesta.
+ */
+static int new_request_id(fss_conn_t* conn) {
+	int req_id = conn->next_req_id;
+	conn->next_req_id = (conn->next_req_id == INT_MAX) ? 1 : conn->next_req_id + 1;
+	return req_id;
+}
+
+/**
+ * @function               set_cork()
+ * @brief                  Se la connessione è TCP abilita (cork = true) o disabilita (cork = false) TCP_CORK, in modo 
+ *                         che le parti di una richiesta vengano accumulate e trasmesse in segmenti pieni (alla 
+ *                         disabilitazione i dati accumulati vengono trasmessi immediatamente).
+ * 
+ * @param conn             Connessione con il server
+ * @param cork             true per abilitare TCP_CORK, false per disabilitarlo
+ */
+static void set_cork(fss_conn_t* conn, bool cork) {
+#ifdef TCP_CORK
+	if (!conn->tcp || conn->corked == cork)
+		return;
+	int on = cork;
+	// in caso di fallimento le parti della richiesta vengono semplicemente trasmesse separatamente
+	if (setsockopt(conn->fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(int)) == 0)
+		conn->corked = cork;
+#endif
+}
+
 /**
  * @function               send_reqcode()
- * @brief                  Invia al server il codice di richiesta code.
+ * @brief                  Invia al server l'identificativo di richiesta req_id e il codice di richiesta code.
  * 
+ * @param conn             Connessione con il server
+ * @param req_id           L'identificativo della richiesta
  * @param code             Il codice di richiesta da inviare al server
  * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
  *                         In caso di fallimento errno può assumere i seguenti valori:
  *                         ECOMM       se si è verificato un errore lato client durante la scrittura sulla socket
  *                         ECONNRESET  se il server ha chiuso la connessione
  */
-static int send_reqcode(request_code_t code) {
+static int send_reqcode(fss_conn_t* conn, int req_id, request_code_t code) {
 	int r;
-	r = writen(g_socket_fd, &code, sizeof(request_code_t));
+	// le parti della richiesta vengono trasmesse alla ricezione della risposta o al termine dell'invio
+	set_cork(conn, true);
+	r = writen(conn->fd, &req_id, sizeof(int));
+	// in caso di successo invio il codice di richiesta
+	if (r != -1 && r != 0)
+		r = writen(conn->fd, &code, sizeof(request_code_t));
 	if (r == -1 || r == 0) {
 		if (errno == EPIPE)
 			errno = ECONNRESET;
@@ -142,20 +526,21 @@ static int send_reqcode(request_code_t code) {
  * @function               send_pathname()
  * @brief                  Invia al server il path di un file.
  * 
+ * @param conn             Connessione con il server
  * @param pathname         Path del file da inviare al server
  * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
  *                         In caso di fallimento errno può assumere i seguenti valori:
  *                         ECOMM         se si è verificato un errore lato client durante la scrittura sulla socket
  *                         ECONNRESET    se il server ha chiuso la connessione
  */
-static int send_pathname(const char* pathname) {
+static int send_pathname(fss_conn_t* conn, const char* pathname) {
 	size_t pathname_len = strlen(pathname) + 1;
 	int r;
 	// invio al server la dimensione del path del file
-	r = writen(g_socket_fd, &pathname_len, sizeof(size_t));
+	r = writen(conn->fd, &pathname_len, sizeof(size_t));
 	// in caso di successo invio il path del file
 	if (r != -1 && r != 0) {
-		r = writen(g_socket_fd, (void*)pathname, pathname_len*sizeof(char));
+		r = writen(conn->fd, (void*)pathname, pathname_len*sizeof(char));
 	}
 	if (r == -1 || r == 0) {
 		if (errno == EPIPE)
@@ -167,10 +552,43 @@ static int send_pathname(const char* pathname) {
 	return 0;
 }
 
+/**
+ * @function               send_content_chunk()
+ * @brief                  Scrive sulla socket chunk_size bytes del contenuto di un file. Se la connessione usa la 
+ *                         compressione il blocco (di al più COMPRESSION_BLOCK_SIZE bytes) viene compresso, se questo ne 
+ *                         riduce la dimensione, e preceduto dalla dimensione con cui è trasmesso.
+ * 
+ * @param conn             Connessione con il server
+ * @param chunk            Bytes da scrivere
+ * @param chunk_size       Numero di bytes da scrivere
+ * @param block            Buffer di COMPRESSION_BLOCK_SIZE bytes per il blocco compresso (non usato se la connessione 
+ *                         non usa la compressione)
+ * 
+ * @return                 Il valore ritornato dall'ultima writen() effettuata.
+ */
+static int send_content_chunk(fss_conn_t* conn, void* chunk, size_t chunk_size, void* block) {
+	if (!conn->compression)
+		return writen(conn->fd, chunk, chunk_size);
+
+	// comprimo il blocco solo se ne riduce la dimensione
+	size_t block_size = 0;
+	if (chunk_size >= COMPRESSION_MIN_SIZE)
+		block_size = lz_compress(chunk, chunk_size, block, chunk_size - 1);
+	void* data = block_size != 0 ? block : chunk;
+	if (block_size == 0)
+		block_size = chunk_size;
+
+	int r = writen(conn->fd, &block_size, sizeof(size_t));
+	if (r == -1 || r == 0)
+		return r;
+	return writen(conn->fd, data, block_size);
+}
+
 /**
  * @function               send_file_content()
  * @brief                  Invia al server il contenuto di un file.
  * 
+ * @param conn             Connessione con il server
  * @param buf              Contenuto del file da inviare
  * @param size             Dimensione del contenuto del file
  * 
@@ -179,14 +597,158 @@ static int send_pathname(const char* pathname) {
  *                         ECOMM        se si è verificato un errore lato client durante la scrittura sulla socket
  *                         ECONNRESET   se il server ha chiuso la connessione
  */
-static int send_file_content(void* buf, size_t size) {
+static int send_file_content(fss_conn_t* conn, void* buf, size_t size) {
+	int r;
+	// alloco, se la connessione usa la compressione, il buffer per i blocchi compressi
+	void* block = NULL;
+	if (conn->compression && size != 0) {
+		block = malloc(COMPRESSION_BLOCK_SIZE);
+		if (!block) {
+			errno = ECOMM;
+			return -1;
+		}
+	}
+
+	// invio al server la dimensione del contenuto del file
+	r = writen(conn->fd, &size, sizeof(size_t));
+	// in caso di successo invio il contenuto del file (in blocchi se la connessione usa la compressione)
+	size_t sent = 0;
+	while (r != -1 && r != 0 && sent < size) {
+		size_t chunk_size = size - sent;
+		if (conn->compression && chunk_size > COMPRESSION_BLOCK_SIZE)
+			chunk_size = COMPRESSION_BLOCK_SIZE;
+		r = send_content_chunk(conn, (char*) buf + sent, chunk_size, block);
+		sent += chunk_size;
+	}
+	if (block)
+		free(block);
+	if (r == -1 || r == 0) {
+		if (errno == EPIPE)
+			errno = ECONNRESET;
+		else
+			errno = ECOMM;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function               send_file_sendfile()
+ * @brief                  Invia al server la dimensione size e il contenuto del file regolare file con sendfile(), 
+ *                         senza copiarlo in un buffer. Se il file viene troncato durante l'invio, non essendo possibile 
+ *                         inviare al server i bytes annunciati, la connessione viene chiusa.
+ * 
+ * @param conn             Connessione con il server (che non deve usare la compressione)
+ * @param file             File da inviare
+ * @param size             Dimensione del file
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         ECOMM        se si è verificato un errore lato client durante la lettura del file o la 
+ *                                      scrittura sulla socket
+ *                         ECONNRESET   se il server ha chiuso la connessione
+ */
+static int send_file_sendfile(fss_conn_t* conn, FILE* file, size_t size) {
+	// invio al server la dimensione del contenuto del file
+	int r = writen(conn->fd, &size, sizeof(size_t));
+	if (r == -1 || r == 0) {
+		if (errno == EPIPE)
+			errno = ECONNRESET;
+		else
+			errno = ECOMM;
+		return -1;
+	}
+
+	// invio il contenuto del file a partire dalla posizione corrente
+	off_t offset = ftello(file);
+	size_t sent = 0;
+	while (offset != -1 && sent < size) {
+		ssize_t n = sendfile(conn->fd, fileno(file), &offset, size - sent);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1 && errno == EPIPE) {
+			errno = ECONNRESET;
+			return -1;
+		}
+		if (n <= 0)
+			break;
+		sent += n;
+	}
+	if (sent < size) {
+		// il file è stato troncato o non può essere letto, il server attende dei bytes che non possono essere inviati
+		close(conn->fd);
+		conn->fd = -1;
+		errno = ECOMM;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function               send_file_stream()
+ * @brief                  Invia al server la dimensione size e il contenuto del file file. Se la connessione non usa la 
+ *                         compressione e il file è regolare il contenuto viene inviato con send_file_sendfile(), 
+ *                         altrimenti viene letto dal disco e inviato a blocchi di WRITE_CHUNK_SIZE bytes. In entrambi i 
+ *                         casi l'intero file non viene caricato in memoria.
+ *                         Se la lettura del file fallisce dopo aver iniziato l'invio, non essendo possibile inviare al 
+ *                         server i bytes annunciati, la connessione viene chiusa.
+ * 
+ * @param conn             Connessione con il server
+ * @param file             File da inviare
+ * @param size             Dimensione del file
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         ECOMM        se si è verificato un errore lato client durante la lettura del file o la 
+ *                                      scrittura sulla socket
+ *                         ECONNRESET   se il server ha chiuso la connessione
+ */
+static int send_file_stream(fss_conn_t* conn, FILE* file, size_t size) {
 	int r;
+	struct stat statbuf;
+	if (!conn->compression && size != 0 && fstat(fileno(file), &statbuf) == 0 && S_ISREG(statbuf.st_mode))
+		return send_file_sendfile(conn, file, size);
+
+	// alloco il buffer per un blocco e, se la connessione usa la compressione, quello per il blocco compresso
+	void* chunk = NULL;
+	void* block = NULL;
+	if (size != 0) {
+		chunk = malloc(size < WRITE_CHUNK_SIZE ? size : WRITE_CHUNK_SIZE);
+		if (conn->compression)
+			block = malloc(COMPRESSION_BLOCK_SIZE);
+		if (!chunk || (conn->compression && !block)) {
+			if (chunk)
+				free(chunk);
+			if (block)
+				free(block);
+			errno = ECOMM;
+			return -1;
+		}
+	}
+
 	// invio al server la dimensione del contenuto del file
-	r = writen(g_socket_fd, &size, sizeof(size_t));
-	// in caso di successo invio il contenuto del file
-	if (r != -1 && r != 0 && size != 0) {
-		r = writen(g_socket_fd, buf, size);
+	r = writen(conn->fd, &size, sizeof(size_t));
+	// in caso di successo invio il contenuto del file a blocchi
+	size_t sent = 0;
+	while (r != -1 && r != 0 && sent < size) {
+		size_t chunk_size = (size - sent < WRITE_CHUNK_SIZE) ? size - sent : WRITE_CHUNK_SIZE;
+		if (fread(chunk, 1, chunk_size, file) != chunk_size) {
+			// il server attende dei bytes che non possono essere inviati, chiudo la connessione
+			free(chunk);
+			if (block)
+				free(block);
+			close(conn->fd);
+			conn->fd = -1;
+			errno = ECOMM;
+			return -1;
+		}
+		r = send_content_chunk(conn, chunk, chunk_size, block);
+		sent += chunk_size;
 	}
+	if (chunk)
+		free(chunk);
+	if (block)
+		free(block);
 	if (r == -1 || r == 0) {
 		if (errno == EPIPE)
 			errno = ECONNRESET;
@@ -201,6 +763,7 @@ static int send_file_content(void* buf, size_t size) {
  * @function               send_N()
  * @brief                  Invia al server il valore del parametro N.
  * 
+ * @param conn             Connessione con il server
  * @param N                Intero da inviare al server
  * 
  * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
@@ -208,9 +771,9 @@ static int send_file_content(void* buf, size_t size) {
  *                         ECOMM        se si è verificato un errore lato client durante la scrittura sulla socket
  *                         ECONNRESET   se il server ha chiuso la connessione
  */
-static int send_N(int N) {
+static int send_N(fss_conn_t* conn, int N) {
 	int r;
-	r = writen(g_socket_fd, &N, sizeof(int));
+	r = writen(conn->fd, &N, sizeof(int));
 	if (r == -1 || r == 0) {
 		if (errno == EPIPE)
 			errno = ECONNRESET;
@@ -222,19 +785,56 @@ static int send_N(int N) {
 }
 
 /**
- * @function               receive_respcode()
- * @brief                  Riceve dal server il codice di risposta.
+ * @function               send_size()
+ * @brief                  Invia al server il valore size (offset o numero di bytes).
  * 
- * @param code             Codice di risposta ricevuto
+ * @param conn             Connessione con il server
+ * @param size             Valore da inviare al server
  * 
  * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
  *                         In caso di fallimento errno può assumere i seguenti valori:
  *                         ECOMM        se si è verificato un errore lato client durante la scrittura sulla socket
  *                         ECONNRESET   se il server ha chiuso la connessione
  */
-static int receive_respcode(response_code_t* code) {
+static int send_size(fss_conn_t* conn, size_t size) {
+	int r;
+	r = writen(conn->fd, &size, sizeof(size_t));
+	if (r == -1 || r == 0) {
+		if (errno == EPIPE)
+			errno = ECONNRESET;
+		else
+			errno = ECOMM;
+		return -1;
+	} 
+	return 0;
+}
+
+/**
+ * @function               receive_invalidation()
+ * @brief                  Riceve dal server il path del file di una notifica di invalidazione (di cui sono già stati 
+ *                         ricevuti identificativo e codice) e impedisce che il file venga letto dalla cache senza 
+ *                         contattare il server.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         ECOMM        se si è verificato un errore lato client durante la lettura dalla socket
+ *                         ECONNRESET   se il server ha chiuso la connessione
+ *                         EPROTO       se il path ricevuto non è valido
+ */
+static int receive_invalidation(fss_conn_t* conn) {
 	int r;
-	r = readn(g_socket_fd, code, sizeof(response_code_t));
+	size_t pathname_len;
+	char pathname[PATH_MAX];
+	r = readn(conn->fd, &pathname_len, sizeof(size_t));
+	if (r != -1 && r != 0) {
+		if (pathname_len == 0 || pathname_len > PATH_MAX) {
+			errno = EPROTO;
+			return -1;
+		}
+		r = readn(conn->fd, pathname, pathname_len);
+	}
 	if (r == 0) {
 		errno = ECONNRESET;
 		return -1;
@@ -244,13 +844,107 @@ static int receive_respcode(response_code_t* code) {
 			errno = ECOMM;
 		return -1;
 	}
+	if (pathname[pathname_len-1] != '\0') {
+		errno = EPROTO;
+		return -1;
+	}
+	cache_unreadable(conn, pathname);
 	return 0;
 }
 
+/**
+ * @function               receive_invalidations()
+ * @brief                  Riceve, senza bloccarsi, le notifiche di invalidazione già disponibili sulla socket.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 0 se non ci sono altri dati da ricevere, 1 se sulla socket ci sono dati che non sono una 
+ *                         notifica di invalidazione completa (una risposta, parte di una notifica o la chiusura della 
+ *                         connessione), -1 in caso di fallimento con errno settato ad indicare l'errore (come in 
+ *                         receive_invalidation()).
+ */
+static int receive_invalidations(fss_conn_t* conn) {
+	char header[sizeof(int) + sizeof(response_code_t)];
+	while (true) {
+		// esamino l'intestazione della prossima risposta senza consumarla
+		ssize_t r = recv(conn->fd, header, sizeof(header), MSG_PEEK | MSG_DONTWAIT);
+		if (r == -1 && errno == EINTR)
+			continue;
+		if (r == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return 0;
+		if (r == -1) {
+			if (errno != ECONNRESET)
+				errno = ECOMM;
+			return -1;
+		}
+		if ((size_t) r < sizeof(header))
+			return 1;
+		int req_id;
+		response_code_t code;
+		memcpy(&req_id, header, sizeof(int));
+		memcpy(&code, header + sizeof(int), sizeof(response_code_t));
+		if (req_id != NO_REQ_ID || code != INVALIDATED)
+			return 1;
+		// consumo l'intestazione e ricevo la notifica (inviata dal server con una sola scrittura)
+		r = readn(conn->fd, header, sizeof(header));
+		if (r == 0) {
+			errno = ECONNRESET;
+			return -1;
+		}
+		else if (r == -1) {
+			if (errno != ECONNRESET)
+				errno = ECOMM;
+			return -1;
+		}
+		if (receive_invalidation(conn) == -1)
+			return -1;
+	}
+}
+
+/**
+ * @function               receive_respcode()
+ * @brief                  Riceve dal server l'identificativo della richiesta a cui si riferisce la risposta e il codice 
+ *                         di risposta, gestendo le notifiche di invalidazione che la precedono.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_id           Identificativo della richiesta ricevuto
+ * @param code             Codice di risposta ricevuto
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         ECOMM        se si è verificato un errore lato client durante la scrittura sulla socket
+ *                         ECONNRESET   se il server ha chiuso la connessione
+ */
+static int receive_respcode(fss_conn_t* conn, int* req_id, response_code_t* code) {
+	int r;
+	set_cork(conn, false);
+	while (true) {
+		r = readn(conn->fd, req_id, sizeof(int));
+		// in caso di successo ricevo il codice di risposta
+		if (r != -1 && r != 0)
+			r = readn(conn->fd, code, sizeof(response_code_t));
+		if (r == 0) {
+			errno = ECONNRESET;
+			return -1;
+		}
+		else if (r == -1) {
+			if (errno != ECONNRESET)
+				errno = ECOMM;
+			return -1;
+		}
+		if (!conn->invalidation || *req_id != NO_REQ_ID || *code != INVALIDATED)
+			return 0;
+		// ricevo la notifica di invalidazione e attendo la risposta
+		if (receive_invalidation(conn) == -1)
+			return -1;
+	}
+}
+
 /**
  * @function               receive_size()
  * @brief                  Riceve dal server il valore di un size_t.
  * 
+ * @param conn             Connessione con il server
  * @param size             size_t ricevuto
  * 
  * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
@@ -258,9 +952,9 @@ static int receive_respcode(response_code_t* code) {
  *                         ECOMM         se si è verificato un errore lato client durante la scrittura sulla socket
  *                         ECONNRESET    se il server ha chiuso la connessione
  */
-static int receive_size(size_t* size) {
+static int receive_size(fss_conn_t* conn, size_t* size) {
 	int r;
-	r = readn(g_socket_fd, size, sizeof(size_t));
+	r = readn(conn->fd, size, sizeof(size_t));
 	if (r == 0) {
 		errno = ECONNRESET;
 		return -1;
@@ -277,6 +971,7 @@ static int receive_size(size_t* size) {
  * @function               receive_pathname()
  * @brief                  Riceve dal server il path di un file.
  * 
+ * @param conn             Connessione con il server
  * @param pathname         Path ricevuto
  * @param size             Dimensione del path ricevuto
  * 
@@ -287,10 +982,10 @@ static int receive_size(size_t* size) {
  *                         ECONNRESET    se il server ha chiuso la connessione
  *                         EPROTO        se si è verificato un errore di protocollo
  */
-static int receive_pathname(char** pathname, size_t* size) {
+static int receive_pathname(fss_conn_t* conn, char** pathname, size_t* size) {
 	int r;
 	// ricevo dal server la dimensione del path del file
-	if (receive_size(size) == -1)
+	if (receive_size(conn, size) == -1)
 		return -1;
 	
 	if (*size == 0) {
@@ -307,7 +1002,7 @@ static int receive_pathname(char** pathname, size_t* size) {
 	} 
 
 	// leggo il path del file
-	r = readn(g_socket_fd, *pathname, (*size)*sizeof(char));
+	r = readn(conn->fd, *pathname, (*size)*sizeof(char));
 	if (r == 0) {
 		free(*pathname);
 		errno = ECONNRESET;
@@ -322,10 +1017,64 @@ static int receive_pathname(char** pathname, size_t* size) {
 	return 0;
 }
 
+/**
+ * @function               receive_compressed_content()
+ * @brief                  Legge dalla socket, in blocchi eventualmente compressi, size bytes del contenuto di un file.
+ * 
+ * @param conn             Connessione con il server
+ * @param buf              Buffer di size bytes in cui memorizzare il contenuto del file
+ * @param size             Dimensione del contenuto del file
+ * 
+ * @return                 Un valore positivo in caso di successo, 0 se il server ha chiuso la connessione, -1 in caso 
+ *                         di fallimento (con errno settato a EPROTO se un blocco ricevuto non è valido).
+ */
+static int receive_compressed_content(fss_conn_t* conn, void* buf, size_t size) {
+	void* block = malloc(COMPRESSION_BLOCK_SIZE);
+	if (!block) {
+		errno = ECOMM;
+		return -1;
+	}
+	int r = 1;
+	for (size_t received = 0; received < size; ) {
+		size_t raw_size = size - received < COMPRESSION_BLOCK_SIZE ? size - received : COMPRESSION_BLOCK_SIZE;
+		void* raw = (char*) buf + received;
+		// leggo la dimensione con cui è trasmesso il blocco
+		size_t block_size;
+		r = readn(conn->fd, &block_size, sizeof(size_t));
+		if (r == -1 || r == 0)
+			break;
+		if (block_size > raw_size) {
+			errno = EPROTO;
+			r = -1;
+			break;
+		}
+		if (block_size == raw_size) {
+			// il blocco non è compresso, lo leggo direttamente nel buffer
+			r = readn(conn->fd, raw, raw_size);
+			if (r == -1 || r == 0)
+				break;
+		}
+		else {
+			r = readn(conn->fd, block, block_size);
+			if (r == -1 || r == 0)
+				break;
+			if (lz_decompress(block, block_size, raw, raw_size) == -1) {
+				errno = EPROTO;
+				r = -1;
+				break;
+			}
+		}
+		received += raw_size;
+	}
+	free(block);
+	return r;
+}
+
 /**
  * @function               receive_file_content()
  * @brief                  Riceve dal server il contenuto di un file.
  * 
+ * @param conn             Connessione con il server
  * @param buf              Contenuto del file ricevuto
  * @param size             Dimensione del contenuto del file ricevuto
  *
@@ -334,11 +1083,12 @@ static int receive_pathname(char** pathname, size_t* size) {
  *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
  *                                       l'operazione
  *                         ECONNRESET    se il server ha chiuso la connessione
+ *                         EPROTO        se è stato ricevuto un blocco compresso non valido
  */
-static int receive_file_content(void** buf, size_t* size) {
+static int receive_file_content(fss_conn_t* conn, void** buf, size_t* size) {
 	int r;
 	// ricevo dal server la dimensione del contenuto file
-	if (receive_size(size) == -1)
+	if (receive_size(conn, size) == -1)
 		return -1;
 
 	// secondo il protocollo il server non invia 0
@@ -351,8 +1101,11 @@ static int receive_file_content(void** buf, size_t* size) {
 		errno = ECOMM;
 		return -1;
 	} 
-	// leggo il contenuto del file
-	r = readn(g_socket_fd, *buf, *size);
+	// leggo il contenuto del file (in blocchi se la connessione usa la compressione)
+	if (!conn->compression)
+		r = readn(conn->fd, *buf, *size);
+	else
+		r = receive_compressed_content(conn, *buf, *size);
 	if (r == 0) {
 		free(*buf);
 		errno = ECONNRESET;
@@ -360,7 +1113,7 @@ static int receive_file_content(void** buf, size_t* size) {
 	}
 	else if (r == -1) {
 		free(*buf);
-		if (errno != ECONNRESET)
+		if (errno != ECONNRESET && errno != EPROTO)
 			errno = ECOMM;
 		return -1;
 	}
@@ -368,13 +1121,112 @@ static int receive_file_content(void** buf, size_t* size) {
 }
 
 /**
- * @function               receive_files()
- * @brief                  Riceve dal server dei file e li memorizza nella directory dirname ( se diversa da @c NULL ).
+ * @function               receive_checksum()
+ * @brief                  Riceve dal server, se la connessione ha negoziato CAP_CHECKSUM, il CRC32C del contenuto di un 
+ *                         file e lo confronta con quello calcolato sul contenuto ricevuto.
  * 
- * @param dirname          La directory in cui memorizzare i file ricevuti, se @c NULL i file ricevuti non vengono memorizzati
- * @param file_received    Il numero di file ricevuti
- * 
- * @return                 0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ * @param conn             Connessione con il server
+ * @param buf              Contenuto del file ricevuto
+ * @param size             Dimensione del contenuto del file ricevuto
+ *
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         EBADMSG       se il checksum ricevuto non corrisponde al contenuto del file
+ *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
+ *                                       l'operazione
+ *                         ECONNRESET    se il server ha chiuso la connessione
+ */
+static int receive_checksum(fss_conn_t* conn, void* buf, size_t size) {
+	if (!conn->checksum)
+		return 0;
+
+	uint32_t checksum;
+	int r = readn(conn->fd, &checksum, sizeof(uint32_t));
+	if (r == 0) {
+		errno = ECONNRESET;
+		return -1;
+	}
+	else if (r == -1) {
+		if (errno != ECONNRESET)
+			errno = ECOMM;
+		return -1;
+	}
+	if (crc32c(0, buf, size) != checksum) {
+		errno = EBADMSG;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function               receive_file_stream()
+ * @brief                  Riceve dal server il contenuto di un file a blocchi di READ_CHUNK_SIZE bytes, scrivendo ogni 
+ *                         blocco nel file file appena ricevuto (senza caricare l'intero contenuto in memoria). Se la 
+ *                         scrittura nel file fallisce il contenuto restante viene comunque ricevuto.
+ * 
+ * @param conn             Connessione con il server
+ * @param file             File in cui scrivere il contenuto ricevuto (se @c NULL il contenuto viene scartato)
+ * @param size             Dimensione del contenuto del file ricevuto
+ * @param write_failed     Settato a true se la scrittura nel file è fallita
+ *
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
+ *                                       l'operazione
+ *                         ECONNRESET    se il server ha chiuso la connessione
+ *                         EPROTO        se è stato ricevuto un blocco compresso non valido
+ */
+static int receive_file_stream(fss_conn_t* conn, FILE* file, size_t* size, bool* write_failed) {
+	int r = 1;
+	// ricevo dal server la dimensione del contenuto file
+	if (receive_size(conn, size) == -1)
+		return -1;
+
+	// secondo il protocollo il server non invia 0
+	if (*size == 0)
+		return 0;
+
+	// alloco il buffer per un blocco
+	void* chunk = malloc(*size < READ_CHUNK_SIZE ? *size : READ_CHUNK_SIZE);
+	if (!chunk) {
+		errno = ECOMM;
+		return -1;
+	}
+	// ricevo il contenuto del file a blocchi (compressi se la connessione usa la compressione) e lo scrivo nel file
+	for (size_t received = 0; received < *size; ) {
+		size_t chunk_size = (*size - received < READ_CHUNK_SIZE) ? *size - received : READ_CHUNK_SIZE;
+		if (!conn->compression)
+			r = readn(conn->fd, chunk, chunk_size);
+		else
+			r = receive_compressed_content(conn, chunk, chunk_size);
+		if (r == -1 || r == 0)
+			break;
+		if (file && !(*write_failed) && fwrite(chunk, 1, chunk_size, file) != chunk_size)
+			*write_failed = true;
+		received += chunk_size;
+	}
+	free(chunk);
+	if (r == 0) {
+		errno = ECONNRESET;
+		return -1;
+	}
+	else if (r == -1) {
+		if (errno != ECONNRESET && errno != EPROTO)
+			errno = ECOMM;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function               receive_files()
+ * @brief                  Riceve dal server dei file e li memorizza nella directory dirname ( se diversa da @c NULL ).
+ * 
+ * @param conn             Connessione con il server
+ * @param dirname          La directory in cui memorizzare i file ricevuti, se @c NULL i file ricevuti non vengono memorizzati
+ * @param file_received    Il numero di file ricevuti
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
  *                         In caso di fallimento errno può assumere i seguenti valori:
  *                         ECOMM       se si è verificato un errore lato client che non ha reso possibile effettuare 
  *                                     l'operazione
@@ -382,10 +1234,10 @@ static int receive_file_content(void** buf, size_t* size) {
  *                         EFAULT      se non è stato possibile scrivere tutti i file ricevuti
  *                         EPROTO      se si è verificato un errore di protocollo
  */
-static int receive_files(const char* dirname, int* num_file_received) {
+static int receive_files(fss_conn_t* conn, const char* dirname, int* num_file_received) {
 	// ricevo dal server il numero di file che intende inviare
 	size_t files_to_receive;
-	if (receive_size(&files_to_receive) == -1)
+	if (receive_size(conn, &files_to_receive) == -1)
 		return -1;
 	
 	int errnosv = 0;
@@ -393,72 +1245,71 @@ static int receive_files(const char* dirname, int* num_file_received) {
 		size_t pathsize_in;
 		char* pathname_in;
 		size_t size_in;
-		void* buf_in = NULL;
+		char* filepath = NULL;
+		FILE* file_in = NULL;
+		bool write_failed = false;
 
 		// ricevo dal server il path del file
-		if (receive_pathname(&pathname_in, &pathsize_in) == -1)
+		if (receive_pathname(conn, &pathname_in, &pathsize_in) == -1)
 			return -1;
 
-		// ricevo dal server il contenuto del file
-		if (receive_file_content(&buf_in, &size_in) == -1)
-			return -1;
+		if (dirname) {
+			// ottengo il nome del file
+			char* filename = get_basename(pathname_in);
+			if (!filename) {
+				free(pathname_in);
+				errno = ECOMM;
+				return -1;
+			}
 
-		// incremento il numero di file ricevuti
-		if (num_file_received != NULL && *num_file_received != INT_MAX) // per evitare overflow
-			(*num_file_received) ++;
+			// costruisco il path del file concatenando il nome del file al path della directory in cui memorizzarlo
+			filepath = build_notexisting_path(dirname, filename);
+			free(filename);
+			if (!filepath && errno == ENOMEM) {
+				free(pathname_in);
+				errno = ECOMM;
+				return -1;
+			}
 
-		/* se dirnam è NULL stampo eventualmente sullo stdout il pathname e i byte ricevuti
-		   e proseguo con la ricezione dell'eventuale file successivo */
-		if (!dirname) {
-			PRINT(" : (%zu byte ricevuti di %s)", size_in, pathname_in);
-			free(buf_in);
-			free(pathname_in);
-			continue;
+			// apro il file in cui scrivere il contenuto ricevuto
+			if (filepath) {
+				file_in = fopen(filepath, "w+");
+				if (!file_in)
+					errnosv = EFAULT;
+			}
 		}
 
-		// ottengo il nome del file
-		char* filename = get_basename(pathname_in);
-		if (!filename) {
-			free(buf_in);
+		// ricevo dal server il contenuto del file, scrivendolo nel file a blocchi (se il file non è stato aperto il 
+		// contenuto viene scartato)
+		if (receive_file_stream(conn, file_in, &size_in, &write_failed) == -1) {
+			if (file_in)
+				fclose(file_in);
+			if (filepath)
+				free(filepath);
 			free(pathname_in);
-			errno = ECOMM;
 			return -1;
 		}
 
-		// costruisco il path del file concatenando il nome del file al path della directory in cui memorizzarlo
-		char* filepath = build_notexisting_path(dirname, filename);
-		if (!filepath) {
-			free(buf_in);
-			free(pathname_in);
-			free(filename);
-			if (errno == ENOMEM) {
-				errno = ECOMM;
-				return -1;
-			}
-			continue;
-		}
+		// incremento il numero di file ricevuti
+		if (num_file_received != NULL && *num_file_received != INT_MAX) // per evitare overflow
+			(*num_file_received) ++;
 
-		// scrivo nel file
-		FILE * file_in;
-		file_in = fopen(filepath, "w+");
-		if (!file_in) {
-			errnosv = EFAULT;
+		/* se dirname è NULL stampo eventualmente sullo stdout il pathname e i byte ricevuti */
+		if (!dirname) {
+			PRINT(" : (%zu byte ricevuti di %s)", size_in, pathname_in);
 		}
-		else {
-			if (size_in != 0) {
-				if (fwrite(buf_in, 1, size_in, file_in) != size_in)
-					errnosv = EFAULT;
-			}
-			if (errnosv != EFAULT) {
+		else if (file_in) {
+			if (fclose(file_in) == -1)
+				write_failed = true;
+			if (write_failed)
+				errnosv = EFAULT;
+			else {
 				PRINT(" : (%zu byte ricevuti e salvati in %s)", size_in, filepath);
 			}
 		}
-		if (fclose(file_in) == -1)
-			errnosv = EFAULT;
-		free(buf_in);
+		if (filepath)
+			free(filepath);
 		free(pathname_in);
-		free(filename);
-		free(filepath);
 	}
 	errno = errnosv;
 	if (errno != 0)
@@ -466,11 +1317,52 @@ static int receive_files(const char* dirname, int* num_file_received) {
 	return 0;
 }
 
+/**
+ * @function               receive_response()
+ * @brief                  Riceve dal server la risposta alla richiesta con identificativo req_id, inviata in modo 
+ *                         sincrono, e setta errno in base al codice di risposta ricevuto.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_id           Identificativo della richiesta inviata
+ * @param code             Se diverso da @c NULL vi viene memorizzato il codice di risposta ricevuto
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento.
+ *                         Errno viene settato nel caso in cui si sono verificati errori che non hanno reso possibile 
+ *                         completare l'operazione e nel caso in cui la risposta ricevuta dal server segnala l'esito 
+ *                         negativo dell'operazione richiesta.
+ *                         Errno può assumere i seguenti valori:
+ *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
+ *                                       l'operazione
+ *                         ECONNRESET    se il server ha chiuso la connessione
+ *                         EPROTO        se la risposta si riferisce a una richiesta diversa
+ */
+static int receive_response(fss_conn_t* conn, int req_id, response_code_t* code) {
+	int resp_id;
+	response_code_t resp_code;
+	if (receive_respcode(conn, &resp_id, &resp_code) == -1)
+		return -1;
+
+	// non essendoci altre richieste in attesa la risposta deve riferirsi a req_id
+	if (resp_id != req_id) {
+		errno = EPROTO;
+		return -1;
+	}
+
+	if (code)
+		*code = resp_code;
+
+	// setto errno in base al codice di risposta ricevuto
+	set_errno(resp_code);
+
+	return 0;
+}
+
 /**
  * @function               do_simple_request()
  * @brief                  Invia al server il codice di richiesta req_code e il path del file relativo alla richiesta,
  *                         attende la ricezione del codice di risposta e setta errno in base al codice ricevuto.
  * 
+ * @param conn             Connessione con il server
  * @param req_code         Codice di richiesta da inviare
  * @param pathname         Path del file da inviare
  * 
@@ -482,24 +1374,48 @@ static int receive_files(const char* dirname, int* num_file_received) {
  *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
  *                                       l'operazione
  *                         ECONNRESET    se il server ha chiuso la connessione
+ *                         EPROTO        se si è verificato un errore di protocollo
  */
-static int do_simple_request(request_code_t req_code, const char* pathname) {
-	// invio al server il codice di richiesta
-	if (send_reqcode(req_code) == -1)
+static int do_simple_request(fss_conn_t* conn, request_code_t req_code, const char* pathname) {
+	// invio al server l'identificativo e il codice di richiesta
+	int req_id = new_request_id(conn);
+	if (send_reqcode(conn, req_id, req_code) == -1)
 		return -1;
 
 	// invio al server il path del file
-	if (send_pathname(pathname) == -1)
+	if (send_pathname(conn, pathname) == -1)
 		return -1;
 
-	// ricevo dal server il codice di risposta
-	response_code_t resp_code;
-	if (receive_respcode(&resp_code) == -1)
-		return -1;
-	
-	// setto errno in base al codice di risposta ricevuto
-	set_errno(resp_code);
+	// ricevo dal server la risposta
+	return receive_response(conn, req_id, NULL);
+}
 
+/**
+ * @function               flags_to_reqcode()
+ * @brief                  Converte i flag di apertura di un file nel codice di richiesta corrispondente.
+ * 
+ * @param flags            Flag di apertura (O_CREATE, O_LOCK, eventualmente in OR, o 0)
+ * @param req_code         Codice di richiesta corrispondente
+ * 
+ * @return                 0 in caso di successo, -1 se flags non è valido.
+ */
+static int flags_to_reqcode(int flags, request_code_t* req_code) {
+	switch (flags) {
+		case O_CREATE:
+			*req_code = OPEN_CREATE;
+			break;
+		case O_LOCK:
+			*req_code = OPEN_LOCK;
+			break;
+		case 0:
+			*req_code = OPEN_NO_FLAGS;
+			break;
+		case O_CREATE|O_LOCK:
+			*req_code = OPEN_CREATE_LOCK;
+			break;
+		default:
+			return -1;
+	}
 	return 0;
 }
 
@@ -514,71 +1430,307 @@ bool is_printing_enable() {
 	return print_enable;
 }
 
-int openConnection(const char* sockname, int msec, const struct timespec abstime) {
+/**
+ * @function               destroy_print_buffer()
+ * @brief                  Dealloca il buffer delle stampe di un thread.
+ * 
+ * @param arg              Il buffer da deallocare
+ */
+static void destroy_print_buffer(void* arg) {
+	print_buffer_t* buffer = arg;
+	if (buffer->data)
+		free(buffer->data);
+	free(buffer);
+}
+
+/**
+ * @function               create_print_buffer_key()
+ * @brief                  Crea la chiave del buffer delle stampe dei thread.
+ */
+static void create_print_buffer_key() {
+	print_buffer_key_err = pthread_key_create(&print_buffer_key, destroy_print_buffer);
+}
+
+int begin_print_buffering() {
+	int r = pthread_once(&print_buffer_once, create_print_buffer_key);
+	if (r != 0 || print_buffer_key_err != 0) {
+		errno = r != 0 ? r : print_buffer_key_err;
+		return -1;
+	}
+	if (pthread_getspecific(print_buffer_key) != NULL) {
+		errno = EALREADY;
+		return -1;
+	}
+	print_buffer_t* buffer = calloc(1, sizeof(print_buffer_t));
+	if (!buffer)
+		return -1;
+	if ((r = pthread_setspecific(print_buffer_key, buffer)) != 0) {
+		free(buffer);
+		errno = r;
+		return -1;
+	}
+	return 0;
+}
+
+int end_print_buffering() {
+	print_buffer_t* buffer = NULL;
+	if (pthread_once(&print_buffer_once, create_print_buffer_key) == 0 && print_buffer_key_err == 0)
+		buffer = pthread_getspecific(print_buffer_key);
+	if (!buffer) {
+		errno = EINVAL;
+		return -1;
+	}
+	pthread_setspecific(print_buffer_key, NULL);
+	int ret = 0;
+	if (buffer->len != 0) {
+		// stampo le stampe accumulate con un'unica scrittura sullo stdout
+		flockfile(stdout);
+		if (fwrite(buffer->data, 1, buffer->len, stdout) != buffer->len)
+			ret = -1;
+		funlockfile(stdout);
+	}
+	destroy_print_buffer(buffer);
+	return ret;
+}
+
+void print_fmt(const char* fmt, ...) {
+	print_buffer_t* buffer = NULL;
+	if (pthread_once(&print_buffer_once, create_print_buffer_key) == 0 && print_buffer_key_err == 0)
+		buffer = pthread_getspecific(print_buffer_key);
+
+	va_list args;
+	va_start(args, fmt);
+	if (!buffer) {
+		vprintf(fmt, args);
+		va_end(args);
+		return;
+	}
+	// calcolo la lunghezza della stampa e, se necessario, ingrandisco il buffer
+	va_list args_copy;
+	va_copy(args_copy, args);
+	int n = vsnprintf(NULL, 0, fmt, args_copy);
+	va_end(args_copy);
+	if (n > 0) {
+		if (buffer->len + n + 1 > buffer->capacity) {
+			size_t capacity = buffer->capacity != 0 ? buffer->capacity : 256;
+			while (buffer->len + n + 1 > capacity)
+				capacity *= 2;
+			char* data = realloc(buffer->data, capacity);
+			if (!data) {
+				// non è possibile accumulare la stampa, la effettuo direttamente
+				vprintf(fmt, args);
+				va_end(args);
+				return;
+			}
+			buffer->data = data;
+			buffer->capacity = capacity;
+		}
+		vsnprintf(buffer->data + buffer->len, buffer->capacity - buffer->len, fmt, args);
+		buffer->len += n;
+	}
+	va_end(args);
+}
+
+int enable_compression() {
+	if (compression_enable)
+		return -1;
+	compression_enable = true;
+	return 0;
+}
+
+bool is_compression_enable() {
+	return compression_enable;
+}
+
+int enable_checksum() {
+	if (checksum_enable)
+		return -1;
+	checksum_enable = true;
+	return 0;
+}
+
+bool is_checksum_enable() {
+	return checksum_enable;
+}
+
+int enable_cache(size_t max_bytes) {
+	if (cache_max_bytes != 0 || max_bytes == 0)
+		return -1;
+	cache_max_bytes = max_bytes;
+	return 0;
+}
+
+bool is_cache_enable() {
+	return cache_max_bytes != 0;
+}
+
+/**
+ * @function               negotiate()
+ * @brief                  Negozia con il server le capacità della connessione appena aperta, richiedendo la 
+ *                         compressione del contenuto dei file, l'invio del checksum dei file letti e/o le notifiche di 
+ *                         invalidazione dei file letti.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i valori settati da receive_response(conn) e inoltre:
+ *                         ECOMM        se si è verificato un errore lato client durante la scrittura sulla socket
+ *                         ECONNRESET   se il server ha chiuso la connessione
+ */
+static int negotiate(fss_conn_t* conn) {
+	int r;
+	int capabilities = 0;
+	if (compression_enable)
+		capabilities |= CAP_COMPRESSION;
+	if (checksum_enable)
+		capabilities |= CAP_CHECKSUM;
+	if (cache_max_bytes != 0)
+		capabilities |= CAP_INVALIDATION;
+	int req_id = new_request_id(conn);
+	if (send_reqcode(conn, req_id, NEGOTIATE) == -1)
+		return -1;
+	r = writen(conn->fd, &capabilities, sizeof(int));
+	if (r == -1 || r == 0) {
+		if (errno == EPIPE)
+			errno = ECONNRESET;
+		else
+			errno = ECOMM;
+		return -1;
+	}
+	if (receive_response(conn, req_id, NULL) == -1 || errno != 0)
+		return -1;
+	// ricevo le capacità accettate dal server
+	r = readn(conn->fd, &capabilities, sizeof(int));
+	if (r == 0) {
+		errno = ECONNRESET;
+		return -1;
+	}
+	else if (r == -1) {
+		if (errno != ECONNRESET)
+			errno = ECOMM;
+		return -1;
+	}
+	conn->compression = (capabilities & CAP_COMPRESSION) != 0;
+	conn->checksum = (capabilities & CAP_CHECKSUM) != 0;
+	conn->invalidation = (capabilities & CAP_INVALIDATION) != 0;
+	return 0;
+}
+
+/**
+ * @function               check_connection_args()
+ * @brief                  Controlla la validità degli argomenti di openConnection() e fss_connect().
+ * 
+ * @param sockname         Il path del socket file o tcp:host:porta
+ * @param msec             Il numero di millisecondi da attendere dopo un tentativo di connessione fallito
+ * @param abstime          Il tempo assoluto entro cui è possibile ritentare la connessione
+ * 
+ * @return                 0 se gli argomenti sono validi, -1 altrimenti con errno settato a EINVAL.
+ */
+static int check_connection_args(const char* sockname, int msec, const struct timespec abstime) {
 	if (!sockname || strlen(sockname) > (UNIX_PATH_MAX-1) || strlen(sockname) == 0 ||
 		msec < 0 || abstime.tv_sec < 0 || abstime.tv_nsec < 0 || abstime.tv_nsec >= 1000000000) {
 		errno = EINVAL;
 		return -1;
 	} 
+	return 0;
+}
 
-	// controllo se il client è già connesso
-	if (g_socket_fd != -1) {
-		errno = EISCONN;
-		return -1;
+/**
+ * @function               connect_to_server()
+ * @brief                  Apre la connessione conn con il server come descritto in openConnection().
+ * 
+ * @param conn             Connessione da aprire
+ * @param sockname         Il path del socket file o tcp:host:porta
+ * @param msec             Il numero di millisecondi da attendere dopo un tentativo di connessione fallito
+ * @param abstime          Il tempo assoluto entro cui è possibile ritentare la connessione
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore 
+ *                         (come in openConnection()).
+ */
+static int connect_to_server(fss_conn_t* conn, const char* sockname, int msec, const struct timespec abstime) {
+	// inizializzo la struttura necessaria per la connessione
+	struct sockaddr_storage client_addr;
+	socklen_t client_addr_len;
+	memset(&client_addr, 0, sizeof(client_addr));
+	bool tcp = strncmp(sockname, TCP_SOCKNAME_PREFIX, strlen(TCP_SOCKNAME_PREFIX)) == 0;
+	if (tcp) {
+		// separo host e porta (l'ultimo ':' di sockname)
+		char host[UNIX_PATH_MAX];
+		strcpy(host, sockname + strlen(TCP_SOCKNAME_PREFIX));
+		char* port = strrchr(host, ':');
+		if (!port || port == host || *(port+1) == '\0') {
+			errno = EINVAL;
+			return -1;
+		}
+		*port = '\0';
+		port ++;
+		struct addrinfo hints;
+		memset(&hints, 0, sizeof(struct addrinfo));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_NUMERICSERV;
+		struct addrinfo* res;
+		if (getaddrinfo(host, port, &hints, &res) != 0) {
+			errno = EINVAL;
+			return -1;
+		}
+		memcpy(&client_addr, res->ai_addr, res->ai_addrlen);
+		client_addr_len = res->ai_addrlen;
+		freeaddrinfo(res);
+	}
+	else {
+		struct sockaddr_un* unix_addr = (struct sockaddr_un*) &client_addr;
+		unix_addr->sun_family = AF_UNIX;    
+		strncpy(unix_addr->sun_path, sockname, UNIX_PATH_MAX-1);
+		client_addr_len = sizeof(struct sockaddr_un);
 	}
 
 	// creo il socket lato client
-	if ((g_socket_fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+	if ((conn->fd = socket(client_addr.ss_family, SOCK_STREAM, 0)) == -1) {
 		errno = ECOMM;
 		return -1;
 	}
 
-	// inizializzo la struttura necessaria per la connessione
-	struct sockaddr_un client_addr;
-	memset(&client_addr, '0', sizeof(client_addr));
-	client_addr.sun_family = AF_UNIX;    
-	strncpy(client_addr.sun_path, sockname, UNIX_PATH_MAX-1);
-
 	// tento la connessione
 	int errnosv = 0;
 	int r;
-	while ((r = connect(g_socket_fd, (struct sockaddr*)&client_addr, sizeof(client_addr))) == -1) {
+	while ((r = connect(conn->fd, (struct sockaddr*)&client_addr, client_addr_len)) == -1) {
 		errnosv = errno;
 
 		// ottengo il tempo corrente
 		struct timespec curr_time = {0, 0};
 		if (clock_gettime(CLOCK_REALTIME, &curr_time) == -1) {
-			close(g_socket_fd);
-			g_socket_fd = -1;
+			close(conn->fd);
+			conn->fd = -1;
 			errno = ECOMM;
 			return -1;
 		} 
 
 		// controllo se si è verificato un errore che implica il fallimento dell'operazione
 		if (errnosv != ENOENT && errnosv != ECONNREFUSED && errnosv != EINTR) {
-			close(g_socket_fd);
-			g_socket_fd = -1;
+			close(conn->fd);
+			conn->fd = -1;
 			errno = ECOMM;
 			return -1;
 		}
 
 		// controllo se è stata ricevuta un'interruzione
 		if (errnosv == EINTR) {
-			if (close(g_socket_fd) == -1)
+			if (close(conn->fd) == -1)
 				errno = ECOMM;
 			else
 				errno = EINTR;
-			g_socket_fd = -1;
+			conn->fd = -1;
 			return -1;
 		}
 
 		// controllo se il tempo destinato ai tentativi è esaurito
 		if (timespeccmp(&curr_time, &abstime, >)) {
-			if (close(g_socket_fd) == -1)
+			if (close(conn->fd) == -1)
 				errno = ECOMM;
 			else
 				errno = ETIMEDOUT;
-			g_socket_fd = -1;
+			conn->fd = -1;
 			return -1;
 		}
 		if (msec == 0)
@@ -590,20 +1742,180 @@ int openConnection(const char* sockname, int msec, const struct timespec abstime
 		towait.tv_nsec = (msec % 1000) * 1000000;
 		if (nanosleep(&towait, NULL) == -1) {
 			errnosv = errno;
-			if (close(g_socket_fd) == -1 || errnosv != EINTR)
+			if (close(conn->fd) == -1 || errnosv != EINTR)
 				errno = ECOMM;
 			if (errnosv == EINTR)
 				errno = errnosv;
-			g_socket_fd = -1;
+			conn->fd = -1;
+			return -1;
+		}
+	}
+
+	// disabilito l'algoritmo di Nagle, le parti di ogni richiesta sono accumulate con TCP_CORK
+	conn->tcp = tcp;
+	conn->corked = false;
+	if (tcp) {
+		int on = 1;
+		if (setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(int)) == -1) {
+			close(conn->fd);
+			conn->fd = -1;
+			errno = ECOMM;
 			return -1;
 		}
 	}
 
 	// copio sockname
-	memset(g_sockname, '\0', UNIX_PATH_MAX);
-	strncpy(g_sockname, sockname, UNIX_PATH_MAX-1);
+	memset(conn->sockname, '\0', UNIX_PATH_MAX);
+	strncpy(conn->sockname, sockname, UNIX_PATH_MAX-1);
+
+	// negozio, se richiesti, la compressione del contenuto dei file, l'invio del checksum e le notifiche di invalidazione
+	conn->compression = false;
+	conn->checksum = false;
+	conn->invalidation = false;
+	if ((compression_enable || checksum_enable || cache_max_bytes != 0) && negotiate(conn) == -1) {
+		int errnosv = errno;
+		close(conn->fd);
+		conn->fd = -1;
+		errno = errnosv;
+		return -1;
+	}
 
-	errno = 0;
+	// creo, se il server invia le notifiche di invalidazione, la cache dei file letti
+	if (conn->invalidation) {
+		conn->cache = hasht_create(CACHE_BUCKETS, NULL, NULL);
+		if (!conn->cache) {
+			close(conn->fd);
+			conn->fd = -1;
+			errno = ECOMM;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @function               lock_conn()
+ * @brief                  Acquisisce la mutex della connessione conn, controllando che la connessione sia aperta.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento con errno settato a ECOMM se conn è @c NULL 
+ *                         o è stata chiusa a seguito di un errore (in tal caso la mutex non è acquisita).
+ */
+static int lock_conn(fss_conn_t* conn) {
+	if (!conn) {
+		errno = ECOMM;
+		return -1;
+	}
+	if (pthread_mutex_lock(&(conn->mutex)) != 0) {
+		errno = ECOMM;
+		return -1;
+	}
+	if (conn->fd == -1) {
+		pthread_mutex_unlock(&(conn->mutex));
+		errno = ECOMM;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function               unlock_conn()
+ * @brief                  Rilascia la mutex della connessione conn preservando errno.
+ * 
+ * @param conn             Connessione con il server
+ */
+static void unlock_conn(fss_conn_t* conn) {
+	int errnosv = errno;
+	pthread_mutex_unlock(&(conn->mutex));
+	errno = errnosv;
+}
+
+/**
+ * @def                    LOCKED_CALL()
+ * @brief                  Ritorna il valore di X, valutata dopo aver acquisito la mutex della connessione conn (se 
+ *                         l'acquisizione fallisce ritorna -1).
+ * 
+ * @param conn             Connessione con il server
+ * @param X                Espressione da valutare in mutua esclusione
+ */
+#define LOCKED_CALL(conn, X) \
+	do { \
+		if (lock_conn(conn) == -1) \
+			return -1; \
+		int locked_r = (X); \
+		unlock_conn(conn); \
+		return locked_r; \
+	} while(0);
+
+fss_conn_t* fss_connect(const char* sockname, int msec, const struct timespec abstime) {
+	if (check_connection_args(sockname, msec, abstime) == -1)
+		return NULL;
+
+	fss_conn_t* conn = calloc(1, sizeof(fss_conn_t));
+	if (!conn) {
+		errno = ECOMM;
+		return NULL;
+	}
+	conn->fd = -1;
+	conn->next_req_id = 1;
+	if (pthread_mutex_init(&(conn->mutex), NULL) != 0) {
+		free(conn);
+		errno = ECOMM;
+		return NULL;
+	}
+
+	if (connect_to_server(conn, sockname, msec, abstime) == -1) {
+		int errnosv = errno;
+		pthread_mutex_destroy(&(conn->mutex));
+		free(conn);
+		errno = errnosv;
+		return NULL;
+	}
+
+	errno = 0;
+	return conn;
+}
+
+int fss_disconnect(fss_conn_t* conn) {
+	if (!conn) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// chiudo il descrittore associato alla socket (se non già chiuso a seguito di un errore) e dealloco la connessione
+	int r = 0;
+	if (conn->fd != -1 && close(conn->fd) == -1)
+		r = -1;
+	cache_destroy(conn);
+	// dealloco le directory registrate con le richieste rimaste in attesa di risposta
+	for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
+		if (conn->pending[i].id != NO_REQ_ID && conn->pending[i].dirname)
+			free(conn->pending[i].dirname);
+	}
+	pthread_mutex_destroy(&(conn->mutex));
+	free(conn);
+	if (r == -1) {
+		errno = ECOMM;
+		return -1;
+	}
+	return 0;
+}
+
+int openConnection(const char* sockname, int msec, const struct timespec abstime) {
+	if (check_connection_args(sockname, msec, abstime) == -1)
+		return -1;
+
+	// controllo se il client è già connesso
+	if (g_conn != NULL) {
+		errno = EISCONN;
+		return -1;
+	}
+
+	g_conn = fss_connect(sockname, msec, abstime);
+	if (!g_conn)
+		return -1;
 	return 0;
 }
 
@@ -614,93 +1926,206 @@ int closeConnection(const char* sockname) {
 	}
 
 	// controllo se la connessione è stata aperta
-	if (g_sockname[0] == '\0') {
+	if (g_conn == NULL) {
 		errno = EALREADY;
 		return -1;
 	}
 	// controllo se il sockname coincide con quello relativo alla connessione aperta
-	if (strcmp(sockname, g_sockname) != 0) {
+	if (strcmp(sockname, g_conn->sockname) != 0) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// chiudo il descrittore associato alla socket
-	if (close(g_socket_fd) == -1) {
-		errno = ECOMM;
-		return -1;
-	}
-	// resetto il descrittore e il nome della socket
-	g_socket_fd = -1;
-	g_sockname[0] = '\0';
-
-	return 0;
+	fss_conn_t* conn = g_conn;
+	g_conn = NULL;
+	return fss_disconnect(conn);
 }
 
-int openFile(const char* pathname, int flags) {
+/**
+ * @function               open_file()
+ * @brief                  Implementa openFile() sulla connessione conn, la cui mutex deve essere già stata acquisita.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 Come openFile().
+ */
+static int open_file(fss_conn_t* conn, const char* pathname, int flags) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		pathname != strchr(pathname, '/') ||strchr(pathname, ',') != NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 	// setto il codice di richiesta da inviare al server in base al valore di flags
 	request_code_t req_code;
-	switch (flags) {
-		case O_CREATE:
-			req_code = OPEN_CREATE;
-			break;
-		case O_LOCK:
-			req_code = OPEN_LOCK;
-			break;
-		case 0:
-			req_code = OPEN_NO_FLAGS;
-			break;
-		case O_CREATE|O_LOCK:
-			req_code = OPEN_CREATE_LOCK;
-			break;
-		default:
-			errno = EINVAL;
-			return -1;
+	if (flags_to_reqcode(flags, &req_code) == -1) {
+		errno = EINVAL;
+		return -1;
 	}
 
-	if (do_simple_request(req_code, pathname) == -1 || errno != 0)
+	if (do_simple_request(conn, req_code, pathname) == -1 || errno != 0)
 		return -1;
 	return 0;
 }
 
-int readFile(const char* pathname, void** buf, size_t* size) {
+/**
+ * @function               read_file()
+ * @brief                  Effettua una richiesta di lettura del file pathname con codice di richiesta req_code 
+ *                         (READ, OPEN_READ_CLOSE o READ_RANGE), memorizzando in buf il contenuto ricevuto e in size la sua 
+ *                         dimensione.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_code         Codice della richiesta
+ * @param pathname         Path del file da leggere
+ * @param offset           Offset da cui leggere (considerato solo per READ_RANGE)
+ * @param length           Numero massimo di bytes da leggere (considerato solo per READ_RANGE)
+ * @param version          Versione del file posseduta dal client, aggiornata con quella ricevuta (considerata solo per 
+ *                         READ_IF_NEWER)
+ * @param buf              Il buffer in cui memorizzare il contenuto del file ricevuto dal server
+ * @param size             La size del buffer buf
+ * 
+ * @return                 0 in caso di successo, 1 se la richiesta è READ_IF_NEWER e il server ha risposto che il file non 
+ *                         è stato modificato, -1 in caso di fallimento ed errno settato ad indicare l'errore 
+ *                         (come in readFile()).
+ */
+static int read_file(fss_conn_t* conn, request_code_t req_code, 
+					const char* pathname, 
+					size_t offset, 
+					size_t length, 
+					size_t* version, 
+					void** buf, 
+					size_t* size) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		strchr(pathname, ',') != NULL || pathname != strchr(pathname, '/') ||
-		!buf || !size) {
+		!buf || !size || (req_code == READ_IF_NEWER && !version)) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
-	request_code_t req_code = READ;
-	if (do_simple_request(req_code, pathname) == -1 || errno != 0)
+	bool cacheable = conn->invalidation && req_code != READ_RANGE;
+	size_t cached_version = 0;
+	if (cacheable) {
+		/* ricevo le notifiche di invalidazione già inviate dal server: il server le invia prima di rispondere alle 
+		   richieste che modificano, rimuovono, espellono o bloccano il file, per cui se dopo averle ricevute il file 
+		   può ancora essere letto dalla cache la copia in cache è quella che il server invierebbe */
+		int r = receive_invalidations(conn);
+		if (r == -1)
+			return -1;
+		cache_entry_t* entry = cache_get(conn, pathname);
+		if (entry && entry->readable && r == 0 && req_code == READ) {
+			if (cache_read(entry, buf, size) == -1)
+				return -1;
+			errno = 0;
+			return 0;
+		}
+		/* altrimenti, se il file è in cache, invio la versione in cache: il server effettua i controlli della lettura 
+		   e, se la copia in cache è valida, risponde NOT_MODIFIED senza inviare il contenuto */
+		if (entry)
+			cached_version = entry->version;
+	}
+
+	int req_id = new_request_id(conn);
+	if (send_reqcode(conn, req_id, req_code) == -1)
+		return -1;
+
+	if (send_pathname(conn, pathname) == -1)
+		return -1;
+
+	if (req_code == READ_RANGE && (send_size(conn, offset) == -1 || send_size(conn, length) == -1))
+		return -1;
+
+	if ((req_code == READ_IF_NEWER || cacheable) && 
+		send_size(conn, cached_version != 0 ? cached_version : (req_code == READ_IF_NEWER ? *version : 0)) == -1)
+		return -1;
+
+	response_code_t resp_code;
+	if (receive_response(conn, req_id, &resp_code) == -1 || errno != 0)
 		return -1;
 	
 	*buf = NULL;
-	if (receive_file_content(buf, size) == -1)
+	*size = 0;
+	if (resp_code == NOT_MODIFIED && cached_version != 0) {
+		/* la copia in cache è valida (le notifiche di invalidazione non rimuovono i file dalla cache e quelle ricevute 
+		   prima della risposta sono state superate dalla verifica del server) */
+		cache_entry_t* entry = cache_get(conn, pathname);
+		if (!entry || entry->version != cached_version) {
+			errno = EPROTO;
+			return -1;
+		}
+		// fino alla chiusura del file le successive letture possono essere effettuate dalla cache
+		if (req_code == READ)
+			entry->readable = true;
+		if (req_code == READ_IF_NEWER && *version == entry->version)
+			return 1;
+		if (cache_read(entry, buf, size) == -1)
+			return -1;
+		if (req_code == READ_IF_NEWER)
+			*version = entry->version;
+		errno = 0;
+		return 0;
+	}
+	if (resp_code == NOT_MODIFIED)
+		return 1;
+
+	// ricevo, in caso di READ_IF_NEWER o se la connessione ha la cache, la versione corrente del file
+	size_t file_version = 0;
+	if ((req_code == READ_IF_NEWER || cacheable) && receive_size(conn, &file_version) == -1)
 		return -1;
+	if (req_code == READ_IF_NEWER)
+		*version = file_version;
+
+	if (receive_file_content(conn, buf, size) == -1)
+		return -1;
+
+	// verifico, se non si tratta di READ_RANGE, il checksum del contenuto ricevuto
+	if (req_code != READ_RANGE && receive_checksum(conn, *buf, *size) == -1) {
+		if (*buf)
+			free(*buf);
+		*buf = NULL;
+		*size = 0;
+		return -1;
+	}
+
+	// memorizzo il file nella cache (fino alla chiusura del file le successive letture possono essere effettuate dalla cache)
+	if (cacheable) {
+		cache_entry_t* entry = cache_put(conn, pathname, *buf, *size, file_version);
+		if (entry && req_code == READ)
+			entry->readable = true;
+	}
 	return 0;
 }
 
-int readNFiles(int N, const char* dirname) {
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+/**
+ * @function               read_n_files()
+ * @brief                  Invia al server la richiesta req_code (READN o READN_CURSOR) e memorizza in dirname i file 
+ *                         ricevuti.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_code         Codice della richiesta
+ * @param N                Il numero massimo di file da leggere, se <= 0 non c'è limite
+ * @param cursor           Il cursore da cui riprendere la scansione, aggiornato con quello ricevuto dal server 
+ *                         (considerato solo per READN_CURSOR)
+ * @param max_bytes        Il numero massimo di bytes da ricevere, 0 se illimitato (considerato solo per READN_CURSOR)
+ * @param dirname          La directory in cui memorizzare i file ricevuti
+ * 
+ * @return                 Il numero di file ricevuti in caso di successo, -1 in caso di fallimento ed errno settato ad 
+ *                         indicare l'errore (come in readNFiles()).
+ */
+static int read_n_files(fss_conn_t* conn, request_code_t req_code, int N, size_t* cursor, size_t max_bytes, const char* dirname) {
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
@@ -721,24 +2146,28 @@ int readNFiles(int N, const char* dirname) {
 		return -1;
 	}
 
-	request_code_t req_code = READN;
-	if (send_reqcode(req_code) == -1)
+	int req_id = new_request_id(conn);
+	if (send_reqcode(conn, req_id, req_code) == -1)
 		return -1;
 
-	if (send_N(N) == -1)
+	if (req_code == READN_CURSOR && send_size(conn, *cursor) == -1)
 		return -1;
-		
-	response_code_t resp_code;
-	if (receive_respcode(&resp_code) == -1)
+
+	if (send_N(conn, N) == -1)
 		return -1;
 
-	set_errno(resp_code);
+	if (req_code == READN_CURSOR && send_size(conn, max_bytes) == -1)
+		return -1;
+		
+	if (receive_response(conn, req_id, NULL) == -1 || errno != 0)
+		return -1;
 
-	if (errno != 0)
+	// ricevo, in caso di READN_CURSOR, il cursore per il batch successivo
+	if (req_code == READN_CURSOR && receive_size(conn, cursor) == -1)
 		return -1;
 	
 	int files_received = 0;
-	if (receive_files(dirname, &files_received) == -1) {
+	if (receive_files(conn, dirname, &files_received) == -1) {
 		if (errno != EFAULT)
 			return -1;
 	}
@@ -746,24 +2175,42 @@ int readNFiles(int N, const char* dirname) {
 	return files_received;
 }
 
-int writeFile(const char* pathname, const char* dirname) {
+/**
+ * @function               write_file()
+ * @brief                  Invia al server il contenuto del file locale source da scrivere nel file pathname con codice di 
+ *                         richiesta req_code (WRITE, OPEN_WRITE_CLOSE o APPEND), memorizzando in dirname gli eventuali 
+ *                         file espulsi dal server.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_code         Codice della richiesta
+ * @param pathname         Il path del file da scrivere nel server
+ * @param source           Il path del file locale da inviare (coincide con pathname per WRITE e OPEN_WRITE_CLOSE)
+ * @param dirname          Il path della directory in cui memorizzare gli eventuali file espulsi dal server
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore 
+ *                         (come in writeFile()).
+ */
+static int write_file(fss_conn_t* conn, request_code_t req_code, 
+						const char* pathname, 
+						const char* source, 
+						const char* dirname) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
-		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL ||
+		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL || !source ||
 		(dirname && strlen(dirname) == 0) || (dirname && strlen(dirname) > (PATH_MAX-1))) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
-	// apro il file pathname
+	// apro il file source
 	int errnosv = 0;
 	FILE * file;
-	file = fopen(pathname, "r+");
+	file = fopen(source, "r");
 	if (!file) {
 		switch (errno) {
 			case EACCES:
@@ -801,80 +2248,73 @@ int writeFile(const char* pathname, const char* dirname) {
 		return -1; 
 	}
 
-	// ricavo la size di pathname
+	// ricavo la size di source
 	struct stat statbuf;
-	if (stat(pathname, &statbuf) == -1) {
+	if (fstat(fileno(file), &statbuf) == -1) {
 		fclose(file);
 		errno = ECOMM;
 		return -1;
 	}
 	size_t buf_size = statbuf.st_size;
 
-	// controllo che pathname sia un file regolare
+	// controllo che source sia un file regolare
 	if (!S_ISREG(statbuf.st_mode)) {
 		fclose(file);
 		errno = EINVAL;
 		return -1;
 	}
 
-	void* buf = NULL;
-	if (buf_size != 0) {
-		// alloco un buffer per leggere il contenuto del file pathname
-		buf = malloc(buf_size);
-		if (!buf) {
-			fclose(file);
-			errno = ECOMM;
-			return -1;
-		}
-
-		// leggo il contenuto del file pathname
-		if (fread(buf, 1, buf_size, file) != buf_size) {
-			fclose(file);
-			free(buf);
-			errno = ECOMM;
-			return -1;
-		}
+	// invio la richiesta, il file viene inviato senza caricarlo interamente in memoria
+	int req_id = new_request_id(conn);
+	if (send_reqcode(conn, req_id, req_code) == -1 || 
+		send_pathname(conn, pathname) == -1 || 
+		send_file_stream(conn, file, buf_size) == -1) {
+		fclose(file);
+		return -1;
 	}
-	// chiudo il file pathname
+	// chiudo il file source
 	if (fclose(file) == -1) {
-		free(buf);
 		errno = ECOMM;
 		return -1;
 	}
 	
-	request_code_t req_code = WRITE;
-	if (send_reqcode(req_code) == -1) {
-		free(buf);
-		return -1;
-	}
-	if (send_pathname(pathname) == -1) {
-		free(buf);
+	if (receive_response(conn, req_id, NULL) == -1 || errno != 0)
 		return -1;
+
+	if (req_code == APPEND) {
+		PRINT(" : %zu bytes scritti in append", buf_size);
 	}
-	if (send_file_content(buf, buf_size) == -1) {
-		free(buf);
-		return -1;
+	else {
+		PRINT(" : %zu bytes scritti", buf_size);
 	}
-	if (buf)
-		free(buf);
-	
-	response_code_t resp_code;
-	if (receive_respcode(&resp_code) == -1)
-		return -1;
 
-	set_errno(resp_code);
-
-	if (errno != 0)
-		return -1;
-
-	PRINT(" : %zu bytes scritti", buf_size);
-
-	if (receive_files(dirname, NULL) == -1)
+	if (receive_files(conn, dirname, NULL) == -1)
 		return -1;
 	return 0;
 }
 
-int appendToFile(const char* pathname, void* buf, size_t size, const char* dirname) {
+/**
+ * @function               append_to_file()
+ * @brief                  Invia al server i size bytes di buf da scrivere nel file pathname in append (APPEND) o a partire 
+ *                         da offset (WRITE_AT), memorizzando in dirname gli eventuali file espulsi dal server.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_code         Codice della richiesta (APPEND o WRITE_AT)
+ * @param pathname         Il path del file su cui scrivere
+ * @param offset           L'offset da cui scrivere (considerato solo per WRITE_AT)
+ * @param buf              Il buffer con i byte da scrivere
+ * @param size             La size del buffer buf
+ * @param dirname          Il path della directory in cui memorizzare gli eventuali file espulsi dal server
+ * 
+ * @return                 0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore 
+ *                         (come in appendToFile()).
+ */
+static int append_to_file(fss_conn_t* conn, request_code_t req_code, 
+						const char* pathname, 
+						size_t offset, 
+						void* buf, 
+						size_t size, 
+						const char* dirname) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL ||
 		(size != 0 && !buf) ||
@@ -884,9 +2324,9 @@ int appendToFile(const char* pathname, void* buf, size_t size, const char* dirna
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
@@ -907,106 +2347,862 @@ int appendToFile(const char* pathname, void* buf, size_t size, const char* dirna
 		return -1;
 	}
 
-	request_code_t req_code = APPEND;
-	if (send_reqcode(req_code) == -1)
+	int req_id = new_request_id(conn);
+	if (send_reqcode(conn, req_id, req_code) == -1)
 		return -1;
 	
-	if (send_pathname(pathname) == -1)
+	if (send_pathname(conn, pathname) == -1)
 		return -1;
 
-	if (send_file_content(buf, size) == -1)
+	if (req_code == WRITE_AT && send_size(conn, offset) == -1)
 		return -1;
 
-	response_code_t resp_code;
-	if (receive_respcode(&resp_code) == -1)
+	if (send_file_content(conn, buf, size) == -1)
 		return -1;
 
-	set_errno(resp_code);
-
-	if (errno != 0)
+	if (receive_response(conn, req_id, NULL) == -1 || errno != 0)
 		return -1;
 
-	PRINT(" : %zu bytes scritti in append", size);
+	if (req_code == WRITE_AT) {
+		PRINT(" : %zu bytes scritti a partire dall'offset %zu", size, offset);
+	}
+	else {
+		PRINT(" : %zu bytes scritti in append", size);
+	}
 	
-	if (receive_files(dirname, NULL) == -1)
+	if (receive_files(conn, dirname, NULL) == -1)
 		return -1;
 	return 0;
 }
 
-int lockFile(const char* pathname) {
+/**
+ * @function               lock_file()
+ * @brief                  Implementa lockFile() sulla connessione conn, la cui mutex deve essere già stata acquisita.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 Come lockFile().
+ */
+static int lock_file(fss_conn_t* conn, const char* pathname) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 	
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
 	request_code_t req_code = LOCK;
-	if (do_simple_request(req_code, pathname) == -1 || (errno != 0 && errno != EALREADY))
+	if (do_simple_request(conn, req_code, pathname) == -1 || (errno != 0 && errno != EALREADY))
 		return -1;
 	if (errno == EALREADY)
 		errno = 0;
 	return 0;
 }
 
-int unlockFile(const char* pathname) {
+/**
+ * @function               unlock_file()
+ * @brief                  Implementa unlockFile() sulla connessione conn, la cui mutex deve essere già stata acquisita.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 Come unlockFile().
+ */
+static int unlock_file(fss_conn_t* conn, const char* pathname) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
 	request_code_t req_code = UNLOCK;
-	if (do_simple_request(req_code, pathname) == -1 || errno != 0)
+	if (do_simple_request(conn, req_code, pathname) == -1 || errno != 0)
 		return -1;
 	return 0;
 }
 
-int closeFile(const char* pathname) {
+/**
+ * @function               close_file()
+ * @brief                  Implementa closeFile() sulla connessione conn, la cui mutex deve essere già stata acquisita.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 Come closeFile().
+ */
+static int close_file(fss_conn_t* conn, const char* pathname) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
+	// dopo la chiusura il server deve verificare che il file sia stato riaperto prima di una nuova lettura
+	cache_unreadable(conn, pathname);
+
 	request_code_t req_code = CLOSE;
-	if (do_simple_request(req_code, pathname) == -1 || errno != 0)
+	if (do_simple_request(conn, req_code, pathname) == -1 || errno != 0)
 		return -1;
 	return 0;
 }
 
-int removeFile(const char* pathname) {
+/**
+ * @function               remove_file()
+ * @brief                  Implementa removeFile() sulla connessione conn, la cui mutex deve essere già stata acquisita.
+ * 
+ * @param conn             Connessione con il server
+ * 
+ * @return                 Come removeFile().
+ */
+static int remove_file(fss_conn_t* conn, const char* pathname) {
 	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
 		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	// controllo se la connessione è stata aperta
-	if (g_socket_fd == -1) {
-		errno = ECOMM;
+	// controllo che non ci siano richieste inviate in pipeline in attesa di risposta
+	if (conn->pending_num != 0) {
+		errno = EINPROGRESS;
 		return -1;
 	}
 
 	request_code_t req_code = REMOVE;
-	if (do_simple_request(req_code, pathname) == -1 || errno != 0)
+	if (do_simple_request(conn, req_code, pathname) == -1 || errno != 0)
 		return -1;
 	return 0;
-}
\ No newline at end of file
+}
+/**
+ * @function               add_pending_request()
+ * @brief                  Registra la richiesta inviata req_id in una posizione libera tra quelle in attesa di risposta.
+ * @warning                Questa funzione deve essere invocata dopo aver controllato che vi siano meno di 
+ *                         MAX_PENDING_REQUESTS richieste in attesa di risposta.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_id           Identificativo della richiesta
+ * @param req_code         Codice della richiesta
+ * @param callback         Funzione da invocare al completamento della richiesta (può essere @c NULL)
+ * @param arg              Argomento da passare a callback
+ * @param dirname          Directory (allocata sullo heap) in cui memorizzare i file espulsi dal server, può essere @c NULL
+ */
+static void add_pending_request(fss_conn_t* conn, int req_id, 
+								request_code_t req_code, 
+								fss_callback_t callback, 
+								void* arg, 
+								char* dirname) {
+	for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
+		if (conn->pending[i].id == NO_REQ_ID) {
+			conn->pending[i].id = req_id;
+			conn->pending[i].code = req_code;
+			conn->pending[i].callback = callback;
+			conn->pending[i].arg = arg;
+			conn->pending[i].dirname = dirname;
+			conn->pending_num++;
+			return;
+		}
+	}
+}
+
+/**
+ * @function               send_pipelined_request()
+ * @brief                  Invia al server il codice di richiesta req_code e il path del file relativo alla richiesta 
+ *                         senza attenderne la risposta, registrando la richiesta tra quelle in attesa di risposta.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_code         Codice di richiesta da inviare
+ * @param pathname         Path del file da inviare
+ * @param callback         Funzione da invocare al completamento della richiesta (può essere @c NULL)
+ * @param arg              Argomento da passare a callback
+ * 
+ * @return                 L'identificativo (> 0) della richiesta inviata in caso di successo, -1 in caso di fallimento 
+ *                         con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         EAGAIN        se ci sono già MAX_PENDING_REQUESTS richieste in attesa di risposta
+ *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
+ *                                       l'operazione
+ *                         ECONNRESET    se il server ha chiuso la connessione
+ *                         EINVAL        se pathname è @c NULL o è lungo 0 o > PATH_MAX-1, se pathname non è un path 
+ *                                       assoluto o se contiene ','
+ */
+static int send_pipelined_request(fss_conn_t* conn, request_code_t req_code, 
+								const char* pathname, 
+								fss_callback_t callback, 
+								void* arg) {
+	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
+		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// controllo che ci sia spazio per un'altra richiesta in attesa di risposta
+	if (conn->pending_num == MAX_PENDING_REQUESTS) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	// compongo la richiesta in un unico buffer e la invio con una sola scrittura: con molte richieste in attesa di 
+	// risposta il socket buffer si riempirebbe altrimenti di piccoli segmenti, bloccando l'invio (e quindi la 
+	// ricezione delle risposte) ben prima di MAX_PENDING_REQUESTS richieste
+	int req_id = new_request_id(conn);
+	size_t pathname_len = strlen(pathname) + 1;
+	char request[sizeof(int) + sizeof(request_code_t) + sizeof(size_t) + PATH_MAX + sizeof(size_t)];
+	char* p = request;
+	memcpy(p, &req_id, sizeof(int));
+	p += sizeof(int);
+	memcpy(p, &req_code, sizeof(request_code_t));
+	p += sizeof(request_code_t);
+	memcpy(p, &pathname_len, sizeof(size_t));
+	p += sizeof(size_t);
+	memcpy(p, pathname, pathname_len);
+	p += pathname_len;
+	// dopo la chiusura il server deve verificare che il file sia stato riaperto prima di una nuova lettura
+	if (req_code == CLOSE)
+		cache_unreadable(conn, pathname);
+	if (req_code == READ && conn->invalidation) {
+		// la risposta non viene inserita nella cache, invio la versione 0 (file non in cache)
+		size_t version = 0;
+		memcpy(p, &version, sizeof(size_t));
+		p += sizeof(size_t);
+	}
+	int r = writen(conn->fd, request, p - request);
+	if (r == -1 || r == 0) {
+		if (errno == EPIPE)
+			errno = ECONNRESET;
+		else
+			errno = ECOMM;
+		return -1;
+	}
+
+	add_pending_request(conn, req_id, req_code, callback, arg, NULL);
+	return req_id;
+}
+
+/**
+ * @function               send_pipelined_write()
+ * @brief                  Invia al server una richiesta WRITE, con il contenuto del file locale pathname, o APPEND, con i 
+ *                         size bytes di buf, senza attenderne la risposta, registrando la richiesta tra quelle in attesa 
+ *                         di risposta insieme alla directory dirname in cui memorizzare gli eventuali file espulsi.
+ *                         Il contenuto viene inviato prima di ritornare.
+ * 
+ * @param conn             Connessione con il server
+ * @param req_code         Codice di richiesta da inviare (WRITE o APPEND)
+ * @param pathname         Path del file da scrivere
+ * @param buf              Il buffer con i bytes da scrivere (considerato solo per APPEND)
+ * @param size             La size del buffer buf (considerato solo per APPEND)
+ * @param dirname          Il path della directory in cui memorizzare gli eventuali file espulsi dal server
+ * @param callback         Funzione da invocare al completamento della richiesta
+ * @param arg              Argomento da passare a callback
+ * 
+ * @return                 L'identificativo (> 0) della richiesta inviata in caso di successo, -1 in caso di fallimento 
+ *                         con errno settato ad indicare l'errore.
+ *                         In caso di fallimento errno può assumere i seguenti valori:
+ *                         EAGAIN        se ci sono già MAX_PENDING_REQUESTS richieste in attesa di risposta
+ *                         ECOMM         se si è verificato un errore lato client che non ha reso possibile effettuare 
+ *                                       l'operazione
+ *                         ECONNRESET    se il server ha chiuso la connessione
+ *                         EINVAL        se i parametri non sono validi (come in writeFile() e appendToFile())
+ */
+static int send_pipelined_write(fss_conn_t* conn, request_code_t req_code, 
+								const char* pathname, 
+								void* buf, 
+								size_t size, 
+								const char* dirname, 
+								fss_callback_t callback, 
+								void* arg) {
+	if (!pathname || strlen(pathname) == 0 || strlen(pathname) > (PATH_MAX-1) ||
+		pathname != strchr(pathname, '/') || strchr(pathname, ',') != NULL ||
+		(req_code == APPEND && size != 0 && !buf) ||
+		(dirname && strlen(dirname) == 0) || (dirname && strlen(dirname) > (PATH_MAX-1))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// controllo che ci sia spazio per un'altra richiesta in attesa di risposta
+	if (conn->pending_num == MAX_PENDING_REQUESTS) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	// apro, in caso di WRITE, il file da inviare
+	FILE* file = NULL;
+	if (req_code == WRITE) {
+		file = fopen(pathname, "r");
+		if (!file) {
+			switch (errno) {
+				case EACCES:
+				case EISDIR:
+				case ELOOP:
+				case ENAMETOOLONG:
+				case ENOENT:
+				case ENOTDIR:
+				case EOVERFLOW:
+				case EINTR:
+					errno = EINVAL;
+					break; 
+				default:
+					errno = ECOMM;
+			}
+			return -1;
+		}
+		// ricavo la size del file e controllo che sia un file regolare
+		struct stat statbuf;
+		if (fstat(fileno(file), &statbuf) == -1) {
+			fclose(file);
+			errno = ECOMM;
+			return -1;
+		}
+		if (!S_ISREG(statbuf.st_mode)) {
+			fclose(file);
+			errno = EINVAL;
+			return -1;
+		}
+		size = statbuf.st_size;
+	}
+
+	// creo, se non esiste, la directory in cui memorizzare i file espulsi dal server e ne copio il path
+	char* dirname_copy = NULL;
+	if (dirname) {
+		int errnosv = 0;
+		if (mkdirr(dirname) == -1) {
+			switch (errno) {
+				case ENAMETOOLONG:
+				case EACCES:
+				case ELOOP:
+				case EMLINK:
+				case ENOSPC:
+				case EROFS:
+					errnosv = EINVAL;
+					break;
+				default:
+					errnosv = ECOMM;
+			}
+		}
+		else if ((dirname_copy = malloc(strlen(dirname) + 1)) == NULL)
+			errnosv = ECOMM;
+		if (errnosv != 0) {
+			if (file)
+				fclose(file);
+			errno = errnosv;
+			return -1;
+		}
+		strcpy(dirname_copy, dirname);
+	}
+
+	// invio la richiesta, il file viene inviato senza caricarlo interamente in memoria
+	int req_id = new_request_id(conn);
+	int r = 0;
+	if (send_reqcode(conn, req_id, req_code) == -1 || send_pathname(conn, pathname) == -1)
+		r = -1;
+	else if (file)
+		r = send_file_stream(conn, file, size);
+	else
+		r = send_file_content(conn, buf, size);
+	if (file && fclose(file) == -1 && r == 0) {
+		errno = ECOMM;
+		r = -1;
+	}
+	if (r == -1) {
+		if (dirname_copy)
+			free(dirname_copy);
+		return -1;
+	}
+
+	add_pending_request(conn, req_id, req_code, callback, arg, dirname_copy);
+	return req_id;
+}
+
+/**
+ * @function               receive_pipelined_response()
+ * @brief                  Implementa receiveResponse() sulla connessione conn, la cui mutex deve essere già stata acquisita.
+ *                         Se callback e arg non sono @c NULL vi vengono restituiti la funzione e l'argomento registrati 
+ *                         con la richiesta a cui si riferisce la risposta.
+ * 
+ * @param conn             Connessione con il server
+ * @param callback         Funzione da invocare al completamento della richiesta (può essere @c NULL)
+ * @param arg              Argomento da passare a callback (può essere @c NULL)
+ * 
+ * @return                 Come receiveResponse().
+ */
+static int receive_pipelined_response(fss_conn_t* conn, int* req_id, 
+									void** buf, 
+									size_t* size, 
+									fss_callback_t* callback, 
+									void** arg) {
+	// controllo che ci siano richieste in attesa di risposta
+	if (conn->pending_num == 0) {
+		errno = ENOMSG;
+		return -1;
+	}
+
+	int resp_id;
+	response_code_t resp_code;
+	if (receive_respcode(conn, &resp_id, &resp_code) == -1)
+		return -1;
+
+	// cerco la richiesta a cui si riferisce la risposta
+	int i;
+	for (i = 0; i < MAX_PENDING_REQUESTS; i++) {
+		if (resp_id != NO_REQ_ID && conn->pending[i].id == resp_id)
+			break;
+	}
+	if (i == MAX_PENDING_REQUESTS) {
+		errno = EPROTO;
+		return -1;
+	}
+	request_code_t req_code = conn->pending[i].code;
+	if (callback && arg) {
+		*callback = conn->pending[i].callback;
+		*arg = conn->pending[i].arg;
+	}
+	char* dirname = conn->pending[i].dirname;
+	conn->pending[i].id = NO_REQ_ID;
+	conn->pending[i].dirname = NULL;
+	conn->pending_num--;
+	*req_id = resp_id;
+
+	// setto errno in base al codice di risposta ricevuto
+	set_errno(resp_code);
+	if (errno != 0) {
+		if (dirname)
+			free(dirname);
+		// una richiesta di lock su un file già bloccato dal client ha successo
+		if (req_code == LOCK && errno == EALREADY) {
+			errno = 0;
+			return 0;
+		}
+		return -1;
+	}
+
+	if (req_code == WRITE || req_code == APPEND) {
+		// ricevo gli eventuali file espulsi e li memorizzo nella directory registrata con la richiesta
+		int r = receive_files(conn, dirname, NULL);
+		if (dirname)
+			free(dirname);
+		if (r == -1) {
+			// se non è stato possibile scrivere i file la risposta è comunque stata consumata
+			if (errno != EFAULT)
+				*req_id = NO_REQ_ID;
+			return -1;
+		}
+	}
+
+	if (req_code == READ) {
+		// ricevo, se la connessione ha la cache, la versione del file (il path della richiesta non è memorizzato, il 
+		// file non viene inserito nella cache)
+		size_t file_version;
+		if (conn->invalidation && receive_size(conn, &file_version) == -1) {
+			*req_id = NO_REQ_ID;
+			return -1;
+		}
+		// ricevo il contenuto del file
+		void* content = NULL;
+		size_t content_size;
+		if (receive_file_content(conn, &content, &content_size) == -1) {
+			*req_id = NO_REQ_ID;
+			return -1;
+		}
+		// verifico il checksum del contenuto ricevuto (in caso di errore la risposta è comunque stata consumata)
+		if (receive_checksum(conn, content, content_size) == -1) {
+			if (content)
+				free(content);
+			return -1;
+		}
+		if (buf && size) {
+			*buf = content;
+			*size = content_size;
+		}
+		else if (content)
+			free(content);
+	}
+	return 0;
+}
+
+
+int fss_openFile(fss_conn_t* conn, const char* pathname, int flags) {
+	LOCKED_CALL(conn, open_file(conn, pathname, flags));
+}
+
+int fss_readFile(fss_conn_t* conn, const char* pathname, void** buf, size_t* size) {
+	LOCKED_CALL(conn, read_file(conn, READ, pathname, 0, 0, NULL, buf, size));
+}
+
+int fss_openReadCloseFile(fss_conn_t* conn, const char* pathname, void** buf, size_t* size) {
+	LOCKED_CALL(conn, read_file(conn, OPEN_READ_CLOSE, pathname, 0, 0, NULL, buf, size));
+}
+
+int fss_readFileRange(fss_conn_t* conn, const char* pathname, size_t offset, size_t length, void** buf, size_t* size) {
+	LOCKED_CALL(conn, read_file(conn, READ_RANGE, pathname, offset, length, NULL, buf, size));
+}
+
+int fss_readFileIfNewer(fss_conn_t* conn, const char* pathname, size_t* version, void** buf, size_t* size) {
+	LOCKED_CALL(conn, read_file(conn, READ_IF_NEWER, pathname, 0, 0, version, buf, size));
+}
+
+int fss_readNFiles(fss_conn_t* conn, int N, const char* dirname) {
+	LOCKED_CALL(conn, read_n_files(conn, READN, N, NULL, 0, dirname));
+}
+
+int fss_readNFilesCursor(fss_conn_t* conn, size_t* cursor, int N, size_t max_bytes, const char* dirname) {
+	if (!cursor) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	LOCKED_CALL(conn, read_n_files(conn, READN_CURSOR, N, cursor, max_bytes, dirname));
+}
+
+int fss_writeFile(fss_conn_t* conn, const char* pathname, const char* dirname) {
+	LOCKED_CALL(conn, write_file(conn, WRITE, pathname, pathname, dirname));
+}
+
+int fss_openWriteCloseFile(fss_conn_t* conn, const char* pathname, const char* dirname) {
+	LOCKED_CALL(conn, write_file(conn, OPEN_WRITE_CLOSE, pathname, pathname, dirname));
+}
+
+int fss_appendFileToFile(fss_conn_t* conn, const char* pathname, const char* source, const char* dirname) {
+	LOCKED_CALL(conn, write_file(conn, APPEND, pathname, source, dirname));
+}
+
+int fss_appendToFile(fss_conn_t* conn, const char* pathname, void* buf, size_t size, const char* dirname) {
+	LOCKED_CALL(conn, append_to_file(conn, APPEND, pathname, 0, buf, size, dirname));
+}
+
+int fss_writeFileAt(fss_conn_t* conn, const char* pathname, size_t offset, void* buf, size_t size, const char* dirname) {
+	LOCKED_CALL(conn, append_to_file(conn, WRITE_AT, pathname, offset, buf, size, dirname));
+}
+
+int fss_lockFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, lock_file(conn, pathname));
+}
+
+int fss_unlockFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, unlock_file(conn, pathname));
+}
+
+int fss_closeFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, close_file(conn, pathname));
+}
+
+int fss_removeFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, remove_file(conn, pathname));
+}
+
+int fss_sendOpenFile(fss_conn_t* conn, const char* pathname, int flags) {
+	request_code_t req_code;
+	if (flags_to_reqcode(flags, &req_code) == -1) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, req_code, pathname, NULL, NULL));
+}
+
+int fss_sendReadFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, send_pipelined_request(conn, READ, pathname, NULL, NULL));
+}
+
+int fss_sendLockFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, send_pipelined_request(conn, LOCK, pathname, NULL, NULL));
+}
+
+int fss_sendUnlockFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, send_pipelined_request(conn, UNLOCK, pathname, NULL, NULL));
+}
+
+int fss_sendCloseFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, send_pipelined_request(conn, CLOSE, pathname, NULL, NULL));
+}
+
+int fss_sendRemoveFile(fss_conn_t* conn, const char* pathname) {
+	LOCKED_CALL(conn, send_pipelined_request(conn, REMOVE, pathname, NULL, NULL));
+}
+
+int fss_receiveResponse(fss_conn_t* conn, int* req_id, void** buf, size_t* size) {
+	if (!req_id) {
+		errno = EINVAL;
+		return -1;
+	}
+	*req_id = NO_REQ_ID;
+
+	LOCKED_CALL(conn, receive_pipelined_response(conn, req_id, buf, size, NULL, NULL));
+}
+
+int fss_getPendingRequests(fss_conn_t* conn) {
+	if (!conn || pthread_mutex_lock(&(conn->mutex)) != 0)
+		return 0;
+	int pending_num = conn->pending_num;
+	pthread_mutex_unlock(&(conn->mutex));
+	return pending_num;
+}
+
+int fss_getFd(fss_conn_t* conn) {
+	LOCKED_CALL(conn, conn->fd);
+}
+
+int fss_asyncOpenFile(fss_conn_t* conn, const char* pathname, int flags, fss_callback_t callback, void* arg) {
+	request_code_t req_code;
+	if (!callback || flags_to_reqcode(flags, &req_code) == -1) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, req_code, pathname, callback, arg));
+}
+
+int fss_asyncReadFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, READ, pathname, callback, arg));
+}
+
+int fss_asyncLockFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, LOCK, pathname, callback, arg));
+}
+
+int fss_asyncUnlockFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, UNLOCK, pathname, callback, arg));
+}
+
+int fss_asyncCloseFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, CLOSE, pathname, callback, arg));
+}
+
+int fss_asyncRemoveFile(fss_conn_t* conn, const char* pathname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_request(conn, REMOVE, pathname, callback, arg));
+}
+
+int fss_asyncWriteFile(fss_conn_t* conn, const char* pathname, const char* dirname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_write(conn, WRITE, pathname, NULL, 0, dirname, callback, arg));
+}
+
+int fss_asyncAppendToFile(fss_conn_t* conn, const char* pathname, void* buf, size_t size, const char* dirname, fss_callback_t callback, void* arg) {
+	if (!callback) {
+		errno = EINVAL;
+		return -1;
+	}
+	LOCKED_CALL(conn, send_pipelined_write(conn, APPEND, pathname, buf, size, dirname, callback, arg));
+}
+
+int fss_poll(fss_conn_t* conn, int timeout) {
+	if (lock_conn(conn) == -1)
+		return -1;
+
+	// istante entro cui deve giungere la prima risposta (le notifiche di invalidazione non prolungano l'attesa)
+	struct timespec deadline = {0, 0};
+	if (timeout > 0) {
+		if (clock_gettime(CLOCK_MONOTONIC, &deadline) == -1) {
+			unlock_conn(conn);
+			errno = ECOMM;
+			return -1;
+		}
+		deadline.tv_sec += timeout / 1000;
+		deadline.tv_nsec += (long) (timeout % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec ++;
+			deadline.tv_nsec -= 1000000000;
+		}
+	}
+
+	int completed = 0;
+	while (conn->pending_num > 0) {
+		// calcolo il tempo rimanente, senza attendere se ho già ricevuto almeno una risposta
+		int remaining = timeout;
+		if (completed > 0)
+			remaining = 0;
+		else if (timeout > 0) {
+			struct timespec now;
+			if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+				unlock_conn(conn);
+				errno = ECOMM;
+				return -1;
+			}
+			long long msec = (long long) (deadline.tv_sec - now.tv_sec) * 1000 + 
+				(deadline.tv_nsec - now.tv_nsec + 999999) / 1000000;
+			remaining = msec > 0 ? (int) msec : 0;
+		}
+		// attendo la prossima risposta
+		struct pollfd pfd = {conn->fd, POLLIN, 0};
+		int r = poll(&pfd, 1, remaining);
+		if (r == -1 && errno == EINTR)
+			break;
+		if (r == -1) {
+			unlock_conn(conn);
+			errno = ECOMM;
+			return -1;
+		}
+		if (r == 0)
+			break;
+
+		// ricevo le notifiche di invalidazione, attendendo nuovamente se la socket non contiene altro
+		if (conn->invalidation) {
+			r = receive_invalidations(conn);
+			if (r == -1) {
+				unlock_conn(conn);
+				return -1;
+			}
+			if (r == 0)
+				continue;
+		}
+
+		int req_id = NO_REQ_ID;
+		void* buf = NULL;
+		size_t size = 0;
+		fss_callback_t callback = NULL;
+		void* arg = NULL;
+		int result = receive_pipelined_response(conn, &req_id, &buf, &size, &callback, &arg);
+		if (req_id == NO_REQ_ID) {
+			// non è stato possibile ricevere la risposta
+			unlock_conn(conn);
+			return -1;
+		}
+		int err = result == -1 ? errno : 0;
+		completed ++;
+
+		if (!callback) {
+			// risposta a una richiesta inviata con send*(), la scarto
+			if (buf)
+				free(buf);
+			continue;
+		}
+		// invoco la callback senza la mutex della connessione, così che possa inviare nuove richieste
+		unlock_conn(conn);
+		callback(req_id, result, err, buf, size, arg);
+		if (lock_conn(conn) == -1)
+			return completed;
+	}
+
+	unlock_conn(conn);
+	errno = 0;
+	return completed;
+}
+
+int openFile(const char* pathname, int flags) {
+	return fss_openFile(g_conn, pathname, flags);
+}
+
+int readFile(const char* pathname, void** buf, size_t* size) {
+	return fss_readFile(g_conn, pathname, buf, size);
+}
+
+int openReadCloseFile(const char* pathname, void** buf, size_t* size) {
+	return fss_openReadCloseFile(g_conn, pathname, buf, size);
+}
+
+int readFileRange(const char* pathname, size_t offset, size_t length, void** buf, size_t* size) {
+	return fss_readFileRange(g_conn, pathname, offset, length, buf, size);
+}
+
+int readFileIfNewer(const char* pathname, size_t* version, void** buf, size_t* size) {
+	return fss_readFileIfNewer(g_conn, pathname, version, buf, size);
+}
+
+int readNFiles(int N, const char* dirname) {
+	return fss_readNFiles(g_conn, N, dirname);
+}
+
+int readNFilesCursor(size_t* cursor, int N, size_t max_bytes, const char* dirname) {
+	return fss_readNFilesCursor(g_conn, cursor, N, max_bytes, dirname);
+}
+
+int writeFile(const char* pathname, const char* dirname) {
+	return fss_writeFile(g_conn, pathname, dirname);
+}
+
+int openWriteCloseFile(const char* pathname, const char* dirname) {
+	return fss_openWriteCloseFile(g_conn, pathname, dirname);
+}
+
+int appendToFile(const char* pathname, void* buf, size_t size, const char* dirname) {
+	return fss_appendToFile(g_conn, pathname, buf, size, dirname);
+}
+
+int appendFileToFile(const char* pathname, const char* source, const char* dirname) {
+	return fss_appendFileToFile(g_conn, pathname, source, dirname);
+}
+
+int writeFileAt(const char* pathname, size_t offset, void* buf, size_t size, const char* dirname) {
+	return fss_writeFileAt(g_conn, pathname, offset, buf, size, dirname);
+}
+
+int lockFile(const char* pathname) {
+	return fss_lockFile(g_conn, pathname);
+}
+
+int unlockFile(const char* pathname) {
+	return fss_unlockFile(g_conn, pathname);
+}
+
+int closeFile(const char* pathname) {
+	return fss_closeFile(g_conn, pathname);
+}
+
+int removeFile(const char* pathname) {
+	return fss_removeFile(g_conn, pathname);
+}
+
+int sendOpenFile(const char* pathname, int flags) {
+	return fss_sendOpenFile(g_conn, pathname, flags);
+}
+
+int sendReadFile(const char* pathname) {
+	return fss_sendReadFile(g_conn, pathname);
+}
+
+int sendLockFile(const char* pathname) {
+	return fss_sendLockFile(g_conn, pathname);
+}
+
+int sendUnlockFile(const char* pathname) {
+	return fss_sendUnlockFile(g_conn, pathname);
+}
+
+int sendCloseFile(const char* pathname) {
+	return fss_sendCloseFile(g_conn, pathname);
+}
+
+int sendRemoveFile(const char* pathname) {
+	return fss_sendRemoveFile(g_conn, pathname);
+}
+
+int receiveResponse(int* req_id, void** buf, size_t* size) {
+	return fss_receiveResponse(g_conn, req_id, buf, size);
+}
+
+int getPendingRequests() {
+	return fss_getPendingRequests(g_conn);
+}
@@ -31,6 +31,7 @@ cmdline_operation_t* cmdline_operation_create(char operation) {
 	cmdline_operation->files = NULL;
 	cmdline_operation->time = -1;
 	cmdline_operation->n = 0;
+	cmdline_operation->jobs = 0;
 	return cmdline_operation;
 }
 
@@ -79,6 +80,8 @@ void cmdline_operation_print(cmdline_operation_t* cmdline_operation) {
 		printf(" -D %s", cmdline_operation->dirname_out);
 	if (cmdline_operation->time != -1)
 		printf(" -t %ld", cmdline_operation->time);
+	if (cmdline_operation->jobs != 0)
+		printf(" -j %d", cmdline_operation->jobs);
 	if (cmdline_operation->operation == 'R' || cmdline_operation->operation == 'w')
 		printf(" n=%d", cmdline_operation->n);
 	printf("\n");
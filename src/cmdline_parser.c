@@ -17,6 +17,11 @@
 #include <protocol.h>
 #include <util.h>
 
+/* Massimo numero di connessioni con cui scrivere i file in parallelo (-j) */
+#define MAX_JOBS 64
+/* Massimo numero di richieste al secondo a ciclo aperto (-O) */
+#define MAX_RATE 1000000
+
 /**
  * @def             PRINT_NEEDS_ARG()
  * @brief           Stampa sullo stderr che l'opzione option necessita un argomento.
@@ -65,7 +70,8 @@ static void usage(char* prog) {
 	printf("options:\n\n"
 		"-h			  stampa il messaggio di help\n\n"
 		"-f filename		  permette di specificare il path della socket per la\n"
-		"			  connessione con il server\n\n"
+		"			  connessione con il server, o tcp:host:porta per una\n"
+		"			  connessione TCP\n\n"
 		"-w dirname[,n=0]	  invia al server una richiesta di scrittura di 'n' file\n"
 		"			  presenti nella directory 'dirname'; se n=0, non è\n"
 		"			  specificato, è negativo o è maggiore del numero di file\n"
@@ -91,6 +97,13 @@ static void usage(char* prog) {
 		"-t time		  permette di specificare il tempo di attesa tra la\n"
 		"			  ricezione della risposta del server a una richiesta\n"
 		"			  e l'invio di una richiesta successiva\n\n"
+		"-O rate		  invia le richieste a ciclo aperto al ritmo di 'rate'\n"
+		"			  richieste al secondo, indipendentemente dal tempo di\n"
+		"			  risposta del server, e misura la latenza di ciascuna\n"
+		"			  richiesta dall'istante in cui avrebbe dovuto essere\n"
+		"			  inviata; non può essere specificata con -t\n\n"
+		"-j n			  permette di specificare il numero di connessioni\n"
+		"			  con cui scrivere in parallelo i file di -w o -W\n\n"
 		"-l file1[,file2]	  invia al server una richiesta di lock dei file\n"
 		"			  specificati\n\n"
 		"-u file1[,file2]	  invia al server una richiesta di unlock dei file\n"
@@ -98,10 +111,14 @@ static void usage(char* prog) {
 		"-c file1[,file2]	  invia al server una richiesta di eliminazione dei file\n"
 		"			  specificati\n\n"
 		"-p			  abilita le stampe per ogni operazione\n\n"
+		"-z			  abilita la compressione del contenuto dei file\n"
+		"			  trasferiti tra client e server\n\n"
+		"-k			  abilita la verifica del checksum dei file letti\n"
+		"			  con -r\n\n"
 		"I path dei file specificati possono essere relativi o assoluti\n");
 }
 
-list_t* cmdline_parser(int argc, char* argv[], char** socket_path) {
+list_t* cmdline_parser(int argc, char* argv[], char** socket_path, long* rate) {
 	int errnosv;
 	cmdline_operation_t* cmdline_operation = NULL;
 	// inizializzo una lista in cui memorizzare cmdline_operation
@@ -113,7 +130,7 @@ list_t* cmdline_parser(int argc, char* argv[], char** socket_path) {
 	}
 	// utilizzo getopt per il riconoscimento delle opzioni
 	int option;
-	while ((option = getopt(argc, argv, ":hpf:w:W:a:D:r:R:d:t:l:u:c:")) != -1) {
+	while ((option = getopt(argc, argv, ":hpzkf:w:W:a:D:r:R:d:t:j:l:u:c:O:")) != -1) {
 		cmdline_operation = NULL;
 		switch (option) {
 			case 'f': // -f filename
@@ -416,6 +433,81 @@ list_t* cmdline_parser(int argc, char* argv[], char** socket_path) {
 					goto cmdline_parser_exit;
 				}
 				break;
+			case 'j': { // -j n
+				errno = 0;
+				// estraggo dalla lista di operazioni l'ultima operazione aggiunta
+				cmdline_operation = list_head_remove(cmdline_operation_list);
+				if (errno != 0) {
+					errnosv = errno;
+					fprintf(stderr, "ERR: %s\n", strerror(errno));
+					goto cmdline_parser_exit;
+				}
+				// controllo se l'opzione è stata specificata congiuntamente a un'operazione di scrittura
+				if (cmdline_operation == NULL || 
+					(cmdline_operation->operation != 'w' && cmdline_operation->operation != 'W')) {
+					fprintf(stderr, "ERR: l'opzione -j deve essere specificata congiuntamente a -w o -W\n");
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				// controllo se l'opzione -j è già stata specificata per l'ultima operazione aggiunta
+				if (cmdline_operation->jobs != 0) {
+					fprintf(stderr, "ERR: l'opzione -j può essere specificata una sola volta congiuntamente a -w o "
+						"-W\n");
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				// controllo se l'opzione non ha argomento
+				if (optarg[0] == '-') { 
+					PRINT_NEEDS_ARG(option);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				// controllo se l'argomento è valido
+				long jobs;
+				if (is_number(optarg, &jobs) != 0) {
+					PRINT_NOT_A_NUMBER(optarg);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				if (jobs <= 0 || jobs > MAX_JOBS) {
+					fprintf(stderr, "ERR: l'argomento di -j deve essere compreso tra 1 e %d\n", MAX_JOBS);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				cmdline_operation->jobs = jobs;
+				// aggiungo l'operazione alla lista
+				if (list_head_insert(cmdline_operation_list, cmdline_operation) == -1) {
+					errnosv = errno;
+					fprintf(stderr, "ERR: %s\n", strerror(errno));
+					goto cmdline_parser_exit;
+				}
+				break;
+			}
+			case 'O': // -O rate
+				// controllo se l'opzione è già stata specificata
+				if (*rate != 0) {
+					PRINT_ONLY_ONCE(option);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				// controllo se l'opzione non ha argomento
+				if (optarg[0] == '-') { 
+					PRINT_NEEDS_ARG(option);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				// controllo se l'argomento è valido
+				if (is_number(optarg, rate) != 0) {
+					PRINT_NOT_A_NUMBER(optarg);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				if (*rate <= 0 || *rate > MAX_RATE) {
+					fprintf(stderr, "ERR: l'argomento di -O deve essere compreso tra 1 e %d\n", MAX_RATE);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				break;
 			case 'p': // -p
 				// abilito le stampe sullo stdout
 				if (enable_printing() == -1) {
@@ -424,6 +516,22 @@ list_t* cmdline_parser(int argc, char* argv[], char** socket_path) {
 					goto cmdline_parser_exit;
 				}
 				break;
+			case 'z': // -z
+				// abilito la compressione del contenuto dei file
+				if (enable_compression() == -1) {
+					PRINT_ONLY_ONCE(option);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				break;
+			case 'k': // -k
+				// abilito la verifica del checksum dei file letti
+				if (enable_checksum() == -1) {
+					PRINT_ONLY_ONCE(option);
+					errnosv = EINVAL;
+					goto cmdline_parser_exit;
+				}
+				break;
 			case 'h': // -h
 				// stampo il messaggio di help
 				usage(argv[0]);
@@ -471,6 +579,18 @@ list_t* cmdline_parser(int argc, char* argv[], char** socket_path) {
 		}
 		strcpy(*socket_path, DEFAULT_SOCKET_PATH);
 	}
+	/* il tempo di attesa di -t dipende dalla ricezione delle risposte del server, è quindi incompatibile con 
+	   l'invio delle richieste a ciclo aperto */
+	if (*rate != 0) {
+		list_for_each(cmdline_operation_list, cmdline_operation) {
+			if (cmdline_operation->time != -1) {
+				fprintf(stderr, "ERR: l'opzione -O non può essere specificata congiuntamente a -t\n");
+				cmdline_operation = NULL;
+				errnosv = EINVAL;
+				goto cmdline_parser_exit;
+			}
+		}
+	}
 	// estraggo l'ultima operazione aggiunta alla lista
 	errno = 0;
 	cmdline_operation = list_head_remove(cmdline_operation_list);
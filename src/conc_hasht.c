@@ -10,11 +10,122 @@
 #include <hasht.h>
 #include <conc_hasht.h>
 
+/**
+ * @function                  segment_lock()
+ * @brief                     Acquisisce la lock del segmento idx di cht aggiornando, se abilitate, le statistiche 
+ *                            sull'acquisizione. Se la lock è posseduta da un altro thread l'acquisizione viene contata 
+ *                            come contesa.
+ *                            I contatori sono aggiornati avendo acquisito la lock e letti atomicamente da 
+ *                            conc_hasht_lock_stats() senza acquisirla.
+ *
+ * @param cht                 Tabella hash thread safe
+ * @param idx                 Indice del segmento
+ *
+ * @return                    0 in caso di successo, il codice di errore di pthread_mutex_lock() in caso di fallimento.
+ */
+static int segment_lock(conc_hasht_t* cht, unsigned int idx) {
+	if (!cht->lock_stats)
+		return pthread_mutex_lock(&cht->mutexs[idx]);
+
+	int contended = 0;
+	int r = pthread_mutex_trylock(&cht->mutexs[idx]);
+	if (r == EBUSY) {
+		contended = 1;
+		r = pthread_mutex_lock(&cht->mutexs[idx]);
+	}
+	if (r != 0)
+		return r;
+	__atomic_store_n(&cht->acquisitions[idx], cht->acquisitions[idx] + 1, __ATOMIC_RELAXED);
+	if (contended)
+		__atomic_store_n(&cht->contentions[idx], cht->contentions[idx] + 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+/**
+ * @function                  segments_init()
+ * @brief                     Alloca e inizializza le mutex ricorsive e i contatori di n_segments segmenti.
+ *
+ * @param n_segments          Numero di segmenti
+ * @param mutexs              Riferimento in cui memorizzare l'array di mutex
+ * @param mutex_attrs         Riferimento in cui memorizzare l'array di attributi delle mutex
+ * @param acquisitions        Riferimento in cui memorizzare l'array dei contatori delle acquisizioni
+ * @param contentions         Riferimento in cui memorizzare l'array dei contatori delle acquisizioni contese
+ *
+ * @return                    0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int segments_init(size_t n_segments, 
+				pthread_mutex_t** mutexs, 
+				pthread_mutexattr_t** mutex_attrs, 
+				size_t** acquisitions, 
+				size_t** contentions) {
+	int r = 0, errnosv;
+	*mutexs = (pthread_mutex_t*) malloc(n_segments * sizeof(pthread_mutex_t));
+	*mutex_attrs = (pthread_mutexattr_t*) malloc(n_segments * sizeof(pthread_mutexattr_t));
+	*acquisitions = (size_t*) calloc(n_segments, sizeof(size_t));
+	*contentions = (size_t*) calloc(n_segments, sizeof(size_t));
+	if (!*mutexs || !*mutex_attrs || !*acquisitions || !*contentions) {
+		errnosv = errno;
+		free(*mutexs);
+		free(*mutex_attrs);
+		free(*acquisitions);
+		free(*contentions);
+		errno = errnosv;
+		return -1;
+	}
+
+	// inizializzo gli attributi delle mutex, le mutex e setto gli attributi delle mutex
+	size_t i;
+	for (i = 0; i < n_segments; i ++) {
+		if ((r = pthread_mutexattr_init(&((*mutex_attrs)[i]))) != 0)
+			break;
+		if ((r = pthread_mutexattr_settype(&((*mutex_attrs)[i]), PTHREAD_MUTEX_RECURSIVE)) != 0) {
+			pthread_mutexattr_destroy(&((*mutex_attrs)[i]));
+			break;
+		}
+		if ((r = pthread_mutex_init(&((*mutexs)[i]), &((*mutex_attrs)[i]))) != 0) {
+			pthread_mutexattr_destroy(&((*mutex_attrs)[i]));
+			break;
+		}
+	}
+
+	if (r == 0)
+		return 0;
+
+	// in caso di fallimento durante l'inizializzazione dealloco quanto allocato precedentemente
+	for (size_t j = 0; j < i; j ++) {
+		pthread_mutex_destroy(&((*mutexs)[j]));
+		pthread_mutexattr_destroy(&((*mutex_attrs)[j]));
+	}
+	free(*mutexs);
+	free(*mutex_attrs);
+	free(*acquisitions);
+	free(*contentions);
+	errno = r;
+	return -1;
+}
+
+/**
+ * @function                  segments_destroy()
+ * @brief                     Distrugge le mutex e dealloca gli array associati ai segmenti di cht.
+ *
+ * @param cht                 Tabella hash thread safe
+ */
+static void segments_destroy(conc_hasht_t* cht) {
+	for (size_t i = 0; i < cht->nsegments; i ++) {
+		pthread_mutex_destroy(&(cht->mutexs[i]));
+		pthread_mutexattr_destroy(&(cht->mutex_attrs[i]));
+	}
+	free(cht->mutexs);
+	free(cht->mutex_attrs);
+	free(cht->acquisitions);
+	free(cht->contentions);
+}
+
 conc_hasht_t* conc_hasht_create(size_t n_buckets, 
 				size_t n_segments, 
 				unsigned int (*hash_function)(void*), 
 				int (*hash_key_compare)(void*, void*)) {
-	int r, errnosv;
+	int errnosv;
 	conc_hasht_t *cht = (conc_hasht_t*) malloc(sizeof(conc_hasht_t));
 	if (!cht)
 		return NULL;
@@ -29,56 +140,17 @@ conc_hasht_t* conc_hasht_create(size_t n_buckets,
 		return NULL;
 
 	cht->nsegments = n_segments > cht->ht->nbuckets? cht->ht->nbuckets : n_segments;
+	cht->lock_stats = false;
 
-	// alloco l'array di mutex associate ai segmenti
-	cht->mutexs = (pthread_mutex_t*) malloc(cht->nsegments * sizeof(pthread_mutex_t));
-	if (!cht->mutexs) {
-		errnosv = errno;
-		hasht_destroy(cht->ht, NULL, NULL);
-		free(cht);
-		errno = errnosv;
-		return NULL;
-	}
-
-	// alloco l'array di attributi delle mutex
-	cht->mutex_attrs = (pthread_mutexattr_t*) malloc(cht->nsegments * sizeof(pthread_mutexattr_t));
-	if (!cht->mutex_attrs) {
+	// alloco e inizializzo le mutex e i contatori associati ai segmenti
+	if (segments_init(cht->nsegments, &cht->mutexs, &cht->mutex_attrs, &cht->acquisitions, &cht->contentions) == -1) {
 		errnosv = errno;
 		hasht_destroy(cht->ht, NULL, NULL);
-		free(cht->mutexs);
 		free(cht);
 		errno = errnosv;
 		return NULL;
 	}
-
-	// inizializzo gli attributi delle mutex, le mutex e setto gli attributi delle mutex
-	int i;
-	for (i = 0; i < cht->nsegments; i ++) {
-		if ((r = pthread_mutexattr_init(&(cht->mutex_attrs[i]))) != 0)
-			break;
-		if ((r = pthread_mutexattr_settype(&(cht->mutex_attrs[i]), PTHREAD_MUTEX_RECURSIVE)) != 0) {
-			pthread_mutexattr_destroy(&(cht->mutex_attrs[i]));
-			break;
-		}
-		if ((r = pthread_mutex_init(&(cht->mutexs[i]), &(cht->mutex_attrs[i]))) != 0) {
-			pthread_mutexattr_destroy(&(cht->mutex_attrs[i]));
-			break;
-		}
-	}
-
-	if (r == 0)
-		return cht;
-
-	// in caso di fallimento durante l'inizializzazione dealloco quanto allocato precedentemente
-	for (int j = 0; j < i; j ++) {
-		pthread_mutex_destroy(&(cht->mutexs[j]));
-		pthread_mutexattr_destroy(&(cht->mutex_attrs[j]));
-	}
-	hasht_destroy(cht->ht, NULL, NULL);
-	free(cht->mutexs);
-	free(cht);
-	errno = r;
-	return NULL;
+	return cht;
 }
 
 void conc_hasht_destroy(conc_hasht_t *cht, void (*free_key)(void*), void (*free_value)(void*)) {
@@ -86,18 +158,7 @@ void conc_hasht_destroy(conc_hasht_t *cht, void (*free_key)(void*), void (*free_
 		return;
 
 	hasht_destroy(cht->ht, free_key, free_value);
-
-	for (int i = 0; i < cht->nsegments; i ++) {
-		if (cht->mutexs)
-			pthread_mutex_destroy(&(cht->mutexs[i]));
-		if (cht->mutex_attrs)
-			pthread_mutexattr_destroy(&(cht->mutex_attrs[i]));
-	}
-
-	if (cht->mutexs) 
-		free(cht->mutexs);
-	if (cht->mutex_attrs)
-		free(cht->mutex_attrs);
+	segments_destroy(cht);
 	free(cht);
 }
 
@@ -125,7 +186,7 @@ int conc_hasht_atomic_contains(conc_hasht_t *cht, void* key) {
 	mutex_idx = cht->nsegments == 1 ? 0 : hash_val % cht->nsegments; 
 
 	// acquisisco la lock associata al segmento
-	r = pthread_mutex_lock(&cht->mutexs[mutex_idx]);
+	r = segment_lock(cht, mutex_idx);
 	if (r != 0) {
 		errno = r;
 		return -1;
@@ -158,7 +219,7 @@ int conc_hasht_lock(conc_hasht_t* cht, void* key) {
 	mutex_idx = cht->nsegments == 1 ? 0 : hash_val % cht->nsegments; 
 
 	// acquisisco la lock associata al segmento
-	r = pthread_mutex_lock(&cht->mutexs[mutex_idx]);
+	r = segment_lock(cht, mutex_idx);
 	if (r != 0) {
 		errno = r;
 		return -1;
@@ -225,7 +286,7 @@ int conc_hasht_atomic_insert(conc_hasht_t *cht, void* key, void *value) {
 	mutex_idx = cht->nsegments == 1 ? 0 : hash_val % cht->nsegments; 
 
 	// acquisisco la lock associata al segmento
-	r = pthread_mutex_lock(&cht->mutexs[mutex_idx]);
+	r = segment_lock(cht, mutex_idx);
 	if (r != 0) {
 		errno = r;
 		return -1;
@@ -268,7 +329,7 @@ int conc_hasht_atomic_delete(conc_hasht_t *cht, void* key, void (*free_key)(void
 	mutex_idx = cht->nsegments == 1 ? 0 : hash_val % cht->nsegments; 
 
 	// acquisisco la lock associata al segmento
-	r = pthread_mutex_lock(&cht->mutexs[mutex_idx]);
+	r = segment_lock(cht, mutex_idx);
 	if (r != 0) {
 		errno = r;
 		return -1;
@@ -310,7 +371,7 @@ void* conc_hasht_atomic_delete_and_get(conc_hasht_t *cht, void* key, void (*free
 	mutex_idx = cht->nsegments == 1 ? 0 : hash_val % cht->nsegments; 
 
 	// acquisisco la lock associata al segmento
-	r = pthread_mutex_lock(&cht->mutexs[mutex_idx]);
+	r = segment_lock(cht, mutex_idx);
 	if (r != 0) {
 		errno = r;
 		return NULL;
@@ -326,4 +387,53 @@ void* conc_hasht_atomic_delete_and_get(conc_hasht_t *cht, void* key, void (*free
 	}
 
 	return value;
-}
\ No newline at end of file
+}
+
+int conc_hasht_enable_lock_stats(conc_hasht_t* cht) {
+	if (!cht) {
+		errno = EINVAL;
+		return -1;
+	}
+	cht->lock_stats = true;
+	return 0;
+}
+
+int conc_hasht_lock_stats(conc_hasht_t* cht, size_t* acquisitions, size_t* contentions) {
+	if (!cht || !acquisitions || !contentions) {
+		errno = EINVAL;
+		return -1;
+	}
+	*acquisitions = 0;
+	*contentions = 0;
+	for (size_t i = 0; i < cht->nsegments; i ++) {
+		*acquisitions += __atomic_load_n(&cht->acquisitions[i], __ATOMIC_RELAXED);
+		*contentions += __atomic_load_n(&cht->contentions[i], __ATOMIC_RELAXED);
+	}
+	return 0;
+}
+
+int conc_hasht_restripe(conc_hasht_t* cht, size_t n_segments) {
+	if (!cht || n_segments == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (n_segments > cht->ht->nbuckets)
+		n_segments = cht->ht->nbuckets;
+	if (n_segments == cht->nsegments)
+		return 0;
+
+	pthread_mutex_t* mutexs;
+	pthread_mutexattr_t* mutex_attrs;
+	size_t *acquisitions, *contentions;
+	if (segments_init(n_segments, &mutexs, &mutex_attrs, &acquisitions, &contentions) == -1)
+		return -1;
+
+	// sostituisco i segmenti (nessun thread può possedere o attendere le lock dei segmenti correnti)
+	segments_destroy(cht);
+	cht->mutexs = mutexs;
+	cht->mutex_attrs = mutex_attrs;
+	cht->acquisitions = acquisitions;
+	cht->contentions = contentions;
+	cht->nsegments = n_segments;
+	return 0;
+}
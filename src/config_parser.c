@@ -146,8 +146,14 @@ config_t* config_init() {
 	config->max_locks = DEFAULT_MAX_LOCKS;
 	config->expected_clients = DEFAULT_EXPECTED_CLIENTS;
 	config->socket_path = NULL;
+	config->tcp_port = DEFAULT_TCP_PORT;
+	config->tcp_address = NULL;
 	config->log_file_path = NULL;
 	config->eviction_policy = DEFAULT_EVICTION_POLICY;
+	config->autotune_interval = DEFAULT_AUTOTUNE_INTERVAL;
+	config->min_workers = DEFAULT_MIN_WORKERS;
+	config->max_workers = DEFAULT_MAX_WORKERS;
+	config->min_locks = DEFAULT_MIN_LOCKS;
 
 	return config;
 }
@@ -157,6 +163,8 @@ void config_destroy(config_t* config) {
 		return;
 	if (config->socket_path)
 		free(config->socket_path);
+	if (config->tcp_address)
+		free(config->tcp_address);
 	if (config->log_file_path)
 		free(config->log_file_path);
 	free(config);
@@ -169,6 +177,7 @@ int config_parser(config_t *config, char* filepath) {
 	}
 	if (filepath == NULL) {
 		STR_CPY_GOTO(DEFAULT_SOCKET_PATH, config->socket_path, config_parser_exit);
+		STR_CPY_GOTO(DEFAULT_TCP_ADDRESS, config->tcp_address, config_parser_exit);
 		STR_CPY_GOTO(DEFAULT_LOG_PATH, config->log_file_path, config_parser_exit);
 		return 0;
 	}
@@ -184,10 +193,12 @@ int config_parser(config_t *config, char* filepath) {
 	// variabili per stabilire se i parametri sono stati specificati più volte
 	bool nworkers_found, workersqueue_found, maxfiles_found, 
 	maxbytes_found, maxlocks_found, expclients_found, 
-	socket_found, log_found, evpolicy_found;
+	socket_found, tcpport_found, tcpaddress_found, log_found, evpolicy_found, 
+	autotune_found, minworkers_found, maxworkers_found, minlocks_found;
 	nworkers_found = workersqueue_found = maxfiles_found = 
 	maxbytes_found = maxlocks_found = expclients_found = 
-	socket_found = log_found = evpolicy_found = false;
+	socket_found = tcpport_found = tcpaddress_found = log_found = evpolicy_found = 
+	autotune_found = minworkers_found = maxworkers_found = minlocks_found = false;
 
 	char buf[CONFIG_LINE_SIZE] = {0};
 	char *param, *value, *tmpstr, *remaining;
@@ -280,6 +291,20 @@ int config_parser(config_t *config, char* filepath) {
 			STR_CPY_GOTO(value, config->socket_path, config_parser_exit);
 			socket_found = true;
 		}
+		else if (strcmp(param, TCP_PORT_STR) == 0) {
+			CHECK_REPEATED_GOTO(tcpport_found, TCP_PORT_STR, config_parser_exit);
+			CHECK_NUMBER_GOTO(value, &num, config_parser_exit);
+			CHECK_NEG_GOTO(num, param, config_parser_exit);
+			CHECK_GREATER(num, MAX_TCP_PORT, config_parser_exit);
+			config->tcp_port = strtol(value, NULL, 10);
+			tcpport_found = true;
+		}
+		else if (strcmp(param, TCP_ADDRESS_STR) == 0) {
+			CHECK_REPEATED_GOTO(tcpaddress_found, TCP_ADDRESS_STR, config_parser_exit);
+			CHECK_STR_LEN_GOTO(value, config_parser_exit);
+			STR_CPY_GOTO(value, config->tcp_address, config_parser_exit);
+			tcpaddress_found = true;
+		}
 		else if (strcmp(param, LOG_FILE_STR) == 0) {
 			CHECK_REPEATED_GOTO(log_found, LOG_FILE_STR, config_parser_exit);
 			CHECK_STR_LEN_GOTO(value, config_parser_exit);
@@ -306,6 +331,38 @@ int config_parser(config_t *config, char* filepath) {
 			}
 			evpolicy_found = true;
 		}
+		else if (strcmp(param, AUTOTUNE_INTERVAL_STR) == 0) {
+			CHECK_REPEATED_GOTO(autotune_found, AUTOTUNE_INTERVAL_STR, config_parser_exit);
+			CHECK_NUMBER_GOTO(value, &num, config_parser_exit);
+			CHECK_NEG_GOTO(num, param, config_parser_exit);
+			CHECK_GREATER(num, MAX_AUTOTUNE_INTERVAL, config_parser_exit);
+			config->autotune_interval = strtol(value, NULL, 10);
+			autotune_found = true;
+		}
+		else if (strcmp(param, MIN_WORKERS_STR) == 0) {
+			CHECK_REPEATED_GOTO(minworkers_found, MIN_WORKERS_STR, config_parser_exit);
+			CHECK_NUMBER_GOTO(value, &num, config_parser_exit);
+			CHECK_NEG_GOTO(num, param, config_parser_exit);
+			CHECK_GREATER(num, SIZE_MAX, config_parser_exit);
+			config->min_workers = strtol(value, NULL, 10);
+			minworkers_found = true;
+		}
+		else if (strcmp(param, MAX_WORKERS_STR) == 0) {
+			CHECK_REPEATED_GOTO(maxworkers_found, MAX_WORKERS_STR, config_parser_exit);
+			CHECK_NUMBER_GOTO(value, &num, config_parser_exit);
+			CHECK_NEG_GOTO(num, param, config_parser_exit);
+			CHECK_GREATER(num, SIZE_MAX, config_parser_exit);
+			config->max_workers = strtol(value, NULL, 10);
+			maxworkers_found = true;
+		}
+		else if (strcmp(param, MIN_LOCKS_STR) == 0) {
+			CHECK_REPEATED_GOTO(minlocks_found, MIN_LOCKS_STR, config_parser_exit);
+			CHECK_NUMBER_GOTO(value, &num, config_parser_exit);
+			CHECK_NEG_GOTO(num, param, config_parser_exit);
+			CHECK_GREATER(num, SIZE_MAX, config_parser_exit);
+			config->min_locks = strtol(value, NULL, 10);
+			minlocks_found = true;
+		}
 		else {
 			fprintf(stderr, "ERR: chiave '%s' non riconosciuta\n", param);
 			goto config_parser_exit;
@@ -313,9 +370,28 @@ int config_parser(config_t *config, char* filepath) {
 		memset(buf, 0, CONFIG_LINE_SIZE);
 	}
 
+	// i limiti dell'autotuning non specificati vengono estesi in modo da comprendere i valori iniziali
+	if (!minworkers_found && config->min_workers > config->n_workers)
+		config->min_workers = config->n_workers;
+	if (!maxworkers_found && config->max_workers < config->n_workers)
+		config->max_workers = config->n_workers;
+	if (!minlocks_found && config->min_locks > config->max_locks)
+		config->min_locks = config->max_locks;
+	if (config->min_workers > config->n_workers || config->n_workers > config->max_workers) {
+		fprintf(stderr, "ERR: deve valere '%s' <= '%s' <= '%s'\n", MIN_WORKERS_STR, N_WORKERS_STR, MAX_WORKERS_STR);
+		goto config_parser_exit;
+	}
+	if (config->min_locks > config->max_locks) {
+		fprintf(stderr, "ERR: deve valere '%s' <= '%s'\n", MIN_LOCKS_STR, MAX_LOCKS_STR);
+		goto config_parser_exit;
+	}
+
 	if (!config->socket_path) {
 		STR_CPY_GOTO(DEFAULT_SOCKET_PATH, config->socket_path, config_parser_exit);
 	}
+	if (!config->tcp_address) {
+		STR_CPY_GOTO(DEFAULT_TCP_ADDRESS, config->tcp_address, config_parser_exit);
+	}
 	if (!config->log_file_path) {
 		STR_CPY_GOTO(DEFAULT_LOG_PATH, config->log_file_path, config_parser_exit);
 	}
@@ -0,0 +1,396 @@
+/**
+ * @file                     conn_pool.c
+ * @brief                    Implementazione del pool di connessioni con il server.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include <conn_pool.h>
+#include <hasht.h>
+
+/**
+ * @struct                   fss_pool
+ * @brief                    Struttura che rappresenta un pool di connessioni con il server.
+ *
+ * @var sockname             Path del socket file o tcp:host:porta
+ * @var n                    Numero di connessioni del pool
+ * @var conns                Array delle connessioni
+ * @var busy                 Array di flag che indicano se la connessione è in uso da parte di un thread
+ * @var broken               Array di flag che indicano se sulla connessione si è verificato un errore di comunicazione
+ *                           (ECOMM) o se il server l'ha chiusa (ECONNRESET)
+ * @var bound_num            Array del numero di file legati a ciascuna connessione
+ * @var bound_files          Tabella che associa ai path dei file aperti tramite il pool l'indice (+1) della connessione
+ *                           a cui sono legati
+ * @var next                 Indice della connessione da cui iniziare la ricerca di una connessione libera
+ * @var mutex                Mutex per l'accesso in mutua esclusione al pool
+ * @var released             Variabile di condizione su cui attendere il rilascio di una connessione
+ */
+struct fss_pool {
+	char sockname[UNIX_PATH_MAX];
+	int n;
+	fss_conn_t** conns;
+	bool* busy;
+	bool* broken;
+	size_t* bound_num;
+	hasht_t* bound_files;
+	int next;
+	pthread_mutex_t mutex;
+	pthread_cond_t released;
+};
+
+/**
+ * @function                 pick_conn()
+ * @brief                    Sceglie la connessione che deve servire un'operazione sul file pathname, con la mutex del
+ *                           pool acquisita.
+ *
+ * @param pool               Il pool di connessioni
+ * @param pathname           Il path del file (@c NULL se l'operazione non riguarda un singolo file)
+ * @param bound              Viene settato a true se il file è legato a una connessione
+ *
+ * @return                   L'indice della connessione se è libera, -1 se occorre attendere il rilascio di una
+ *                           connessione, -2 se nessuna connessione è utilizzabile.
+ */
+static int pick_conn(fss_pool_t* pool, const char* pathname, bool* bound) {
+	void* v = pathname ? hasht_get_value(pool->bound_files, (void*) pathname) : NULL;
+	*bound = v != NULL;
+	if (v) {
+		int i = (int) ((intptr_t) v - 1);
+		return pool->busy[i] ? -1 : i;
+	}
+
+	// scelgo tra le connessioni libere quella con meno file legati, preferendo quelle che non hanno subito errori;
+	// una connessione che ha subito un errore è utilizzabile solo se non ha file legati (verrà riaperta)
+	int chosen = -1;
+	bool usable = false;
+	for (int k = 0; k < pool->n; k ++) {
+		int i = (pool->next + k) % pool->n;
+		if (pool->broken[i] && pool->bound_num[i] > 0)
+			continue;
+		usable = true;
+		if (pool->busy[i])
+			continue;
+		if (chosen == -1 ||
+			(pool->broken[chosen] && !pool->broken[i]) ||
+			(pool->broken[chosen] == pool->broken[i] && pool->bound_num[i] < pool->bound_num[chosen]))
+			chosen = i;
+	}
+	if (chosen == -1)
+		return usable ? -1 : -2;
+	return chosen;
+}
+
+/**
+ * @function                 acquire_conn()
+ * @brief                    Acquisisce la connessione che deve servire un'operazione sul file pathname, attendendo che
+ *                           sia libera. Se la connessione ha subito un errore di comunicazione viene riaperta.
+ *
+ * @param pool               Il pool di connessioni
+ * @param pathname           Il path del file (@c NULL se l'operazione non riguarda un singolo file)
+ * @param bind               Se true e il file non è legato a nessuna connessione lo lega a quella acquisita
+ * @param new_binding        Se non @c NULL viene settato a true se il file è stato legato alla connessione acquisita
+ *
+ * @return                   L'indice della connessione in caso di successo, -1 in caso di fallimento ed errno settato
+ *                           ad indicare l'errore.
+ *                           In caso di fallimento errno può assumere i seguenti valori:
+ *                           ECOMM      se nessuna connessione è utilizzabile
+ *                           ENOMEM     se non è stato possibile legare il file alla connessione
+ * @note                     Se non è possibile riaprire la connessione questa viene posta a @c NULL e l'operazione
+ *                           fallirà con errno settato a ECOMM.
+ */
+static int acquire_conn(fss_pool_t* pool, const char* pathname, bool bind, bool* new_binding) {
+	if (new_binding)
+		*new_binding = false;
+	if (pthread_mutex_lock(&(pool->mutex)) != 0) {
+		errno = ECOMM;
+		return -1;
+	}
+
+	int i;
+	bool bound;
+	while ((i = pick_conn(pool, pathname, &bound)) == -1) {
+		if (pthread_cond_wait(&(pool->released), &(pool->mutex)) != 0) {
+			pthread_mutex_unlock(&(pool->mutex));
+			errno = ECOMM;
+			return -1;
+		}
+	}
+	if (i == -2) {
+		pthread_mutex_unlock(&(pool->mutex));
+		errno = ECOMM;
+		return -1;
+	}
+
+	// lego il file alla connessione prima di servire l'operazione, così che operazioni concorrenti sullo stesso file
+	// vengano servite dalla stessa connessione
+	if (bind && !bound) {
+		char* key = strdup(pathname);
+		if (!key || hasht_insert(pool->bound_files, key, (void*) (intptr_t) (i+1)) == -1) {
+			free(key);
+			pthread_mutex_unlock(&(pool->mutex));
+			errno = ENOMEM;
+			return -1;
+		}
+		pool->bound_num[i] ++;
+		if (new_binding)
+			*new_binding = true;
+	}
+	pool->busy[i] = true;
+	pool->next = (i+1) % pool->n;
+	bool reconnect = pool->broken[i];
+	pthread_mutex_unlock(&(pool->mutex));
+
+	if (reconnect) {
+		// la connessione non ha file legati (altrimenti non sarebbe stata scelta), la riapro con un solo tentativo
+		fss_disconnect(pool->conns[i]);
+		struct timespec now = {0, 0};
+		clock_gettime(CLOCK_REALTIME, &now);
+		pool->conns[i] = fss_connect(pool->sockname, 0, now);
+		if (!pool->conns[i])
+			errno = ECOMM;
+	}
+
+	return i;
+}
+
+/**
+ * @function                 release_conn()
+ * @brief                    Rilascia la connessione i dopo un'operazione che ha restituito r, eventualmente slegando il
+ *                           file pathname. Preserva errno.
+ *
+ * @param pool               Il pool di connessioni
+ * @param i                  L'indice della connessione
+ * @param r                  Il valore restituito dall'operazione
+ * @param pathname           Il path del file da slegare dalla connessione (@c NULL se non occorre slegare alcun file)
+ */
+static void release_conn(fss_pool_t* pool, int i, int r, const char* pathname) {
+	int errnosv = errno;
+	pthread_mutex_lock(&(pool->mutex));
+	pool->broken[i] = !pool->conns[i] || (r == -1 && (errnosv == ECOMM || errnosv == ECONNRESET));
+	if (pathname) {
+		void* v = hasht_get_value(pool->bound_files, (void*) pathname);
+		if (v && (int) ((intptr_t) v - 1) == i) {
+			hasht_delete(pool->bound_files, (void*) pathname, free, NULL);
+			pool->bound_num[i] --;
+		}
+	}
+	pool->busy[i] = false;
+	pthread_cond_broadcast(&(pool->released));
+	pthread_mutex_unlock(&(pool->mutex));
+	errno = errnosv;
+}
+
+/**
+ * @def                      POOL_CALL()
+ * @brief                    Ritorna il valore di X, valutata dopo aver acquisito la connessione conn del pool che deve
+ *                           servire l'operazione sul file pathname (se l'acquisizione fallisce ritorna -1).
+ *
+ * @param pool               Il pool di connessioni
+ * @param pathname           Il path del file (@c NULL se l'operazione non riguarda un singolo file)
+ * @param conn               Nome della variabile a cui assegnare la connessione acquisita
+ * @param X                  Espressione da valutare con la connessione acquisita
+ */
+#define POOL_CALL(pool, pathname, conn, X) \
+	do { \
+		if (!pool) { \
+			errno = EINVAL; \
+			return -1; \
+		} \
+		int pool_i = acquire_conn(pool, pathname, false, NULL); \
+		if (pool_i == -1) \
+			return -1; \
+		fss_conn_t* conn = pool->conns[pool_i]; \
+		int pool_r = (X); \
+		release_conn(pool, pool_i, pool_r, NULL); \
+		return pool_r; \
+	} while(0);
+
+fss_pool_t* fss_pool_create(const char* sockname, int n, int msec, const struct timespec abstime) {
+	if (!sockname || strlen(sockname) > (UNIX_PATH_MAX-1) || n <= 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fss_pool_t* pool = calloc(1, sizeof(fss_pool_t));
+	if (!pool) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	strcpy(pool->sockname, sockname);
+	pool->n = n;
+	pool->conns = calloc(n, sizeof(fss_conn_t*));
+	pool->busy = calloc(n, sizeof(bool));
+	pool->broken = calloc(n, sizeof(bool));
+	pool->bound_num = calloc(n, sizeof(size_t));
+	pool->bound_files = hasht_create(POOL_BOUND_FILES_BUCKETS, NULL, NULL);
+	if (!pool->conns || !pool->busy || !pool->broken || !pool->bound_num || !pool->bound_files) {
+		hasht_destroy(pool->bound_files, NULL, NULL);
+		free(pool->bound_num);
+		free(pool->broken);
+		free(pool->busy);
+		free(pool->conns);
+		free(pool);
+		errno = ENOMEM;
+		return NULL;
+	}
+	if (pthread_mutex_init(&(pool->mutex), NULL) != 0) {
+		hasht_destroy(pool->bound_files, NULL, NULL);
+		free(pool->bound_num);
+		free(pool->broken);
+		free(pool->busy);
+		free(pool->conns);
+		free(pool);
+		errno = ENOMEM;
+		return NULL;
+	}
+	if (pthread_cond_init(&(pool->released), NULL) != 0) {
+		pthread_mutex_destroy(&(pool->mutex));
+		hasht_destroy(pool->bound_files, NULL, NULL);
+		free(pool->bound_num);
+		free(pool->broken);
+		free(pool->busy);
+		free(pool->conns);
+		free(pool);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	for (int i = 0; i < n; i ++) {
+		if ((pool->conns[i] = fss_connect(sockname, msec, abstime)) == NULL) {
+			int errnosv = errno;
+			fss_pool_destroy(pool);
+			errno = errnosv;
+			return NULL;
+		}
+	}
+
+	errno = 0;
+	return pool;
+}
+
+int fss_pool_destroy(fss_pool_t* pool) {
+	if (!pool) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int r = 0;
+	for (int i = 0; i < pool->n; i ++) {
+		if (pool->conns[i] && fss_disconnect(pool->conns[i]) == -1)
+			r = -1;
+	}
+	pthread_cond_destroy(&(pool->released));
+	pthread_mutex_destroy(&(pool->mutex));
+	hasht_destroy(pool->bound_files, free, NULL);
+	free(pool->bound_num);
+	free(pool->broken);
+	free(pool->busy);
+	free(pool->conns);
+	free(pool);
+
+	if (r == -1)
+		errno = ECOMM;
+	return r;
+}
+
+int fss_pool_openFile(fss_pool_t* pool, const char* pathname, int flags) {
+	if (!pool || !pathname) {
+		errno = EINVAL;
+		return -1;
+	}
+	bool new_binding;
+	int i = acquire_conn(pool, pathname, true, &new_binding);
+	if (i == -1)
+		return -1;
+	int r = fss_openFile(pool->conns[i], pathname, flags);
+	// se l'apertura fallisce il file resta legato alla connessione solo se lo era già
+	release_conn(pool, i, r, (r == -1 && new_binding) ? pathname : NULL);
+	return r;
+}
+
+int fss_pool_readFile(fss_pool_t* pool, const char* pathname, void** buf, size_t* size) {
+	POOL_CALL(pool, pathname, conn, fss_readFile(conn, pathname, buf, size));
+}
+
+int fss_pool_openReadCloseFile(fss_pool_t* pool, const char* pathname, void** buf, size_t* size) {
+	POOL_CALL(pool, pathname, conn, fss_openReadCloseFile(conn, pathname, buf, size));
+}
+
+int fss_pool_readFileRange(fss_pool_t* pool, const char* pathname, size_t offset, size_t length, void** buf,
+	size_t* size) {
+	POOL_CALL(pool, pathname, conn, fss_readFileRange(conn, pathname, offset, length, buf, size));
+}
+
+int fss_pool_readFileIfNewer(fss_pool_t* pool, const char* pathname, size_t* version, void** buf, size_t* size) {
+	POOL_CALL(pool, pathname, conn, fss_readFileIfNewer(conn, pathname, version, buf, size));
+}
+
+int fss_pool_readNFiles(fss_pool_t* pool, int N, const char* dirname) {
+	POOL_CALL(pool, NULL, conn, fss_readNFiles(conn, N, dirname));
+}
+
+int fss_pool_readNFilesCursor(fss_pool_t* pool, size_t* cursor, int N, size_t max_bytes, const char* dirname) {
+	// il cursore non dipende dalla connessione, i batch successivi possono essere serviti da connessioni diverse
+	POOL_CALL(pool, NULL, conn, fss_readNFilesCursor(conn, cursor, N, max_bytes, dirname));
+}
+
+int fss_pool_writeFile(fss_pool_t* pool, const char* pathname, const char* dirname) {
+	POOL_CALL(pool, pathname, conn, fss_writeFile(conn, pathname, dirname));
+}
+
+int fss_pool_openWriteCloseFile(fss_pool_t* pool, const char* pathname, const char* dirname) {
+	POOL_CALL(pool, pathname, conn, fss_openWriteCloseFile(conn, pathname, dirname));
+}
+
+int fss_pool_appendToFile(fss_pool_t* pool, const char* pathname, void* buf, size_t size, const char* dirname) {
+	POOL_CALL(pool, pathname, conn, fss_appendToFile(conn, pathname, buf, size, dirname));
+}
+
+int fss_pool_appendFileToFile(fss_pool_t* pool, const char* pathname, const char* source, const char* dirname) {
+	POOL_CALL(pool, pathname, conn, fss_appendFileToFile(conn, pathname, source, dirname));
+}
+
+int fss_pool_writeFileAt(fss_pool_t* pool, const char* pathname, size_t offset, void* buf, size_t size,
+	const char* dirname) {
+	POOL_CALL(pool, pathname, conn, fss_writeFileAt(conn, pathname, offset, buf, size, dirname));
+}
+
+int fss_pool_lockFile(fss_pool_t* pool, const char* pathname) {
+	POOL_CALL(pool, pathname, conn, fss_lockFile(conn, pathname));
+}
+
+int fss_pool_unlockFile(fss_pool_t* pool, const char* pathname) {
+	POOL_CALL(pool, pathname, conn, fss_unlockFile(conn, pathname));
+}
+
+int fss_pool_closeFile(fss_pool_t* pool, const char* pathname) {
+	if (!pool) {
+		errno = EINVAL;
+		return -1;
+	}
+	int i = acquire_conn(pool, pathname, false, NULL);
+	if (i == -1)
+		return -1;
+	int r = fss_closeFile(pool->conns[i], pathname);
+	// anche in caso di fallimento il file non è più aperto dalla connessione
+	release_conn(pool, i, r, pathname);
+	return r;
+}
+
+int fss_pool_removeFile(fss_pool_t* pool, const char* pathname) {
+	if (!pool) {
+		errno = EINVAL;
+		return -1;
+	}
+	int i = acquire_conn(pool, pathname, false, NULL);
+	if (i == -1)
+		return -1;
+	int r = fss_removeFile(pool->conns[i], pathname);
+	// se la rimozione fallisce perchè il file non è in lock il file resta aperto dalla connessione
+	release_conn(pool, i, r, (r == 0 || errno == ENOENT || errno == ECOMM || errno == ECONNRESET) ? pathname : NULL);
+	return r;
+}
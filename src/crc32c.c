@@ -0,0 +1,247 @@
+/**
+ * @file     crc32c.c
+ * @brief    Implementazione del calcolo del CRC32C.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <crc32c.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC32C_HW
+#include <nmmintrin.h>
+#endif
+
+/* Polinomio di Castagnoli (rappresentazione riflessa) */
+#define CRC32C_POLY 0x82F63B78u
+
+/* Lunghezze dei blocchi elaborati in parallelo dalla versione hardware (3 blocchi alla volta) */
+#define CRC32C_LONG 8192
+#define CRC32C_SHORT 256
+
+/* Tabella per il calcolo software, inizializzata alla prima invocazione */
+static uint32_t crc32c_table[256];
+/* Tabelle per applicare a un CRC32C l'aggiunta di CRC32C_LONG e di CRC32C_SHORT bytes nulli */
+static uint32_t crc32c_long[4][256];
+static uint32_t crc32c_short[4][256];
+/* Flag che indica se l'istruzione crc32 è supportata */
+static bool crc32c_hw = false;
+/* Variabile per l'inizializzazione della tabella e del flag una sola volta */
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @function               gf2_matrix_times()
+ * @brief                  Moltiplica il vettore vec per la matrice 32x32 mat su GF(2).
+ * 
+ * @param mat              Matrice (una colonna per elemento)
+ * @param vec              Vettore
+ * 
+ * @return                 Il prodotto.
+ */
+static uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) {
+	uint32_t sum = 0;
+	while (vec) {
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat ++;
+	}
+	return sum;
+}
+
+/**
+ * @function               gf2_matrix_square()
+ * @brief                  Calcola in square il quadrato della matrice 32x32 mat su GF(2).
+ * 
+ * @param square           Matrice risultato
+ * @param mat              Matrice da elevare al quadrato
+ */
+static void gf2_matrix_square(uint32_t* square, const uint32_t* mat) {
+	for (int n = 0; n < 32; n ++)
+		square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+/**
+ * @function               crc32c_zeros()
+ * @brief                  Costruisce le tabelle zeros per applicare a un CRC32C l'aggiunta di len bytes nulli 
+ *                         (len deve essere una potenza di 2 maggiore di 1).
+ * 
+ * @param zeros            Tabelle da costruire
+ * @param len              Numero di bytes nulli
+ */
+static void crc32c_zeros(uint32_t zeros[][256], size_t len) {
+	uint32_t even[32], odd[32];
+
+	// operatore per un bit nullo
+	odd[0] = CRC32C_POLY;
+	uint32_t row = 1;
+	for (int n = 1; n < 32; n ++) {
+		odd[n] = row;
+		row <<= 1;
+	}
+	// operatori per 2 e 4 bit nulli
+	gf2_matrix_square(even, odd);
+	gf2_matrix_square(odd, even);
+	// elevo al quadrato: il primo quadrato è l'operatore per un byte nullo, i successivi per 2, 4, ..., len bytes
+	uint32_t* op = odd;
+	uint32_t* tmp = even;
+	for (; len; len >>= 1) {
+		gf2_matrix_square(tmp, op);
+		uint32_t* swap = op;
+		op = tmp;
+		tmp = swap;
+	}
+
+	for (uint32_t n = 0; n < 256; n ++) {
+		zeros[0][n] = gf2_matrix_times(op, n);
+		zeros[1][n] = gf2_matrix_times(op, n << 8);
+		zeros[2][n] = gf2_matrix_times(op, n << 16);
+		zeros[3][n] = gf2_matrix_times(op, n << 24);
+	}
+}
+
+/**
+ * @function               crc32c_shift()
+ * @brief                  Applica a crc l'aggiunta dei bytes nulli rappresentata dalle tabelle zeros.
+ * 
+ * @param zeros            Tabelle costruite con crc32c_zeros()
+ * @param crc              CRC32C non complementato
+ * 
+ * @return                 Il CRC32C non complementato aggiornato.
+ */
+static uint32_t crc32c_shift(uint32_t zeros[][256], uint32_t crc) {
+	return zeros[0][crc & 0xFF] ^ zeros[1][(crc >> 8) & 0xFF] ^ zeros[2][(crc >> 16) & 0xFF] ^ zeros[3][crc >> 24];
+}
+
+/**
+ * @function               crc32c_init()
+ * @brief                  Inizializza la tabella per il calcolo software e stabilisce se l'istruzione crc32 è supportata.
+ */
+static void crc32c_init() {
+	for (uint32_t i = 0; i < 256; i ++) {
+		uint32_t c = i;
+		for (int k = 0; k < 8; k ++)
+			c = (c & 1) ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+		crc32c_table[i] = c;
+	}
+#ifdef CRC32C_HW
+	__builtin_cpu_init();
+	crc32c_hw = __builtin_cpu_supports("sse4.2");
+	if (crc32c_hw) {
+		crc32c_zeros(crc32c_long, CRC32C_LONG);
+		crc32c_zeros(crc32c_short, CRC32C_SHORT);
+	}
+#endif
+}
+
+/**
+ * @function               crc32c_sw()
+ * @brief                  Aggiorna il CRC32C (non complementato) crc con i size bytes di buf usando la tabella.
+ * 
+ * @param crc              CRC32C non complementato
+ * @param buf              Bytes con cui aggiornare crc
+ * @param size             Numero di bytes di buf
+ * 
+ * @return                 Il CRC32C non complementato aggiornato.
+ */
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char* buf, size_t size) {
+	while (size --)
+		crc = crc32c_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef CRC32C_HW
+/**
+ * @function               crc32c_sse42_blocks()
+ * @brief                  Aggiorna il CRC32C (non complementato) crc con i bytes di *buf a gruppi di 3 blocchi di len 
+ *                         bytes, calcolando i CRC32C dei 3 blocchi in parallelo (l'istruzione crc32 ha una latenza di 3 
+ *                         cicli) e combinandoli con le tabelle zeros. Aggiorna *buf e *size con i bytes non elaborati.
+ * 
+ * @param crc              CRC32C non complementato
+ * @param buf              Bytes con cui aggiornare crc
+ * @param size             Numero di bytes di *buf
+ * @param len              Lunghezza dei blocchi (multiplo di 8)
+ * @param zeros            Tabelle per applicare l'aggiunta di len bytes nulli
+ * 
+ * @return                 Il CRC32C non complementato aggiornato.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42_blocks(uint32_t crc, const unsigned char** buf, size_t* size, 
+	size_t len, uint32_t zeros[][256]) {
+#if defined(__x86_64__)
+	while (*size >= len * 3) {
+		const unsigned char* next = *buf;
+		const unsigned char* end = next + len;
+		uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+		do {
+			uint64_t v0, v1, v2;
+			memcpy(&v0, next, sizeof(uint64_t));
+			memcpy(&v1, next + len, sizeof(uint64_t));
+			memcpy(&v2, next + 2 * len, sizeof(uint64_t));
+			crc0 = _mm_crc32_u64(crc0, v0);
+			crc1 = _mm_crc32_u64(crc1, v1);
+			crc2 = _mm_crc32_u64(crc2, v2);
+			next += sizeof(uint64_t);
+		} while (next < end);
+		crc = crc32c_shift(zeros, (uint32_t) crc0) ^ (uint32_t) crc1;
+		crc = crc32c_shift(zeros, crc) ^ (uint32_t) crc2;
+		*buf += len * 3;
+		*size -= len * 3;
+	}
+#endif
+	return crc;
+}
+
+/**
+ * @function               crc32c_sse42()
+ * @brief                  Aggiorna il CRC32C (non complementato) crc con i size bytes di buf usando l'istruzione crc32.
+ * 
+ * @param crc              CRC32C non complementato
+ * @param buf              Bytes con cui aggiornare crc
+ * @param size             Numero di bytes di buf
+ * 
+ * @return                 Il CRC32C non complementato aggiornato.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char* buf, size_t size) {
+	crc = crc32c_sse42_blocks(crc, &buf, &size, CRC32C_LONG, crc32c_long);
+	crc = crc32c_sse42_blocks(crc, &buf, &size, CRC32C_SHORT, crc32c_short);
+#if defined(__x86_64__)
+	uint64_t crc64 = crc;
+	while (size >= sizeof(uint64_t)) {
+		uint64_t v;
+		memcpy(&v, buf, sizeof(uint64_t));
+		crc64 = _mm_crc32_u64(crc64, v);
+		buf += sizeof(uint64_t);
+		size -= sizeof(uint64_t);
+	}
+	crc = (uint32_t) crc64;
+#endif
+	while (size >= sizeof(uint32_t)) {
+		uint32_t v;
+		memcpy(&v, buf, sizeof(uint32_t));
+		crc = _mm_crc32_u32(crc, v);
+		buf += sizeof(uint32_t);
+		size -= sizeof(uint32_t);
+	}
+	while (size --)
+		crc = _mm_crc32_u8(crc, *buf++);
+	return crc;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void* buf, size_t size) {
+	if (buf == NULL || size == 0)
+		return crc;
+	pthread_once(&crc32c_once, crc32c_init);
+
+	crc = ~crc;
+#ifdef CRC32C_HW
+	if (crc32c_hw)
+		return ~crc32c_sse42(crc, buf, size);
+#endif
+	return ~crc32c_sw(crc, buf, size);
+}
@@ -0,0 +1,769 @@
+/**
+ * @file                     fssbench.c
+ * @brief                    Generatore di carico per il server. Esegue per una durata (o un numero di operazioni)
+ *                           prefissata un mix configurabile di operazioni su un insieme di file, con N thread che
+ *                           condividono M connessioni, a ciclo chiuso (ogni thread invia l'operazione successiva appena
+ *                           ricevuta la risposta) o a ciclo aperto (le operazioni vengono avviate ad un tasso
+ *                           prefissato). Al termine stampa il throughput e i percentili della latenza di ogni operazione.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <client_api.h>
+#include <latency_hist.h>
+#include <util.h>
+
+/* Secondi da dedicare ai tentativi di connessione verso il server */
+#define TRY_CONN_FOR_SEC 5
+/* Millisecondi da attendere tra un tentativo di connessione verso il server e il successivo */
+#define RETRY_CONN_AFTER_MSEC 1000
+/* Massimo numero di thread */
+#define MAX_THREADS 256
+/* Massimo numero di dimensioni dei file specificabili con -s */
+#define MAX_SIZES 16
+/* Numero di file da leggere con ciascuna operazione readn */
+#define READN_BENCH_FILES 8
+/* Prefisso di default dei path dei file utilizzati */
+#define DEFAULT_PREFIX "/fssbench"
+/* Mix di operazioni di default */
+#define DEFAULT_MIX "read=80,write=20"
+/* Durata di default in secondi */
+#define DEFAULT_DURATION 10
+/* Numero di file di default */
+#define DEFAULT_KEYS 1000
+/* Dimensione di default dei file */
+#define DEFAULT_SIZE 4096
+
+/**
+ * @enum                     bench_op_t
+ * @brief                    Operazioni eseguibili dal generatore di carico.
+ */
+typedef enum bench_op {
+	OP_OPEN,     // openFile() e closeFile() di un file esistente
+	OP_READ,     // openReadCloseFile()
+	OP_WRITE,    // creazione (o apertura in modalità locked) del file, scrittura dall'offset 0 e closeFile()
+	OP_APPEND,   // openFile(), appendToFile() e closeFile()
+	OP_LOCK,     // openFile(), lockFile(), unlockFile() e closeFile()
+	OP_READN,    // readNFiles() di READN_BENCH_FILES file
+	OP_NUM
+} bench_op_t;
+
+/* Nomi delle operazioni (utilizzati in -m e nel report) */
+static const char* op_names[OP_NUM] = {"open", "read", "write", "append", "lock", "readn"};
+
+/**
+ * @struct                   bench_conf_t
+ * @brief                    Parametri del generatore di carico.
+ *
+ * @var sockname             Il path del socket file o tcp:host:porta
+ * @var prefix               Prefisso dei path dei file
+ * @var threads              Numero di thread
+ * @var conns                Numero di connessioni (condivise tra i thread)
+ * @var duration             Durata in secondi
+ * @var ops                  Numero massimo di operazioni (0 se il limite è dato solo dalla durata)
+ * @var rate                 Tasso complessivo di operazioni al secondo a ciclo aperto (0 per il ciclo chiuso)
+ * @var keys                 Numero di file
+ * @var zipf                 Esponente della distribuzione Zipf della popolarità dei file (0 per la distribuzione
+ *                           uniforme)
+ * @var populate             Flag che indica se creare i file prima della misurazione
+ * @var seed                 Seme dei generatori di numeri pseudocasuali (0 per derivarlo dall'ora corrente)
+ * @var weights              Pesi delle operazioni
+ * @var weights_sum          Somma dei pesi delle operazioni
+ * @var sizes                Dimensioni dei file
+ * @var size_weights         Pesi delle dimensioni dei file
+ * @var sizes_num            Numero di dimensioni dei file
+ * @var size_weights_sum     Somma dei pesi delle dimensioni dei file
+ * @var max_size             Massima dimensione dei file
+ * @var zipf_cdf             Funzione di ripartizione della distribuzione Zipf
+ */
+typedef struct bench_conf {
+	char* sockname;
+	char* prefix;
+	int threads;
+	int conns;
+	long duration;
+	long ops;
+	double rate;
+	long keys;
+	double zipf;
+	bool populate;
+	long seed;
+	long weights[OP_NUM];
+	long weights_sum;
+	size_t sizes[MAX_SIZES];
+	long size_weights[MAX_SIZES];
+	int sizes_num;
+	long size_weights_sum;
+	size_t max_size;
+	double* zipf_cdf;
+} bench_conf_t;
+
+/**
+ * @struct                   bench_thread_t
+ * @brief                    Stato di un thread del generatore di carico.
+ *
+ * @var id                   Identificativo del thread
+ * @var conn                 Connessione utilizzata dal thread
+ * @var rng                  Stato del generatore di numeri pseudocasuali
+ * @var buf                  Buffer con il contenuto da scrivere nei file
+ * @var ops                  Numero massimo di operazioni del thread (0 se illimitato)
+ * @var hist                 Istogrammi delle latenze delle operazioni
+ * @var fatal                Flag che indica se il thread è terminato a causa di un errore di comunicazione
+ */
+typedef struct bench_thread {
+	int id;
+	fss_conn_t* conn;
+	uint64_t rng;
+	char* buf;
+	long ops;
+	hist_t hist[OP_NUM];
+	bool fatal;
+} bench_thread_t;
+
+/* Parametri del generatore di carico */
+static bench_conf_t conf;
+/* Istante di inizio della misurazione */
+static struct timespec bench_start;
+
+/**
+ * @function                 rng_next()
+ * @brief                    Genera un numero pseudocasuale (xorshift64*).
+ *
+ * @param state              Lo stato del generatore
+ *
+ * @return                   Il numero generato.
+ */
+static inline uint64_t rng_next(uint64_t* state) {
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 2685821657736338717ULL;
+}
+
+/**
+ * @function                 rng_double()
+ * @brief                    Genera un numero pseudocasuale uniforme in [0, 1).
+ *
+ * @param state              Lo stato del generatore
+ *
+ * @return                   Il numero generato.
+ */
+static inline double rng_double(uint64_t* state) {
+	return (rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @function                 pick_key()
+ * @brief                    Estrae l'indice di un file secondo la distribuzione di popolarità configurata.
+ *
+ * @param rng                Lo stato del generatore di numeri pseudocasuali
+ *
+ * @return                   L'indice del file.
+ */
+static long pick_key(uint64_t* rng) {
+	if (!conf.zipf_cdf)
+		return rng_next(rng) % conf.keys;
+	// ricerca binaria del primo indice la cui probabilità cumulata è >= u
+	double u = rng_double(rng);
+	long lo = 0, hi = conf.keys - 1;
+	while (lo < hi) {
+		long mid = lo + (hi - lo) / 2;
+		if (conf.zipf_cdf[mid] < u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * @function                 pick_weighted()
+ * @brief                    Estrae un indice in [0, n) con probabilità proporzionale a weights.
+ *
+ * @param rng                Lo stato del generatore di numeri pseudocasuali
+ * @param weights            I pesi
+ * @param n                  Il numero di pesi
+ * @param sum                La somma dei pesi
+ *
+ * @return                   L'indice estratto.
+ */
+static int pick_weighted(uint64_t* rng, const long* weights, int n, long sum) {
+	long r = rng_next(rng) % sum;
+	for (int i = 0; i < n; i++) {
+		if (r < weights[i])
+			return i;
+		r -= weights[i];
+	}
+	return n - 1;
+}
+
+/**
+ * @function                 key_path()
+ * @brief                    Scrive in path il path del file di indice key.
+ *
+ * @param path               Il buffer in cui scrivere il path (di dimensione PATH_MAX)
+ * @param key                L'indice del file
+ */
+static inline void key_path(char* path, long key) {
+	snprintf(path, PATH_MAX, "%s/f%ld", conf.prefix, key);
+}
+
+/**
+ * @function                 write_key()
+ * @brief                    Crea il file path e vi scrive size bytes o, se esiste già, lo apre in modalità locked e
+ *                           ne sovrascrive i primi size bytes; infine lo chiude.
+ *
+ * @param conn               La connessione
+ * @param path               Il path del file
+ * @param buf                Il contenuto da scrivere
+ * @param size               Il numero di bytes da scrivere
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int write_key(fss_conn_t* conn, const char* path, char* buf, size_t size) {
+	int r;
+	if (fss_openFile(conn, path, O_CREATE | O_LOCK) == 0) {
+		r = fss_appendToFile(conn, path, buf, size, NULL);
+	}
+	else {
+		if (errno != EEXIST || fss_openFile(conn, path, O_LOCK) == -1)
+			return -1;
+		r = fss_writeFileAt(conn, path, 0, buf, size, NULL);
+	}
+	int errnosv = errno;
+	if (fss_closeFile(conn, path) == -1 && r == 0)
+		return -1;
+	errno = errnosv;
+	return r;
+}
+
+/**
+ * @function                 run_op()
+ * @brief                    Esegue l'operazione op su un file estratto secondo la distribuzione di popolarità.
+ *
+ * @param t                  Lo stato del thread
+ * @param op                 L'operazione da eseguire
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int run_op(bench_thread_t* t, bench_op_t op) {
+	char path[PATH_MAX];
+	key_path(path, pick_key(&t->rng));
+	size_t size = conf.sizes[pick_weighted(&t->rng, conf.size_weights, conf.sizes_num, conf.size_weights_sum)];
+	void* buf = NULL;
+	size_t buf_size;
+	int r, errnosv;
+
+	switch (op) {
+		case OP_OPEN:
+			if (fss_openFile(t->conn, path, 0) == -1)
+				return -1;
+			return fss_closeFile(t->conn, path);
+		case OP_READ:
+			r = fss_openReadCloseFile(t->conn, path, &buf, &buf_size);
+			if (buf)
+				free(buf);
+			return r;
+		case OP_WRITE:
+			return write_key(t->conn, path, t->buf, size);
+		case OP_APPEND:
+			if (fss_openFile(t->conn, path, 0) == -1)
+				return -1;
+			r = fss_appendToFile(t->conn, path, t->buf, size, NULL);
+			errnosv = errno;
+			if (fss_closeFile(t->conn, path) == -1 && r == 0)
+				return -1;
+			errno = errnosv;
+			return r;
+		case OP_LOCK:
+			if (fss_openFile(t->conn, path, 0) == -1)
+				return -1;
+			r = fss_lockFile(t->conn, path);
+			if (r == 0)
+				r = fss_unlockFile(t->conn, path);
+			errnosv = errno;
+			if (fss_closeFile(t->conn, path) == -1 && r == 0)
+				return -1;
+			errno = errnosv;
+			return r;
+		case OP_READN:
+			return fss_readNFiles(t->conn, READN_BENCH_FILES, NULL) == -1 ? -1 : 0;
+		default:
+			errno = EINVAL;
+			return -1;
+	}
+}
+
+/**
+ * @function                 populate_worker()
+ * @brief                    Crea i file di indice id, id + threads, id + 2*threads, ... prima della misurazione.
+ *
+ * @param arg                Lo stato del thread
+ */
+static void* populate_worker(void* arg) {
+	bench_thread_t* t = arg;
+	char path[PATH_MAX];
+	for (long k = t->id; k < conf.keys && !t->fatal; k += conf.threads) {
+		key_path(path, k);
+		size_t size = conf.sizes[pick_weighted(&t->rng, conf.size_weights, conf.sizes_num, conf.size_weights_sum)];
+		if (write_key(t->conn, path, t->buf, size) == -1 && (errno == ECOMM || errno == ECONNRESET)) {
+			fprintf(stderr, "ERR: thread %d: scrittura di '%s' (%s)\n", t->id, path, strerror(errno));
+			t->fatal = true;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @function                 bench_worker()
+ * @brief                    Esegue le operazioni fino al termine della durata o al raggiungimento del numero massimo di
+ *                           operazioni. A ciclo aperto l'i-esima operazione viene avviata all'istante
+ *                           bench_start + i * threads / rate e la sua latenza viene misurata a partire da tale istante,
+ *                           in modo che i ritardi accumulati dal server non riducano il carico generato.
+ *
+ * @param arg                Lo stato del thread
+ */
+static void* bench_worker(void* arg) {
+	bench_thread_t* t = arg;
+	uint64_t start = ts_to_usec(&bench_start);
+	uint64_t end = start + conf.duration * 1000000;
+	// intervallo tra due operazioni del thread a ciclo aperto (sfasato tra i thread)
+	double interval = conf.rate > 0 ? conf.threads * 1000000.0 / conf.rate : 0;
+	double next = start + interval * t->id / conf.threads;
+
+	for (long i = 0; t->ops == 0 || i < t->ops; i++) {
+		uint64_t op_start;
+		if (interval > 0) {
+			op_start = (uint64_t) next;
+			next += interval;
+			if (op_start >= end)
+				break;
+			// attendo l'istante di avvio dell'operazione
+			sleep_until_usec(op_start);
+		}
+		else {
+			op_start = now_usec();
+			if (op_start >= end)
+				break;
+		}
+
+		bench_op_t op = pick_weighted(&t->rng, conf.weights, OP_NUM, conf.weights_sum);
+		int r = run_op(t, op);
+		uint64_t op_end = now_usec();
+		if (r == -1) {
+			t->hist[op].errors ++;
+			if (errno == ECOMM || errno == ECONNRESET) {
+				fprintf(stderr, "ERR: thread %d: %s (%s)\n", t->id, op_names[op], strerror(errno));
+				t->fatal = true;
+				break;
+			}
+		}
+		else {
+			hist_record(&t->hist[op], op_end - op_start);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @function                 parse_weighted_list()
+ * @brief                    Effettua il parsing di una lista nella forma nome=peso,... (se names è diverso da @c NULL)
+ *                           o valore[:peso],... (se names è @c NULL).
+ *
+ * @param arg                La stringa da analizzare
+ * @param names              I nomi ammessi (@c NULL se gli elementi sono valori numerici)
+ * @param n                  Il numero di nomi o il massimo numero di valori
+ * @param values             L'array in cui memorizzare i valori (se names è @c NULL)
+ * @param weights            L'array in cui memorizzare i pesi
+ *
+ * @return                   Il numero di elementi in caso di successo, -1 se arg non è valido.
+ */
+static int parse_weighted_list(char* arg, const char** names, int n, size_t* values, long* weights) {
+	int count = 0;
+	char* saveptr;
+	for (char* tok = strtok_r(arg, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+		long weight = 1, value;
+		if (names) {
+			char* eq = strchr(tok, '=');
+			if (!eq)
+				return -1;
+			*eq = '\0';
+			int i;
+			for (i = 0; i < n && strcmp(tok, names[i]) != 0; i++);
+			if (i == n || is_number(eq + 1, &weight) != 0 || weight < 0)
+				return -1;
+			weights[i] = weight;
+			count ++;
+		}
+		else {
+			if (count == n)
+				return -1;
+			char* colon = strchr(tok, ':');
+			if (colon) {
+				*colon = '\0';
+				if (is_number(colon + 1, &weight) != 0 || weight <= 0)
+					return -1;
+			}
+			if (is_number(tok, &value) != 0 || value < 0)
+				return -1;
+			values[count] = value;
+			weights[count] = weight;
+			count ++;
+		}
+	}
+	return count;
+}
+
+/**
+ * @function                 usage()
+ * @brief                    Stampa del messaggio di help.
+ *
+ * @param prog               Il nome del programma
+ */
+static void usage(char* prog) {
+	printf("usage: %s -f sockname [options]\n", prog);
+	printf("options:\n\n"
+		"-h			  stampa il messaggio di help\n\n"
+		"-f sockname		  path della socket del server, o tcp:host:porta\n\n"
+		"-t n			  numero di thread (default 1)\n\n"
+		"-c n			  numero di connessioni, condivise tra i thread\n"
+		"			  (default uguale al numero di thread)\n\n"
+		"-d sec			  durata della misurazione (default %d)\n\n"
+		"-o n			  numero massimo di operazioni (default illimitato)\n\n"
+		"-r rate		  operazioni al secondo complessive a ciclo aperto\n"
+		"			  (default 0, ciclo chiuso)\n\n"
+		"-m op=peso[,...]	  mix di operazioni tra open, read, write, append,\n"
+		"			  lock e readn (default %s)\n\n"
+		"-n n			  numero di file (default %d)\n\n"
+		"-s size[:peso][,...]	  dimensioni dei file scritti (default %d)\n\n"
+		"-u			  popolarità dei file uniforme (default)\n\n"
+		"-Z s			  popolarità dei file Zipf con esponente s\n\n"
+		"-x prefix		  prefisso dei path dei file (default %s)\n\n"
+		"-e			  utilizza i file esistenti senza crearli prima\n"
+		"			  della misurazione\n\n"
+		"-S seed		  seme dei generatori di numeri pseudocasuali, per\n"
+		"			  ripetere la stessa sequenza di operazioni\n"
+		"			  (default derivato dall'ora corrente)\n\n"
+		"-z			  abilita la compressione del contenuto dei file\n\n"
+		"-k			  abilita la verifica del checksum dei file letti\n\n",
+		DEFAULT_DURATION, DEFAULT_MIX, DEFAULT_KEYS, DEFAULT_SIZE, DEFAULT_PREFIX);
+}
+
+/**
+ * @function                 parse_long()
+ * @brief                    Effettua il parsing dell'argomento dell'opzione option come intero in [min, max].
+ *
+ * @param option             L'opzione
+ * @param arg                L'argomento
+ * @param min                Il valore minimo
+ * @param max                Il valore massimo
+ * @param n                  Il puntatore in cui memorizzare il valore
+ *
+ * @return                   0 in caso di successo, -1 se l'argomento non è valido.
+ */
+static int parse_long(int option, const char* arg, long min, long max, long* n) {
+	if (is_number(arg, n) != 0 || *n < min || *n > max) {
+		fprintf(stderr, "ERR: l'argomento di -%c deve essere compreso tra %ld e %ld\n", option, min, max);
+		return -1;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	int extval = EXIT_SUCCESS;
+	bench_thread_t* threads = NULL;
+	pthread_t* tids = NULL;
+	fss_conn_t** conns = NULL;
+	int conns_opened = 0;
+	char* mix = NULL;
+	char* sizes = NULL;
+	long n;
+
+	memset(&conf, 0, sizeof(bench_conf_t));
+	conf.threads = 1;
+	conf.duration = DEFAULT_DURATION;
+	conf.keys = DEFAULT_KEYS;
+	conf.populate = true;
+	conf.prefix = DEFAULT_PREFIX;
+
+	if (argc == 1) {
+		usage(argv[0]);
+		return EXIT_SUCCESS;
+	}
+	int option;
+	while ((option = getopt(argc, argv, ":hf:t:c:d:o:r:m:n:s:uZ:x:eS:zk")) != -1) {
+		switch (option) {
+			case 'h':
+				usage(argv[0]);
+				return EXIT_SUCCESS;
+			case 'f':
+				conf.sockname = optarg;
+				break;
+			case 't':
+				if (parse_long(option, optarg, 1, MAX_THREADS, &n) == -1) return EXIT_FAILURE;
+				conf.threads = n;
+				break;
+			case 'c':
+				if (parse_long(option, optarg, 1, MAX_THREADS, &n) == -1) return EXIT_FAILURE;
+				conf.conns = n;
+				break;
+			case 'd':
+				if (parse_long(option, optarg, 1, INT_MAX, &conf.duration) == -1) return EXIT_FAILURE;
+				break;
+			case 'o':
+				if (parse_long(option, optarg, 0, LONG_MAX, &conf.ops) == -1) return EXIT_FAILURE;
+				break;
+			case 'r':
+				if (parse_long(option, optarg, 0, INT_MAX, &n) == -1) return EXIT_FAILURE;
+				conf.rate = n;
+				break;
+			case 'm':
+				mix = optarg;
+				break;
+			case 'n':
+				if (parse_long(option, optarg, 1, INT_MAX, &conf.keys) == -1) return EXIT_FAILURE;
+				break;
+			case 's':
+				sizes = optarg;
+				break;
+			case 'u':
+				conf.zipf = 0;
+				break;
+			case 'Z':
+				conf.zipf = strtod(optarg, NULL);
+				if (conf.zipf <= 0) {
+					fprintf(stderr, "ERR: l'argomento di -Z deve essere un numero positivo\n");
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'x':
+				if (optarg[0] != '/' || strchr(optarg, ',')) {
+					fprintf(stderr, "ERR: il prefisso deve essere un path assoluto che non contiene ','\n");
+					return EXIT_FAILURE;
+				}
+				conf.prefix = optarg;
+				break;
+			case 'e':
+				conf.populate = false;
+				break;
+			case 'S':
+				if (parse_long(option, optarg, 1, LONG_MAX, &conf.seed) == -1) return EXIT_FAILURE;
+				break;
+			case 'z':
+				enable_compression();
+				break;
+			case 'k':
+				enable_checksum();
+				break;
+			case ':':
+				fprintf(stderr, "ERR: l'opzione -%c necessita un argomento\n", optopt);
+				return EXIT_FAILURE;
+			default:
+				fprintf(stderr, "ERR: l'opzione -%c non è gestita\n", optopt);
+				return EXIT_FAILURE;
+		}
+	}
+	if (!conf.sockname) {
+		fprintf(stderr, "ERR: è necessario specificare il server con -f\n");
+		return EXIT_FAILURE;
+	}
+	// non avvio più thread delle operazioni da eseguire e più connessioni dei thread
+	if (conf.ops > 0 && conf.ops < conf.threads)
+		conf.threads = conf.ops;
+	if (conf.conns == 0 || conf.conns > conf.threads)
+		conf.conns = conf.threads;
+
+	// effettuo il parsing del mix di operazioni e delle dimensioni dei file
+	char default_mix[] = DEFAULT_MIX;
+	if (parse_weighted_list(mix ? mix : default_mix, op_names, OP_NUM, NULL, conf.weights) <= 0) {
+		fprintf(stderr, "ERR: mix di operazioni non valido\n");
+		return EXIT_FAILURE;
+	}
+	for (int i = 0; i < OP_NUM; i++)
+		conf.weights_sum += conf.weights[i];
+	if (conf.weights_sum == 0) {
+		fprintf(stderr, "ERR: mix di operazioni non valido\n");
+		return EXIT_FAILURE;
+	}
+	if (sizes) {
+		conf.sizes_num = parse_weighted_list(sizes, NULL, MAX_SIZES, conf.sizes, conf.size_weights);
+		if (conf.sizes_num <= 0) {
+			fprintf(stderr, "ERR: dimensioni dei file non valide\n");
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		conf.sizes[0] = DEFAULT_SIZE;
+		conf.size_weights[0] = 1;
+		conf.sizes_num = 1;
+	}
+	for (int i = 0; i < conf.sizes_num; i++) {
+		conf.size_weights_sum += conf.size_weights[i];
+		if (conf.sizes[i] > conf.max_size)
+			conf.max_size = conf.sizes[i];
+	}
+
+	// calcolo la funzione di ripartizione della distribuzione Zipf
+	if (conf.zipf > 0) {
+		conf.zipf_cdf = malloc(conf.keys * sizeof(double));
+		if (!conf.zipf_cdf) {
+			PERRFMT("ERR: malloc (%s)\n", strerror(errno));
+			return EXIT_FAILURE;
+		}
+		double sum = 0;
+		for (long k = 0; k < conf.keys; k++) {
+			sum += 1.0 / pow(k + 1, conf.zipf);
+			conf.zipf_cdf[k] = sum;
+		}
+		for (long k = 0; k < conf.keys; k++)
+			conf.zipf_cdf[k] /= sum;
+	}
+
+	// ignoro SIGPIPE
+	struct sigaction s;
+	memset(&s, 0, sizeof(struct sigaction));
+	s.sa_handler = SIG_IGN;
+	if (sigaction(SIGPIPE, &s, NULL) == -1) {
+		PERRFMT("ERR: sigaction (%s)\n", strerror(errno));
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+
+	threads = calloc(conf.threads, sizeof(bench_thread_t));
+	tids = calloc(conf.threads, sizeof(pthread_t));
+	conns = calloc(conf.conns, sizeof(fss_conn_t*));
+	if (!threads || !tids || !conns) {
+		PERRFMT("ERR: calloc (%s)\n", strerror(errno));
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+
+	// apro le connessioni
+	struct timespec abstime;
+	abstime.tv_nsec = 0;
+	abstime.tv_sec = time(NULL) + TRY_CONN_FOR_SEC;
+	for (conns_opened = 0; conns_opened < conf.conns; conns_opened++) {
+		conns[conns_opened] = fss_connect(conf.sockname, RETRY_CONN_AFTER_MSEC, abstime);
+		if (!conns[conns_opened]) {
+			fprintf(stderr, "ERR: fss_connect (%s)\n", errno_to_str(errno));
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+	}
+
+	// inizializzo lo stato dei thread
+	uint64_t seed = conf.seed ? (uint64_t) conf.seed : (uint64_t) time(NULL) ^ ((uint64_t) getpid() << 32);
+	for (int i = 0; i < conf.threads; i++) {
+		threads[i].id = i;
+		threads[i].conn = conns[i % conf.conns];
+		threads[i].rng = (seed + i + 1) * 0x9E3779B97F4A7C15ULL;
+		threads[i].ops = conf.ops == 0 ? 0 : conf.ops / conf.threads + (i < conf.ops % conf.threads);
+		threads[i].buf = malloc(conf.max_size ? conf.max_size : 1);
+		if (!threads[i].buf) {
+			PERRFMT("ERR: malloc (%s)\n", strerror(errno));
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+		for (size_t j = 0; j < conf.max_size; j++)
+			threads[i].buf[j] = 'a' + rng_next(&threads[i].rng) % 26;
+	}
+
+	// creo i file prima della misurazione
+	if (conf.populate) {
+		printf("Creazione di %ld file...\n", conf.keys);
+		int started;
+		for (started = 0; started < conf.threads; started++) {
+			if (pthread_create(&tids[started], NULL, populate_worker, &threads[started]) != 0)
+				break;
+		}
+		for (int i = 0; i < started; i++)
+			pthread_join(tids[i], NULL);
+		for (int i = 0; i < conf.threads; i++) {
+			if (threads[i].fatal || started < conf.threads) {
+				fprintf(stderr, "ERR: non è stato possibile creare i file\n");
+				extval = EXIT_FAILURE;
+				goto exit;
+			}
+		}
+	}
+
+	// avvio la misurazione
+	printf("%d thread, %d connessioni, %s", conf.threads, conf.conns, conf.rate > 0 ? "ciclo aperto" : "ciclo chiuso");
+	if (conf.rate > 0)
+		printf(" a %.0f op/s", conf.rate);
+	printf(", %ld file, popolarità %s", conf.keys, conf.zipf > 0 ? "zipf" : "uniforme");
+	if (conf.zipf > 0)
+		printf(" (s=%.2f)", conf.zipf);
+	printf("\n");
+	clock_gettime(CLOCK_MONOTONIC, &bench_start);
+	int started;
+	for (started = 0; started < conf.threads; started++) {
+		if (pthread_create(&tids[started], NULL, bench_worker, &threads[started]) != 0) {
+			PERRFMT("%s", "ERR: pthread_create\n");
+			extval = EXIT_FAILURE;
+			break;
+		}
+	}
+	for (int i = 0; i < started; i++)
+		pthread_join(tids[i], NULL);
+	double elapsed = (now_usec() - ts_to_usec(&bench_start)) / 1000000.0;
+
+	// stampo il report
+	hist_t* total = calloc(1, sizeof(hist_t));
+	hist_t* per_op = calloc(OP_NUM, sizeof(hist_t));
+	if (!total || !per_op) {
+		PERRFMT("ERR: calloc (%s)\n", strerror(errno));
+		if (total) free(total);
+		if (per_op) free(per_op);
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+	for (int i = 0; i < conf.threads; i++) {
+		if (threads[i].fatal)
+			extval = EXIT_FAILURE;
+		for (int op = 0; op < OP_NUM; op++) {
+			hist_merge(&per_op[op], &threads[i].hist[op]);
+			hist_merge(total, &threads[i].hist[op]);
+		}
+	}
+	printf("durata %.3f s, latenze in microsecondi\n", elapsed);
+	hist_print_header();
+	for (int op = 0; op < OP_NUM; op++) {
+		if (conf.weights[op] > 0)
+			hist_print_row(op_names[op], &per_op[op], elapsed);
+	}
+	hist_print_row("total", total, elapsed);
+	free(total);
+	free(per_op);
+
+exit:
+	for (int i = 0; i < conns_opened; i++)
+		fss_disconnect(conns[i]);
+	if (threads) {
+		for (int i = 0; i < conf.threads; i++) {
+			if (threads[i].buf)
+				free(threads[i].buf);
+		}
+		free(threads);
+	}
+	if (tids)
+		free(tids);
+	if (conns)
+		free(conns);
+	if (conf.zipf_cdf)
+		free(conf.zipf_cdf);
+	return extval;
+}
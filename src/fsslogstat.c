@@ -0,0 +1,1108 @@
+/**
+ * @file                     fsslogstat.c
+ * @brief                    Analizzatore del file di log del server. Calcola le stesse statistiche di statistiche.sh,
+ *                           stampandole nello stesso formato, con un'unica lettura del log: il file viene mappato in
+ *                           memoria e suddiviso, in corrispondenza dei fine riga, in porzioni analizzate in parallelo
+ *                           da più thread, i cui risultati parziali vengono infine sommati.
+ *                           Con l'opzione -x stampa inoltre le richieste servite in ciascun secondo, la distribuzione
+ *                           dei bytes processati da ciascuna operazione e il bilanciamento del carico tra i thread.
+ *                           I campi dei record e il loro valore numerico vengono interpretati come farebbe awk -F",".
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <hasht.h>
+#include <log_format.h>
+#include <util.h>
+
+/* Numero di campi di un record del log considerati */
+#define LOG_FIELDS 10
+/* Indici dei campi di un record del log */
+#define F_TIME 0
+#define F_THREAD_ID 1
+#define F_OPERATION 2
+#define F_BYTES 6
+#define F_CURR_FILES 7
+#define F_CURR_BYTES 8
+#define F_CURR_CLIENTS 9
+/* Lunghezza del campo TIME (dd-mm-yyyy HH:MM:SS) */
+#define TIME_LEN 19
+/* Massimo numero di thread */
+#define MAX_THREADS 64
+/* Minima dimensione della porzione del log analizzata da ciascun thread */
+#define MIN_CHUNK_SIZE (1 << 20)
+/* Numero di bucket degli istogrammi dei bytes (0 e una potenza di 2 per bucket) */
+#define BYTES_BUCKETS 65
+/* Numero di bucket iniziale delle tabelle hash */
+#define HT_BUCKETS 1024
+
+/**
+ * @enum                     counter_t
+ * @brief                    Contatori della sezione OPERAZIONI (e delle nuove connessioni).
+ */
+typedef enum counter {
+	C_OPEN_NO_FLAGS,
+	C_OPEN_LOCK,
+	C_OPEN_CREATE_LOCK,
+	C_LOCK,
+	C_UNLOCK,
+	C_CLOSE,
+	C_OPEN_WRITE_CLOSE,
+	C_OPEN_READ_CLOSE,
+	C_READ,
+	C_WRITE,
+	C_REMOVE,
+	C_EVICTION,
+	C_NEW_CONNECTION,
+	C_NUM
+} counter_t;
+
+/**
+ * @struct                   field_t
+ * @brief                    Campo di un record del log (non terminato da '\0').
+ *
+ * @var s                    Puntatore al primo carattere del campo
+ * @var len                  Lunghezza del campo
+ */
+typedef struct field {
+	const char* s;
+	size_t len;
+} field_t;
+
+/**
+ * @struct                   awk_max_t
+ * @brief                    Massimo dei valori numerici di un campo.
+ *
+ * @var set                  Flag che indica se è stato registrato almeno un valore
+ * @var value                Il massimo
+ * @var strings              Flag che indica se il campo ha assunto valori non numerici e non vuoti: awk li confronta
+ *                           come stringhe e il massimo dipende dall'ordine dei record, va quindi ricalcolato con
+ *                           fold_max()
+ */
+typedef struct awk_max {
+	bool set;
+	double value;
+	bool strings;
+} awk_max_t;
+
+/**
+ * @struct                   bytes_hist_t
+ * @brief                    Istogramma dei bytes processati da un'operazione.
+ *
+ * @var count                Numero di record
+ * @var sum                  Somma dei bytes
+ * @var buckets              Contatori dei bucket (il bucket 0 conta i record con 0 bytes, il bucket i > 0 quelli con
+ *                           bytes in [2^(i-1), 2^i))
+ */
+typedef struct bytes_hist {
+	long count;
+	double sum;
+	long buckets[BYTES_BUCKETS];
+} bytes_hist_t;
+
+/**
+ * @struct                   log_stats_t
+ * @brief                    Statistiche calcolate su una porzione del log.
+ *
+ * @var start                Inizio della porzione
+ * @var end                  Fine della porzione
+ * @var first                Flag che indica se la porzione inizia con il primo record (l'intestazione) del log
+ * @var counters             Contatori della sezione OPERAZIONI
+ * @var read_sum             Somma dei bytes dei record di lettura
+ * @var read_count           Numero di record di lettura
+ * @var write_sum            Somma dei bytes dei record di scrittura
+ * @var write_count          Numero di record di scrittura
+ * @var max_files            Massimo numero di file memorizzati
+ * @var max_bytes            Massimo numero di bytes memorizzati
+ * @var max_clients          Massimo numero di connessioni contemporanee
+ * @var threads              Tabella hash THREAD_ID -> numero di richieste servite (long*)
+ * @var seconds              Tabella hash TIME -> numero di richieste servite (long*)
+ * @var ops                  Tabella hash OPERATION -> istogramma dei bytes processati (bytes_hist_t*)
+ * @var error                Flag che indica se si è verificato un errore
+ */
+typedef struct log_stats {
+	const char* start;
+	const char* end;
+	bool first;
+	long counters[C_NUM];
+	double read_sum;
+	long read_count;
+	double write_sum;
+	long write_count;
+	awk_max_t max_files;
+	awk_max_t max_bytes;
+	awk_max_t max_clients;
+	hasht_t* threads;
+	hasht_t* seconds;
+	hasht_t* ops;
+	bool error;
+} log_stats_t;
+
+/**
+ * @struct                   second_t
+ * @brief                    Richieste servite in un secondo.
+ *
+ * @var time                 Il secondo (in secondi dall'epoca, UTC)
+ * @var label                Il campo TIME del secondo
+ * @var count                Numero di richieste servite
+ */
+typedef struct second {
+	time_t time;
+	const char* label;
+	long count;
+} second_t;
+
+/**
+ * @function                 contains()
+ * @brief                    Verifica se il campo f contiene la stringa s (equivale a $n ~ /s/ in awk).
+ *
+ * @param f                  Il campo
+ * @param s                  La stringa da cercare
+ *
+ * @return                   true se il campo contiene s, false altrimenti.
+ */
+static inline bool contains(const field_t* f, const char* s) {
+	size_t len = strlen(s);
+	if (len > f->len)
+		return false;
+	for (const char* p = f->s; p + len <= f->s + f->len; p++) {
+		if ((p = memchr(p, s[0], f->s + f->len - p)) == NULL || p + len > f->s + f->len)
+			return false;
+		if (memcmp(p, s, len) == 0)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @function                 equals()
+ * @brief                    Verifica se il campo f è uguale alla stringa s (equivale a $n ~ /^s$/ in awk).
+ *
+ * @param f                  Il campo
+ * @param s                  La stringa
+ *
+ * @return                   true se il campo è uguale a s, false altrimenti.
+ */
+static inline bool equals(const field_t* f, const char* s) {
+	return strlen(s) == f->len && memcmp(f->s, s, f->len) == 0;
+}
+
+/**
+ * @function                 awk_number()
+ * @brief                    Converte il campo f in numero come farebbe awk, considerandone il più lungo prefisso che
+ *                           rappresenta un numero decimale (0 se non ne esiste uno).
+ *
+ * @param f                  Il campo
+ * @param numeric            Se diverso da @c NULL, viene settato a true se l'intero campo rappresenta un numero
+ *                           (a meno di spazi iniziali e finali), a false altrimenti
+ *
+ * @return                   Il valore numerico del campo.
+ */
+static double awk_number(const field_t* f, bool* numeric) {
+	const char* p = f->s;
+	const char* end = f->s + f->len;
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	const char* num = p;
+	if (p < end && (*p == '+' || *p == '-'))
+		p++;
+	int digits = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		p++;
+		digits++;
+	}
+	if (p < end && *p == '.') {
+		p++;
+		while (p < end && *p >= '0' && *p <= '9') {
+			p++;
+			digits++;
+		}
+	}
+	if (digits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+		const char* exp = p + 1;
+		if (exp < end && (*exp == '+' || *exp == '-'))
+			exp++;
+		if (exp < end && *exp >= '0' && *exp <= '9') {
+			while (exp < end && *exp >= '0' && *exp <= '9')
+				exp++;
+			p = exp;
+		}
+	}
+	double value = 0;
+	if (digits > 0) {
+		char buf[64];
+		size_t len = p - num < sizeof(buf) - 1 ? p - num : sizeof(buf) - 1;
+		memcpy(buf, num, len);
+		buf[len] = '\0';
+		value = strtod(buf, NULL);
+	}
+	if (numeric) {
+		const char* q = p;
+		while (q < end && (*q == ' ' || *q == '\t'))
+			q++;
+		*numeric = digits > 0 && q == end;
+	}
+	return value;
+}
+
+/**
+ * @function                 update_max()
+ * @brief                    Aggiorna il massimo m con il valore del campo f se questo è numerico
+ *                           (equivale a $n > max {max = $n} in awk se il campo non assume valori non numerici).
+ *
+ * @param m                  Il massimo
+ * @param f                  Il campo
+ */
+static inline void update_max(awk_max_t* m, const field_t* f) {
+	bool numeric;
+	double v = awk_number(f, &numeric);
+	if (!numeric && f->len > 0)
+		m->strings = true;
+	if (numeric && v > (m->set ? m->value : 0)) {
+		m->value = v;
+		m->set = true;
+	}
+}
+
+/**
+ * @function                 merge_max()
+ * @brief                    Somma al massimo dst il massimo src.
+ *
+ * @param dst                Il massimo destinazione
+ * @param src                Il massimo sorgente
+ */
+static inline void merge_max(awk_max_t* dst, const awk_max_t* src) {
+	if (src->set && (!dst->set || src->value > dst->value)) {
+		dst->set = true;
+		dst->value = src->value;
+	}
+	dst->strings |= src->strings;
+}
+
+/**
+ * @function                 split_fields()
+ * @brief                    Suddivide il record [line, end) nei suoi primi LOG_FIELDS campi (quelli mancanti sono
+ *                           vuoti).
+ *
+ * @param line               Inizio del record
+ * @param end                Fine del record (escluso il carattere di fine riga)
+ * @param f                  L'array in cui memorizzare i campi
+ */
+static inline void split_fields(const char* line, const char* end, field_t* f) {
+	memset(f, 0, sizeof(field_t) * LOG_FIELDS);
+	const char* p = line;
+	for (int n = 0; n < LOG_FIELDS; n++) {
+		const char* comma = memchr(p, ',', end - p);
+		f[n].s = p;
+		f[n].len = (comma ? comma : end) - p;
+		if (!comma)
+			break;
+		p = comma + 1;
+	}
+}
+
+/**
+ * @function                 fold_max()
+ * @brief                    Calcola il massimo dei valori del campo column dei record del log successivi al primo
+ *                           confrontandoli come farebbe awk: numericamente se entrambi i valori sono numerici,
+ *                           come stringhe altrimenti.
+ *
+ * @param map                Il log
+ * @param size               La dimensione del log
+ * @param column             L'indice del campo
+ *
+ * @return                   Il valore numerico del massimo (max+0 in awk).
+ */
+static double fold_max(const char* map, size_t size, int column) {
+	field_t f[LOG_FIELDS];
+	field_t max = {NULL, 0};
+	bool max_set = false, max_numeric = false;
+	double max_value = 0;
+	const char* end = map + size;
+	const char* nl = memchr(map, '\n', size);
+	for (const char* line = nl ? nl + 1 : end; line < end; line = nl + 1) {
+		nl = memchr(line, '\n', end - line);
+		if (!nl)
+			nl = end;
+		split_fields(line, nl, f);
+		bool numeric;
+		double v = awk_number(&f[column], &numeric);
+		bool greater;
+		// una variabile non inizializzata vale 0 nei confronti numerici e "" in quelli tra stringhe
+		if (numeric && (!max_set || max_numeric))
+			greater = v > max_value;
+		else {
+			size_t len = f[column].len < max.len ? f[column].len : max.len;
+			int r = len ? memcmp(f[column].s, max.s, len) : 0;
+			greater = r > 0 || (r == 0 && f[column].len > max.len);
+		}
+		if (greater) {
+			max = f[column];
+			max_set = true;
+			max_numeric = numeric;
+			max_value = v;
+		}
+	}
+	return max_value;
+}
+
+/**
+ * @function                 print_awk_number()
+ * @brief                    Stampa sullo stdout il numero v come farebbe print in awk.
+ *
+ * @param v                  Il numero
+ */
+static void print_awk_number(double v) {
+	if (v == (long long) v)
+		printf("%lld", (long long) v);
+	else
+		printf("%.6g", v);
+}
+
+/**
+ * @function                 field_to_str()
+ * @brief                    Restituisce una copia terminata da '\0' del campo f.
+ *
+ * @param f                  Il campo
+ *
+ * @return                   La copia in caso di successo, @c NULL in caso di fallimento con errno settato.
+ */
+static char* field_to_str(const field_t* f) {
+	char* s = malloc(f->len + 1);
+	if (!s)
+		return NULL;
+	memcpy(s, f->s, f->len);
+	s[f->len] = '\0';
+	return s;
+}
+
+/**
+ * @function                 ht_lookup()
+ * @brief                    Restituisce il valore associato in ht alla chiave f, inserendo se non presente una nuova
+ *                           entry con valore allocato con calloc() di value_size bytes.
+ *
+ * @param ht                 La tabella hash
+ * @param f                  Il campo da utilizzare come chiave
+ * @param value_size         La dimensione del valore
+ *
+ * @return                   Il valore in caso di successo, @c NULL in caso di fallimento con errno settato.
+ */
+static void* ht_lookup(hasht_t* ht, const field_t* f, size_t value_size) {
+	char key[256];
+	char* k = f->len < sizeof(key) ? key : field_to_str(f);
+	if (!k)
+		return NULL;
+	if (k == key) {
+		memcpy(key, f->s, f->len);
+		key[f->len] = '\0';
+	}
+	void* value = hasht_get_value(ht, k);
+	if (!value) {
+		char* new_key = k == key ? strdup(key) : k;
+		value = calloc(1, value_size);
+		if (!new_key || !value || hasht_insert(ht, new_key, value) == -1) {
+			free(new_key);
+			free(value);
+			return NULL;
+		}
+		return value;
+	}
+	if (k != key)
+		free(k);
+	return value;
+}
+
+/**
+ * @function                 bytes_bucket()
+ * @brief                    Restituisce il bucket dell'istogramma dei bytes in cui ricade v.
+ *
+ * @param v                  Il numero di bytes
+ *
+ * @return                   L'indice del bucket.
+ */
+static inline int bytes_bucket(uint64_t v) {
+	return v == 0 ? 0 : 64 - __builtin_clzll(v);
+}
+
+/**
+ * @function                 is_request()
+ * @brief                    Verifica se il record con operazione op rappresenta una richiesta servita da un thread
+ *                           (i record considerati dalla sezione THREADS di statistiche.sh).
+ *
+ * @param op                 Il campo OPERATION del record
+ *
+ * @return                   true se il record rappresenta una richiesta servita, false altrimenti.
+ */
+static inline bool is_request(const field_t* op) {
+	return contains(op, "OPEN") || contains(op, "WRITE") || contains(op, "APPEND") || contains(op, "LOCK") ||
+		contains(op, "REMOVE") || equals(op, "CLOSE") || contains(op, "READN 1/") ||
+		contains(op, "READN_CURSOR 1/") || equals(op, "READ") || equals(op, "READ_RANGE") ||
+		equals(op, "READ_IF_NEWER") || contains(op, "TEMPORARILY_UNAVAILABLE");
+}
+
+/**
+ * @function                 analyze_line()
+ * @brief                    Aggiorna le statistiche st con il record [line, end).
+ *
+ * @param st                 Le statistiche
+ * @param line               Inizio del record
+ * @param end                Fine del record (escluso il carattere di fine riga)
+ * @param header             Flag che indica se il record è il primo del log
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento con errno settato.
+ */
+static int analyze_line(log_stats_t* st, const char* line, const char* end, bool header) {
+	field_t f[LOG_FIELDS];
+	split_fields(line, end, f);
+	const field_t* op = &f[F_OPERATION];
+
+	// OPERAZIONI
+	if (contains(op, "OPEN_NO_FLAGS")) st->counters[C_OPEN_NO_FLAGS]++;
+	if (contains(op, "OPEN_LOCK")) st->counters[C_OPEN_LOCK]++;
+	if (contains(op, "OPEN_CREATE_LOCK")) st->counters[C_OPEN_CREATE_LOCK]++;
+	if (equals(op, "LOCK")) st->counters[C_LOCK]++;
+	if (contains(op, "UNLOCK")) st->counters[C_UNLOCK]++;
+	if (equals(op, "CLOSE")) st->counters[C_CLOSE]++;
+	if (contains(op, "OPEN_WRITE_CLOSE")) st->counters[C_OPEN_WRITE_CLOSE]++;
+	if (contains(op, "OPEN_READ_CLOSE")) st->counters[C_OPEN_READ_CLOSE]++;
+	if (contains(op, "REMOVE")) st->counters[C_REMOVE]++;
+	if (contains(op, EVICTION)) st->counters[C_EVICTION]++;
+	if (contains(op, NEW_CONNECTION)) st->counters[C_NEW_CONNECTION]++;
+
+	// STATISTICHE
+	if (contains(op, "READ")) {
+		st->counters[C_READ]++;
+		st->read_sum += awk_number(&f[F_BYTES], NULL);
+		st->read_count++;
+	}
+	if (contains(op, "WRITE") || contains(op, "APPEND")) {
+		st->counters[C_WRITE]++;
+		st->write_sum += awk_number(&f[F_BYTES], NULL);
+		st->write_count++;
+	}
+	if (header)
+		return 0;
+	update_max(&st->max_files, &f[F_CURR_FILES]);
+	update_max(&st->max_bytes, &f[F_CURR_BYTES]);
+	update_max(&st->max_clients, &f[F_CURR_CLIENTS]);
+
+	// THREADS e richieste servite in ciascun secondo
+	if (is_request(op)) {
+		long* count = ht_lookup(st->threads, &f[F_THREAD_ID], sizeof(long));
+		if (!count)
+			return -1;
+		(*count)++;
+		if ((count = ht_lookup(st->seconds, &f[F_TIME], sizeof(long))) == NULL)
+			return -1;
+		(*count)++;
+	}
+
+	// bytes processati da ciascuna operazione (READN i/N e READN_CURSOR i/N sono considerate come READN e
+	// READN_CURSOR)
+	if (f[F_BYTES].len > 0) {
+		bool numeric;
+		double bytes = awk_number(&f[F_BYTES], &numeric);
+		if (numeric && bytes >= 0) {
+			field_t name = *op;
+			const char* space = memchr(name.s, ' ', name.len);
+			if (space)
+				name.len = space - name.s;
+			bytes_hist_t* h = ht_lookup(st->ops, &name, sizeof(bytes_hist_t));
+			if (!h)
+				return -1;
+			h->count++;
+			h->sum += bytes;
+			h->buckets[bytes_bucket(bytes >= (double) UINT64_MAX ? UINT64_MAX : (uint64_t) bytes)]++;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @function                 analyze_chunk()
+ * @brief                    Funzione eseguita dai thread: analizza i record della porzione del log assegnata.
+ *
+ * @param arg                Le statistiche della porzione (log_stats_t*)
+ */
+static void* analyze_chunk(void* arg) {
+	log_stats_t* st = arg;
+	const char* line = st->start;
+	bool header = st->first;
+	while (line < st->end) {
+		const char* nl = memchr(line, '\n', st->end - line);
+		const char* end = nl ? nl : st->end;
+		if (analyze_line(st, line, end, header) == -1) {
+			st->error = true;
+			return NULL;
+		}
+		header = false;
+		line = end + 1;
+	}
+	return NULL;
+}
+
+/**
+ * @function                 stats_init()
+ * @brief                    Inizializza le statistiche st.
+ *
+ * @param st                 Le statistiche
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento con errno settato.
+ */
+static int stats_init(log_stats_t* st) {
+	memset(st, 0, sizeof(log_stats_t));
+	st->threads = hasht_create(HT_BUCKETS, NULL, NULL);
+	st->seconds = hasht_create(HT_BUCKETS, NULL, NULL);
+	st->ops = hasht_create(HT_BUCKETS, NULL, NULL);
+	if (!st->threads || !st->seconds || !st->ops)
+		return -1;
+	return 0;
+}
+
+/**
+ * @function                 stats_destroy()
+ * @brief                    Dealloca la memoria delle statistiche st.
+ *
+ * @param st                 Le statistiche
+ */
+static void stats_destroy(log_stats_t* st) {
+	if (st->threads)
+		hasht_destroy(st->threads, free, free);
+	if (st->seconds)
+		hasht_destroy(st->seconds, free, free);
+	if (st->ops)
+		hasht_destroy(st->ops, free, free);
+}
+
+/**
+ * @function                 merge_ht()
+ * @brief                    Somma ai valori della tabella hash dst quelli della tabella hash src.
+ *
+ * @param dst                La tabella hash destinazione
+ * @param src                La tabella hash sorgente
+ * @param hist               Flag che indica se i valori sono bytes_hist_t (altrimenti sono long)
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento con errno settato.
+ */
+static int merge_ht(hasht_t* dst, hasht_t* src, bool hist) {
+	for (size_t b = 0; b < src->nbuckets; b++) {
+		for (entry_t* e = src->buckets[b]; e != NULL; e = e->next) {
+			field_t key = {e->key, strlen(e->key)};
+			void* value = ht_lookup(dst, &key, hist ? sizeof(bytes_hist_t) : sizeof(long));
+			if (!value)
+				return -1;
+			if (hist) {
+				bytes_hist_t* d = value;
+				bytes_hist_t* s = e->value;
+				d->count += s->count;
+				d->sum += s->sum;
+				for (int i = 0; i < BYTES_BUCKETS; i++)
+					d->buckets[i] += s->buckets[i];
+			}
+			else
+				*(long*) value += *(long*) e->value;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @function                 stats_merge()
+ * @brief                    Somma alle statistiche dst le statistiche src.
+ *
+ * @param dst                Le statistiche destinazione
+ * @param src                Le statistiche sorgente
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento con errno settato.
+ */
+static int stats_merge(log_stats_t* dst, log_stats_t* src) {
+	for (int i = 0; i < C_NUM; i++)
+		dst->counters[i] += src->counters[i];
+	dst->read_sum += src->read_sum;
+	dst->read_count += src->read_count;
+	dst->write_sum += src->write_sum;
+	dst->write_count += src->write_count;
+	merge_max(&dst->max_files, &src->max_files);
+	merge_max(&dst->max_bytes, &src->max_bytes);
+	merge_max(&dst->max_clients, &src->max_clients);
+	if (merge_ht(dst->threads, src->threads, false) == -1 || merge_ht(dst->seconds, src->seconds, false) == -1 ||
+		merge_ht(dst->ops, src->ops, true) == -1)
+		return -1;
+	return 0;
+}
+
+/**
+ * @function                 ht_entries()
+ * @brief                    Restituisce un array con le entry della tabella hash ht.
+ *
+ * @param ht                 La tabella hash
+ *
+ * @return                   L'array (di ht->nentries elementi) in caso di successo, @c NULL in caso di fallimento con
+ *                           errno settato.
+ */
+static entry_t** ht_entries(hasht_t* ht) {
+	entry_t** entries = malloc((ht->nentries ? ht->nentries : 1) * sizeof(entry_t*));
+	if (!entries)
+		return NULL;
+	size_t n = 0;
+	for (size_t b = 0; b < ht->nbuckets; b++) {
+		for (entry_t* e = ht->buckets[b]; e != NULL; e = e->next)
+			entries[n++] = e;
+	}
+	return entries;
+}
+
+/**
+ * @function                 line_coll_cmp()
+ * @brief                    Confronta due righe secondo la localizzazione corrente (come sort).
+ */
+static int line_coll_cmp(const void* a, const void* b) {
+	int r = strcoll(*(char* const*) a, *(char* const*) b);
+	return r != 0 ? r : strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+/**
+ * @function                 entry_key_cmp()
+ * @brief                    Confronta le chiavi (stringhe) di due entry.
+ */
+static int entry_key_cmp(const void* a, const void* b) {
+	return strcmp((*(entry_t* const*) a)->key, (*(entry_t* const*) b)->key);
+}
+
+/**
+ * @function                 second_cmp()
+ * @brief                    Confronta due secondi.
+ */
+static int second_cmp(const void* a, const void* b) {
+	const second_t* x = a;
+	const second_t* y = b;
+	return x->time < y->time ? -1 : x->time > y->time;
+}
+
+/**
+ * @function                 parse_time()
+ * @brief                    Converte il campo TIME (dd-mm-yyyy HH:MM:SS) in secondi dall'epoca (UTC).
+ *
+ * @param s                  Il campo TIME
+ * @param t                  Il puntatore in cui memorizzare il risultato
+ *
+ * @return                   0 in caso di successo, -1 se il campo non è nel formato atteso.
+ */
+static int parse_time(const char* s, time_t* t) {
+	int d, mo, y, h, mi, sec;
+	if (strlen(s) != TIME_LEN || sscanf(s, "%2d-%2d-%4d %2d:%2d:%2d", &d, &mo, &y, &h, &mi, &sec) != 6)
+		return -1;
+	// giorni dall'epoca della data (algoritmo days_from_civil)
+	y -= mo <= 2;
+	long era = (y >= 0 ? y : y - 399) / 400;
+	long yoe = y - era * 400;
+	long doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	long days = era * 146097 + doe - 719468;
+	*t = (time_t) days * 86400 + h * 3600 + mi * 60 + sec;
+	return 0;
+}
+
+/**
+ * @function                 print_section()
+ * @brief                    Stampa sullo stdout l'intestazione della sezione title nel formato di statistiche.sh.
+ *
+ * @param title              Il titolo della sezione
+ */
+static void print_section(const char* title) {
+	int len = strlen(title);
+	int left = (60 - len + 1) / 2;
+	int right = 60 - len - left;
+	printf("%.*s %s %.*s\n", left, "==============================================================", title,
+		right, "==============================================================");
+}
+
+/**
+ * @function                 print_stats()
+ * @brief                    Stampa sullo stdout le statistiche di statistiche.sh.
+ *
+ * @param st                 Le statistiche del log
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento con errno settato.
+ */
+static int print_stats(log_stats_t* st) {
+	long* c = st->counters;
+	print_section("OPERAZIONI");
+	printf("Numero di open senza flag: %ld\n", c[C_OPEN_NO_FLAGS]);
+	printf("Numero di open-lock: %ld\n", c[C_OPEN_LOCK]);
+	printf("Numero di open-create-lock: %ld\n", c[C_OPEN_CREATE_LOCK]);
+	printf("Numero di lock: %ld\n", c[C_LOCK]);
+	printf("Numero di unlock: %ld\n", c[C_UNLOCK]);
+	printf("Numero di close: %ld\n", c[C_CLOSE]);
+	printf("Numero di open-write-close: %ld\n", c[C_OPEN_WRITE_CLOSE]);
+	printf("Numero di open-read-close: %ld\n", c[C_OPEN_READ_CLOSE]);
+	printf("Numero di file letti: %ld\n", c[C_READ]);
+	printf("Numero di file scritti (con write o append): %ld\n", c[C_WRITE]);
+	printf("Numero di remove: %ld\n", c[C_REMOVE]);
+	printf("Numero di esecuzioni dell'algoritmo di rimpiazzamento: %ld\n", c[C_EVICTION]);
+
+	print_section("STATISTICHE");
+	printf("Byte letti in media: %.f\n", st->read_count == 0 ? 0 : st->read_sum / st->read_count + 0.5);
+	printf("Byte scritti in media: %.f\n", st->write_count == 0 ? 0 : st->write_sum / st->write_count + 0.5);
+	// statistiche.sh calcola i MB con bc (scale=6), che omette lo zero prima della virgola
+	double max_bytes = st->max_bytes.set ? st->max_bytes.value : 0;
+	printf("Massimo numero di MB memorizzati: ");
+	if (max_bytes == 0)
+		printf("0\n");
+	else {
+		long long micro = (long long) max_bytes;
+		if (micro >= 1000000)
+			printf("%lld", micro / 1000000);
+		printf(".%06lld\n", micro % 1000000);
+	}
+	printf("Massimo numero di file memorizzati: ");
+	print_awk_number(st->max_files.set ? st->max_files.value : 0);
+	printf("\nMassimo numero di connessioni contemporanee: ");
+	print_awk_number(st->max_clients.set ? st->max_clients.value : 0);
+	printf("\nNumero di clienti serviti in totale: %ld\n", c[C_NEW_CONNECTION]);
+
+	print_section("THREADS");
+	if (st->threads->nentries == 0) {
+		printf("I thread non hanno servito alcuna richiesta\n");
+		return 0;
+	}
+	// statistiche.sh ordina le righe con sort
+	entry_t** entries = ht_entries(st->threads);
+	char** lines = calloc(st->threads->nentries, sizeof(char*));
+	int extval = 0;
+	if (!entries || !lines) {
+		extval = -1;
+		goto exit;
+	}
+	for (size_t i = 0; i < st->threads->nentries; i++) {
+		size_t len = strlen(entries[i]->key) + 64;
+		if ((lines[i] = malloc(len)) == NULL) {
+			extval = -1;
+			goto exit;
+		}
+		snprintf(lines[i], len, "Il thread %s ha servito %ld richieste", (char*) entries[i]->key,
+			*(long*) entries[i]->value);
+	}
+	qsort(lines, st->threads->nentries, sizeof(char*), line_coll_cmp);
+	for (size_t i = 0; i < st->threads->nentries; i++)
+		printf("%s\n", lines[i]);
+
+exit:
+	if (lines) {
+		for (size_t i = 0; i < st->threads->nentries; i++)
+			free(lines[i]);
+		free(lines);
+	}
+	free(entries);
+	return extval;
+}
+
+/**
+ * @function                 print_extended_stats()
+ * @brief                    Stampa sullo stdout le richieste servite in ciascun secondo, la distribuzione dei bytes
+ *                           processati da ciascuna operazione e il bilanciamento del carico tra i thread.
+ *
+ * @param st                 Le statistiche del log
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento con errno settato.
+ */
+static int print_extended_stats(log_stats_t* st) {
+	int extval = 0;
+	second_t* seconds = NULL;
+	entry_t** entries = NULL;
+
+	print_section("THROUGHPUT");
+	size_t n = 0;
+	if ((entries = ht_entries(st->seconds)) == NULL ||
+		(seconds = malloc((st->seconds->nentries ? st->seconds->nentries : 1) * sizeof(second_t))) == NULL) {
+		extval = -1;
+		goto exit;
+	}
+	for (size_t i = 0; i < st->seconds->nentries; i++) {
+		if (parse_time(entries[i]->key, &seconds[n].time) == 0) {
+			seconds[n].label = entries[i]->key;
+			seconds[n].count = *(long*) entries[i]->value;
+			n++;
+		}
+	}
+	free(entries);
+	entries = NULL;
+	if (n == 0)
+		printf("Nessuna richiesta servita\n");
+	else {
+		qsort(seconds, n, sizeof(second_t), second_cmp);
+		// i secondi in cui non è stata servita alcuna richiesta non compaiono nel log
+		long span = seconds[n - 1].time - seconds[0].time + 1;
+		long total = 0;
+		size_t max = 0;
+		long min = span > (long) n ? 0 : LONG_MAX;
+		for (size_t i = 0; i < n; i++) {
+			total += seconds[i].count;
+			if (seconds[i].count > seconds[max].count)
+				max = i;
+			if (seconds[i].count < min)
+				min = seconds[i].count;
+		}
+		printf("Intervallo: %s - %s (%ld secondi)\n", seconds[0].label, seconds[n - 1].label, span);
+		printf("Richieste servite al secondo: media %.1f, minimo %ld, massimo %ld (%s)\n",
+			(double) total / span, min, seconds[max].count, seconds[max].label);
+		for (size_t i = 0; i < n; i++) {
+			if (i > 0 && seconds[i].time - seconds[i - 1].time > 1)
+				printf("... %ld secondi senza richieste\n", (long) (seconds[i].time - seconds[i - 1].time - 1));
+			printf("%s %ld\n", seconds[i].label, seconds[i].count);
+		}
+	}
+
+	print_section("BYTE PER OPERAZIONE");
+	if ((entries = ht_entries(st->ops)) == NULL) {
+		extval = -1;
+		goto exit;
+	}
+	qsort(entries, st->ops->nentries, sizeof(entry_t*), entry_key_cmp);
+	for (size_t i = 0; i < st->ops->nentries; i++) {
+		bytes_hist_t* h = entries[i]->value;
+		printf("%s: %ld record, %.0f byte (media %.0f)\n", (char*) entries[i]->key, h->count, h->sum,
+			h->count ? h->sum / h->count : 0.0);
+		for (int b = 0; b < BYTES_BUCKETS; b++) {
+			if (h->buckets[b] == 0)
+				continue;
+			if (b == 0)
+				printf("  %-28s %10ld\n", "0", h->buckets[b]);
+			else {
+				char range[64];
+				snprintf(range, sizeof(range), "[%llu, %llu)", 1ULL << (b - 1),
+					b < 64 ? 1ULL << b : ULLONG_MAX);
+				printf("  %-28s %10ld\n", range, h->buckets[b]);
+			}
+		}
+	}
+	free(entries);
+	entries = NULL;
+
+	print_section("BILANCIAMENTO THREADS");
+	size_t nthreads = st->threads->nentries;
+	if (nthreads == 0)
+		printf("I thread non hanno servito alcuna richiesta\n");
+	else {
+		if ((entries = ht_entries(st->threads)) == NULL) {
+			extval = -1;
+			goto exit;
+		}
+		qsort(entries, nthreads, sizeof(entry_t*), entry_key_cmp);
+		double total = 0, sq = 0;
+		size_t min = 0, max = 0;
+		for (size_t i = 0; i < nthreads; i++) {
+			long c = *(long*) entries[i]->value;
+			total += c;
+			sq += (double) c * c;
+			if (c < *(long*) entries[min]->value)
+				min = i;
+			if (c > *(long*) entries[max]->value)
+				max = i;
+		}
+		double mean = total / nthreads;
+		double stddev = sqrt(sq / nthreads - mean * mean > 0 ? sq / nthreads - mean * mean : 0);
+		printf("Thread: %zu, richieste servite: media %.1f, minimo %ld (thread %s), massimo %ld (thread %s)\n",
+			nthreads, mean, *(long*) entries[min]->value, (char*) entries[min]->key,
+			*(long*) entries[max]->value, (char*) entries[max]->key);
+		printf("Rapporto massimo/media: %.2f, coefficiente di variazione: %.2f\n",
+			*(long*) entries[max]->value / mean, stddev / mean);
+		for (size_t i = 0; i < nthreads; i++) {
+			long c = *(long*) entries[i]->value;
+			printf("Thread %s: %5.1f%%\n", (char*) entries[i]->key, c * 100.0 / total);
+		}
+	}
+
+exit:
+	free(entries);
+	free(seconds);
+	return extval;
+}
+
+/**
+ * @function                 usage()
+ * @brief                    Stampa del messaggio di help.
+ *
+ * @param prog               Il nome del programma
+ */
+static void usage(char* prog) {
+	printf("usage: %s [options] logfile\n", prog);
+	printf("options:\n\n"
+		"-h			  stampa il messaggio di help\n\n"
+		"-j n			  numero di thread (default numero di processori)\n\n"
+		"-x			  stampa anche le richieste servite al secondo, i bytes\n"
+		"			  processati da ciascuna operazione e il bilanciamento\n"
+		"			  del carico tra i thread\n\n");
+}
+
+int main(int argc, char* argv[]) {
+	int extval = EXIT_SUCCESS;
+	long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool extended = false;
+	int fd = -1;
+	char* map = NULL;
+	size_t size = 0;
+	log_stats_t* chunks = NULL;
+	int chunks_num = 0;
+	log_stats_t total;
+	bool total_init = false;
+
+	// sort, con cui statistiche.sh ordina le righe della sezione THREADS, rispetta la localizzazione
+	setlocale(LC_COLLATE, "");
+
+	int option;
+	while ((option = getopt(argc, argv, ":hj:x")) != -1) {
+		switch (option) {
+			case 'h':
+				usage(argv[0]);
+				return EXIT_SUCCESS;
+			case 'j':
+				if (is_number(optarg, &nthreads) != 0 || nthreads < 1 || nthreads > MAX_THREADS) {
+					fprintf(stderr, "ERR: l'argomento di -j deve essere compreso tra 1 e %d\n", MAX_THREADS);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'x':
+				extended = true;
+				break;
+			case ':':
+				fprintf(stderr, "ERR: l'opzione -%c necessita un argomento\n", optopt);
+				return EXIT_FAILURE;
+			default:
+				fprintf(stderr, "ERR: l'opzione -%c non è gestita\n", optopt);
+				return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc - 1) {
+		printf("usage: %s [options] logfile\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > MAX_THREADS)
+		nthreads = MAX_THREADS;
+
+	struct stat st;
+	if (stat(argv[optind], &st) == -1 || !S_ISREG(st.st_mode)) {
+		printf("Specifica un file regolare esistente\n");
+		return EXIT_FAILURE;
+	}
+	if ((fd = open(argv[optind], O_RDONLY)) == -1) {
+		perror("open");
+		return EXIT_FAILURE;
+	}
+	size = st.st_size;
+	if (size > 0) {
+		if ((map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+			perror("mmap");
+			map = NULL;
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+		posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+	}
+
+	// suddivido il log in porzioni che terminano con un fine riga
+	if (size / nthreads < MIN_CHUNK_SIZE)
+		nthreads = size / MIN_CHUNK_SIZE > 0 ? size / MIN_CHUNK_SIZE : 1;
+	if ((chunks = calloc(nthreads, sizeof(log_stats_t))) == NULL) {
+		perror("calloc");
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+	const char* start = map;
+	for (chunks_num = 0; chunks_num < nthreads; chunks_num++) {
+		if (stats_init(&chunks[chunks_num]) == -1) {
+			perror("stats_init");
+			chunks_num++;
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+		const char* end = map + size * (chunks_num + 1) / nthreads;
+		if (chunks_num == nthreads - 1)
+			end = map + size;
+		else if (end < start)
+			end = start;
+		else {
+			const char* nl = end > map ? memchr(end - 1, '\n', map + size - (end - 1)) : NULL;
+			end = nl ? nl + 1 : map + size;
+		}
+		chunks[chunks_num].start = start;
+		chunks[chunks_num].end = end;
+		chunks[chunks_num].first = start == map;
+		start = end;
+	}
+
+	pthread_t tids[MAX_THREADS];
+	int started = 0;
+	for (; started < chunks_num; started++) {
+		if ((errno = pthread_create(&tids[started], NULL, analyze_chunk, &chunks[started])) != 0) {
+			perror("pthread_create");
+			extval = EXIT_FAILURE;
+			break;
+		}
+	}
+	for (int i = 0; i < started; i++)
+		pthread_join(tids[i], NULL);
+	if (extval == EXIT_FAILURE)
+		goto exit;
+
+	// sommo le statistiche delle porzioni
+	if (stats_init(&total) == -1) {
+		perror("stats_init");
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+	total_init = true;
+	for (int i = 0; i < chunks_num; i++) {
+		if (chunks[i].error) {
+			fprintf(stderr, "ERR: analisi del log fallita (%s)\n", strerror(ENOMEM));
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+		if (stats_merge(&total, &chunks[i]) == -1) {
+			perror("stats_merge");
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+	}
+	// i massimi dei campi che assumono valori non numerici vanno ricalcolati leggendo il log in ordine
+	awk_max_t* maxs[] = {&total.max_files, &total.max_bytes, &total.max_clients};
+	int columns[] = {F_CURR_FILES, F_CURR_BYTES, F_CURR_CLIENTS};
+	for (int i = 0; i < 3; i++) {
+		if (maxs[i]->strings) {
+			maxs[i]->value = fold_max(map, size, columns[i]);
+			maxs[i]->set = true;
+		}
+	}
+	if (print_stats(&total) == -1 || (extended && print_extended_stats(&total) == -1)) {
+		perror("print_stats");
+		extval = EXIT_FAILURE;
+	}
+
+exit:
+	if (total_init)
+		stats_destroy(&total);
+	for (int i = 0; i < chunks_num; i++)
+		stats_destroy(&chunks[i]);
+	free(chunks);
+	if (map)
+		munmap(map, size);
+	if (fd != -1)
+		close(fd);
+	return extval;
+}
@@ -0,0 +1,756 @@
+/**
+ * @file                     fssreplay.c
+ * @brief                    Replay di un carico registrato nel file di log del server. Ricostruisce dal log le sequenze
+ *                           di operazioni di ciascun client (identificato dal descrittore con cui il server lo ha
+ *                           servito, tra un record NEW_CONNECTION e il successivo CLOSED_CONNECTION) e le riesegue su
+ *                           un server, con una connessione per ogni descrittore, rispettando i tempi registrati
+ *                           (eventualmente compressi) o senza attese. Al termine stampa le latenze delle operazioni, il
+ *                           ritardo accumulato rispetto alla registrazione, gli esiti che differiscono da quelli
+ *                           registrati e il confronto tra le espulsioni registrate e quelle avvenute durante il replay.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <client_api.h>
+#include <latency_hist.h>
+#include <log_format.h>
+#include <protocol.h>
+#include <util.h>
+
+/* Secondi da dedicare ai tentativi di connessione verso il server */
+#define TRY_CONN_FOR_SEC 5
+/* Millisecondi da attendere tra un tentativo di connessione verso il server e il successivo */
+#define RETRY_CONN_AFTER_MSEC 1000
+/* Numero di campi di un record del log */
+#define LOG_FIELDS 10
+/* Indici dei campi di un record del log */
+#define F_TIME 0
+#define F_OPERATION 2
+#define F_OUTCOME 3
+#define F_CLIENT_FD 4
+#define F_FILE 5
+#define F_BYTES 6
+
+/**
+ * @enum                     event_type_t
+ * @brief                    Tipo di un evento della traccia.
+ */
+typedef enum event_type {
+	EV_CONNECT,     // connessione del client
+	EV_DISCONNECT,  // disconnessione del client
+	EV_OP           // operazione richiesta dal client
+} event_type_t;
+
+/**
+ * @struct                   trace_event_t
+ * @brief                    Evento della traccia di un client.
+ *
+ * @var type                 Tipo dell'evento
+ * @var op                   Operazione richiesta (se type è EV_OP)
+ * @var time                 Istante dell'evento in microsecondi dall'inizio della traccia
+ * @var seq                  Posizione dell'evento tra quelli registrati nello stesso secondo
+ * @var path                 Path del file su cui è stata richiesta l'operazione
+ * @var bytes                Numero di bytes processati dall'operazione
+ * @var n                    Numero di file letti (per READN e READN_CURSOR)
+ * @var expect_ok            Flag che indica se l'operazione registrata ha avuto successo
+ */
+typedef struct trace_event {
+	event_type_t type;
+	request_code_t op;
+	uint64_t time;
+	size_t seq;
+	char* path;
+	size_t bytes;
+	int n;
+	bool expect_ok;
+} trace_event_t;
+
+/**
+ * @struct                   stream_t
+ * @brief                    Sequenza degli eventi dei client serviti dal server con lo stesso descrittore.
+ *
+ * @var fd                   Il descrittore registrato
+ * @var events               Array degli eventi
+ * @var len                  Numero di eventi
+ * @var cap                  Capacità dell'array degli eventi
+ * @var conn                 Connessione con cui vengono rieseguite le operazioni
+ */
+typedef struct stream {
+	int fd;
+	trace_event_t* events;
+	size_t len;
+	size_t cap;
+	fss_conn_t* conn;
+} stream_t;
+
+/**
+ * @struct                   replay_stats_t
+ * @brief                    Statistiche del replay.
+ *
+ * @var op_hist              Istogrammi delle latenze delle operazioni
+ * @var lag                  Istogramma del ritardo dell'avvio delle operazioni rispetto alla registrazione
+ * @var ok_to_fail           Numero di operazioni registrate con successo e fallite durante il replay
+ * @var fail_to_ok           Numero di operazioni registrate con esito negativo e con successo durante il replay
+ * @var conn_errors          Numero di connessioni non riuscite
+ * @var mutex                Mutex per l'accesso in mutua esclusione alle statistiche
+ */
+typedef struct replay_stats {
+	hist_t op_hist[MAX_REQ_CODE + 1];
+	hist_t lag;
+	size_t ok_to_fail;
+	size_t fail_to_ok;
+	size_t conn_errors;
+	pthread_mutex_t mutex;
+} replay_stats_t;
+
+/* Il path del socket file o tcp:host:porta */
+static char* sockname = NULL;
+/* Fattore di compressione dei tempi (0 per eseguire le operazioni senza attese) */
+static double speed = 1;
+/* Istante di inizio del replay */
+static uint64_t replay_start;
+/* Buffer con il contenuto da scrivere nei file */
+static char* content = NULL;
+/* Statistiche del replay */
+static replay_stats_t stats;
+
+/**
+ * @function                 split_fields()
+ * @brief                    Suddivide la linea line nei campi separati da ',' (mantenendo i campi vuoti).
+ *
+ * @param line               La linea da suddividere (viene modificata)
+ * @param fields             L'array in cui memorizzare i campi
+ * @param max                Il massimo numero di campi
+ *
+ * @return                   Il numero di campi.
+ */
+static int split_fields(char* line, char** fields, int max) {
+	int n = 0;
+	line[strcspn(line, "\r\n")] = '\0';
+	while (n < max) {
+		fields[n++] = line;
+		char* comma = strchr(line, ',');
+		if (!comma)
+			break;
+		*comma = '\0';
+		line = comma + 1;
+	}
+	for (int i = n; i < max; i++)
+		fields[i] = "";
+	return n;
+}
+
+/**
+ * @function                 parse_time()
+ * @brief                    Converte il timestamp di un record del log (dd-mm-yyyy HH:MM:SS) nel numero di secondi
+ *                           trascorsi dal 01-01-1970.
+ *
+ * @param s                  Il timestamp
+ * @param secs               Il puntatore in cui memorizzare il risultato
+ *
+ * @return                   0 in caso di successo, -1 se il timestamp non è valido.
+ */
+static int parse_time(const char* s, long* secs) {
+	int d, m, y, hh, mm, ss;
+	if (sscanf(s, "%d-%d-%d %d:%d:%d", &d, &m, &y, &hh, &mm, &ss) != 6)
+		return -1;
+	// numero di giorni dal 01-01-1970 (calendario gregoriano)
+	y -= m <= 2;
+	long era = (y >= 0 ? y : y - 399) / 400;
+	long yoe = y - era * 400;
+	long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	long days = era * 146097 + doe - 719468;
+	*secs = days * 86400 + hh * 3600 + mm * 60 + ss;
+	return 0;
+}
+
+/**
+ * @function                 str_to_req_code()
+ * @brief                    Restituisce il codice di richiesta rappresentato da s.
+ *
+ * @param s                  La stringa che rappresenta il codice (come restituita da req_code_to_str())
+ *
+ * @return                   Il codice di richiesta, -1 se s non rappresenta un codice di richiesta.
+ */
+static int str_to_req_code(const char* s) {
+	for (int code = MIN_REQ_CODE; code <= MAX_REQ_CODE; code++) {
+		if (strcmp(s, req_code_to_str(code)) == 0)
+			return code;
+	}
+	return -1;
+}
+
+/**
+ * @function                 stream_append()
+ * @brief                    Aggiunge l'evento ev alla sequenza s.
+ *
+ * @param s                  La sequenza
+ * @param ev                 L'evento
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int stream_append(stream_t* s, const trace_event_t* ev) {
+	if (s->len == s->cap) {
+		size_t cap = s->cap ? s->cap * 2 : 64;
+		trace_event_t* events = realloc(s->events, cap * sizeof(trace_event_t));
+		if (!events)
+			return -1;
+		s->events = events;
+		s->cap = cap;
+	}
+	s->events[s->len++] = *ev;
+	return 0;
+}
+
+/**
+ * @function                 get_stream()
+ * @brief                    Restituisce la sequenza associata al descrittore fd, creandola se non esiste.
+ *
+ * @param streams            Il puntatore all'array delle sequenze, indicizzato per descrittore
+ * @param streams_len        Il puntatore alla lunghezza dell'array
+ * @param fd                 Il descrittore
+ *
+ * @return                   La sequenza in caso di successo, @c NULL in caso di fallimento ed errno settato ad indicare
+ *                           l'errore.
+ */
+static stream_t* get_stream(stream_t*** streams, int* streams_len, int fd) {
+	if (fd >= *streams_len) {
+		int len = *streams_len ? *streams_len : 16;
+		while (len <= fd)
+			len *= 2;
+		stream_t** tmp = realloc(*streams, len * sizeof(stream_t*));
+		if (!tmp)
+			return NULL;
+		memset(tmp + *streams_len, 0, (len - *streams_len) * sizeof(stream_t*));
+		*streams = tmp;
+		*streams_len = len;
+	}
+	if (!(*streams)[fd]) {
+		(*streams)[fd] = calloc(1, sizeof(stream_t));
+		if (!(*streams)[fd])
+			return NULL;
+		(*streams)[fd]->fd = fd;
+	}
+	return (*streams)[fd];
+}
+
+/**
+ * @function                 count_evictions()
+ * @brief                    Conta i record EVICTION del log filename.
+ *
+ * @param filename           Il path del log
+ * @param evictions          Il puntatore in cui memorizzare il numero di espulsioni
+ * @param bytes              Il puntatore in cui memorizzare il numero di bytes espulsi
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int count_evictions(const char* filename, size_t* evictions, size_t* bytes) {
+	FILE* file = fopen(filename, "r");
+	if (!file)
+		return -1;
+	char* line = NULL;
+	size_t line_cap = 0;
+	char* fields[LOG_FIELDS];
+	*evictions = *bytes = 0;
+	while (getline(&line, &line_cap, file) != -1) {
+		split_fields(line, fields, LOG_FIELDS);
+		if (strcmp(fields[F_OPERATION], EVICTION) == 0) {
+			(*evictions) ++;
+			*bytes += strtoul(fields[F_BYTES], NULL, 10);
+		}
+	}
+	if (line)
+		free(line);
+	fclose(file);
+	return 0;
+}
+
+/**
+ * @function                 replay_op()
+ * @brief                    Riesegue l'operazione registrata nell'evento ev sulla connessione conn.
+ *
+ * @param conn               La connessione
+ * @param ev                 L'evento
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ */
+static int replay_op(fss_conn_t* conn, const trace_event_t* ev) {
+	void* buf = NULL;
+	size_t size, version = 0;
+	int r, errnosv;
+
+	switch (ev->op) {
+		case OPEN_NO_FLAGS:
+			return fss_openFile(conn, ev->path, 0);
+		case OPEN_CREATE:
+			return fss_openFile(conn, ev->path, O_CREATE);
+		case OPEN_LOCK:
+			return fss_openFile(conn, ev->path, O_LOCK);
+		case OPEN_CREATE_LOCK:
+			return fss_openFile(conn, ev->path, O_CREATE | O_LOCK);
+		case WRITE:
+		case APPEND:
+			// il contenuto originale non è registrato nel log: scrivo bytes bytes di contenuto sintetico
+			return fss_appendToFile(conn, ev->path, content, ev->bytes, NULL);
+		case WRITE_AT:
+			return fss_writeFileAt(conn, ev->path, 0, content, ev->bytes, NULL);
+		case OPEN_WRITE_CLOSE:
+			if (fss_openFile(conn, ev->path, O_CREATE | O_LOCK) == -1)
+				return -1;
+			r = fss_appendToFile(conn, ev->path, content, ev->bytes, NULL);
+			errnosv = errno;
+			if (fss_closeFile(conn, ev->path) == -1 && r == 0)
+				return -1;
+			errno = errnosv;
+			return r;
+		case READ:
+			r = fss_readFile(conn, ev->path, &buf, &size);
+			break;
+		case OPEN_READ_CLOSE:
+			r = fss_openReadCloseFile(conn, ev->path, &buf, &size);
+			break;
+		case READ_RANGE:
+			r = fss_readFileRange(conn, ev->path, 0, ev->bytes, &buf, &size);
+			break;
+		case READ_IF_NEWER:
+			r = fss_readFileIfNewer(conn, ev->path, &version, &buf, &size);
+			break;
+		case READN:
+		case READN_CURSOR:
+			return fss_readNFiles(conn, ev->n, NULL) == -1 ? -1 : 0;
+		case LOCK:
+			return fss_lockFile(conn, ev->path);
+		case UNLOCK:
+			return fss_unlockFile(conn, ev->path);
+		case CLOSE:
+			return fss_closeFile(conn, ev->path);
+		case REMOVE:
+			return fss_removeFile(conn, ev->path);
+		default:
+			errno = EINVAL;
+			return -1;
+	}
+	if (buf)
+		free(buf);
+	return r;
+}
+
+/**
+ * @function                 open_stream_conn()
+ * @brief                    Apre la connessione della sequenza s, chiudendo l'eventuale connessione precedente.
+ *
+ * @param s                  La sequenza
+ */
+static void open_stream_conn(stream_t* s) {
+	if (s->conn)
+		fss_disconnect(s->conn);
+	struct timespec abstime;
+	abstime.tv_nsec = 0;
+	abstime.tv_sec = time(NULL) + TRY_CONN_FOR_SEC;
+	s->conn = fss_connect(sockname, RETRY_CONN_AFTER_MSEC, abstime);
+	if (!s->conn) {
+		fprintf(stderr, "ERR: fss_connect per il descrittore %d (%s)\n", s->fd, errno_to_str(errno));
+		pthread_mutex_lock(&stats.mutex);
+		stats.conn_errors ++;
+		pthread_mutex_unlock(&stats.mutex);
+	}
+}
+
+/**
+ * @function                 replay_worker()
+ * @brief                    Riesegue la sequenza di eventi di un descrittore. Se speed è positivo ogni evento viene
+ *                           eseguito non prima dell'istante replay_start + time / speed, e il ritardo rispetto a tale
+ *                           istante viene registrato nelle statistiche.
+ *
+ * @param arg                La sequenza
+ */
+static void* replay_worker(void* arg) {
+	stream_t* s = arg;
+	for (size_t i = 0; i < s->len; i++) {
+		trace_event_t* ev = &s->events[i];
+		if (speed > 0) {
+			uint64_t sched = replay_start + (uint64_t) (ev->time / speed);
+			uint64_t now = now_usec();
+			if (now < sched) {
+				sleep_until_usec(sched);
+				now = sched;
+			}
+			if (ev->type == EV_OP) {
+				pthread_mutex_lock(&stats.mutex);
+				hist_record(&stats.lag, now - sched);
+				pthread_mutex_unlock(&stats.mutex);
+			}
+		}
+
+		switch (ev->type) {
+			case EV_CONNECT:
+				open_stream_conn(s);
+				break;
+			case EV_DISCONNECT:
+				if (s->conn)
+					fss_disconnect(s->conn);
+				s->conn = NULL;
+				break;
+			case EV_OP: {
+				// se il log non registra la connessione del client (il log è iniziato dopo) la apro ora
+				if (!s->conn)
+					open_stream_conn(s);
+				uint64_t op_start = now_usec();
+				int r = replay_op(s->conn, ev);
+				uint64_t op_end = now_usec();
+				pthread_mutex_lock(&stats.mutex);
+				if (r == 0)
+					hist_record(&stats.op_hist[ev->op], op_end - op_start);
+				else
+					stats.op_hist[ev->op].errors ++;
+				if (r == 0 && !ev->expect_ok)
+					stats.fail_to_ok ++;
+				else if (r == -1 && ev->expect_ok)
+					stats.ok_to_fail ++;
+				pthread_mutex_unlock(&stats.mutex);
+				break;
+			}
+		}
+	}
+	if (s->conn)
+		fss_disconnect(s->conn);
+	s->conn = NULL;
+	return NULL;
+}
+
+/**
+ * @function                 usage()
+ * @brief                    Stampa del messaggio di help.
+ *
+ * @param prog               Il nome del programma
+ */
+static void usage(char* prog) {
+	printf("usage: %s -f sockname -i log [options]\n", prog);
+	printf("options:\n\n"
+		"-h			  stampa il messaggio di help\n\n"
+		"-f sockname		  path della socket del server, o tcp:host:porta\n\n"
+		"-i log			  log del server da cui ricostruire il carico\n\n"
+		"-s speed		  fattore di compressione dei tempi registrati\n"
+		"			  (default 1, tempi originali; 0 esegue le\n"
+		"			  operazioni senza attese)\n\n"
+		"-l log			  log del server su cui viene effettuato il replay,\n"
+		"			  letto al termine per confrontare le espulsioni\n\n"
+		"-z			  abilita la compressione del contenuto dei file\n\n"
+		"-k			  abilita la verifica del checksum dei file letti\n\n");
+}
+
+int main(int argc, char* argv[]) {
+	int extval = EXIT_SUCCESS;
+	char* trace_name = NULL;
+	char* replay_log = NULL;
+	FILE* trace = NULL;
+	char* line = NULL;
+	size_t line_cap = 0;
+	stream_t** streams = NULL;
+	int streams_len = 0;
+	// numero di eventi registrati in ciascun secondo della traccia
+	size_t* per_sec = NULL;
+	size_t per_sec_len = 0;
+	pthread_t* tids = NULL;
+	bool stats_init = false;
+
+	if (argc == 1) {
+		usage(argv[0]);
+		return EXIT_SUCCESS;
+	}
+	int option;
+	while ((option = getopt(argc, argv, ":hf:i:s:l:zk")) != -1) {
+		switch (option) {
+			case 'h':
+				usage(argv[0]);
+				return EXIT_SUCCESS;
+			case 'f':
+				sockname = optarg;
+				break;
+			case 'i':
+				trace_name = optarg;
+				break;
+			case 's': {
+				char* end;
+				errno = 0;
+				speed = strtod(optarg, &end);
+				if (errno != 0 || *end != '\0' || speed < 0) {
+					fprintf(stderr, "ERR: l'argomento di -s deve essere un numero non negativo\n");
+					return EXIT_FAILURE;
+				}
+				break;
+			}
+			case 'l':
+				replay_log = optarg;
+				break;
+			case 'z':
+				enable_compression();
+				break;
+			case 'k':
+				enable_checksum();
+				break;
+			case ':':
+				fprintf(stderr, "ERR: l'opzione -%c necessita un argomento\n", optopt);
+				return EXIT_FAILURE;
+			default:
+				fprintf(stderr, "ERR: l'opzione -%c non è gestita\n", optopt);
+				return EXIT_FAILURE;
+		}
+	}
+	if (!sockname || !trace_name) {
+		fprintf(stderr, "ERR: è necessario specificare il server con -f e il log con -i\n");
+		return EXIT_FAILURE;
+	}
+
+	// ricostruisco dal log le sequenze di eventi di ciascun descrittore
+	trace = fopen(trace_name, "r");
+	if (!trace) {
+		PERRFMT("ERR: fopen di '%s' (%s)\n", trace_name, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	char* fields[LOG_FIELDS];
+	long first_time = -1, last_time = 0;
+	size_t records = 0, ops = 0, sessions = 0, rec_evictions = 0, rec_evicted_bytes = 0, max_bytes = 0;
+	while (getline(&line, &line_cap, trace) != -1) {
+		split_fields(line, fields, LOG_FIELDS);
+		long secs;
+		if (parse_time(fields[F_TIME], &secs) == -1)
+			continue; // intestazione o record non valido
+		records ++;
+		if (first_time == -1)
+			first_time = secs;
+		last_time = secs;
+
+		trace_event_t ev;
+		memset(&ev, 0, sizeof(trace_event_t));
+		long sec = secs > first_time ? secs - first_time : 0;
+		ev.time = (uint64_t) sec * 1000000;
+		char* op = fields[F_OPERATION];
+
+		if (strcmp(op, EVICTION) == 0) {
+			rec_evictions ++;
+			rec_evicted_bytes += strtoul(fields[F_BYTES], NULL, 10);
+			continue;
+		}
+		if (strcmp(op, NEW_CONNECTION) == 0)
+			ev.type = EV_CONNECT;
+		else if (strcmp(op, CLOSED_CONNECTION) == 0)
+			ev.type = EV_DISCONNECT;
+		else {
+			/* le operazioni sospese vengono rieseguite all'istante della richiesta (registrata con esito
+			   CLIENT_IS_WAITING), ignoro quindi il record del loro completamento */
+			if (strcmp(op, OP_SUSPENDED) == 0)
+				continue;
+			// READN e READN_CURSOR registrano un record "i/n" per ogni file inviato: considero solo il primo
+			char* space = strchr(op, ' ');
+			int i = 1, n = 0;
+			if (space) {
+				*space = '\0';
+				if (sscanf(space + 1, "%d/%d", &i, &n) != 2)
+					continue;
+			}
+			int code = str_to_req_code(op);
+			if (code == -1 || code == NEGOTIATE || i > 1)
+				continue;
+			ev.type = EV_OP;
+			ev.op = code;
+			ev.n = n > 0 ? n : 1;
+			ev.bytes = strtoul(fields[F_BYTES], NULL, 10);
+			ev.expect_ok = strcmp(fields[F_OUTCOME], resp_code_to_str(OK)) == 0 ||
+				strcmp(fields[F_OUTCOME], CLIENT_IS_WAITING) == 0;
+			if (ev.bytes > max_bytes)
+				max_bytes = ev.bytes;
+			ev.path = strdup(fields[F_FILE]);
+			if (!ev.path) {
+				PERRFMT("ERR: strdup (%s)\n", strerror(errno));
+				extval = EXIT_FAILURE;
+				goto exit;
+			}
+		}
+
+		// ignoro i record che non sono associati ad un client (es. SHUT_DOWN)
+		long fd;
+		if (is_number(fields[F_CLIENT_FD], &fd) != 0 || fd < 0 || fd > INT_MAX) {
+			if (ev.path)
+				free(ev.path);
+			continue;
+		}
+		if (sec >= per_sec_len) {
+			size_t len = per_sec_len ? per_sec_len : 64;
+			while (len <= sec)
+				len *= 2;
+			size_t* tmp = realloc(per_sec, len * sizeof(size_t));
+			if (!tmp) {
+				if (ev.path)
+					free(ev.path);
+				PERRFMT("ERR: realloc (%s)\n", strerror(errno));
+				extval = EXIT_FAILURE;
+				goto exit;
+			}
+			memset(tmp + per_sec_len, 0, (len - per_sec_len) * sizeof(size_t));
+			per_sec = tmp;
+			per_sec_len = len;
+		}
+		ev.seq = per_sec[sec];
+		stream_t* s = get_stream(&streams, &streams_len, fd);
+		if (!s || stream_append(s, &ev) == -1) {
+			if (ev.path)
+				free(ev.path);
+			PERRFMT("ERR: memorizzazione della traccia (%s)\n", strerror(errno));
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+		per_sec[sec] ++;
+		if (ev.type == EV_OP)
+			ops ++;
+		else if (ev.type == EV_CONNECT)
+			sessions ++;
+	}
+	fclose(trace);
+	trace = NULL;
+	if (records == 0) {
+		fprintf(stderr, "ERR: '%s' non contiene record validi\n", trace_name);
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+
+	/* il log registra i tempi con la risoluzione del secondo: distribuisco uniformemente nel secondo gli eventi 
+	   registrati in esso, nell'ordine in cui compaiono nel log */
+	for (int fd = 0; fd < streams_len; fd++) {
+		for (size_t i = 0; streams[fd] && i < streams[fd]->len; i++) {
+			trace_event_t* ev = &streams[fd]->events[i];
+			ev->time += ev->seq * 1000000 / per_sec[ev->time / 1000000];
+		}
+	}
+
+	content = malloc(max_bytes ? max_bytes : 1);
+	tids = calloc(streams_len ? streams_len : 1, sizeof(pthread_t));
+	if (!content || !tids) {
+		PERRFMT("ERR: malloc (%s)\n", strerror(errno));
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+	for (size_t i = 0; i < max_bytes; i++)
+		content[i] = 'a' + i % 26;
+	memset(&stats, 0, sizeof(replay_stats_t));
+	if (pthread_mutex_init(&stats.mutex, NULL) != 0) {
+		PERRFMT("%s", "ERR: pthread_mutex_init\n");
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+	stats_init = true;
+
+	// ignoro SIGPIPE
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(struct sigaction));
+	sa.sa_handler = SIG_IGN;
+	if (sigaction(SIGPIPE, &sa, NULL) == -1) {
+		PERRFMT("ERR: sigaction (%s)\n", strerror(errno));
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+
+	// avvio un thread per ogni descrittore
+	printf("Traccia: %zu record, %zu operazioni, %zu sessioni, durata registrata %ld s\n",
+		records, ops, sessions, last_time - first_time);
+	replay_start = now_usec();
+	int started = 0, fd;
+	for (fd = 0; fd < streams_len; fd++) {
+		if (!streams[fd])
+			continue;
+		if (pthread_create(&tids[fd], NULL, replay_worker, streams[fd]) != 0) {
+			PERRFMT("%s", "ERR: pthread_create\n");
+			extval = EXIT_FAILURE;
+			break;
+		}
+		started ++;
+	}
+	for (int i = 0; i < fd; i++) {
+		if (streams[i])
+			pthread_join(tids[i], NULL);
+	}
+	double elapsed = (now_usec() - replay_start) / 1000000.0;
+
+	// stampo il report
+	if (speed > 0)
+		printf("Replay con %d connessioni a velocità %.2fx: durata %.3f s (attesa %.3f s)\n",
+			started, speed, elapsed, (last_time - first_time) / speed);
+	else
+		printf("Replay con %d connessioni senza attese: durata %.3f s\n", started, elapsed);
+	printf("latenze in microsecondi\n");
+	hist_print_header();
+	hist_t* total = calloc(1, sizeof(hist_t));
+	if (!total) {
+		PERRFMT("ERR: calloc (%s)\n", strerror(errno));
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+	for (int code = MIN_REQ_CODE; code <= MAX_REQ_CODE; code++) {
+		if (stats.op_hist[code].count + stats.op_hist[code].errors == 0)
+			continue;
+		hist_print_row(req_code_to_str(code), &stats.op_hist[code], elapsed);
+		hist_merge(total, &stats.op_hist[code]);
+	}
+	hist_print_row("total", total, elapsed);
+	free(total);
+	if (speed > 0) {
+		printf("Ritardo rispetto alla registrazione (microsecondi): p50 %lu, p99 %lu, max %lu\n",
+			(unsigned long) hist_percentile(&stats.lag, 50), (unsigned long) hist_percentile(&stats.lag, 99),
+			(unsigned long) stats.lag.max);
+	}
+	printf("Esiti diversi dalla registrazione: %zu (OK -> errore: %zu, errore -> OK: %zu)\n",
+		stats.ok_to_fail + stats.fail_to_ok, stats.ok_to_fail, stats.fail_to_ok);
+	if (stats.conn_errors > 0)
+		printf("Connessioni non riuscite: %zu\n", stats.conn_errors);
+	printf("Espulsioni registrate: %zu (%zu bytes)\n", rec_evictions, rec_evicted_bytes);
+	if (replay_log) {
+		size_t evictions, evicted_bytes;
+		if (count_evictions(replay_log, &evictions, &evicted_bytes) == -1) {
+			PERRFMT("ERR: lettura di '%s' (%s)\n", replay_log, strerror(errno));
+			extval = EXIT_FAILURE;
+		}
+		else {
+			printf("Espulsioni durante il replay: %zu (%zu bytes), differenza %+ld\n",
+				evictions, evicted_bytes, (long) evictions - (long) rec_evictions);
+		}
+	}
+
+exit:
+	if (trace)
+		fclose(trace);
+	if (line)
+		free(line);
+	for (int fd = 0; fd < streams_len; fd++) {
+		if (!streams[fd])
+			continue;
+		for (size_t i = 0; i < streams[fd]->len; i++) {
+			if (streams[fd]->events[i].path)
+				free(streams[fd]->events[i].path);
+		}
+		if (streams[fd]->events)
+			free(streams[fd]->events);
+		free(streams[fd]);
+	}
+	if (streams)
+		free(streams);
+	if (per_sec)
+		free(per_sec);
+	if (tids)
+		free(tids);
+	if (content)
+		free(content);
+	if (stats_init)
+		pthread_mutex_destroy(&stats.mutex);
+	return extval;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file                     latency_hist.c
+ * @brief                    Implementazione dell'istogramma log-lineare delle latenze.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <math.h>
+
+#include <latency_hist.h>
+
+/**
+ * @function                 hist_bucket()
+ * @brief                    Restituisce l'indice del bucket dell'istogramma in cui ricade la latenza v.
+ *
+ * @param v                  La latenza in microsecondi
+ *
+ * @return                   L'indice del bucket.
+ */
+static inline int hist_bucket(uint64_t v) {
+	if (v < 2 * HIST_SUB)
+		return v;
+	int msb = 63 - __builtin_clzll(v);
+	int shift = msb - HIST_SUB_BITS;
+	return shift * HIST_SUB + (v >> shift);
+}
+
+/**
+ * @function                 hist_value()
+ * @brief                    Restituisce la latenza rappresentativa (il punto medio) del bucket b.
+ *
+ * @param b                  L'indice del bucket
+ *
+ * @return                   La latenza in microsecondi.
+ */
+static inline uint64_t hist_value(int b) {
+	if (b < 2 * HIST_SUB)
+		return b;
+	int shift = b / HIST_SUB - 1;
+	uint64_t low = (uint64_t) (b - shift * HIST_SUB) << shift;
+	return low + ((1ULL << shift) >> 1);
+}
+
+uint64_t ts_to_usec(const struct timespec* t) {
+	return (uint64_t) t->tv_sec * 1000000 + t->tv_nsec / 1000;
+}
+
+void usec_to_ts(uint64_t usec, struct timespec* t) {
+	t->tv_sec = usec / 1000000;
+	t->tv_nsec = (usec % 1000000) * 1000;
+}
+
+uint64_t now_usec() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return ts_to_usec(&t);
+}
+
+void sleep_until_usec(uint64_t usec) {
+	struct timespec t;
+	usec_to_ts(usec, &t);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR);
+}
+
+void hist_record(hist_t* h, uint64_t v) {
+	h->buckets[hist_bucket(v)] ++;
+	h->count ++;
+	h->sum += v;
+	if (v > h->max)
+		h->max = v;
+}
+
+void hist_merge(hist_t* dst, const hist_t* src) {
+	for (int i = 0; i < HIST_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+	dst->count += src->count;
+	dst->errors += src->errors;
+	dst->sum += src->sum;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+uint64_t hist_percentile(const hist_t* h, double p) {
+	if (h->count == 0)
+		return 0;
+	uint64_t target = (uint64_t) ceil(p / 100.0 * h->count);
+	if (target == 0)
+		target = 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < HIST_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= target) {
+			uint64_t v = hist_value(i);
+			return v > h->max ? h->max : v;
+		}
+	}
+	return h->max;
+}
+
+void hist_print_header() {
+	printf("%-16s %10s %8s %12s %10s %9s %9s %9s %9s %9s\n",
+		"op", "count", "err", "op/s", "mean", "p50", "p90", "p99", "p99.9", "max");
+}
+
+void hist_print_row(const char* name, const hist_t* h, double elapsed) {
+	printf("%-16s %10lu %8lu %12.1f %10.1f %9lu %9lu %9lu %9lu %9lu\n",
+		name, (unsigned long) h->count, (unsigned long) h->errors, elapsed > 0 ? h->count / elapsed : 0.0,
+		h->count ? (double) h->sum / h->count : 0.0,
+		(unsigned long) hist_percentile(h, 50), (unsigned long) hist_percentile(h, 90),
+		(unsigned long) hist_percentile(h, 99), (unsigned long) hist_percentile(h, 99.9),
+		(unsigned long) h->max);
+}
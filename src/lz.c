@@ -0,0 +1,205 @@
+/**
+ * @file     lz.c
+ * @brief    Implementazione del compressore della famiglia LZ77.
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include <lz.h>
+
+/* Numero di bit dell'hash delle sequenze di LZ_MIN_MATCH bytes */
+#define LZ_HASH_BITS 12
+
+/* Valore che in un token indica che la lunghezza prosegue nei byte successivi */
+#define LZ_LEN_EXT 15
+
+/**
+ * @function               read32()
+ * @brief                  Legge 4 bytes a partire da p.
+ * 
+ * @param p                Puntatore ai bytes da leggere
+ * 
+ * @return                 Il valore letto.
+ */
+static uint32_t read32(const unsigned char* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(uint32_t));
+	return v;
+}
+
+/**
+ * @function               hash_seq()
+ * @brief                  Calcola l'hash di una sequenza di LZ_MIN_MATCH bytes.
+ * 
+ * @param seq              Sequenza di cui calcolare l'hash
+ * 
+ * @return                 L'hash della sequenza.
+ */
+static size_t hash_seq(uint32_t seq) {
+	return (size_t) ((seq * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+/**
+ * @function               write_len()
+ * @brief                  Scrive in dst l'estensione di una lunghezza len >= LZ_LEN_EXT.
+ * 
+ * @param dst              Buffer in cui scrivere
+ * @param op               Posizione in dst da cui scrivere, aggiornata al termine della scrittura
+ * @param len              Lunghezza di cui scrivere l'estensione
+ */
+static void write_len(unsigned char* dst, size_t* op, size_t len) {
+	len -= LZ_LEN_EXT;
+	while (len >= 255) {
+		dst[(*op)++] = 255;
+		len -= 255;
+	}
+	dst[(*op)++] = (unsigned char) len;
+}
+
+/**
+ * @function               emit_sequence()
+ * @brief                  Scrive in dst una sequenza composta da lit_len literal e da un match di lunghezza match_len a 
+ *                         distanza offset (se match_len è 0 la sequenza è l'ultima e contiene solo literal).
+ * 
+ * @param dst              Buffer in cui scrivere
+ * @param op               Posizione in dst da cui scrivere, aggiornata al termine della scrittura
+ * @param dst_capacity     Dimensione del buffer dst
+ * @param lit              Literal
+ * @param lit_len          Numero di literal
+ * @param offset           Distanza del match
+ * @param match_len        Lunghezza del match
+ * 
+ * @return                 0 in caso di successo, -1 se la sequenza non entra in dst.
+ */
+static int emit_sequence(unsigned char* dst, size_t* op, size_t dst_capacity, 
+	const unsigned char* lit, size_t lit_len, size_t offset, size_t match_len) {
+	// calcolo lo spazio necessario nel caso peggiore
+	size_t needed = 1 + lit_len + lit_len / 255 + 1;
+	if (match_len != 0)
+		needed += 2 + match_len / 255 + 1;
+	if (*op > dst_capacity || dst_capacity - *op < needed)
+		return -1;
+
+	size_t match_code = match_len != 0 ? match_len - LZ_MIN_MATCH : 0;
+	unsigned char token = (unsigned char) (((lit_len < LZ_LEN_EXT ? lit_len : LZ_LEN_EXT) << 4) | 
+		(match_code < LZ_LEN_EXT ? match_code : LZ_LEN_EXT));
+	dst[(*op)++] = token;
+	if (lit_len >= LZ_LEN_EXT)
+		write_len(dst, op, lit_len);
+	memcpy(dst + *op, lit, lit_len);
+	*op += lit_len;
+
+	if (match_len != 0) {
+		dst[(*op)++] = (unsigned char) (offset & 0xFF);
+		dst[(*op)++] = (unsigned char) (offset >> 8);
+		if (match_code >= LZ_LEN_EXT)
+			write_len(dst, op, match_code);
+	}
+	return 0;
+}
+
+size_t lz_compress(const void* src, size_t src_size, void* dst, size_t dst_capacity) {
+	if (src == NULL || dst == NULL)
+		return 0;
+
+	const unsigned char* in = src;
+	unsigned char* out = dst;
+	size_t ip = 0, anchor = 0, op = 0;
+
+	/* ultima posizione (+1) in cui è stata incontrata una sequenza con un certo hash, 0 se mai incontrata
+	   (la tabella è allocata sullo stack e azzerata ad ogni blocco) */
+	size_t table[(size_t) 1 << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	while (src_size >= LZ_MIN_MATCH && ip <= src_size - LZ_MIN_MATCH) {
+		uint32_t seq = read32(in + ip);
+		size_t h = hash_seq(seq);
+		size_t candidate = table[h];
+		table[h] = ip + 1;
+		if (candidate != 0 && ip - (candidate - 1) <= LZ_MAX_OFFSET && read32(in + candidate - 1) == seq) {
+			// estendo il match
+			size_t ref = candidate - 1;
+			size_t len = LZ_MIN_MATCH;
+			while (ip + len < src_size && in[ref + len] == in[ip + len])
+				len ++;
+			if (emit_sequence(out, &op, dst_capacity, in + anchor, ip - anchor, ip - ref, len) == -1)
+				return 0;
+			ip += len;
+			anchor = ip;
+		}
+		else
+			ip ++;
+	}
+
+	// scrivo i literal rimanenti
+	if (emit_sequence(out, &op, dst_capacity, in + anchor, src_size - anchor, 0, 0) == -1)
+		return 0;
+
+	return op;
+}
+
+int lz_decompress(const void* src, size_t src_size, void* dst, size_t dst_size) {
+	if (src == NULL || dst == NULL)
+		return -1;
+
+	const unsigned char* in = src;
+	unsigned char* out = dst;
+	size_t ip = 0, op = 0;
+
+	while (ip < src_size) {
+		unsigned char token = in[ip++];
+
+		// leggo il numero di literal
+		size_t lit_len = token >> 4;
+		if (lit_len == LZ_LEN_EXT) {
+			unsigned char b;
+			do {
+				if (ip >= src_size)
+					return -1;
+				b = in[ip++];
+				lit_len += b;
+			} while (b == 255);
+		}
+		// copio i literal
+		if (lit_len > src_size - ip || lit_len > dst_size - op)
+			return -1;
+		memcpy(out + op, in + ip, lit_len);
+		ip += lit_len;
+		op += lit_len;
+
+		// l'ultima sequenza contiene solo literal
+		if (ip == src_size)
+			break;
+
+		// leggo l'offset del match
+		if (src_size - ip < 2)
+			return -1;
+		size_t offset = (size_t) in[ip] | ((size_t) in[ip+1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			return -1;
+
+		// leggo la lunghezza del match
+		size_t match_len = token & 0x0F;
+		if (match_len == LZ_LEN_EXT) {
+			unsigned char b;
+			do {
+				if (ip >= src_size)
+					return -1;
+				b = in[ip++];
+				match_len += b;
+			} while (b == 255);
+		}
+		match_len += LZ_MIN_MATCH;
+		if (match_len > dst_size - op)
+			return -1;
+
+		// copio il match byte per byte (il match può sovrapporsi ai bytes che produce)
+		for (size_t i = 0; i < match_len; i ++)
+			out[op + i] = out[op - offset + i];
+		op += match_len;
+	}
+
+	return op == dst_size ? 0 : -1;
+}
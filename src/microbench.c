@@ -0,0 +1,812 @@
+/**
+ * @file                     microbench.c
+ * @brief                    Microbenchmark delle strutture dati del server (hasht, conc_hasht, list, int_list,
+ *                           threadpool) e della selezione delle vittime delle politiche di espulsione.
+ *                           Stampa sullo stdout i risultati in formato CSV, una riga per misurazione, in modo che le
+ *                           misurazioni effettuate su commit diversi possano essere confrontate
+ *                           (test/bench/compare.sh).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include <config_parser.h>
+#include <conc_hasht.h>
+#include <eviction_policy.h>
+#include <hasht.h>
+#include <int_list.h>
+#include <latency_hist.h>
+#include <list.h>
+#include <logger.h>
+#include <protocol.h>
+#include <storage_server.h>
+#include <threadpool.h>
+#include <util.h>
+
+/* Numero di elementi minimo delle misurazioni */
+#define MIN_SIZE 1000
+/* Numero di elementi massimo di default delle misurazioni */
+#define DEFAULT_MAX_SIZE 1000000
+/* Numero massimo di thread di default delle misurazioni */
+#define DEFAULT_MAX_THREADS 8
+/* Massimo numero di thread */
+#define MAX_THREADS 64
+/* Numero massimo di elementi */
+#define MAX_SIZE 10000000
+/* Moltiplicatore (coprimo con le potenze di 10) utilizzato per visitare gli elementi in un ordine pseudocasuale */
+#define PERM_MULT 2654435761UL
+/* Massimo numero di confronti effettuati dalle ricerche lineari nelle liste */
+#define LIST_SCAN_BUDGET 100000000L
+/* Numero di task sottomessi al threadpool per ogni misurazione */
+#define POOL_TASKS 100000
+/* Minimo e massimo numero di file scritti, provocando un'espulsione, per ogni misurazione */
+#define EVICT_MIN_OPS 10
+#define EVICT_MAX_OPS 1000
+/* Massimo numero di file visitati complessivamente dalle selezioni delle vittime di ogni misurazione */
+#define EVICT_SCAN_BUDGET 10000000L
+/* Size del contenuto dei file memorizzati nello storage */
+#define EVICT_FILE_SIZE 16
+
+/**
+ * @struct                   cht_thread_t
+ * @brief                    Argomento dei thread che operano sulla tabella hash concorrente.
+ *
+ * @var cht                  La tabella hash
+ * @var op                   L'operazione da effettuare (0 insert, 1 contains, 2 delete)
+ * @var from                 Primo indice della porzione di chiavi assegnata al thread
+ * @var to                   Indice successivo all'ultimo della porzione di chiavi assegnata al thread
+ * @var size                 Numero complessivo di chiavi
+ * @var barrier              Barriera su cui i thread si sincronizzano prima di iniziare
+ * @var errors               Numero di operazioni fallite
+ * @var start                Istante in cui il thread ha iniziato le operazioni in nanosecondi
+ * @var end                  Istante in cui il thread ha terminato le operazioni in nanosecondi
+ */
+typedef struct cht_thread {
+	conc_hasht_t* cht;
+	int op;
+	long from;
+	long to;
+	long size;
+	pthread_barrier_t* barrier;
+	long errors;
+	uint64_t start;
+	uint64_t end;
+} cht_thread_t;
+
+/**
+ * @struct                   pool_slot_t
+ * @brief                    Istanti di sottomissione e di avvio di un task del threadpool.
+ *
+ * @var submit               Istante di sottomissione del task in nanosecondi
+ * @var start                Istante di avvio del task in nanosecondi
+ */
+typedef struct pool_slot {
+	uint64_t submit;
+	uint64_t start;
+} pool_slot_t;
+
+/* Etichetta delle misurazioni (tipicamente l'hash del commit) */
+static const char* label = "";
+/* Chiavi utilizzate dalle misurazioni */
+static char** keys = NULL;
+/* Numero di chiavi allocate */
+static long keys_num = 0;
+/* Numero di task del threadpool terminati */
+static long pool_done = 0;
+
+/**
+ * @function                 now_nsec()
+ * @brief                    Restituisce il tempo corrente del clock monotonico in nanosecondi.
+ *
+ * @return                   Il tempo corrente in nanosecondi.
+ */
+static inline uint64_t now_nsec() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/**
+ * @function                 perm()
+ * @brief                    Restituisce l'i-esimo elemento di una permutazione pseudocasuale di [0, size), con size
+ *                           potenza di 10.
+ *
+ * @param i                  L'indice
+ * @param size               Il numero di elementi
+ *
+ * @return                   L'elemento della permutazione.
+ */
+static inline long perm(long i, long size) {
+	return (long) (((unsigned long) i * PERM_MULT) % size);
+}
+
+/**
+ * @function                 ptr_cmp()
+ * @brief                    Confronta due puntatori.
+ *
+ * @param a                  Il primo puntatore
+ * @param b                  Il secondo puntatore
+ *
+ * @return                   1 se i puntatori sono uguali, 0 altrimenti.
+ */
+static int ptr_cmp(void* a, void* b) {
+	return a == b;
+}
+
+/**
+ * @function                 print_header()
+ * @brief                    Stampa sullo stdout l'intestazione del CSV dei risultati.
+ */
+static void print_header() {
+	printf("label,benchmark,op,size,threads,ops,ns_per_op,ops_per_sec,p50_ns,p99_ns\n");
+}
+
+/**
+ * @function                 print_result()
+ * @brief                    Stampa sullo stdout una riga del CSV dei risultati.
+ *
+ * @param bench              Il nome del benchmark
+ * @param op                 Il nome dell'operazione misurata
+ * @param size               Il numero di elementi della struttura dati
+ * @param threads            Il numero di thread
+ * @param ops                Il numero di operazioni effettuate
+ * @param elapsed            La durata della misurazione in nanosecondi
+ * @param h                  L'istogramma delle latenze in nanosecondi delle singole operazioni
+ *                           (@c NULL se non sono state misurate singolarmente)
+ */
+static void print_result(const char* bench, const char* op, long size, int threads, long ops, uint64_t elapsed,
+	const hist_t* h) {
+	if (ops <= 0)
+		return;
+	printf("%s,%s,%s,%ld,%d,%ld,%.1f,%.0f,", label, bench, op, size, threads, ops,
+		(double) elapsed / ops, elapsed > 0 ? ops * 1e9 / elapsed : 0.0);
+	if (h)
+		printf("%lu,%lu\n", (unsigned long) hist_percentile(h, 50), (unsigned long) hist_percentile(h, 99));
+	else
+		printf(",\n");
+	fflush(stdout);
+}
+
+/**
+ * @function                 bench_hasht()
+ * @brief                    Misura inserimento, ricerca (con successo e senza) e cancellazione di size chiavi nella
+ *                           tabella hash.
+ *
+ * @param size               Il numero di chiavi
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int bench_hasht(long size) {
+	hasht_t* ht = hasht_create(size / LOAD_FACTOR, NULL, NULL);
+	if (!ht) {
+		perror("hasht_create");
+		return -1;
+	}
+	uint64_t start = now_nsec();
+	for (long i = 0; i < size; i++) {
+		if (hasht_insert(ht, keys[i], keys[i]) == -1) {
+			perror("hasht_insert");
+			hasht_destroy(ht, NULL, NULL);
+			return -1;
+		}
+	}
+	print_result("hasht", "insert", size, 1, size, now_nsec() - start, NULL);
+
+	long found = 0;
+	start = now_nsec();
+	for (long i = 0; i < size; i++)
+		found += hasht_get_value(ht, keys[perm(i, size)]) != NULL;
+	print_result("hasht", "lookup_hit", size, 1, size, now_nsec() - start, NULL);
+	// le chiavi successive a size non sono presenti nella tabella
+	long misses = keys_num - size < size ? keys_num - size : size;
+	start = now_nsec();
+	for (long i = 0; i < misses; i++)
+		found += hasht_get_value(ht, keys[size + i]) != NULL;
+	print_result("hasht", "lookup_miss", size, 1, misses, now_nsec() - start, NULL);
+
+	start = now_nsec();
+	for (long i = 0; i < size; i++)
+		hasht_delete(ht, keys[perm(i, size)], NULL, NULL);
+	print_result("hasht", "delete", size, 1, size, now_nsec() - start, NULL);
+
+	hasht_destroy(ht, NULL, NULL);
+	if (found != size) {
+		fprintf(stderr, "ERR: hasht: trovate %ld chiavi su %ld\n", found, size);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function                 cht_worker()
+ * @brief                    Funzione eseguita dai thread che operano sulla tabella hash concorrente.
+ *
+ * @param arg                L'argomento del thread (cht_thread_t*)
+ */
+static void* cht_worker(void* arg) {
+	cht_thread_t* t = arg;
+	pthread_barrier_wait(t->barrier);
+	t->start = now_nsec();
+	for (long i = t->from; i < t->to; i++) {
+		char* key = keys[perm(i, t->size)];
+		switch (t->op) {
+			case 0:
+				if (conc_hasht_atomic_insert(t->cht, key, key) == -1)
+					t->errors ++;
+				break;
+			case 1:
+				if (conc_hasht_atomic_contains(t->cht, key) != 1)
+					t->errors ++;
+				break;
+			default:
+				if (conc_hasht_atomic_delete(t->cht, key, NULL, NULL) == -1)
+					t->errors ++;
+		}
+	}
+	t->end = now_nsec();
+	return NULL;
+}
+
+/**
+ * @function                 bench_conc_hasht()
+ * @brief                    Misura inserimento, ricerca e cancellazione di size chiavi nella tabella hash concorrente,
+ *                           ripartite tra nthreads thread, con il numero di lock utilizzato di default dal server.
+ *
+ * @param size               Il numero di chiavi
+ * @param nthreads           Il numero di thread
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int bench_conc_hasht(long size, int nthreads) {
+	static const char* op_names[] = {"insert", "lookup_hit", "delete"};
+	cht_thread_t args[MAX_THREADS];
+	pthread_t tids[MAX_THREADS];
+	pthread_barrier_t barrier;
+	int extval = 0;
+
+	conc_hasht_t* cht = conc_hasht_create(size / LOAD_FACTOR, DEFAULT_MAX_LOCKS, NULL, NULL);
+	if (!cht) {
+		perror("conc_hasht_create");
+		return -1;
+	}
+	for (int op = 0; op < 3 && extval == 0; op++) {
+		if ((errno = pthread_barrier_init(&barrier, NULL, nthreads)) != 0) {
+			perror("pthread_barrier_init");
+			extval = -1;
+			break;
+		}
+		int started = 0;
+		for (; started < nthreads; started++) {
+			args[started] = (cht_thread_t) {cht, op, size * started / nthreads, size * (started + 1) / nthreads,
+				size, &barrier, 0, 0, 0};
+			if ((errno = pthread_create(&tids[started], NULL, cht_worker, &args[started])) != 0) {
+				perror("pthread_create");
+				break;
+			}
+		}
+		if (started < nthreads) {
+			// i thread avviati attendono sulla barriera: non posso sbloccarli, termino il processo
+			exit(EXIT_FAILURE);
+		}
+		// la durata va dal primo thread che inizia le operazioni all'ultimo che le termina
+		long errors = 0;
+		uint64_t start = UINT64_MAX, end = 0;
+		for (int i = 0; i < nthreads; i++) {
+			pthread_join(tids[i], NULL);
+			errors += args[i].errors;
+			if (args[i].start < start)
+				start = args[i].start;
+			if (args[i].end > end)
+				end = args[i].end;
+		}
+		uint64_t elapsed = end - start;
+		pthread_barrier_destroy(&barrier);
+		if (errors) {
+			fprintf(stderr, "ERR: conc_hasht: %ld operazioni %s fallite\n", errors, op_names[op]);
+			extval = -1;
+			break;
+		}
+		print_result("conc_hasht", op_names[op], size, nthreads, size, elapsed, NULL);
+	}
+	conc_hasht_destroy(cht, NULL, NULL);
+	return extval;
+}
+
+/**
+ * @function                 bench_list()
+ * @brief                    Misura l'inserimento in coda, la ricerca e la rimozione di elementi arbitrari e la rimozione
+ *                           dalla testa di size elementi nella lista.
+ *
+ * @param size               Il numero di elementi
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int bench_list(long size) {
+	// gli elementi sono le chiavi, che non vengono mai deallocate dalla lista
+	list_t* list = list_create(ptr_cmp, free);
+	if (!list) {
+		perror("list_create");
+		return -1;
+	}
+	uint64_t start = now_nsec();
+	for (long i = 0; i < size; i++) {
+		if (list_tail_insert(list, keys[i]) == -1) {
+			perror("list_tail_insert");
+			list_destroy(list, LIST_DO_NOT_FREE_DATA);
+			return -1;
+		}
+	}
+	print_result("list", "tail_insert", size, 1, size, now_nsec() - start, NULL);
+
+	// le ricerche sono lineari: limito il numero di confronti complessivi
+	long scans = LIST_SCAN_BUDGET / size;
+	if (scans > size / 2)
+		scans = size / 2;
+	long found = 0;
+	start = now_nsec();
+	for (long i = 0; i < scans; i++)
+		found += list_contains(list, keys[perm(i, size)]) == 1;
+	print_result("list", "contains", size, 1, scans, now_nsec() - start, NULL);
+	start = now_nsec();
+	for (long i = 0; i < scans; i++)
+		list_remove_and_get(list, keys[perm(i, size)]);
+	print_result("list", "remove", size, 1, scans, now_nsec() - start, NULL);
+
+	long removed = 0;
+	start = now_nsec();
+	while (list_head_remove(list) != NULL)
+		removed ++;
+	print_result("list", "head_remove", size, 1, removed, now_nsec() - start, NULL);
+
+	list_destroy(list, LIST_DO_NOT_FREE_DATA);
+	if (found != scans || removed != size - scans) {
+		fprintf(stderr, "ERR: list: risultati delle operazioni inattesi\n");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function                 bench_int_list()
+ * @brief                    Misura l'inserimento in coda, la ricerca e la rimozione di elementi arbitrari e la rimozione
+ *                           dalla testa di size interi nella lista di interi.
+ *
+ * @param size               Il numero di elementi
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int bench_int_list(long size) {
+	int_list_t* list = int_list_create();
+	if (!list) {
+		perror("int_list_create");
+		return -1;
+	}
+	uint64_t start = now_nsec();
+	for (long i = 0; i < size; i++) {
+		if (int_list_tail_insert(list, i) == -1) {
+			perror("int_list_tail_insert");
+			int_list_destroy(list);
+			return -1;
+		}
+	}
+	print_result("int_list", "tail_insert", size, 1, size, now_nsec() - start, NULL);
+
+	long scans = LIST_SCAN_BUDGET / size;
+	if (scans > size / 2)
+		scans = size / 2;
+	long found = 0;
+	start = now_nsec();
+	for (long i = 0; i < scans; i++)
+		found += int_list_contains(list, perm(i, size)) == 1;
+	print_result("int_list", "contains", size, 1, scans, now_nsec() - start, NULL);
+	start = now_nsec();
+	for (long i = 0; i < scans; i++)
+		int_list_remove(list, perm(i, size));
+	print_result("int_list", "remove", size, 1, scans, now_nsec() - start, NULL);
+
+	long removed = 0;
+	int data;
+	start = now_nsec();
+	while (int_list_head_remove(list, &data) == 0)
+		removed ++;
+	print_result("int_list", "head_remove", size, 1, removed, now_nsec() - start, NULL);
+
+	int_list_destroy(list);
+	if (found != scans || removed != size - scans) {
+		fprintf(stderr, "ERR: int_list: risultati delle operazioni inattesi\n");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @function                 pool_task()
+ * @brief                    Task sottomesso al threadpool: registra l'istante di avvio.
+ *
+ * @param arg                Lo slot del task (pool_slot_t*)
+ * @param worker_id          L'identificativo del worker che esegue il task
+ */
+static void pool_task(void* arg, int worker_id) {
+	pool_slot_t* slot = arg;
+	slot->start = now_nsec();
+	__atomic_add_fetch(&pool_done, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @function                 pool_submit()
+ * @brief                    Sottomette al pool il task associato a slot, ritentando finché il pool lo rifiuta.
+ *
+ * @param pool               Il threadpool
+ * @param slot               Lo slot del task
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int pool_submit(threadpool_t* pool, pool_slot_t* slot) {
+	int r;
+	slot->submit = now_nsec();
+	while ((r = threadpool_add(pool, pool_task, slot)) == 1)
+		sched_yield();
+	if (r == -1)
+		perror("threadpool_add");
+	return r;
+}
+
+/**
+ * @function                 bench_threadpool()
+ * @brief                    Misura la latenza tra la sottomissione di un task al threadpool e il suo avvio, sia quando
+ *                           i task sono sottomessi uno alla volta ai worker inattivi (submit_to_run) sia quando sono
+ *                           sottomessi a raffica e si accodano (burst).
+ *
+ * @param nthreads           Il numero di worker del pool
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int bench_threadpool(int nthreads) {
+	static const char* op_names[] = {"submit_to_run", "burst"};
+	int extval = 0;
+	pool_slot_t* slots = malloc(sizeof(pool_slot_t) * POOL_TASKS);
+	hist_t* hist = malloc(sizeof(hist_t));
+	if (!slots || !hist) {
+		perror("malloc");
+		free(slots);
+		free(hist);
+		return -1;
+	}
+
+	for (int mode = 0; mode < 2 && extval == 0; mode++) {
+		threadpool_t* pool = threadpool_create(nthreads, DEFAULT_DIM_WORKERS_QUEUE);
+		if (!pool) {
+			perror("threadpool_create");
+			extval = -1;
+			break;
+		}
+		long tasks = mode == 0 ? POOL_TASKS / 10 : POOL_TASKS;
+		__atomic_store_n(&pool_done, 0, __ATOMIC_RELAXED);
+		uint64_t start = now_nsec();
+		long submitted = 0;
+		for (; submitted < tasks; submitted++) {
+			if (pool_submit(pool, &slots[submitted]) == -1) {
+				extval = -1;
+				break;
+			}
+			// sottomettendo i task uno alla volta attendo che ciascuno sia terminato prima del successivo
+			if (mode == 0) {
+				while (__atomic_load_n(&pool_done, __ATOMIC_ACQUIRE) <= submitted)
+					sched_yield();
+			}
+		}
+		while (__atomic_load_n(&pool_done, __ATOMIC_ACQUIRE) < submitted)
+			sched_yield();
+		uint64_t elapsed = now_nsec() - start;
+		threadpool_destroy(pool);
+		if (extval == -1)
+			break;
+
+		memset(hist, 0, sizeof(hist_t));
+		for (long i = 0; i < tasks; i++)
+			hist_record(hist, slots[i].start - slots[i].submit);
+		print_result("threadpool", op_names[mode], 0, nthreads, tasks, elapsed, hist);
+	}
+	free(slots);
+	free(hist);
+	return extval;
+}
+
+/**
+ * @function                 drain_worker()
+ * @brief                    Legge e scarta le risposte inviate dallo storage al client simulato.
+ *
+ * @param arg                Il descrittore da cui leggere (long)
+ */
+static void* drain_worker(void* arg) {
+	int fd = (long) arg;
+	char buf[65536];
+	ssize_t r;
+	while ((r = read(fd, buf, sizeof(buf))) != 0) {
+		if (r == -1 && errno != EINTR)
+			break;
+	}
+	return NULL;
+}
+
+/**
+ * @function                 store_file()
+ * @brief                    Scrive nello storage, con una richiesta OPEN_WRITE_CLOSE, il file associato alla chiave i.
+ *
+ * @param storage            Lo storage
+ * @param master_fd          Il descrittore su cui lo storage segnala la disconnessione del client
+ * @param client_fd          Il descrittore del client simulato
+ * @param i                  L'indice della chiave
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int store_file(storage_t* storage, int master_fd, int client_fd, long i) {
+	// lo storage acquisisce path e contenuto del file
+	char* path = strdup(keys[i]);
+	char* content = malloc(EVICT_FILE_SIZE);
+	if (!path || !content) {
+		perror("malloc");
+		free(path);
+		free(content);
+		return -1;
+	}
+	memset(content, 'a' + i % 26, EVICT_FILE_SIZE);
+	return write_file_handler(storage, master_fd, client_fd, 0, 0, path, content, EVICT_FILE_SIZE, 0,
+		OPEN_WRITE_CLOSE);
+}
+
+/**
+ * @function                 bench_eviction()
+ * @brief                    Misura il costo della scrittura di un file in uno storage pieno con size file, che comporta
+ *                           la selezione di una vittima secondo la politica policy e la sua espulsione.
+ *
+ * @param size               Il numero massimo di file dello storage
+ * @param policy             La politica di espulsione
+ * @param logger             Il logger dello storage
+ *
+ * @return                   0 in caso di successo, -1 in caso di fallimento.
+ */
+static int bench_eviction(long size, eviction_policy_t policy, logger_t* logger) {
+	int extval = -1;
+	int sv[2] = {-1, -1};
+	int master_fd = -1;
+	bool drain_started = false;
+	pthread_t drain_tid;
+	storage_t* storage = NULL;
+	hist_t* hist = NULL;
+
+	config_t* config = config_init();
+	if (!config) {
+		perror("config_init");
+		return -1;
+	}
+	config->max_file_num = size;
+	config->max_bytes = (size + 1) * EVICT_FILE_SIZE * 2;
+	config->eviction_policy = policy;
+	if ((storage = storage_create(config, logger)) == NULL) {
+		perror("storage_create");
+		goto exit;
+	}
+	// il client simulato è un'estremità di una coppia di socket, dall'altra vengono scartate le risposte
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1 || (master_fd = open("/dev/null", O_WRONLY)) == -1) {
+		perror("socketpair");
+		goto exit;
+	}
+	if ((errno = pthread_create(&drain_tid, NULL, drain_worker, (void*) (long) sv[1])) != 0) {
+		perror("pthread_create");
+		goto exit;
+	}
+	drain_started = true;
+	if (new_connection_handler(storage, sv[0], false) == -1) {
+		perror("new_connection_handler");
+		goto exit;
+	}
+
+	const char* policy_str = eviction_policy_to_str(policy);
+	char bench[32];
+	snprintf(bench, sizeof(bench), "eviction_%s", policy_str);
+	uint64_t start = now_nsec();
+	for (long i = 0; i < size; i++) {
+		if (store_file(storage, master_fd, sv[0], i) == -1)
+			goto exit;
+	}
+	print_result(bench, "fill", size, 1, size, now_nsec() - start, NULL);
+
+	// ogni ulteriore scrittura comporta un'espulsione
+	if ((hist = calloc(1, sizeof(hist_t))) == NULL) {
+		perror("calloc");
+		goto exit;
+	}
+	// la selezione della vittima può visitare tutti i file: limito il numero di espulsioni con gli storage più grandi
+	long ops = EVICT_SCAN_BUDGET / size;
+	if (ops < EVICT_MIN_OPS)
+		ops = EVICT_MIN_OPS;
+	if (ops > EVICT_MAX_OPS)
+		ops = EVICT_MAX_OPS;
+	start = now_nsec();
+	for (long i = 0; i < ops; i++) {
+		uint64_t op_start = now_nsec();
+		if (store_file(storage, master_fd, sv[0], size + i) == -1)
+			goto exit;
+		hist_record(hist, now_nsec() - op_start);
+	}
+	print_result(bench, "write_evict", size, 1, ops, now_nsec() - start, hist);
+	extval = 0;
+
+exit:
+	// chiudendo la socket del client simulato il thread che scarta le risposte termina
+	if (sv[0] != -1)
+		shutdown(sv[0], SHUT_RDWR);
+	if (drain_started)
+		pthread_join(drain_tid, NULL);
+	if (sv[0] != -1) {
+		close(sv[0]);
+		close(sv[1]);
+	}
+	if (master_fd != -1)
+		close(master_fd);
+	storage_destroy(storage);
+	config_destroy(config);
+	free(hist);
+	return extval;
+}
+
+/**
+ * @function                 usage()
+ * @brief                    Stampa del messaggio di help.
+ *
+ * @param prog               Il nome del programma
+ */
+static void usage(char* prog) {
+	printf("usage: %s [options]\n", prog);
+	printf("options:\n\n"
+		"-h			  stampa il messaggio di help\n\n"
+		"-l label		  etichetta delle misurazioni, tipicamente l'hash del commit\n\n"
+		"-n size		  numero massimo di elementi (default %d), le misurazioni\n"
+		"			  vengono effettuate con 1e3, 1e4, ... elementi fino a size\n\n"
+		"-t n			  numero massimo di thread (default %d), le misurazioni\n"
+		"			  vengono effettuate con 1, 2, 4, ... thread fino a n\n\n"
+		"-r n			  numero di ripetizioni delle misurazioni (default 1)\n\n"
+		"-b bench[,...]		  esegue solo i benchmark indicati tra hasht, conc_hasht,\n"
+		"			  list, int_list, threadpool ed eviction (default tutti)\n\n",
+		DEFAULT_MAX_SIZE, DEFAULT_MAX_THREADS);
+}
+
+/**
+ * @function                 selected()
+ * @brief                    Verifica se il benchmark name è tra quelli selezionati con -b.
+ *
+ * @param benchs             La lista di benchmark selezionati (@c NULL se sono selezionati tutti)
+ * @param name               Il nome del benchmark
+ *
+ * @return                   true se il benchmark è selezionato, false altrimenti.
+ */
+static bool selected(const char* benchs, const char* name) {
+	if (!benchs)
+		return true;
+	size_t len = strlen(name);
+	for (const char* p = benchs; (p = strstr(p, name)) != NULL; p += len) {
+		if ((p == benchs || p[-1] == ',') && (p[len] == ',' || p[len] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+int main(int argc, char* argv[]) {
+	int extval = EXIT_SUCCESS;
+	long max_size = DEFAULT_MAX_SIZE;
+	long max_threads = DEFAULT_MAX_THREADS;
+	long reps = 1;
+	const char* benchs = NULL;
+	logger_t* logger = NULL;
+
+	int option;
+	while ((option = getopt(argc, argv, ":hl:n:t:r:b:")) != -1) {
+		switch (option) {
+			case 'h':
+				usage(argv[0]);
+				return EXIT_SUCCESS;
+			case 'l':
+				if (strchr(optarg, ',')) {
+					fprintf(stderr, "ERR: l'etichetta non può contenere ','\n");
+					return EXIT_FAILURE;
+				}
+				label = optarg;
+				break;
+			case 'n':
+				if (is_number(optarg, &max_size) != 0 || max_size < MIN_SIZE || max_size > MAX_SIZE) {
+					fprintf(stderr, "ERR: l'argomento di -n deve essere compreso tra %d e %d\n", MIN_SIZE, MAX_SIZE);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 't':
+				if (is_number(optarg, &max_threads) != 0 || max_threads < 1 || max_threads > MAX_THREADS) {
+					fprintf(stderr, "ERR: l'argomento di -t deve essere compreso tra 1 e %d\n", MAX_THREADS);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'r':
+				if (is_number(optarg, &reps) != 0 || reps < 1 || reps > INT_MAX) {
+					fprintf(stderr, "ERR: l'argomento di -r deve essere compreso tra 1 e %d\n", INT_MAX);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'b':
+				benchs = optarg;
+				break;
+			case ':':
+				fprintf(stderr, "ERR: l'opzione -%c necessita un argomento\n", optopt);
+				return EXIT_FAILURE;
+			default:
+				fprintf(stderr, "ERR: l'opzione -%c non è gestita\n", optopt);
+				return EXIT_FAILURE;
+		}
+	}
+
+	// genero le chiavi: le size chiavi inserite e altre non presenti nelle strutture dati
+	keys_num = max_size * 2;
+	if ((keys = calloc(keys_num, sizeof(char*))) == NULL) {
+		perror("calloc");
+		return EXIT_FAILURE;
+	}
+	for (long i = 0; i < keys_num; i++) {
+		char buf[64];
+		snprintf(buf, sizeof(buf), "/microbench/dir%ld/file%ld", i % 100, i);
+		if ((keys[i] = strdup(buf)) == NULL) {
+			perror("strdup");
+			extval = EXIT_FAILURE;
+			goto exit;
+		}
+	}
+	// le operazioni effettuate dallo storage vengono registrate su /dev/null
+	if (selected(benchs, "eviction") && (logger = logger_create("/dev/null", NULL)) == NULL) {
+		perror("logger_create");
+		extval = EXIT_FAILURE;
+		goto exit;
+	}
+
+	print_header();
+	// ripeto le misurazioni: il confronto tra due esecuzioni considera il risultato migliore di ciascuna
+	for (long r = 0; r < reps && extval == EXIT_SUCCESS; r++) {
+		for (long size = MIN_SIZE; size <= max_size && extval == EXIT_SUCCESS; size *= 10) {
+			if (selected(benchs, "hasht") && bench_hasht(size) == -1)
+				extval = EXIT_FAILURE;
+			for (int t = 1; t <= max_threads && extval == EXIT_SUCCESS; t *= 2) {
+				if (selected(benchs, "conc_hasht") && bench_conc_hasht(size, t) == -1)
+					extval = EXIT_FAILURE;
+			}
+			if (extval == EXIT_SUCCESS && selected(benchs, "list") && bench_list(size) == -1)
+				extval = EXIT_FAILURE;
+			if (extval == EXIT_SUCCESS && selected(benchs, "int_list") && bench_int_list(size) == -1)
+				extval = EXIT_FAILURE;
+			eviction_policy_t policies[] = {FIFO, LRU, LFU, LW};
+			for (int p = 0; p < 4 && extval == EXIT_SUCCESS; p++) {
+				if (selected(benchs, "eviction") && bench_eviction(size, policies[p], logger) == -1)
+					extval = EXIT_FAILURE;
+			}
+		}
+		for (int t = 1; t <= max_threads && extval == EXIT_SUCCESS; t *= 2) {
+			if (selected(benchs, "threadpool") && bench_threadpool(t) == -1)
+				extval = EXIT_FAILURE;
+		}
+	}
+
+exit:
+	if (logger)
+		logger_destroy(logger);
+	for (long i = 0; i < keys_num; i++)
+		free(keys[i]);
+	free(keys);
+	return extval;
+}
@@ -33,6 +33,20 @@ char* req_code_to_str(request_code_t code) {
 			return "REMOVE";
 		case CLOSE:
 			return "CLOSE";
+		case OPEN_WRITE_CLOSE:
+			return "OPEN_WRITE_CLOSE";
+		case OPEN_READ_CLOSE:
+			return "OPEN_READ_CLOSE";
+		case READ_RANGE:
+			return "READ_RANGE";
+		case WRITE_AT:
+			return "WRITE_AT";
+		case READ_IF_NEWER:
+			return "READ_IF_NEWER";
+		case READN_CURSOR:
+			return "READN_CURSOR";
+		case NEGOTIATE:
+			return "NEGOTIATE";
 		default: 
 			return NULL;
 	}
@@ -64,6 +78,12 @@ char* resp_code_to_str(response_code_t code) {
 			return "TEMPORARILY_UNAVAILABLE";
 		case COULD_NOT_EVICT:
 			return "COULD_NOT_EVICT";
+		case INVALID_OFFSET:
+			return "INVALID_OFFSET";
+		case NOT_MODIFIED:
+			return "NOT_MODIFIED";
+		case INVALIDATED:
+			return "INVALIDATED";
 		default: 
 			return NULL;
 	}
@@ -9,11 +9,16 @@
 #include <string.h>
 #include <stdbool.h>
 #include <signal.h>
+#include <sched.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #include <config_parser.h>
+#include <autotuner.h>
 #include <eviction_policy.h>
 #include <protocol.h>
 #include <logger.h>
@@ -29,17 +34,42 @@
 #define MAXBACKLOG 64
 #endif
 
+/**
+ * Numero massimo di task in corso per ciascun client: raggiunto il limite il descrittore del client non viene più 
+ * ascoltato fino alla terminazione di uno dei task, così che un client non possa occupare tutti i workers
+ */
+#if !defined(MAX_CLIENT_TASKS)
+#define MAX_CLIENT_TASKS 2
+#endif
+
+/**
+ * Numero massimo di file espulsi alla volta, con lo storage bloccato, a seguito della riduzione della sua capacità
+ */
+#if !defined(RECONFIG_EVICTION_BATCH)
+#define RECONFIG_EVICTION_BATCH 16
+#endif
+
+/**
+ * Numero massimo di contatori degli utilizzi ricostruiti alla volta, con lo storage bloccato, a seguito della modifica 
+ * della politica di espulsione
+ */
+#if !defined(RECONFIG_REBUILD_BATCH)
+#define RECONFIG_REBUILD_BATCH 256
+#endif
+
 /**
  * @struct               task_args_t
  * @brief                Struttura che raccoglie gli argomenti di un task che un worker dovrà servire.
  * 
  * @var storage          Struttura storage
  * @var master_fd        Descrittore per la comunicazione con il master
+ * @var done_fd          Descrittore per comunicare al master la terminazione del task
  * @var client_fd        Descrittore del client che ha effettuato la richiesta
  */
 typedef struct task_args {
 	storage_t* storage;
 	int master_fd;
+	int done_fd;
 	int client_fd;
 } task_args_t;
 
@@ -55,16 +85,23 @@ static void task_handler(void *arg, int worker_id) {
 
 	storage_t* storage = task_arg->storage;
 	int master_fd = task_arg->master_fd;
+	int done_fd = task_arg->done_fd;
 	int client_fd = task_arg->client_fd;
 
+	int r;
+
 	// leggo la richiesta del client
 	request_t* req = read_request(storage, master_fd, client_fd, worker_id);
 	if (req == NULL) {
+		// comunico al master che il task è terminato (il descrittore può essere chiuso se il client si è disconnesso)
+		EQM1_DO(writen(done_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(arg);
 		return;
 	}
 
-	int r;
+	/* la richiesta è stata letta, comunico al master che può tornare ad ascoltare il client
+	   (le richieste successive del client possono così essere servite mentre questa è in corso) */
+	EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 
 	// servo la richiesta
 	switch (req->code) {
@@ -77,39 +114,57 @@ static void task_handler(void *arg, int worker_id) {
 				master_fd,
 				client_fd,
 				worker_id,
+				req->id,
 				req->file_path,
 				req->code),
 			r, EXTF);
 			break;
 		case WRITE:
 		case APPEND:
+		case OPEN_WRITE_CLOSE:
+		case WRITE_AT:
 			EQM1_DO(write_file_handler(
 				storage,
 				master_fd,
 				client_fd,
 				worker_id,
+				req->id,
 				req->file_path,
 				req->content,
 				req->content_size,
+				req->offset,
 				req->code),
 			r, EXTF);
 			break;
 		case READ:
+		case OPEN_READ_CLOSE:
+		case READ_RANGE:
+		case READ_IF_NEWER:
 			EQM1_DO(read_file_handler(
 				storage,
 				master_fd,
 				client_fd,
 				worker_id,
-				req->file_path),
+				req->id,
+				req->file_path,
+				req->offset,
+				req->length,
+				req->version,
+				req->code),
 			r, EXTF);
 			break;
 		case READN:
+		case READN_CURSOR:
 			EQM1_DO(readn_file_handler(
 				storage,
 				master_fd,
 				client_fd,
 				worker_id,
-				req->n),
+				req->id,
+				req->n,
+				req->cursor,
+				req->max_bytes,
+				req->code),
 			r, EXTF);
 			break;
 		case LOCK:
@@ -118,6 +173,7 @@ static void task_handler(void *arg, int worker_id) {
 				master_fd,
 				client_fd,
 				worker_id,
+				req->id,
 				req->file_path),
 			r, EXTF);
 			break;
@@ -127,6 +183,7 @@ static void task_handler(void *arg, int worker_id) {
 				master_fd,
 				client_fd,
 				worker_id,
+				req->id,
 				req->file_path),
 			r, EXTF);
 			break;
@@ -136,6 +193,7 @@ static void task_handler(void *arg, int worker_id) {
 				master_fd,
 				client_fd,
 				worker_id,
+				req->id,
 				req->file_path),
 			r, EXTF);
 			break;
@@ -145,11 +203,24 @@ static void task_handler(void *arg, int worker_id) {
 				master_fd,
 				client_fd,
 				worker_id,
+				req->id,
 				req->file_path),
 			r, EXTF);
 			break;
+		case NEGOTIATE:
+			EQM1_DO(negotiate_handler(
+				storage,
+				master_fd,
+				client_fd,
+				worker_id,
+				req->id,
+				req->capabilities),
+			r, EXTF);
+			break;
 		default: ;
 	}
+	// comunico al master che il task è terminato (il descrittore può essere chiuso se il client si è disconnesso)
+	EQM1_DO(writen(done_fd, &client_fd, sizeof(int)), r, EXTF);
 	free(arg);
 	free(req);
 }
@@ -175,6 +246,9 @@ typedef struct sighandler_args {
 /**
  * @function             sig_handler()
  * @breif                Funzione eseguita dal signal handler thread.
+ *                       A seguito di SIGUSR2 scrive un byte sul descrittore per la comunicazione con il main thread e 
+ *                       continua ad attendere segnali, a seguito di SIGHUP, SIGINT o SIGQUIT chiude il descrittore e 
+ *                       termina.
  * 
  * @param arg            Argomenti della funzione
  */
@@ -191,31 +265,234 @@ static void *sig_handler(void *arg) {
 	NEQ0_DO(pthread_sigmask(SIG_BLOCK, set, NULL), r, return NULL);
 
 	int sig;
-	NEQ0_DO(sigwait(set, &sig), r, return NULL);
-
-	switch (sig) {
-		case SIGHUP:
-			NEQ0_DO(pthread_mutex_lock(mutex), r, EXTF);
-			*shut_down = true;
-			NEQ0_DO(pthread_mutex_unlock(mutex), r, EXTF);
-			EQM1(close(signal_fd), r);
-			return NULL;
-		case SIGINT:
-		case SIGQUIT:
-			NEQ0_DO(pthread_mutex_lock(mutex), r, EXTF);
-			*shut_down_now = true;
-			NEQ0_DO(pthread_mutex_unlock(mutex), r, EXTF);
-			EQM1(close(signal_fd), r);
-			return NULL;
-		case SIGUSR1:
-			// inviato dal main thread per sbloccare il thread dalla sigwait e forzarne l'uscita
-			return NULL;
-		default: ; // non vengono ricevuti altri segnali
-	}	
+	char reconfig = 1;
+	for (;;) {
+		NEQ0_DO(sigwait(set, &sig), r, return NULL);
+
+		switch (sig) {
+			case SIGUSR2:
+				// comunico al main thread di rileggere il file di configurazione
+				EQM1(writen(signal_fd, &reconfig, sizeof(char)), r);
+				break;
+			case SIGHUP:
+				NEQ0_DO(pthread_mutex_lock(mutex), r, EXTF);
+				*shut_down = true;
+				NEQ0_DO(pthread_mutex_unlock(mutex), r, EXTF);
+				EQM1(close(signal_fd), r);
+				return NULL;
+			case SIGINT:
+			case SIGQUIT:
+				NEQ0_DO(pthread_mutex_lock(mutex), r, EXTF);
+				*shut_down_now = true;
+				NEQ0_DO(pthread_mutex_unlock(mutex), r, EXTF);
+				EQM1(close(signal_fd), r);
+				return NULL;
+			case SIGUSR1:
+				// inviato dal main thread per sbloccare il thread dalla sigwait e forzarne l'uscita
+				return NULL;
+			default: ; // non vengono ricevuti altri segnali
+		}
+	}
 
 	return NULL;
 }
 
+/**
+ * @struct               reconfig_t
+ * @brief                Struttura contenente lo stato della riconfigurazione del server a seguito di SIGUSR2.
+ *
+ * @var config_file      Path del file di configurazione (@c NULL se non è stato specificato)
+ * @var config           Valori di configurazione correnti
+ * @var max_locks        Valore di max_locks letto all'avvio del server
+ * @var n_workers        Valore di n_workers letto dal file di configurazione (config->n_workers può essere modificato 
+ *                       dall'autotuning)
+ * @var pool             Threadpool dei workers
+ * @var storage          Struttura storage
+ * @var logger           Logger
+ * @var master_fd        Descrittore per la comunicazione con il master
+ * @var thread           Thread che effettua la riconfigurazione
+ * @var started          Flag che indica se è stato avviato almeno un thread di riconfigurazione
+ * @var running          Flag che indica se il thread di riconfigurazione è in esecuzione
+ * @var stop             Flag settato dal master per interrompere le espulsioni in corso
+ * @var mutex            Mutex per l'accesso in mutua esclusione ai flag running e stop
+ */
+typedef struct reconfig {
+	char* config_file;
+	config_t* config;
+	size_t max_locks;
+	size_t n_workers;
+	threadpool_t* pool;
+	storage_t* storage;
+	logger_t* logger;
+	int master_fd;
+	pthread_t thread;
+	bool started;
+	bool running;
+	bool stop;
+	pthread_mutex_t mutex;
+} reconfig_t;
+
+/**
+ * @function             reconfig_handler()
+ * @brief                Funzione eseguita dal thread di riconfigurazione. Rilegge il file di configurazione e applica 
+ *                       le modifiche a n_workers, dim_workers_queue, max_file_num, max_bytes ed eviction_policy 
+ *                       (le modifiche agli altri valori richiedono il riavvio del server e vengono ignorate). 
+ *                       Il numero di workers scelto dall'autotuning viene mantenuto se n_workers non è stato 
+ *                       modificato nel file di configurazione. Se la politica di espulsione viene modificata ricostruisce 
+ *                       i contatori degli utilizzi dei file a gruppi di RECONFIG_REBUILD_BATCH e se la capacità dello 
+ *                       storage viene ridotta espelle i file in eccesso a gruppi di RECONFIG_EVICTION_BATCH, in modo 
+ *                       da non sospendere a lungo il servizio delle richieste.
+ * 
+ * @param arg            Lo stato della riconfigurazione
+ */
+static void *reconfig_handler(void *arg) {
+	int r;
+	reconfig_t* rc = arg;
+	config_t* old = rc->config;
+
+	config_t* new = NULL;
+	EQNULL_DO(config_init(), new, EXTF);
+	if (config_parser(new, rc->config_file) == -1) {
+		fprintf(stderr, "ERR: riconfigurazione fallita, i valori di configurazione restano invariati\n");
+		LOG(log_record(rc->logger, "%d,%s,%s", MASTER_ID, RECONFIGURATION, "FAILED"));
+		config_destroy(new);
+		NEQ0_DO(pthread_mutex_lock(&rc->mutex), r, EXTF);
+		rc->running = false;
+		NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+		return NULL;
+	}
+
+	// segnalo le modifiche che non possono essere applicate senza riavviare il server
+	if (strcmp(new->socket_path, old->socket_path) != 0)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", SOCKET_PATH_STR);
+	if (new->tcp_port != old->tcp_port)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", TCP_PORT_STR);
+	if (strcmp(new->tcp_address, old->tcp_address) != 0)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", TCP_ADDRESS_STR);
+	if (strcmp(new->log_file_path, old->log_file_path) != 0)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", LOG_FILE_STR);
+	if (new->max_locks != rc->max_locks)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", MAX_LOCKS_STR);
+	if (new->expected_clients != old->expected_clients)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", EXPECTED_CLIENTS_STR);
+	if (new->autotune_interval != old->autotune_interval)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", AUTOTUNE_INTERVAL_STR);
+	if (new->min_workers != old->min_workers)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", MIN_WORKERS_STR);
+	if (new->max_workers != old->max_workers)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", MAX_WORKERS_STR);
+	if (new->min_locks != old->min_locks)
+		printf("%s: la modifica richiede il riavvio del server, ignorata\n", MIN_LOCKS_STR);
+
+	/* cambio la politica di espulsione prima di modificare la capacità dello storage, in modo che gli eventuali file 
+	   in eccesso vengano espulsi secondo la nuova politica */
+	if (new->eviction_policy != old->eviction_policy) {
+		EQM1_DO(storage_set_eviction_policy(rc->storage, new->eviction_policy), r, EXTF);
+		old->eviction_policy = new->eviction_policy;
+	}
+	if (new->max_file_num != old->max_file_num || new->max_bytes != old->max_bytes) {
+		EQM1_DO(storage_set_capacity(rc->storage, new->max_file_num, new->max_bytes), r, EXTF);
+		old->max_file_num = new->max_file_num;
+		old->max_bytes = new->max_bytes;
+	}
+	// se n_workers non è stato modificato nel file di configurazione mantengo il numero di workers corrente
+	size_t n_workers = new->n_workers != rc->n_workers ? new->n_workers : old->n_workers;
+	if (n_workers != old->n_workers || new->dim_workers_queue != old->dim_workers_queue) {
+		if (threadpool_resize(rc->pool, n_workers, new->dim_workers_queue) == -1) {
+			PERRORSTR(errno)
+		}
+		else {
+			old->n_workers = n_workers;
+			old->dim_workers_queue = new->dim_workers_queue;
+			rc->n_workers = new->n_workers;
+		}
+	}
+	config_destroy(new);
+
+	printf("=========== RICONFIGURAZIONE ===========\n");
+	printf("%s = %zu\n", N_WORKERS_STR, old->n_workers);
+	printf("%s = %zu\n", DIM_WORKERS_QUEUE_STR, old->dim_workers_queue);
+	printf("%s = %zu\n", MAX_FILE_NUM_STR, old->max_file_num);
+	printf("%s = %zu\n", MAX_BYTES_STR, old->max_bytes);
+	printf("%s = %s\n", EVICTION_POLICY_STR, eviction_policy_to_str(old->eviction_policy));
+	fflush(stdout);
+	LOG(log_record(rc->logger, "%d,%s,%s", MASTER_ID, RECONFIGURATION, "OK"));
+
+	// ricostruisco gradualmente i contatori degli utilizzi dei file
+	for (;;) {
+		NEQ0_DO(pthread_mutex_lock(&rc->mutex), r, EXTF);
+		bool stop = rc->stop;
+		NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+		if (stop)
+			break;
+		EQM1_DO(storage_rebuild_usage_counters(rc->storage, RECONFIG_REBUILD_BATCH), r, EXTF);
+		if (r == 0)
+			break;
+		// cedo il processore ai workers tra un gruppo di contatori e il successivo
+		sched_yield();
+	}
+
+	// espello gradualmente i file che eccedono la capacità dello storage
+	for (;;) {
+		NEQ0_DO(pthread_mutex_lock(&rc->mutex), r, EXTF);
+		bool stop = rc->stop;
+		NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+		if (stop)
+			break;
+		EQM1_DO(storage_evict_excess(rc->storage, rc->master_fd, MASTER_ID, RECONFIG_EVICTION_BATCH), r, EXTF);
+		if (r == 0)
+			break;
+		// cedo il processore ai workers tra un gruppo di espulsioni e il successivo
+		sched_yield();
+	}
+
+	NEQ0_DO(pthread_mutex_lock(&rc->mutex), r, EXTF);
+	rc->running = false;
+	NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+	return NULL;
+}
+
+/**
+ * @function             reconfig_start()
+ * @brief                Avvia il thread di riconfigurazione, se non è già in esecuzione.
+ * 
+ * @param rc             Lo stato della riconfigurazione
+ */
+static void reconfig_start(reconfig_t* rc) {
+	int r;
+	NEQ0_DO(pthread_mutex_lock(&rc->mutex), r, EXTF);
+	if (rc->running) {
+		NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+		printf("Riconfigurazione già in corso, SIGUSR2 ignorato\n");
+		return;
+	}
+	rc->running = true;
+	NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+
+	// attendo la terminazione del thread della riconfigurazione precedente
+	if (rc->started)
+		NEQ0(pthread_join(rc->thread, NULL), r);
+	NEQ0_DO(pthread_create(&rc->thread, NULL, reconfig_handler, rc), r, EXTF);
+	rc->started = true;
+}
+
+/**
+ * @function             reconfig_stop()
+ * @brief                Interrompe le espulsioni del thread di riconfigurazione e ne attende la terminazione.
+ * 
+ * @param rc             Lo stato della riconfigurazione
+ */
+static void reconfig_stop(reconfig_t* rc) {
+	int r;
+	if (!rc->started)
+		return;
+	NEQ0_DO(pthread_mutex_lock(&rc->mutex), r, EXTF);
+	rc->stop = true;
+	NEQ0_DO(pthread_mutex_unlock(&rc->mutex), r, EXTF);
+	NEQ0(pthread_join(rc->thread, NULL), r);
+	rc->started = false;
+}
+
 /**
  * @function             is_flag_setted()
  * @brief                Permette di stabilire se flag è settato a true accedendovi in mutua esclusione con mutex.
@@ -265,6 +542,68 @@ static int get_max_fd(fd_set set, int fdmax) {
 	return -1;
 }
 
+/**
+ * @function             close_connection()
+ * @brief                Chiude la connessione con il client associato al descrittore fd (già rimosso dal set dei 
+ *                       descrittori attivi).
+ * 
+ * @param fd             Descrittore del client
+ * @param clients        Riferimento al numero di client connessi
+ * @param logger         Logger
+ */
+static void close_connection(int fd, int* clients, logger_t* logger) {
+	int r;
+	(*clients) --;
+	EQM1(close(fd), r);
+	LOG(log_record(logger, "%d,%s,,%d,,,,,%d",
+		MASTER_ID, CLOSED_CONNECTION, fd, *clients));
+}
+
+/**
+ * @function             tcp_listen()
+ * @brief                Crea un socket in ascolto di connessioni TCP all'indirizzo address e alla porta port.
+ * 
+ * @param address        Indirizzo su cui accettare connessioni
+ * @param port           Porta su cui accettare connessioni
+ * 
+ * @return               Il descrittore del socket in caso di successo, -1 in caso di fallimento.
+ */
+static int tcp_listen(const char* address, size_t port) {
+	char port_str[8];
+	snprintf(port_str, sizeof(port_str), "%zu", port);
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+	struct addrinfo* res;
+	int r = getaddrinfo(address, port_str, &hints, &res);
+	if (r != 0) {
+		fprintf(stderr, "ERR: indirizzo '%s' non valido: %s\n", address, gai_strerror(r));
+		return -1;
+	}
+
+	int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	if (fd == -1) {
+		PERRORSTR(errno)
+		freeaddrinfo(res);
+		return -1;
+	}
+	// permetto il riavvio del server sulla stessa porta mentre le connessioni precedenti sono in TIME_WAIT
+	int on = 1;
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(int)) == -1 ||
+		bind(fd, res->ai_addr, res->ai_addrlen) == -1 ||
+		listen(fd, MAXBACKLOG) == -1) {
+		PERRORSTR(errno)
+		close(fd);
+		freeaddrinfo(res);
+		return -1;
+	}
+	freeaddrinfo(res);
+	return fd;
+}
+
 /**
  * @function             usage()
  * @brief                stampa il messaggio di usage.
@@ -307,6 +646,12 @@ static void usage(char* prog) {
 	printf("# Path della socket per la connessione con i client\n");
 	printf("# (se non specificato = %s)\n", DEFAULT_SOCKET_PATH);
 	printf("%s=path;\n\n", SOCKET_PATH_STR);
+	printf("# Porta TCP su cui accettare, oltre che sulla socket, connessioni dai client\n");
+	printf("# (n intero, 0 < n <= %d, se non specificato le connessioni TCP non vengono accettate)\n", MAX_TCP_PORT);
+	printf("%s=n;\n\n", TCP_PORT_STR);
+	printf("# Indirizzo su cui accettare connessioni TCP\n");
+	printf("# (se non specificato = %s)\n", DEFAULT_TCP_ADDRESS);
+	printf("%s=addr;\n\n", TCP_ADDRESS_STR);
 	printf("# Path del file di log\n");
 	printf("# (ad ogni esecuzione se già esiste viene sovrascritto, se non specificato = %s)\n", DEFAULT_LOG_PATH);
 	printf("%s=path;\n\n", LOG_FILE_STR);
@@ -317,18 +662,38 @@ static void usage(char* prog) {
 	eviction_policy_to_str(LFU),
 	eviction_policy_to_str(LW),
 	eviction_policy_to_str(DEFAULT_EVICTION_POLICY));
-	printf("%s=policy;\n", EVICTION_POLICY_STR);
+	printf("%s=policy;\n\n", EVICTION_POLICY_STR);
+	printf("# Intervallo in millisecondi tra due passi dell'autotuning del numero di thread workers e di lock\n");
+	printf("# (n intero, 0 < n <= %d, se non specificato l'autotuning è disabilitato)\n", MAX_AUTOTUNE_INTERVAL);
+	printf("%s=n;\n\n", AUTOTUNE_INTERVAL_STR);
+	printf("# Numero minimo di thread workers durante l'autotuning\n");
+	printf("# (n intero, 0 < n <= %s, se non specificato = %u)\n", N_WORKERS_STR, DEFAULT_MIN_WORKERS);
+	printf("%s=n;\n\n", MIN_WORKERS_STR);
+	printf("# Numero massimo di thread workers durante l'autotuning\n");
+	printf("# (n intero, n >= %s, se non specificato = %u o %s se maggiore)\n", 
+	N_WORKERS_STR, DEFAULT_MAX_WORKERS, N_WORKERS_STR);
+	printf("%s=n;\n\n", MAX_WORKERS_STR);
+	printf("# Numero minimo di lock che possono essere associate ai files durante l'autotuning\n");
+	printf("# (n intero, 0 < n <= %s, se non specificato = %u)\n", MAX_LOCKS_STR, DEFAULT_MIN_LOCKS);
+	printf("%s=n;\n\n", MIN_LOCKS_STR);
+	printf("Alla ricezione di SIGUSR2 il file di configurazione viene riletto e vengono applicate, senza riavviare il\n");
+	printf("server, le modifiche a %s, %s, %s, %s e %s.\n", N_WORKERS_STR, DIM_WORKERS_QUEUE_STR, 
+	MAX_FILE_NUM_STR, MAX_BYTES_STR, EVICTION_POLICY_STR);
+	printf("Se la capacità dello storage viene ridotta i file in eccesso vengono espulsi gradualmente.\n");
+	printf("Se l'autotuning è abilitato il numero di thread workers e di lock viene adeguato al carico osservato e ogni\n");
+	printf("decisione viene registrata nel file di log.\n");
 }
 
 int main(int argc, char *argv[]) {
 	int r, extval = EXIT_SUCCESS;
 
-	// maschero i segnali SIGINT, SIGQUIT e SIGHUP
+	// maschero i segnali SIGINT, SIGQUIT, SIGHUP e SIGUSR2
 	sigset_t mask;
 	EQM1_DO(sigemptyset(&mask), r, EXTF);
 	EQM1_DO(sigaddset(&mask, SIGINT), r, EXTF); 
 	EQM1_DO(sigaddset(&mask, SIGQUIT), r, EXTF);
 	EQM1_DO(sigaddset(&mask, SIGHUP), r, EXTF);
+	EQM1_DO(sigaddset(&mask, SIGUSR2), r, EXTF);
 	NEQ0_DO(pthread_sigmask(SIG_BLOCK, &mask, NULL), r, EXTF);
 
 	// ignoro il segnale SIGPIPE
@@ -400,8 +765,6 @@ int main(int argc, char *argv[]) {
 		extval = EXIT_FAILURE;
 		goto server_exit;
 	}
-	free(config_file);
-	config_file = NULL;
 
 	// stampo i valori di configurazione
 	printf("=========== VALORI DI CONFIGURAZIONE ===========\n");
@@ -412,8 +775,18 @@ int main(int argc, char *argv[]) {
 	printf("%s = %zu\n", MAX_LOCKS_STR, config->max_locks);
 	printf("%s = %zu\n", EXPECTED_CLIENTS_STR, config->expected_clients);
 	printf("%s = %s\n", SOCKET_PATH_STR, config->socket_path);   
+	if (config->tcp_port != 0) {
+		printf("%s = %zu\n", TCP_PORT_STR, config->tcp_port);
+		printf("%s = %s\n", TCP_ADDRESS_STR, config->tcp_address);
+	}
 	printf("%s = %s\n", LOG_FILE_STR, config->log_file_path);
 	printf("%s = %s\n", EVICTION_POLICY_STR, eviction_policy_to_str(config->eviction_policy));
+	if (config->autotune_interval != 0) {
+		printf("%s = %zu\n", AUTOTUNE_INTERVAL_STR, config->autotune_interval);
+		printf("%s = %zu\n", MIN_WORKERS_STR, config->min_workers);
+		printf("%s = %zu\n", MAX_WORKERS_STR, config->max_workers);
+		printf("%s = %zu\n", MIN_LOCKS_STR, config->min_locks);
+	}
 
 	// set up del welcoming socket
 	int listenfd;
@@ -426,6 +799,17 @@ int main(int argc, char *argv[]) {
 	EQM1_DO(bind(listenfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)), r, extval = EXIT_FAILURE; goto server_exit);
 	EQM1_DO(listen(listenfd, MAXBACKLOG), r, EXTF);
 
+	// set up del welcoming socket TCP, se richiesto
+	int tcp_listenfd = -1;
+	if (config->tcp_port != 0) {
+		if ((tcp_listenfd = tcp_listen(config->tcp_address, config->tcp_port)) == -1) {
+			EQM1(close(listenfd), r);
+			EQM1(unlink(config->socket_path), r);
+			extval = EXIT_FAILURE;
+			goto server_exit;
+		}
+	}
+
 	// creo il logger
 	logger_t* logger = logger_create(config->log_file_path, INIT_LINE);
 	if (!logger) {
@@ -440,11 +824,33 @@ int main(int argc, char *argv[]) {
 	// pipe per la comunicazione tra master e workers
 	int workers_pipe[2];
 	EQM1_DO(pipe(workers_pipe), r, EXTF);
+	// pipe su cui i workers comunicano al master la terminazione dei task
+	int done_pipe[2];
+	EQM1_DO(pipe(done_pipe), r, EXTF);
 
-	// creo lo storage
+	// creo lo storage (storage_create() modifica config->max_locks, ne conservo il valore letto per la riconfigurazione)
+	size_t max_locks = config->max_locks;
 	storage_t* storage = NULL;
 	EQNULL_DO(storage_create(config, logger), storage, EXTF);
 
+	// stato della riconfigurazione a seguito di SIGUSR2
+	reconfig_t reconfig;
+	memset(&reconfig, 0, sizeof(reconfig_t));
+	reconfig.config_file = config_file;
+	reconfig.config = config;
+	reconfig.max_locks = max_locks;
+	reconfig.n_workers = config->n_workers;
+	reconfig.pool = pool;
+	reconfig.storage = storage;
+	reconfig.logger = logger;
+	reconfig.master_fd = workers_pipe[1];
+	NEQ0_DO(pthread_mutex_init(&reconfig.mutex, NULL), r, EXTF);
+
+	// stato dell'autotuning, se abilitato
+	autotuner_t* tuner = NULL;
+	if (config->autotune_interval != 0)
+		EQNULL_DO(autotuner_create(config, max_locks, pool, storage, logger), tuner, EXTF);
+
 	// maschere per la gestione del selettore
 	fd_set set, tmpset;
 	FD_ZERO(&set);
@@ -452,15 +858,32 @@ int main(int argc, char *argv[]) {
 	FD_SET(listenfd, &set);
 	FD_SET(signal_pipe[0], &set);
 	FD_SET(workers_pipe[0], &set);
+	FD_SET(done_pipe[0], &set);
 	int fdmax = (listenfd > signal_pipe[0]) ? listenfd : signal_pipe[0];
 	fdmax = (workers_pipe[0] > fdmax) ? workers_pipe[0] : fdmax;
+	fdmax = (done_pipe[0] > fdmax) ? done_pipe[0] : fdmax;
+	if (tcp_listenfd != -1) {
+		FD_SET(tcp_listenfd, &set);
+		fdmax = (tcp_listenfd > fdmax) ? tcp_listenfd : fdmax;
+	}
 
 	// numero di client connessi
 	int connected_clients = 0;
 
+	/* numero di task in corso per ciascun descrittore e flag che indica se il client si è disconnesso: il descrittore 
+	   di un client disconnesso viene chiuso solo quando nessun task lo sta utilizzando, così che non possa essere 
+	   riassegnato a una nuova connessione mentre un worker vi sta ancora rispondendo */
+	size_t tasks_in_flight[FD_SETSIZE];
+	bool disconnected[FD_SETSIZE];
+	// flag che indica se il descrittore va reinserito nel set alla terminazione di un task (limite MAX_CLIENT_TASKS)
+	bool rearm_pending[FD_SETSIZE];
+	memset(tasks_in_flight, 0, sizeof(tasks_in_flight));
+	memset(disconnected, 0, sizeof(disconnected));
+	memset(rearm_pending, 0, sizeof(rearm_pending));
+
 	// main loop
 	while (!is_flag_setted(sig_mutex, shut_down_now)) {
-		// se shut_down è settato elimino il listenfd dalla maschera
+		// se shut_down è settato elimino il listenfd e il tcp_listenfd dalla maschera
 		if (is_flag_setted(sig_mutex, shut_down)) {
 			if (listenfd != -1) {
 				FD_CLR(listenfd, &set);
@@ -469,10 +892,29 @@ int main(int argc, char *argv[]) {
 				EQM1(close(listenfd), r);
 				listenfd = -1;
 			}
+			if (tcp_listenfd != -1) {
+				FD_CLR(tcp_listenfd, &set);
+				if (tcp_listenfd == fdmax)
+					fdmax = get_max_fd(set, fdmax);
+				EQM1(close(tcp_listenfd), r);
+				tcp_listenfd = -1;
+			}
 		}
 		
+		// eseguo un passo dell'autotuning se è trascorso l'intervallo (non durante una riconfigurazione)
+		struct timeval timeout;
+		if (tuner) {
+			if (autotuner_due(tuner)) {
+				NEQ0_DO(pthread_mutex_lock(&reconfig.mutex), r, EXTF);
+				bool exclusive = !reconfig.running;
+				NEQ0_DO(pthread_mutex_unlock(&reconfig.mutex), r, EXTF);
+				EQM1_DO(autotuner_step(tuner, exclusive), r, EXTF);
+			}
+			autotuner_timeout(tuner, &timeout);
+		}
+
 		tmpset = set;
-		EQM1_DO(select(fdmax + 1, &tmpset, NULL, NULL, NULL), r, EXTF);
+		EQM1_DO(select(fdmax + 1, &tmpset, NULL, NULL, tuner ? &timeout : NULL), r, EXTF);
 		
 		for (int i = 0; i <= fdmax; i ++) {
 			if (is_flag_setted(sig_mutex, shut_down_now)) {
@@ -485,7 +927,7 @@ int main(int argc, char *argv[]) {
 				continue;
 			
 			int client_fd;
-			if (i == listenfd) {
+			if (i == listenfd || i == tcp_listenfd) {
 				// è giunta una nuova richiesta di connessione
 				if (is_flag_setted(sig_mutex, shut_down_now)) {
 					LOG(log_record(logger, "%d,%s", 
@@ -495,12 +937,27 @@ int main(int argc, char *argv[]) {
 				if (is_flag_setted(sig_mutex, shut_down))
 					continue;
 
-				EQM1_DO(client_fd = accept(listenfd, (struct sockaddr*)NULL ,NULL), r, EXTF);
+				bool tcp = (i == tcp_listenfd);
+				EQM1_DO(client_fd = accept(i, (struct sockaddr*)NULL ,NULL), r, EXTF);
+				// il descrittore non può essere gestito con la select, rifiuto la connessione
+				if (client_fd >= FD_SETSIZE) {
+					EQM1(close(client_fd), r);
+					continue;
+				}
+				if (tcp) {
+					/* disabilito l'algoritmo di Nagle: le parti di una risposta sono accumulate con TCP_CORK e 
+					   trasmesse alla fine della risposta senza attendere l'ack dei segmenti precedenti */
+					int on = 1;
+					EQM1(setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(int)), r);
+				}
 				FD_SET(client_fd, &set);
 				if (client_fd > fdmax)
 					fdmax = client_fd;
+				tasks_in_flight[client_fd] = 0;
+				disconnected[client_fd] = false;
+				rearm_pending[client_fd] = false;
 
-				EQM1_DO(new_connection_handler(storage, client_fd), r, EXTF);
+				EQM1_DO(new_connection_handler(storage, client_fd, tcp), r, EXTF);
 
 				connected_clients++;
 
@@ -514,6 +971,13 @@ int main(int argc, char *argv[]) {
 						MASTER_ID, SHUT_DOWN_NOW));
 					break;
 				}
+				// se è stato ricevuto SIGUSR2 il thread ha scritto un byte, altrimenti ha chiuso la pipe
+				char reconfig_req;
+				EQM1_DO(read(signal_pipe[0], &reconfig_req, sizeof(char)), r, EXTF);
+				if (r == 1) {
+					reconfig_start(&reconfig);
+					continue;
+				}
 				else {
 					LOG(log_record(logger, "%d,%s", 
 						MASTER_ID, SHUT_DOWN));
@@ -537,22 +1001,56 @@ int main(int argc, char *argv[]) {
 
 				// se negativo significa che il client associato al descrittore -(client_fd) si è disconnesso
 				if (client_fd < 0) {
-					connected_clients --;
-					EQM1(close((-client_fd)), r);
-					LOG(log_record(logger, "%d,%s,,%d,,,,,%d",
-						MASTER_ID, CLOSED_CONNECTION, (-client_fd), connected_clients));
+					client_fd = -client_fd;
+					disconnected[client_fd] = true;
+					/* il descrittore potrebbe essere già stato reinserito nel set, lo rimuovo anche dal set restituito
+					   dalla select affinché non venga servito nelle iterazioni successive del ciclo */
+					FD_CLR(client_fd, &set);
+					FD_CLR(client_fd, &tmpset);
+					if (client_fd == fdmax)
+						fdmax = get_max_fd(set, fdmax);
+					// se dei task stanno ancora utilizzando il descrittore lo chiudo al termine dell'ultimo
+					if (tasks_in_flight[client_fd] > 0)
+						continue;
+					close_connection(client_fd, &connected_clients, logger);
 					// se è stato ricevuto il segnale SIGHUP e non ci sono più client connessi posso terminare
 					if (is_flag_setted(sig_mutex, shut_down) && connected_clients == 0) {
 						set_flag(sig_mutex, &shut_down_now);
 						break;
 					}
 				}
-				// altrimenti il client associato al descrittore client_fd è stato servito
-				else {
+				// altrimenti è stata letta la richiesta del client associato al descrittore client_fd
+				else if (!disconnected[client_fd]) {
+					// se il client ha raggiunto il limite di task in corso lo riascolto alla terminazione di uno di essi
+					if (tasks_in_flight[client_fd] >= MAX_CLIENT_TASKS) {
+						rearm_pending[client_fd] = true;
+						continue;
+					}
+					FD_SET(client_fd, &set);
+					if (client_fd > fdmax)
+						fdmax = client_fd;
+				}
+			}
+			else if (i == done_pipe[0]) {
+				// un worker ha terminato un task, leggo il descrittore del client servito
+				EQM1_DO(readn(done_pipe[0], &client_fd, sizeof(int)), r, EXTF);
+				tasks_in_flight[client_fd] --;
+				// se il client era in attesa della terminazione di un task torno ad ascoltarlo
+				if (rearm_pending[client_fd] && !disconnected[client_fd]) {
+					rearm_pending[client_fd] = false;
 					FD_SET(client_fd, &set);
 					if (client_fd > fdmax)
 						fdmax = client_fd;
 				}
+				// se il client si è disconnesso e nessun altro task utilizza il descrittore chiudo la connessione
+				if (disconnected[client_fd] && tasks_in_flight[client_fd] == 0) {
+					close_connection(client_fd, &connected_clients, logger);
+					// se è stato ricevuto il segnale SIGHUP e non ci sono più client connessi posso terminare
+					if (is_flag_setted(sig_mutex, shut_down) && connected_clients == 0) {
+						set_flag(sig_mutex, &shut_down_now);
+						break;
+					}
+				}
 			}
 			else {
 				// è stata ricevuta una richiesta da un client già connesso
@@ -572,12 +1070,15 @@ int main(int argc, char *argv[]) {
 				EQNULL_DO(malloc(sizeof(task_args_t)), args, EXTF);
 				args->storage = storage;
 				args->master_fd = workers_pipe[1];
+				args->done_fd = done_pipe[1];
 				args->client_fd = client_fd;
 			
 				// aggiugo al threadpool la richiesta
 				EQM1_DO(threadpool_add(pool, task_handler, (void*)args), r, EXTF);
+				if (r == 0)
+					tasks_in_flight[client_fd] ++;
 				// controllo se il threadpool ha respinto il task
-				if (r == 1) {
+				else if (r == 1) {
 					// il threadpool ha rifiutato il task
 					if (rejected_task_handler(storage, workers_pipe[1], client_fd) == 0) {
 						// se il client non si è disconnesso aggiungo il suo descrittore al set
@@ -592,9 +1093,16 @@ int main(int argc, char *argv[]) {
 	}
 	if (listenfd != -1)
 		EQM1(close(listenfd), r);
+	if (tcp_listenfd != -1)
+		EQM1(close(tcp_listenfd), r);
+
+	// attendo la terminazione dell'eventuale riconfigurazione in corso (che può ridimensionare il pool)
+	reconfig_stop(&reconfig);
+	NEQ0_DO(pthread_mutex_destroy(&reconfig.mutex), r, EXTF);
 	
 	// attendo la terminazione dei thread e distruggo il pool
 	threadpool_destroy(pool);
+	autotuner_destroy(tuner);
 
 	// stampo le statistiche
 	EQM1_DO(print_statistics(storage), r, EXTF);
@@ -605,6 +1113,7 @@ int main(int argc, char *argv[]) {
 	storage_destroy(storage);
 	logger_destroy(logger);
 	config_destroy(config);
+	free(config_file);
 	return 0;
 
 server_exit:
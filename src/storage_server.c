@@ -10,6 +10,9 @@
 #include <limits.h>
 #include <time.h>
 #include <stdbool.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #include <storage_server.h>
 #include <config_parser.h>
@@ -20,6 +23,8 @@
 #include <protocol.h>
 #include <logger.h>
 #include <log_format.h>
+#include <lz.h>
+#include <crc32c.h>
 #include <util.h>
 
 /**
@@ -33,11 +38,18 @@
  * @var max_files_stored     Numero massimo di file memorizzati
  * @var max_bytes_stored     Numero massimo di bytes memorizzati
  * @var evicted_files        Numero di file espulsi
+ * @var last_file_version    Ultima versione assegnata a un file
+ * @var last_file_seq        Ultimo numero d'ordine di inserimento assegnato a un file
  * @var eviction_policy      Politica di espulsione dei file dallo storage
+ * @var tcp                  Flag che indica se il server accetta connessioni TCP
  * @var files_queue          Coda dei file memorizzati
+ * @var usage_rebuild_node   Nodo di files_queue da cui riprendere la ricostruzione dei contatori degli utilizzi dopo un 
+ *                           cambio della politica di espulsione (NULL se non vi sono contatori da ricostruire)
  * @var files_ht             Tabella hash thread safe per i file memorizzati
  * @var connected_clients    Tabella hash thread safe per i client connessi
  * @var mutex                Mutex per l'accesso in mutua esclusione allo storage
+ * @var notify_fds           Lista dei file descriptor dei client con notifiche di invalidazione da inviare
+ * @var notify_mutex         Mutex per l'accesso in mutua esclusione a notify_fds
  * @var logger               Puntatore alla struttura che rappresenta il logger
  */
 typedef struct storage {
@@ -48,11 +60,17 @@ typedef struct storage {
 	size_t max_files_stored;
 	size_t max_bytes_stored;
 	size_t evicted_files;
+	size_t last_file_version;
+	size_t last_file_seq;
 	eviction_policy_t eviction_policy;
+	bool tcp;
 	list_t* files_queue;
+	node_t* usage_rebuild_node;
 	conc_hasht_t* files_ht;
 	conc_hasht_t* connected_clients;
 	pthread_mutex_t mutex;
+	int_list_t* notify_fds;
+	pthread_mutex_t notify_mutex;
 	logger_t* logger;
 } storage_t;
 
@@ -65,11 +83,19 @@ typedef struct storage {
  * @var content_size         Dimensione del contenuto del file
  * @var locked_by_fd         File descriptor del client che è in possesso della lock sul file
  * @var can_write_fd         File descriptor del client che può effettuare l'operazione write, -1 se nessun client ha tale diritto
- * @var pending_lock_fds     Lista dei file descriptor dei client che sono in attesa di acquisire la lock sul file
+ * @var pending_locks        Lista delle richieste di lock in attesa di essere soddisfatte
  * @var open_by_fds          Lista dei file descriptor dei client che hanno aperto il file
+ * @var cached_by_fds        Lista dei file descriptor dei client (con CAP_INVALIDATION) che hanno in cache il contenuto 
+ *                           del file, da notificare quando il file viene modificato, rimosso o espulso
  * @var creation_time        Timestamp della creazione del file
  * @var last_usage_time      Timestamp dell'ultimo utilizzo del file
  * @var usage_counter        Contatore degli utilizzi del file
+ * @var lw_usage_counter     Flag che indica se il contatore degli utilizzi conta le aperture in corso (politica LW)
+ * @var version              Versione del contenuto del file, aggiornata a ogni creazione o modifica (le versioni sono 
+ *                           assegnate da un contatore globale dello storage per cui non si ripetono tra file diversi)
+ * @var seq                  Numero d'ordine di inserimento del file nello storage (crescente lungo files_queue, usato 
+ *                           come cursore da READN_CURSOR)
+ * @var checksum             CRC32C del contenuto del file
  */
 typedef struct file {
 	char* path;
@@ -77,11 +103,16 @@ typedef struct file {
 	size_t content_size;
 	int locked_by_fd;
 	int can_write_fd;
-	int_list_t* pending_lock_fds;
+	list_t* pending_locks;
 	int_list_t* open_by_fds;
+	int_list_t* cached_by_fds;
 	struct timespec creation_time;
 	struct timespec last_usage_time;
 	int usage_counter;
+	bool lw_usage_counter;
+	size_t version;
+	size_t seq;
+	uint32_t checksum;
 } file_t;
 
 /**
@@ -92,16 +123,28 @@ typedef struct file {
  * @var path_size            Lunghezza del path del file
  * @var content              Contenuto del file
  * @var content_size         Dimensione del contenuto del file
- * @var pending_lock_fds     Lista dei file descriptor dei client in attesa di acquisire la lock sul file espulso
+ * @var pending_locks        Lista delle richieste di lock in attesa sul file espulso
  */
 typedef struct evicted_file {
 	char* path;
 	size_t path_size;
 	void* content;
 	size_t content_size;
-	int_list_t* pending_lock_fds;
+	list_t* pending_locks;
 } evicted_file_t;
 
+/**
+ * @struct                   pending_lock_t
+ * @brief                    Struttura che rappresenta una richiesta di lock in attesa di essere soddisfatta.
+ *
+ * @var fd                   Descrittore del client in attesa di acquisire la lock
+ * @var req_id               Identificativo della richiesta a cui rispondere una volta acquisita la lock
+ */
+typedef struct pending_lock {
+	int fd;
+	int req_id;
+} pending_lock_t;
+
 /**
  * @struct                   client_t
  * @brief                    Struttura che rappresenta un client.
@@ -109,11 +152,28 @@ typedef struct evicted_file {
  * @var fd                   Descrittore del client connesso al server
  * @var opened_files         Lista dei file aperti dal client
  * @var locked_files         Lista dei file bloccati dal client
+ * @var cached_files         Lista dei file di cui il client ha in cache il contenuto (con CAP_INVALIDATION)
+ * @var invalidations        Lista dei path dei file di cui inviare al client la notifica di invalidazione
+ * @var capabilities         Capacità della connessione con il client negoziate con NEGOTIATE (CAP_COMPRESSION, 
+ *                           CAP_CHECKSUM, CAP_INVALIDATION)
+ * @var tcp                  Flag che indica se il client è connesso tramite TCP
+ * @var send_mutex           Mutex per l'invio in mutua esclusione delle risposte al client
+ * @var refs                 Numero di thread che stanno inviando una risposta al client (protetto dalla lock sulla 
+ *                           tabella hash dei client connessi)
+ * @var master_fd            Descrittore del master a cui comunicare la disconnessione del client quando refs si azzera 
+ *                           (-1 se il client non è stato eliminato dallo storage)
  */
 typedef struct client {
 	int fd;
 	list_t* opened_files;
 	list_t* locked_files;
+	list_t* cached_files;
+	list_t* invalidations;
+	int capabilities;
+	bool tcp;
+	pthread_mutex_t send_mutex;
+	int refs;
+	int master_fd;
 } client_t;
 
 /**
@@ -151,19 +211,249 @@ typedef struct client {
 	} while(0);
 
 /**
- * @function                 send_response_code()
- * @brief                    Invia al client associato al file descriptor fd il codice di risposta code.
- * 
+ * @function                 acquire_client()
+ * @brief                    Recupera il client associato al file descriptor fd impedendo che venga distrutto fino alla 
+ *                           successiva invocazione di release_client().
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
  * @param fd                 File descriptor del client
+ *
+ * @return                   Il client in caso di successo, NULL se il client non è connesso.
+ */
+static client_t* acquire_client(storage_t* storage, int fd) {
+	int r;
+	client_t* client;
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &fd), client, EXTF);
+	if (client != NULL)
+		client->refs ++;
+	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+	return client;
+}
+
+static void destroy_client(client_t* client);
+
+/**
+ * @function                 release_client()
+ * @brief                    Rilascia il client recuperato con acquire_client(). Se il client è stato eliminato dallo 
+ *                           storage e non vi sono altri riferimenti comunica al master la disconnessione e lo distrugge.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param client             Il client da rilasciare
+ */
+static void release_client(storage_t* storage, client_t* client) {
+	int r;
+	int fd = client->fd;
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+	client->refs --;
+	bool last = client->master_fd != -1 && client->refs == 0;
+	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+	if (last) {
+		// comunico al master che il client si è disconnesso
+		int neg_client_fd = -fd;
+		EQM1_DO(writen(client->master_fd, &neg_client_fd, sizeof(int)), r, EXTF);
+		destroy_client(client);
+	}
+}
+
+/**
+ * @function                 set_cork()
+ * @brief                    Se il client è connesso tramite TCP abilita (cork = 1) o disabilita (cork = 0) TCP_CORK sulla 
+ *                           connessione, in modo che le parti di una risposta vengano accumulate e trasmesse in segmenti 
+ *                           pieni (alla disabilitazione i dati accumulati vengono trasmessi immediatamente).
  * 
- * @return                   0 in caso di sucesso, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ * @param client             Il client
+ * @param cork               1 per abilitare TCP_CORK, 0 per disabilitarlo
+ */
+static void set_cork(client_t* client, int cork) {
+#ifdef TCP_CORK
+	if (client->tcp && setsockopt(client->fd, IPPROTO_TCP, TCP_CORK, &cork, sizeof(int)) == -1 && errno != EBADF)
+		PERRORSTR(errno)
+#endif
+}
+
+/**
+ * @function                 begin_response()
+ * @brief                    Acquisisce la mutex per l'invio delle risposte al client associato al file descriptor fd e
+ *                           invia l'identificativo della richiesta req_id e il codice di risposta code.
+ *                           Il resto della risposta deve essere inviato prima di invocare end_response().
+ * @warning                  Tra begin_response() e end_response() non deve essere iniziata nessun'altra risposta.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param fd                 File descriptor del client
+ * @param req_id             Identificativo della richiesta a cui si risponde
+ * @param code               Codice di risposta
+ *
+ * @return                   Il client a cui si sta rispondendo, da passare a end_response(), in caso di sucesso, 
+ *                           NULL in caso di fallimento ed errno settato ad indicare l'errore (in tal caso la mutex viene 
+ *                           rilasciata).
+ *                           In caso di fallimento errno può assumere i seguenti valori:
+ *                           EPIPE se il client non è connesso
  * @note                     Errno viene eventualmente settato da writen().
  */
-static int send_response_code(int fd, response_code_t code) {
+static client_t* begin_response(storage_t* storage, int fd, int req_id, response_code_t code) {
 	int r;
-	WRITE_TO_CLIENT(fd, &code, sizeof(response_code_t), r);
-	if (r == -1 || r == 0)
+	client_t* client = acquire_client(storage, fd);
+	if (client == NULL) {
+		errno = EPIPE;
+		return NULL;
+	}
+	NEQ0_DO(pthread_mutex_lock(&client->send_mutex), r, EXTF);
+	set_cork(client, 1);
+	// identificativo e codice vengono inviati con un'unica scrittura, così che una risposta composta dal solo codice 
+	// occupi un unico segmento nel socket buffer del client
+	char header[sizeof(int) + sizeof(response_code_t)];
+	memcpy(header, &req_id, sizeof(int));
+	memcpy(header + sizeof(int), &code, sizeof(response_code_t));
+	WRITE_TO_CLIENT(fd, header, sizeof(header), r);
+	if (r == -1 || r == 0) {
+		int errnosv = errno;
+		set_cork(client, 0);
+		NEQ0_DO(pthread_mutex_unlock(&client->send_mutex), r, EXTF);
+		release_client(storage, client);
+		errno = errnosv;
+		return NULL;
+	}
+	return client;
+}
+
+/**
+ * @function                 flush_invalidations()
+ * @brief                    Invia al client le notifiche di invalidazione accodate.
+ * @warning                  Questa funzione deve essere invocata dopo aver acquisito la mutex per l'invio delle risposte 
+ *                           al client, al termine di una risposta.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param client             Il client
+ */
+static void flush_invalidations(storage_t* storage, client_t* client) {
+	int r;
+	int fd = client->fd;
+	char* path;
+	while (true) {
+		// estraggo la prossima notifica (la lock sul client non viene mantenuta durante l'invio)
+		EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+		path = list_head_remove(client->invalidations);
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+		if (path == NULL)
+			return;
+
+		// compongo la notifica in un unico buffer
+		int req_id = NO_REQ_ID;
+		response_code_t code = INVALIDATED;
+		size_t path_size = strlen(path) + 1;
+		char notice[sizeof(int) + sizeof(response_code_t) + sizeof(size_t) + PATH_MAX];
+		char* p = notice;
+		memcpy(p, &req_id, sizeof(int));
+		p += sizeof(int);
+		memcpy(p, &code, sizeof(response_code_t));
+		p += sizeof(response_code_t);
+		memcpy(p, &path_size, sizeof(size_t));
+		p += sizeof(size_t);
+		memcpy(p, path, path_size);
+		p += path_size;
+		free(path);
+
+		// in caso di errore la connessione verrà chiusa alla successiva lettura o risposta
+		WRITE_TO_CLIENT(fd, notice, p - notice, r);
+		if (r == -1 || r == 0)
+			return;
+	}
+}
+
+/**
+ * @function                 deliver_invalidations()
+ * @brief                    Invia al client le notifiche di invalidazione accodate, a meno che un altro thread non stia 
+ *                           inviando una risposta al client (in tal caso le notifiche vengono inviate da quest'ultimo al 
+ *                           termine della risposta, così che l'invio non possa interrompere una risposta in corso).
+ * @warning                  Questa funzione deve essere invocata senza aver acquisito la mutex per l'invio delle risposte 
+ *                           al client.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param client             Il client recuperato con acquire_client()
+ */
+static void deliver_invalidations(storage_t* storage, client_t* client) {
+	int r;
+	int fd = client->fd;
+	while (true) {
+		EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+		EQM1_DO(list_is_empty(client->invalidations), r, EXTF);
+		bool empty = r;
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+		if (empty)
+			return;
+		/* se la mutex è occupata il thread che la possiede controllerà le notifiche accodate dopo averla rilasciata 
+		   (la notifica è stata accodata prima del tentativo di acquisirla) */
+		if ((r = pthread_mutex_trylock(&client->send_mutex)) == EBUSY)
+			return;
+		NEQ0_DO(r, r, EXTF);
+		flush_invalidations(storage, client);
+		NEQ0_DO(pthread_mutex_unlock(&client->send_mutex), r, EXTF);
+	}
+}
+
+/**
+ * @function                 push_invalidations()
+ * @brief                    Invia ai client le notifiche di invalidazione accodate da invalidate_cached_file().
+ *                           Viene invocata dai worker dopo aver modificato, rimosso o espulso file o ceduto lock e prima 
+ *                           di rispondere al client che ha effettuato la richiesta, così che al termine della richiesta 
+ *                           gli altri client siano già stati notificati.
+ * @warning                  Questa funzione deve essere invocata senza avere alcuna lock acquisita.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ */
+static void push_invalidations(storage_t* storage) {
+	int r, fd;
+	while (true) {
+		NEQ0_DO(pthread_mutex_lock(&storage->notify_mutex), r, EXTF);
+		bool empty = int_list_head_remove(storage->notify_fds, &fd) == -1;
+		NEQ0_DO(pthread_mutex_unlock(&storage->notify_mutex), r, EXTF);
+		if (empty)
+			return;
+		client_t* client = acquire_client(storage, fd);
+		if (client == NULL)
+			continue;
+		deliver_invalidations(storage, client);
+		release_client(storage, client);
+	}
+}
+
+/**
+ * @function                 end_response()
+ * @brief                    Invia le notifiche di invalidazione accodate per il client, trasmette le parti della 
+ *                           risposta eventualmente accumulate e rilascia la mutex per l'invio delle risposte al client.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param client             Il client restituito da begin_response()
+ */
+static void end_response(storage_t* storage, client_t* client) {
+	int r;
+	flush_invalidations(storage, client);
+	set_cork(client, 0);
+	NEQ0_DO(pthread_mutex_unlock(&client->send_mutex), r, EXTF);
+	// invio le notifiche accodate durante l'invio della risposta da thread che non hanno potuto acquisire la mutex
+	deliver_invalidations(storage, client);
+	release_client(storage, client);
+}
+
+/**
+ * @function                 send_response_code()
+ * @brief                    Invia al client associato al file descriptor fd una risposta costituita dal solo codice
+ *                           di risposta code.
+ *
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param fd                 File descriptor del client
+ * @param req_id             Identificativo della richiesta a cui si risponde
+ * @param code               Codice di risposta
+ *
+ * @return                   0 in caso di sucesso, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ * @note                     Errno viene eventualmente settato da writen().
+ */
+static int send_response_code(storage_t* storage, int fd, int req_id, response_code_t code) {
+	client_t* client = begin_response(storage, fd, req_id, code);
+	if (client == NULL)
 		return -1;
+	end_response(storage, client);
 	return 0;
 }
 
@@ -206,11 +496,36 @@ static int send_file_name(int fd, size_t path_size, char* path) {
 	return 0;
 }
 
+/**
+ * @function                 client_capabilities()
+ * @brief                    Restituisce le capacità negoziate dalla connessione con il client associato al file 
+ *                           descriptor fd.
+ * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param fd                 File descriptor del client
+ * 
+ * @return                   Le capacità della connessione (0 se il client non è connesso).
+ */
+static int client_capabilities(storage_t* storage, int fd) {
+	int r;
+	client_t* client;
+	int capabilities = 0;
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &fd), client, EXTF);
+	if (client != NULL)
+		capabilities = client->capabilities;
+	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+	return capabilities;
+}
+
 /**
  * @function                 send_file_content()
  * @brief                    Invia al client associato al file descriptor fd la dimensione del file file_size e il contenuto 
- *                           del file file_content.
+ *                           del file file_content. Se la connessione usa la compressione il contenuto viene inviato in 
+ *                           blocchi di COMPRESSION_BLOCK_SIZE bytes, comprimendo quelli per cui la compressione ne riduce 
+ *                           la dimensione.
  * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
  * @param fd                 File descriptor del client
  * @param file_size          Dimensione del file
  * @param file_content       Contenuto del file
@@ -218,18 +533,163 @@ static int send_file_name(int fd, size_t path_size, char* path) {
  * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
  * @note                     Errno viene eventualmente settato da writen() o da send_size().
  */
-static int send_file_content(int fd, size_t file_size, void* file_content) {
+static int send_file_content(storage_t* storage, int fd, size_t file_size, void* file_content) {
 	int r = 0;
 	if (send_size(fd, file_size) == -1)
 		return -1;
-	if (file_size != 0) {
+	if (file_size == 0)
+		return 0;
+	if (!(client_capabilities(storage, fd) & CAP_COMPRESSION)) {
 		WRITE_TO_CLIENT(fd, file_content, file_size, r);
 		if (r == -1 || r == 0)
 			return -1;
+		return 0;
 	}
+
+	// alloco il buffer per i blocchi compressi
+	void* block = NULL;
+	EQNULL_DO(malloc(COMPRESSION_BLOCK_SIZE), block, EXTF);
+	for (size_t sent = 0; sent < file_size; ) {
+		size_t raw_size = file_size - sent < COMPRESSION_BLOCK_SIZE ? file_size - sent : COMPRESSION_BLOCK_SIZE;
+		void* raw = (char*) file_content + sent;
+		// comprimo il blocco solo se ne riduce la dimensione
+		size_t block_size = 0;
+		if (raw_size >= COMPRESSION_MIN_SIZE)
+			block_size = lz_compress(raw, raw_size, block, raw_size - 1);
+		void* data = block_size != 0 ? block : raw;
+		if (block_size == 0)
+			block_size = raw_size;
+		if (send_size(fd, block_size) == -1) {
+			free(block);
+			return -1;
+		}
+		WRITE_TO_CLIENT(fd, data, block_size, r);
+		if (r == -1 || r == 0) {
+			free(block);
+			return -1;
+		}
+		sent += raw_size;
+	}
+	free(block);
 	return 0;
 }
 
+/**
+ * @function                 send_file_checksum()
+ * @brief                    Invia al client associato al file descriptor fd il CRC32C del contenuto di un file, se la 
+ *                           connessione con il client ha negoziato CAP_CHECKSUM.
+ * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param fd                 File descriptor del client
+ * @param checksum           CRC32C del contenuto del file
+ * 
+ * @return                   0 in caso di successo, -1 in caso di fallimento ed errno settato ad indicare l'errore.
+ * @note                     Errno viene eventualmente settato da writen().
+ */
+static int send_file_checksum(storage_t* storage, int fd, uint32_t checksum) {
+	int r;
+	if (!(client_capabilities(storage, fd) & CAP_CHECKSUM))
+		return 0;
+	WRITE_TO_CLIENT(fd, &checksum, sizeof(uint32_t), r);
+	if (r == -1 || r == 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * @function                 receive_file_content()
+ * @brief                    Legge dal client associato al file descriptor fd i file_size bytes del contenuto di un file, 
+ *                           inviati in blocchi (eventualmente compressi) se la connessione usa la compressione.
+ * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param fd                 File descriptor del client
+ * @param file_content       Buffer di file_size bytes in cui memorizzare il contenuto del file
+ * @param file_size          Dimensione del contenuto del file
+ * 
+ * @return                   Un valore positivo in caso di successo, 0 se il client ha chiuso la connessione, -1 in caso 
+ *                           di fallimento (anche se un blocco ricevuto non è valido).
+ */
+static int receive_file_content(storage_t* storage, int fd, void* file_content, size_t file_size) {
+	int r;
+	if (!(client_capabilities(storage, fd) & CAP_COMPRESSION)) {
+		READ_FROM_CLIENT(fd, file_content, file_size, r);
+		return r;
+	}
+
+	// alloco il buffer per i blocchi compressi
+	void* block = NULL;
+	EQNULL_DO(malloc(COMPRESSION_BLOCK_SIZE), block, EXTF);
+	for (size_t received = 0; received < file_size; ) {
+		size_t raw_size = file_size - received < COMPRESSION_BLOCK_SIZE ? file_size - received : COMPRESSION_BLOCK_SIZE;
+		void* raw = (char*) file_content + received;
+		// leggo la dimensione con cui è trasmesso il blocco
+		size_t block_size;
+		READ_FROM_CLIENT(fd, &block_size, sizeof(size_t), r);
+		if (r == -1 || r == 0 || block_size > raw_size) {
+			free(block);
+			return r == 0 ? 0 : -1;
+		}
+		if (block_size == raw_size) {
+			// il blocco non è compresso, lo leggo direttamente nel contenuto del file
+			READ_FROM_CLIENT(fd, raw, raw_size, r);
+		}
+		else {
+			READ_FROM_CLIENT(fd, block, block_size, r);
+			if (r != -1 && r != 0 && lz_decompress(block, block_size, raw, raw_size) == -1)
+				r = -1;
+		}
+		if (r == -1 || r == 0) {
+			free(block);
+			return r;
+		}
+		received += raw_size;
+	}
+	free(block);
+	return 1;
+}
+
+/**
+ * @function                 init_pending_lock()
+ * @brief                    Inizializza una struttura che rappresenta una richiesta di lock in attesa e ritorna un 
+ *                           puntatore ad essa.
+ *
+ * @param fd                 Descrittore del client in attesa di acquisire la lock
+ * @param req_id             Identificativo della richiesta di lock
+ *
+ * @return                   Un puntatore alla struttura che rappresenta la richiesta di lock in attesa in caso di successo,
+ *                           NULL in caso di fallimento ed errno settato ad indicare l'errore.
+ * @note                     Può fallire e settare errno se si verificano gli errori specificati da malloc().
+ */
+static pending_lock_t* init_pending_lock(int fd, int req_id) {
+	pending_lock_t* pending_lock = malloc(sizeof(pending_lock_t));
+	if (pending_lock == NULL)
+		return NULL;
+	pending_lock->fd = fd;
+	pending_lock->req_id = req_id;
+	return pending_lock;
+}
+
+/**
+ * @function                 cmp_pending_lock()
+ * @brief                    Confronta due strutture che rappresentano richieste di lock in attesa.
+ *                           Esse sono uguali se sono state effettuate dallo stesso client.
+ *
+ * @param a                  Prima richiesta da confrontare
+ * @param b                  Seconda richiesta da confrontare
+ *
+ * @return                   1 se le richieste sono uguali, 0 altrimenti. Se i puntatori sono @c NULL errno viene settato a 
+ *                           EINVAL e viene restituito 0.
+ */
+static int cmp_pending_lock(void* a, void* b) {
+	if (!a || !b) {
+		errno = EINVAL;
+		return 0;
+	}
+	pending_lock_t* p1 = a;
+	pending_lock_t* p2 = b;
+	return (p1->fd == p2->fd);
+}
+
 /**
  * @function                 init_file()
  * @brief                    Inizializza una struttura che rappresenta un file nello storage e ritorna un puntatore ad essa.
@@ -258,21 +718,32 @@ static file_t* init_file(char* path) {
 	file->locked_by_fd = -1;
 	file->can_write_fd = -1;
 
-	file->pending_lock_fds = int_list_create();
-	if (file->pending_lock_fds == NULL) {
+	file->pending_locks = list_create(cmp_pending_lock, free);
+	if (file->pending_locks == NULL) {
 		free(file);
 		return NULL;
 	}		
 	file->open_by_fds = int_list_create();
 	if (file->open_by_fds == NULL) {
+		list_destroy(file->pending_locks, LIST_DO_NOT_FREE_DATA);
+		free(file);
+		return NULL;
+	}
+	file->cached_by_fds = int_list_create();
+	if (file->cached_by_fds == NULL) {
+		int_list_destroy(file->open_by_fds);
+		list_destroy(file->pending_locks, LIST_DO_NOT_FREE_DATA);
 		free(file);
-		int_list_destroy(file->pending_lock_fds);
 		return NULL;
 	}
 	
 	clock_gettime(CLOCK_REALTIME, &file->creation_time);
 	file->last_usage_time = file->creation_time;
 	file->usage_counter = 0;
+	file->lw_usage_counter = false;
+	file->version = 0;
+	file->seq = 0;
+	file->checksum = 0;
 
 	return file;
 }
@@ -290,10 +761,12 @@ static void destroy_file(file_t* file) {
 		free(file->path);
 	if (file->content)
 		free(file->content);
-	if (file->pending_lock_fds)
-		int_list_destroy(file->pending_lock_fds);
+	if (file->pending_locks)
+		list_destroy(file->pending_locks, LIST_FREE_DATA);
 	if (file->open_by_fds != NULL)
 		int_list_destroy(file->open_by_fds);
+	if (file->cached_by_fds != NULL)
+		int_list_destroy(file->cached_by_fds);
 	free(file);
 }
 
@@ -318,6 +791,24 @@ static int cmp_file(void* a, void* b) {
 	return (strcmp(f1->path, f2->path) == 0);
 }
 
+/**
+ * @function                 cmp_path()
+ * @brief                    Funzione di confronto tra path.
+ * 
+ * @param a                  Primo path da confrontare
+ * @param b                  Secondo path da confrontare
+ * 
+ * @return                   1 se i path sono uguali, 0 altrimenti. Se i puntatori sono @c NULL errno viene settato a EINVAL
+ *                           e viene restituito 0.
+ */
+static int cmp_path(void* a, void* b) {
+	if (!a || !b) {
+		errno = EINVAL;
+		return 0;
+	}
+	return (strcmp(a, b) == 0);
+}
+
 /**
  * @function                 init_evicted_file()
  * @brief                    Inizializza una struttura che rappresenta un file espulso dallo storage e ritorna un puntatore
@@ -353,8 +844,8 @@ static evicted_file_t* init_evicted_file(file_t* file) {
 	evicted_file->content = file->content;
 	file->content = NULL;
 
-	evicted_file->pending_lock_fds = file->pending_lock_fds;
-	file->pending_lock_fds = NULL;
+	evicted_file->pending_locks = file->pending_locks;
+	file->pending_locks = NULL;
 
 	return evicted_file;
 }
@@ -372,8 +863,8 @@ static void destroy_evicted_file(evicted_file_t* evicted_file) {
 		free(evicted_file->path);
 	if (evicted_file->content)
 		free(evicted_file->content);
-	if (evicted_file->pending_lock_fds)
-		int_list_destroy(evicted_file->pending_lock_fds);
+	if (evicted_file->pending_locks)
+		list_destroy(evicted_file->pending_locks, LIST_FREE_DATA);
 	free(evicted_file);
 }
 
@@ -403,6 +894,7 @@ static int cmp_evicted_file(void* a, void* b) {
  * @brief                    Inizializza una struttura che rappresenta un client e ritorna un puntatore ad essa.
  * 
  * @param fd                 Descrittore del client connesso al server
+ * @param tcp                Flag che indica se il client è connesso tramite TCP
  * 
  * @return                   Un puntatore a una struttura che rappresenta un client connesso al server in caso di successo,
  *                           NULL in caso di fallimento ed errno settato ad indicare l'errore.
@@ -410,7 +902,7 @@ static int cmp_evicted_file(void* a, void* b) {
  *                           EINVAL se fd è < 0
  * @note                     Può fallire e settare errno se si verificano gli errori specificati da malloc() e list_create().
  */
-static client_t* init_client(int fd) {
+static client_t* init_client(int fd, bool tcp) {
 	if (fd < 0) {
 		errno = EINVAL;
 		return NULL;
@@ -420,16 +912,46 @@ static client_t* init_client(int fd) {
 		return NULL;
 		
 	client->fd = fd;
+	client->capabilities = 0;
+	client->tcp = tcp;
+	client->refs = 0;
+	client->master_fd = -1;
+	int r = pthread_mutex_init(&client->send_mutex, NULL);
+	if (r != 0) {
+		free(client);
+		errno = r;
+		return NULL;
+	}
 
 	client->opened_files = list_create(cmp_file, (void (*)(void*)) destroy_file);
 	if (!client->opened_files) {
+		pthread_mutex_destroy(&client->send_mutex);
 		free(client);
 		return NULL;
 	}
 	client->locked_files = list_create(cmp_file, (void (*)(void*)) destroy_file);
 	if (!client->locked_files) {
+		list_destroy(client->opened_files, LIST_DO_NOT_FREE_DATA);
+		pthread_mutex_destroy(&client->send_mutex);
+		free(client);
+		return NULL;
+	}
+	client->cached_files = list_create(cmp_file, (void (*)(void*)) destroy_file);
+	if (!client->cached_files) {
+		list_destroy(client->locked_files, LIST_DO_NOT_FREE_DATA);
+		list_destroy(client->opened_files, LIST_DO_NOT_FREE_DATA);
+		pthread_mutex_destroy(&client->send_mutex);
 		free(client);
+		return NULL;
+	}
+	client->invalidations = list_create(cmp_path, free);
+	if (!client->invalidations) {
+		list_destroy(client->cached_files, LIST_DO_NOT_FREE_DATA);
+		list_destroy(client->locked_files, LIST_DO_NOT_FREE_DATA);
 		list_destroy(client->opened_files, LIST_DO_NOT_FREE_DATA);
+		pthread_mutex_destroy(&client->send_mutex);
+		free(client);
+		return NULL;
 	}
 
 	return client;
@@ -448,6 +970,11 @@ static void destroy_client(client_t* client) {
 		list_destroy(client->opened_files, LIST_DO_NOT_FREE_DATA);
 	if (client->locked_files)
 		list_destroy(client->locked_files, LIST_DO_NOT_FREE_DATA);
+	if (client->cached_files)
+		list_destroy(client->cached_files, LIST_DO_NOT_FREE_DATA);
+	if (client->invalidations)
+		list_destroy(client->invalidations, LIST_FREE_DATA);
+	pthread_mutex_destroy(&client->send_mutex);
 	free(client);
 }
 
@@ -468,8 +995,12 @@ storage_t* storage_create(config_t* config, logger_t* logger) {
 	storage->max_files_stored = 0;
 	storage->max_bytes_stored = 0;
 	storage->evicted_files = 0;
+	storage->last_file_version = 0;
+	storage->last_file_seq = 0;
 	storage->eviction_policy = config->eviction_policy;
+	storage->tcp = config->tcp_port != 0;
 
+	storage->usage_rebuild_node = NULL;
 	storage->files_queue = list_create(cmp_file, (void (*)(void*)) destroy_file);
 	if (!storage->files_queue) {
 		free(storage);
@@ -487,6 +1018,9 @@ storage_t* storage_create(config_t* config, logger_t* logger) {
 		errno = errnosv;
 		return NULL;
 	}
+	// le acquisizioni delle lock associate ai files vengono contate solo se utilizzate dall'autotuning
+	if (config->autotune_interval != 0)
+		conc_hasht_enable_lock_stats(storage->files_ht);
 
 	int client_buckets = (config->expected_clients) / LOAD_FACTOR;
 	storage->connected_clients = conc_hasht_create(client_buckets, client_buckets, NULL, int_cmp);
@@ -510,6 +1044,29 @@ storage_t* storage_create(config_t* config, logger_t* logger) {
 		return NULL;
 	}
 
+	storage->notify_fds = int_list_create();
+	if (!storage->notify_fds) {
+		errnosv = errno;
+		list_destroy(storage->files_queue, LIST_DO_NOT_FREE_DATA);
+		conc_hasht_destroy(storage->files_ht, NULL, NULL);
+		conc_hasht_destroy(storage->connected_clients, NULL, (void (*)(void*)) destroy_client);
+		pthread_mutex_destroy(&(storage->mutex));
+		free(storage);
+		errno = errnosv;
+		return NULL;
+	}
+	r = pthread_mutex_init(&(storage->notify_mutex), NULL);
+	if (r != 0) {
+		list_destroy(storage->files_queue, LIST_DO_NOT_FREE_DATA);
+		conc_hasht_destroy(storage->files_ht, NULL, NULL);
+		conc_hasht_destroy(storage->connected_clients, NULL, (void (*)(void*)) destroy_client);
+		pthread_mutex_destroy(&(storage->mutex));
+		int_list_destroy(storage->notify_fds);
+		free(storage);
+		errno = r;
+		return NULL;
+	}
+
 	storage->logger = logger;
 
 	return storage;
@@ -525,10 +1082,13 @@ void storage_destroy(storage_t* storage) {
 	if (storage->connected_clients)
 		conc_hasht_destroy(storage->connected_clients, NULL, (void (*)(void*)) destroy_client);
 	pthread_mutex_destroy(&(storage->mutex));
+	if (storage->notify_fds)
+		int_list_destroy(storage->notify_fds);
+	pthread_mutex_destroy(&(storage->notify_mutex));
 	free(storage);
 }
 
-int new_connection_handler(storage_t* storage, int client_fd) {
+int new_connection_handler(storage_t* storage, int client_fd, bool tcp) {
 	if (storage == NULL || client_fd < 0) {
 		errno = EINVAL;
 		return -1;
@@ -537,7 +1097,7 @@ int new_connection_handler(storage_t* storage, int client_fd) {
 	int r;
 	// alloco un puntatore a una struttura che rappresenta un client
 	client_t* client = NULL;
-	EQNULL_DO(init_client(client_fd), client, EXTF);
+	EQNULL_DO(init_client(client_fd, tcp), client, EXTF);
 
 	// aggiungo il client alla tabella hash di client connessi se non è già presente
 	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
@@ -575,8 +1135,14 @@ static void update_file_usage_time(file_t* file, request_code_t op, eviction_pol
 		case APPEND:
 		case READ:
 		case READN:
+		case READN_CURSOR:
 		case LOCK:
 		case UNLOCK:
+		case OPEN_WRITE_CLOSE:
+		case OPEN_READ_CLOSE:
+		case READ_RANGE:
+		case WRITE_AT:
+		case READ_IF_NEWER:
 			EQM1(clock_gettime(CLOCK_REALTIME, &file->last_usage_time), r);
 			break;
 		case CLOSE:
@@ -585,6 +1151,33 @@ static void update_file_usage_time(file_t* file, request_code_t op, eviction_pol
 	} 
 }
 
+/**
+ * @function                 rebuild_file_usage_counter()
+ * @brief                    Ricostruisce il contatore degli utilizzi di file secondo la politica di espulsione policy, 
+ *                           se il contatore è stato aggiornato secondo una politica che lo interpreta diversamente.
+ * @warning                  Questa funzione deve essere invocata avendo accesso esclusivo al file.
+ * 
+ * @param file               Puntatore alla struttura che rappresenta il file il cui contatore deve essere ricostruito
+ * @param policy             Politica di espulsione
+ */
+static void rebuild_file_usage_counter(file_t* file, eviction_policy_t policy) {
+	/* FIFO, LRU e LFU aggiornano il contatore degli utilizzi allo stesso modo, mentre LW vi conta le aperture in corso: 
+	   il contatore va ricostruito solo se la politica LW è stata abilitata o disabilitata */
+	if (file->lw_usage_counter == (policy == LW))
+		return;
+	if (policy == LW) {
+		// ogni client che ha aperto il file contribuisce con 2 utilizzi
+		size_t open_by = int_list_get_length(file->open_by_fds);
+		file->usage_counter = open_by <= INT_MAX/2 ? 2 * open_by : INT_MAX;
+	}
+	else {
+		/* la frequenza degli utilizzi passati non è nota, a parità di contatore i file vengono espulsi in base al 
+		   tempo di ultimo utilizzo */
+		file->usage_counter = 1;
+	}
+	file->lw_usage_counter = policy == LW;
+}
+
 /**
  * @function                 update_file_usage_counter()
  * @brief                    Aggiorna il contatore degli utilizzi di file in base al tipo di operazione effettuata op e 
@@ -596,6 +1189,14 @@ static void update_file_usage_time(file_t* file, request_code_t op, eviction_pol
  * @param policy             Politica di espulsione
  */
 static void update_file_usage_counter(file_t* file, request_code_t op, eviction_policy_t policy) {
+	if (op == OPEN_CREATE_LOCK || op == OPEN_CREATE || op == OPEN_WRITE_CLOSE) {
+		// il contatore viene assegnato secondo la politica corrente
+		file->lw_usage_counter = policy == LW;
+	}
+	else if (file->lw_usage_counter != (policy == LW)) {
+		// il contatore non è ancora stato ricostruito dopo il cambio di politica, lo sarà dallo stato del file
+		return;
+	}
 	switch (op) {
 		case OPEN_CREATE_LOCK:
 		case OPEN_CREATE:
@@ -619,6 +1220,10 @@ static void update_file_usage_counter(file_t* file, request_code_t op, eviction_
 		case APPEND:
 		case READ:
 		case READN:
+		case READN_CURSOR:
+		case READ_RANGE:
+		case WRITE_AT:
+		case READ_IF_NEWER:
 			if (file->usage_counter != INT_MAX)
 				file->usage_counter += 1;
 			break;
@@ -632,15 +1237,127 @@ static void update_file_usage_counter(file_t* file, request_code_t op, eviction_
 			if (policy == LW)
 				file->usage_counter -= 2;
 			break;
+		case OPEN_WRITE_CLOSE: // equivale a OPEN_CREATE_LOCK, WRITE e CLOSE
+			if (policy == LW)
+				file->usage_counter = 1;
+			else
+				file->usage_counter = 2;
+			break;
+		case OPEN_READ_CLOSE: // equivale a OPEN_NO_FLAGS, READ e CLOSE
+			if (policy == LW) {
+				if (file->usage_counter != INT_MAX)
+					file->usage_counter += 1;
+			}
+			else {
+				if (file->usage_counter <= INT_MAX-2)
+					file->usage_counter += 2;
+			}
+			break;
 		case REMOVE:
 		default: ;
 	}
 }
 
+/**
+ * @function                 register_cached_file()
+ * @brief                    Se la connessione con il client associato al file descriptor fd ha la capacità 
+ *                           CAP_INVALIDATION registra che il client ha in cache il contenuto del file.
+ * @warning                  Questa funzione deve essere invocata dopo aver acquisito la lock sulla tabella hash di file 
+ *                           per l'accesso a file, che deve essere mantenuta fino all'invio del contenuto al client (così 
+ *                           che una notifica di invalidazione non possa precedere il contenuto).
+ * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param file               Il file letto dal client
+ * @param fd                 File descriptor del client
+ * 
+ * @return                   true se la connessione con il client ha la capacità CAP_INVALIDATION, false altrimenti.
+ */
+static bool register_cached_file(storage_t* storage, file_t* file, int fd) {
+	int r;
+	client_t* client;
+	bool invalidation = false;
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &fd), client, EXTF);
+	if (client != NULL && (client->capabilities & CAP_INVALIDATION)) {
+		invalidation = true;
+		// la notifica eventualmente accodata riguarda una versione precedente a quella che il client riceverà
+		char* path = list_remove_and_get(client->invalidations, file->path);
+		if (path != NULL)
+			free(path);
+		EQM1_DO(int_list_contains(file->cached_by_fds, fd), r, EXTF);
+		if (!r) {
+			EQM1_DO(int_list_tail_insert(file->cached_by_fds, fd), r, EXTF);
+			EQM1_DO(list_tail_insert(client->cached_files, file), r, EXTF);
+		}
+	}
+	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+	return invalidation;
+}
+
+/**
+ * @function                 invalidate_cached_file()
+ * @brief                    Accoda ai client che hanno in cache il contenuto del file, eccetto il client associato al file 
+ *                           descriptor except_fd, la notifica che la copia in cache non può più essere utilizzata (le 
+ *                           notifiche vengono inviate da push_invalidations()).
+ * @warning                  Questa funzione deve essere invocata dopo aver acquisito la lock sulla tabella hash di file 
+ *                           per l'accesso a file e senza aver acquisito alcuna lock sulla tabella hash dei client.
+ * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param file               Il file modificato, rimosso, espulso o bloccato
+ * @param except_fd          File descriptor del client da non notificare (-1 per notificare tutti i client)
+ */
+static void invalidate_cached_file(storage_t* storage, file_t* file, int except_fd) {
+	int r, fd;
+	client_t* client;
+
+	// il client escluso continua ad avere in cache il file
+	EQM1_DO(int_list_contains(file->cached_by_fds, except_fd), r, EXTF);
+	bool keep = r;
+	if (keep)
+		EQM1_DO(int_list_remove(file->cached_by_fds, except_fd), r, EXTF);
+
+	while (int_list_head_remove(file->cached_by_fds, &fd) == 0) {
+		// controllo che il client sia ancora connesso (la sua connessione non può essere chiusa finchè il file è 
+		// nella sua lista di file in cache, la cui scansione richiede la lock sul file)
+		EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
+		ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &fd), client, EXTF);
+		bool notify = false;
+		if (client != NULL) {
+			// accodo la notifica (se non già accodata)
+			EQM1_DO(list_contains(client->invalidations, file->path), r, EXTF);
+			if (!r && (client->capabilities & CAP_INVALIDATION)) {
+				char* path;
+				EQNULL_DO(malloc(strlen(file->path) + 1), path, EXTF);
+				strcpy(path, file->path);
+				EQM1_DO(list_tail_insert(client->invalidations, path), r, EXTF);
+				notify = true;
+			}
+			// rimuovo il file dalla lista di file in cache del client
+			list_remove_and_get(client->cached_files, file);
+		}
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+
+		if (notify) {
+			// segnalo che il client ha notifiche da ricevere
+			NEQ0_DO(pthread_mutex_lock(&storage->notify_mutex), r, EXTF);
+			EQM1_DO(int_list_contains(storage->notify_fds, fd), r, EXTF);
+			if (!r)
+				EQM1_DO(int_list_tail_insert(storage->notify_fds, fd), r, EXTF);
+			NEQ0_DO(pthread_mutex_unlock(&storage->notify_mutex), r, EXTF);
+		}
+	}
+
+	if (keep)
+		EQM1_DO(int_list_tail_insert(file->cached_by_fds, except_fd), r, EXTF);
+}
+
 /**
  * @function                 give_lock_to_waiting_client()
- * @brief                    Estrae il primo client in attesa di acquisire la lock su file e gli assegna la lock.
+ * @brief                    Estrae la prima richiesta di lock in attesa su file e assegna la lock al client che l'ha
+ *                           effettuata. Le richieste di client che si sono nel frattempo disconnessi vengono scartate.
  *                           Se nessun client è in attesa di acquisire la lock setta il campo file->locked_by_fd a -1.
+ *                           La risposta alla richiesta deve essere inviata con send_lock_granted() dopo aver rilasciato 
+ *                           le lock, in modo che un client lento a ricevere non blocchi lo storage.
  * @warning                  Questa funzione deve essere invocata dopo aver acquisito la lock sulla tabella hash di file per 
  *                           l'accesso a file.
  * 
@@ -648,45 +1365,66 @@ static void update_file_usage_counter(file_t* file, request_code_t op, eviction_
  * @param file               File il cui detentore della lock deve essere modificato
  * @param worker_id          Identificativo del worker thread che gestisce la richiesta
  * 
- * @return                   Il descrittore del client la cui connessione dovrà essere chiusa perchè disconnesso,
- *                           -1 se nessun client si è disconnesso.
+ * @return                   La richiesta di lock soddisfatta, NULL se nessun client era in attesa della lock.
  */
-static int give_lock_to_waiting_client(storage_t* storage, file_t* file, int worker_id, int master_fd) {
-	int r, fd;
+static pending_lock_t* give_lock_to_waiting_client(storage_t* storage, file_t* file, int worker_id) {
+	int r;
+	client_t* client = NULL;
+	pending_lock_t* pending_lock = NULL;
+
+	while (client == NULL) {
+		// rimuovo la prima richiesta di lock in attesa su file
+		ERRNOSET_DO(list_head_remove(file->pending_locks), pending_lock, EXTF);
+		if (pending_lock == NULL) {
+			// nessun client è in attesa di acquisire la lock
+			file->locked_by_fd = -1;
+			return NULL;
+		}
 
-	// rimuovo il primo client in attesa di acquisire la lock su file
-	ERRNOSET_DO(int_list_head_remove(file->pending_lock_fds, &fd), r, EXTF);
-	if (r == -1) {
-		// nessun client è in attesa di acquisire la lock
-		file->locked_by_fd = -1;
-		return -1;
+		// recupero il client divenuto detentore della lock
+		EQM1_DO(conc_hasht_lock(storage->connected_clients, &pending_lock->fd), r, EXTF);
+		ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &pending_lock->fd), client, EXTF);
+		if (client == NULL) {
+			// il client si è disconnesso, passo alla richiesta successiva
+			EQM1_DO(conc_hasht_unlock(storage->connected_clients, &pending_lock->fd), r, EXTF);
+			free(pending_lock);
+			continue;
+		}
+		file->locked_by_fd = pending_lock->fd;
+		// inserisco il file nella lista di file bloccati dal client
+		EQM1_DO(list_tail_insert(client->locked_files, file), r, EXTF);
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &pending_lock->fd), r, EXTF);
 	}
 
-	file->locked_by_fd = fd;
-
-	// recupero il client divenuto detentore della lock
-	client_t* client;
-	EQM1_DO(conc_hasht_lock(storage->connected_clients, &fd), r, EXTF);
-	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &fd), client, EXTF);
-	if (client == NULL) {
-		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
-		return -1;
-	}
-	// inserisco il file nella lista di file bloccati dal client
-	EQM1_DO(list_tail_insert(client->locked_files, file), r, EXTF);
-	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &fd), r, EXTF);
+	// gli altri client non possono più leggere il file, le loro copie in cache non possono più essere utilizzate
+	invalidate_cached_file(storage, file, pending_lock->fd);
 
 	LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
-		worker_id, OP_SUSPENDED, resp_code_to_str(OK), fd, file->path, 0));
+		worker_id, OP_SUSPENDED, resp_code_to_str(OK), pending_lock->fd, file->path, 0));
 
-	// rispondo al client in attesa della lock l'esito positivo dell'operazione
-	if (send_response_code(fd, OK) == -1)
-		return fd;
-	
-	// comunico al master di aver servito il client che era in attesa
-	EQM1_DO(writen(master_fd, &fd, sizeof(int)), r, EXTF);
-	
-	return -1;
+	return pending_lock;
+}
+
+/**
+ * @function                 send_lock_granted()
+ * @brief                    Invia le notifiche di invalidazione accodate cedendo la lock, risponde l'esito positivo alla 
+ *                           richiesta di lock soddisfatta da give_lock_to_waiting_client() e la dealloca.
+ * @warning                  Questa funzione deve essere invocata senza avere alcuna lock acquisita.
+ * 
+ * @param storage            Puntatore alla struttura che rappresenta lo storage
+ * @param granted            La richiesta di lock soddisfatta (se NULL la funzione non ha effetto)
+ * 
+ * @return                   Il descrittore del client la cui connessione dovrà essere chiusa perchè disconnesso,
+ *                           -1 se nessun client si è disconnesso.
+ */
+static int send_lock_granted(storage_t* storage, pending_lock_t* granted) {
+	if (granted == NULL)
+		return -1;
+	push_invalidations(storage);
+	int fd = granted->fd;
+	int r = send_response_code(storage, fd, granted->req_id, OK);
+	free(granted);
+	return r == -1 ? fd : -1;
 }
 
 /**
@@ -700,9 +1438,15 @@ static int give_lock_to_waiting_client(storage_t* storage, file_t* file, int wor
  */
 static void delete_file_from_storage(storage_t* storage, file_t* file) {
 	int r, fd;
+
+	// notifico la rimozione del file ai client che lo hanno in cache
+	invalidate_cached_file(storage, file, -1);
 	
 	// elimino il file dalla tabella hash
 	EQM1_DO(conc_hasht_delete(storage->files_ht, file->path, NULL, NULL), r, EXTF);
+	// se la ricostruzione dei contatori degli utilizzi deve riprendere dal file la faccio riprendere dal successivo
+	if (storage->usage_rebuild_node != NULL && storage->usage_rebuild_node->data == file)
+		storage->usage_rebuild_node = storage->usage_rebuild_node->next;
 	// elimino il file dalla coda
 	EQNULL_DO(list_remove_and_get(storage->files_queue, file), file, EXTF);
 
@@ -753,6 +1497,9 @@ static int_list_t* delete_client_from_storage(storage_t* storage, int master_fd,
 	// lista dei client di cui dovrò chiudere la connessione
 	int_list_t* clients_unreachable = NULL;
 	EQNULL_DO(int_list_create(), clients_unreachable, EXTF);
+	// lista delle richieste di lock soddisfatte a cui rispondere dopo aver rilasciato le lock
+	list_t* granted_locks = NULL;
+	EQNULL_DO(list_create(cmp_pending_lock, free), granted_locks, EXTF);
 	
 	// prendo la lock sullo storage per evitare che vengano ad esempio cancellati file aperti o bloccati dal client
 	NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
@@ -763,6 +1510,7 @@ static int_list_t* delete_client_from_storage(storage_t* storage, int master_fd,
 	// le risorse associate al client sono già state deallocate
 	if (client == NULL) {
 		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+		list_destroy(granted_locks, LIST_FREE_DATA);
 		return clients_unreachable;
 	}
 
@@ -772,11 +1520,9 @@ static int_list_t* delete_client_from_storage(storage_t* storage, int master_fd,
 		if (file != NULL && file->path != NULL) {
 			EQM1_DO(conc_hasht_lock(storage->files_ht, file->path), r, EXTF); 
 			// passo la lock sul file a un eventuale client in attesa
-			int fd = give_lock_to_waiting_client(storage, file, worker_id, master_fd);
-			/* se nel contattare il client a cui passare la lock ho riscontrato che si è disconnesso
-			   aggiungo il suo descrittore alla lista di client di cui dovrò chiudere la connessione */
-			if (fd != -1)
-				EQM1_DO(int_list_tail_insert(clients_unreachable, fd), r, EXTF);
+			pending_lock_t* granted = give_lock_to_waiting_client(storage, file, worker_id);
+			if (granted != NULL)
+				EQM1_DO(list_tail_insert(granted_locks, granted), r, EXTF);
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file->path), r, EXTF);
 		}
 	}
@@ -790,17 +1536,50 @@ static int_list_t* delete_client_from_storage(storage_t* storage, int master_fd,
 			update_file_usage_time(file, CLOSE, storage->eviction_policy);
 			// rimuovo il client dalla lista di descrittori di client che hanno aperto il file
 			EQM1_DO(int_list_remove(file->open_by_fds, client_fd), r, EXTF);
+			// rimuovo le eventuali richieste di lock sul file effettuate dal client e ancora in attesa
+			pending_lock_t key = { client_fd, NO_REQ_ID }, *pending_lock;
+			while ((pending_lock = list_remove_and_get(file->pending_locks, &key)) != NULL)
+				free(pending_lock);
+			EQM1_DO(conc_hasht_unlock(storage->files_ht, file->path), r, EXTF);
+		}
+	}
+
+	// itero sui file che il client ha in cache
+	list_for_each(client->cached_files, file) {
+		if (file != NULL && file->path != NULL) {
+			EQM1_DO(conc_hasht_lock(storage->files_ht, file->path), r, EXTF);
+			// rimuovo il client dalla lista di descrittori di client che hanno in cache il file
+			int_list_remove(file->cached_by_fds, client_fd);
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file->path), r, EXTF);
 		}
 	}
 
 	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 
-	// comunico al master che il client si è disconnesso
-	int neg_client_fd = -client_fd;
-	EQM1_DO(writen(master_fd, &neg_client_fd, sizeof(int)), r, EXTF);
+	// rispondo ai client a cui sono state passate le lock
+	pending_lock_t* granted;
+	while ((granted = list_head_remove(granted_locks)) != NULL) {
+		/* se nel contattare il client a cui passare la lock ho riscontrato che si è disconnesso
+		   aggiungo il suo descrittore alla lista di client di cui dovrò chiudere la connessione */
+		int fd = send_lock_granted(storage, granted);
+		if (fd != -1)
+			EQM1_DO(int_list_tail_insert(clients_unreachable, fd), r, EXTF);
+	}
+	list_destroy(granted_locks, LIST_FREE_DATA);
 
-	destroy_client(client);
+	/* se altri thread stanno inviando una risposta al client la disconnessione verrà comunicata al master e il client 
+	   distrutto dall'ultimo di questi, in modo che il descrittore non venga chiuso e riutilizzato durante l'invio */
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
+	bool last = client->refs == 0;
+	if (!last)
+		client->master_fd = master_fd;
+	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+	if (last) {
+		// comunico al master che il client si è disconnesso
+		int neg_client_fd = -client_fd;
+		EQM1_DO(writen(master_fd, &neg_client_fd, sizeof(int)), r, EXTF);
+		destroy_client(client);
+	}
 
 	return clients_unreachable;
 }
@@ -848,29 +1627,25 @@ void close_client_connection(storage_t* storage, int master_fd, int client_fd, i
  * @param storage            Puntatore alla struttura che rappresenta lo storage
  * @param file_path          Il file rimosso dallo storage
  * @param master_fd          Descrittore per la comunicazione con il master thread
- * @param clients_waiting    Lista dei descrittori dei client in attesa di acquisire la lock sul file file_path
+ * @param pending_locks      Lista delle richieste di lock in attesa sul file file_path
  * @param worker_id          Identificativo del worker thread che gestisce la richiesta
  */
 static void notify_clients_file_not_exists(storage_t* storage, 
 									char* file_path, 
 									int master_fd, 
-									int_list_t* clients_waiting, 
+									list_t* pending_locks, 
 									int worker_id) {
-	int r, fd;
-	size_t len;
-	ERRNOSET_DO(int_list_get_length(clients_waiting), len, EXTF); 
+	pending_lock_t* pending_lock;
 	
-	for (int i = 0; i < len; i ++) {
-		// rimuovo dalla lista il file descriptor del client in attesa
-		EQM1_DO(int_list_head_remove(clients_waiting, &fd), r, EXTF);
+	// estraggo le richieste di lock in attesa
+	while ((pending_lock = list_head_remove(pending_locks)) != NULL) {
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
-			worker_id, req_code_to_str(LOCK), resp_code_to_str(FILE_NOT_EXISTS), fd, file_path, 0));
-		/* comunico al client che il file non esiste e al master di aver servito il client
+			worker_id, req_code_to_str(LOCK), resp_code_to_str(FILE_NOT_EXISTS), pending_lock->fd, file_path, 0));
+		/* comunico al client che il file non esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(fd, FILE_NOT_EXISTS) == -1)
-			close_client_connection(storage, master_fd, fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &fd, sizeof(int)), r, EXTF);
+		if (send_response_code(storage, pending_lock->fd, pending_lock->req_id, FILE_NOT_EXISTS) == -1)
+			close_client_connection(storage, master_fd, pending_lock->fd, worker_id);
+		free(pending_lock);
 	}
 }
 
@@ -919,6 +1694,8 @@ static evicted_file_t* evict_file(storage_t* storage, char* path_needed) {
 			// itero sui file dello storage
 			list_for_each(storage->files_queue, file) {
 				EQM1_DO(conc_hasht_lock(storage->files_ht, file->path), r, EXTF);
+				// il contatore potrebbe non essere ancora stato ricostruito dopo il cambio di politica
+				rebuild_file_usage_counter(file, storage->eviction_policy);
 				if (min_usage_time.tv_sec == 0) {
 					// inizializzo il timestamp minimo
 					min_usage_time = file->last_usage_time;
@@ -1004,11 +1781,27 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 	// struttura per memorizzare gli argomenti della richiesta
 	request_t* req = NULL;
 	EQNULL_DO(malloc(sizeof(request_t)), req, EXTF);
+	req->id = NO_REQ_ID;
 	req->code = -1;
 	req->file_path = NULL;
 	req->content_size = 0;
 	req->content = NULL;
 	req->n = 0;
+	req->offset = 0;
+	req->length = 0;
+	req->version = 0;
+	req->cursor = 0;
+	req->max_bytes = 0;
+	req->capabilities = 0;
+
+	// leggo l'identificativo della richiesta
+	READ_FROM_CLIENT(client_fd, &req->id, sizeof(int), r);
+	if (r == -1 || r == 0) {
+		close_client_connection(storage, master_fd, client_fd, worker_id);
+		free(req);
+		errno = ECOMM;
+		return NULL;
+	}
 
 	// leggo il codice della richiesta
 	READ_FROM_CLIENT(client_fd, &req->code, sizeof(request_code_t), r);
@@ -1022,14 +1815,14 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 	if (req->code < MIN_REQ_CODE || req->code > MAX_REQ_CODE) {
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,,%d",
 			worker_id, NULL, resp_code_to_str(NOT_RECOGNIZED_OP), client_fd, 0));
-		send_response_code(client_fd, NOT_RECOGNIZED_OP);
+		send_response_code(storage, client_fd, req->id, NOT_RECOGNIZED_OP);
 		close_client_connection(storage, master_fd, client_fd, worker_id);
 		free(req);
 		errno = ECOMM;
 		return NULL;
 	}
 
-	if (req->code != READN) {
+	if (req->code != READN && req->code != READN_CURSOR && req->code != NEGOTIATE) {
 		size_t file_path_len;
 		// leggo la size del path del file
 		READ_FROM_CLIENT(client_fd, &file_path_len, sizeof(size_t), r);
@@ -1043,7 +1836,7 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 		if (file_path_len > PATH_MAX) {
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,,%d",
 				worker_id, req_code_to_str(req->code), resp_code_to_str(TOO_LONG_PATH), client_fd, 0));
-			send_response_code(client_fd, TOO_LONG_PATH);
+			send_response_code(storage, client_fd, req->id, TOO_LONG_PATH);
 			close_client_connection(storage, master_fd, client_fd, worker_id);
 			free(req);
 			errno = ECOMM;
@@ -1053,7 +1846,7 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 		if (file_path_len == 0) {
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,,%d",
 				worker_id, req_code_to_str(req->code), resp_code_to_str(INVALID_PATH), client_fd, 0));
-			send_response_code(client_fd, INVALID_PATH);
+			send_response_code(storage, client_fd, req->id, INVALID_PATH);
 			close_client_connection(storage, master_fd, client_fd, worker_id);
 			free(req);
 			errno = ECOMM;
@@ -1076,7 +1869,19 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 			strchr(req->file_path, '/') != req->file_path) {
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 				worker_id, req_code_to_str(req->code), resp_code_to_str(INVALID_PATH), client_fd, req->file_path, 0));
-			send_response_code(client_fd, INVALID_PATH);
+			send_response_code(storage, client_fd, req->id, INVALID_PATH);
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+			free(req->file_path);
+			free(req);
+			errno = ECOMM;
+			return NULL;
+		}
+	}
+
+	if (req->code == READ_RANGE || req->code == WRITE_AT) {
+		// leggo l'offset
+		READ_FROM_CLIENT(client_fd, &req->offset, sizeof(size_t), r);
+		if (r == -1 || r == 0) {
 			close_client_connection(storage, master_fd, client_fd, worker_id);
 			free(req->file_path);
 			free(req);
@@ -1085,7 +1890,32 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 		}
 	}
 
-	if (req->code == WRITE || req->code == APPEND) {
+	if (req->code == READ_RANGE) {
+		// leggo il numero massimo di bytes da leggere
+		READ_FROM_CLIENT(client_fd, &req->length, sizeof(size_t), r);
+		if (r == -1 || r == 0) {
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+			free(req->file_path);
+			free(req);
+			errno = ECOMM;
+			return NULL;
+		}
+	}
+
+	if (req->code == READ_IF_NEWER || 
+		((req->code == READ || req->code == OPEN_READ_CLOSE) && (client_capabilities(storage, client_fd) & CAP_INVALIDATION))) {
+		// leggo la versione del file posseduta dal client (in caso di READ e OPEN_READ_CLOSE quella in cache)
+		READ_FROM_CLIENT(client_fd, &req->version, sizeof(size_t), r);
+		if (r == -1 || r == 0) {
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+			free(req->file_path);
+			free(req);
+			errno = ECOMM;
+			return NULL;
+		}
+	}
+
+	if (req->code == WRITE || req->code == APPEND || req->code == OPEN_WRITE_CLOSE || req->code == WRITE_AT) {
 		// leggo la size del contenuto del file
 		READ_FROM_CLIENT(client_fd, &req->content_size, sizeof(size_t), r);
 		if (r == -1 || r == 0) {
@@ -1095,11 +1925,15 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 			errno = ECOMM;
 			return NULL;
 		}
-		// controllo che la dimensione del file non sia maggiore della capacità dello storage
-		if (req->content_size > storage->max_bytes) {
+		/* controllo che la dimensione del file non sia maggiore della capacità dello storage
+		   (la capacità può essere modificata dalla riconfigurazione, la leggo in mutua esclusione) */
+		NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
+		size_t max_bytes = storage->max_bytes;
+		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+		if (req->content_size > max_bytes) {
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 				worker_id, req_code_to_str(req->code), resp_code_to_str(TOO_LONG_CONTENT), client_fd, req->file_path, 0));
-			send_response_code(client_fd, TOO_LONG_CONTENT);
+			send_response_code(storage, client_fd, req->id, TOO_LONG_CONTENT);
 			close_client_connection(storage, master_fd, client_fd, worker_id);
 			free(req->file_path);
 			free(req);
@@ -1109,7 +1943,7 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 		if (req->content_size != 0) {
 			// leggo il contenuto del file
 			EQNULL_DO(malloc(req->content_size), req->content, EXTF);
-			READ_FROM_CLIENT(client_fd, req->content, req->content_size, r);
+			r = receive_file_content(storage, client_fd, req->content, req->content_size);
 			if (r == -1 || r == 0) {
 				close_client_connection(storage, master_fd, client_fd, worker_id);
 				free(req->file_path);
@@ -1121,7 +1955,18 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 		}
 	}
 
-	if (req->code == READN) {
+	if (req->code == READN_CURSOR) {
+		// leggo il cursore da cui riprendere la scansione
+		READ_FROM_CLIENT(client_fd, &req->cursor, sizeof(size_t), r);
+		if (r == -1 || r == 0) {
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+			free(req);
+			errno = ECOMM;
+			return NULL;
+		}
+	}
+
+	if (req->code == READN || req->code == READN_CURSOR) {
 		// leggo il valore di n
 		READ_FROM_CLIENT(client_fd, &req->n, sizeof(int), r);
 		if (r == -1 || r == 0) {
@@ -1133,6 +1978,28 @@ request_t* read_request(storage_t* storage, int master_fd, int client_fd, int wo
 		}
 	}
 
+	if (req->code == NEGOTIATE) {
+		// leggo le capacità richieste dal client
+		READ_FROM_CLIENT(client_fd, &req->capabilities, sizeof(int), r);
+		if (r == -1 || r == 0) {
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+			free(req);
+			errno = ECOMM;
+			return NULL;
+		}
+	}
+
+	if (req->code == READN_CURSOR) {
+		// leggo il numero massimo di bytes del batch
+		READ_FROM_CLIENT(client_fd, &req->max_bytes, sizeof(size_t), r);
+		if (r == -1 || r == 0) {
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+			free(req);
+			errno = ECOMM;
+			return NULL;
+		}
+	}
+
 	return req;
 }
 
@@ -1156,7 +2023,7 @@ int rejected_task_handler(storage_t* storage,
 		0));
 
 	// rispondo al client comunicando che il server è momentaneamente non disponibile
-	if (send_response_code(client_fd, TEMPORARILY_UNAVAILABLE) == -1) {
+	if (send_response_code(storage, client_fd, req->id, TEMPORARILY_UNAVAILABLE) == -1) {
 		close_client_connection(storage, master_fd, client_fd, MASTER_ID);
 		disconnected = 1;
 	}
@@ -1173,6 +2040,7 @@ int open_file_handler(storage_t* storage,
 						int master_fd, 
 						int client_fd, 
 						int worker_id, 
+						int req_id, 
 						char* file_path, 
 						request_code_t mode) {
 	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0 ||
@@ -1198,18 +2066,16 @@ int open_file_handler(storage_t* storage,
 			NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 				worker_id, req_code_to_str(mode), resp_code_to_str(FILE_ALREADY_EXISTS), client_fd, file_path, 0));
-			/* rispondo al client che il file già esiste e comunico al master di aver servito il client
+			/* rispondo al client che il file già esiste
 			   (in caso di errore chiudo la connessione del client) */
-			if (send_response_code(client_fd, FILE_ALREADY_EXISTS) == -1)
+			if (send_response_code(storage, client_fd, req_id, FILE_ALREADY_EXISTS) == -1)
 				close_client_connection(storage, master_fd, client_fd, worker_id);
-			else
-				EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 			free(file_path);
 			return 0;
 		}
 
 		// se necessario espello un file
-		if (storage->curr_file_num == storage->max_files) {
+		if (storage->curr_file_num >= storage->max_files) {
 			/* rilascio la lock sulla tabella hash ma mantengo la lock sullo storage
 			   (per cui non potrà essere creato un file con lo stesso nome) */
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
@@ -1227,12 +2093,9 @@ int open_file_handler(storage_t* storage,
 				LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 					worker_id, req_code_to_str(mode), resp_code_to_str(COULD_NOT_EVICT), client_fd, file_path, 0));
 				/* rispondo al client che non è stato possibile espellere file
-				   e comunico al master di aver servito il client
 				   (in caso di errore chiudo la connessione del client) */
-				if (send_response_code(client_fd, COULD_NOT_EVICT) == -1)
+				if (send_response_code(storage, client_fd, req_id, COULD_NOT_EVICT) == -1)
 					close_client_connection(storage, master_fd, client_fd, worker_id);
-				else
-					EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 				free(file_path);
 				return 0;
 			}
@@ -1253,10 +2116,14 @@ int open_file_handler(storage_t* storage,
 		EQNULL_DO(init_file(file_path), file, EXTF);
 		EQM1_DO(conc_hasht_insert(storage->files_ht, file_path, file), r, EXTF);
 		EQM1_DO(list_tail_insert(storage->files_queue, file), r, EXTF);
+		file->seq = ++(storage->last_file_seq);
 		
 		if (mode == OPEN_CREATE_LOCK)
 			file->can_write_fd = client_fd;
 
+		// assegno la versione al file
+		file->version = ++(storage->last_file_version);
+
 		(storage->curr_file_num) ++;
 
 		if (storage->curr_file_num > storage->max_files_stored)
@@ -1278,12 +2145,10 @@ int open_file_handler(storage_t* storage,
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 				worker_id, req_code_to_str(mode), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-			/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+			/* rispondo al client che il file non esiste
 			   (in caso di errore chiudo la connessione del client) */
-			if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+			if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
 				close_client_connection(storage, master_fd, client_fd, worker_id);
-			else
-				EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 			free(file_path);
 			return 0;
 		}
@@ -1294,17 +2159,35 @@ int open_file_handler(storage_t* storage,
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 				worker_id, req_code_to_str(mode), resp_code_to_str(FILE_ALREADY_OPEN), client_fd, file_path, 0));
-			/* rispondo al client che il file è già stato aperto e comunico al master di aver servito il client
+			/* rispondo al client che il file è già stato aperto
 			   (in caso di errore chiudo la connessione del client) */
-			if (send_response_code(client_fd, FILE_ALREADY_OPEN) == -1)
+			if (send_response_code(storage, client_fd, req_id, FILE_ALREADY_OPEN) == -1)
 				close_client_connection(storage, master_fd, client_fd, worker_id);
-			else
-				EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 			free(file_path);
 			return 0;
 		}
 	}
 
+	// recupero il client richiedente
+	client_t* client;
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	if (client == NULL) {
+		// il client si è disconnesso mentre la richiesta era in corso, non gli rispondo
+		if (file->can_write_fd == client_fd)
+			file->can_write_fd = -1;
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		if (evicted_file != NULL) {
+			// notifico ai client in attesa di acquisire la lock sul file rimosso che il file espulso non esiste
+			notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_locks, worker_id);
+			destroy_evicted_file(evicted_file);
+		}
+		if (mode == OPEN_NO_FLAGS || mode == OPEN_LOCK)
+			free(file_path);
+		return 0;
+	}
+
 	// aggiorno i metadati del file necessari per il caching
 	update_file_usage_counter(file, mode, storage->eviction_policy);
 	update_file_usage_time(file, mode, storage->eviction_policy);
@@ -1312,11 +2195,6 @@ int open_file_handler(storage_t* storage,
 	// inserisco il client tra coloro che hanno aperto il file
 	EQM1_DO(int_list_tail_insert(file->open_by_fds, client_fd), r, EXTF);
 
-	// recupero il client richiedente
-	client_t* client;
-	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
-	EQNULL_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
-
 	// inserisco il file tra quelli aperti dal client
 	EQM1_DO(list_tail_insert(client->opened_files, file), r, EXTF);
 
@@ -1328,15 +2206,19 @@ int open_file_handler(storage_t* storage,
 			EQM1_DO(list_tail_insert(client->locked_files, file), r, EXTF);
 		}
 		else {
-			// il file è già bloccato, inserisco il client che ha fatto richiesta nella lista di attesa
-			EQM1_DO(int_list_tail_insert(file->pending_lock_fds, client_fd), r, EXTF);
+			// il file è già bloccato, inserisco la richiesta nella lista di attesa (le verrà risposto in seguito)
+			pending_lock_t* pending_lock = NULL;
+			EQNULL_DO(init_pending_lock(client_fd, req_id), pending_lock, EXTF);
+			EQM1_DO(list_tail_insert(file->pending_locks, pending_lock), r, EXTF);
 			EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 				worker_id, req_code_to_str(mode), CLIENT_IS_WAITING, client_fd, file_path, 0));
+			// notifico l'eventuale espulsione ai client che hanno in cache il file espulso
+			push_invalidations(storage);
 			if (evicted_file != NULL) {
 				// notifico ai client in attesa di acquisire la lock sul file rimosso che il file espulso non esiste
-				notify_clients_file_not_exists(storage, file_path, master_fd, evicted_file->pending_lock_fds, worker_id);
+				notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_locks, worker_id);
 				destroy_evicted_file(evicted_file);
 			}
 			free(file_path);
@@ -1345,6 +2227,11 @@ int open_file_handler(storage_t* storage,
 	}
 
 	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+
+	// se il client ha acquisito la lock gli altri client non possono più utilizzare le copie del file in cache
+	if (mode == OPEN_LOCK || mode == OPEN_CREATE_LOCK)
+		invalidate_cached_file(storage, file, client_fd);
+
 	EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 
 	if (mode == OPEN_LOCK || mode == OPEN_NO_FLAGS) { // in caso di CREATE il logging è già stato effettuato
@@ -1352,16 +2239,17 @@ int open_file_handler(storage_t* storage,
 			worker_id, req_code_to_str(mode), resp_code_to_str(OK), client_fd, file_path, 0));
 	}
 
-	/* invio l'esito positivo al client e comunico al master di aver servito il client
+	// notifico l'eventuale espulsione e l'acquisizione della lock ai client che hanno in cache i file
+	push_invalidations(storage);
+
+	/* invio l'esito positivo al client
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1)
+	if (send_response_code(storage, client_fd, req_id, OK) == -1)
 		close_client_connection(storage, master_fd, client_fd, worker_id);
-	else
-		EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 
 	if (evicted_file != NULL) {
 		// notifico ai client in attesa di acquisire la lock sul file rimosso che il file espulso non esiste
-		notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_lock_fds, worker_id);
+		notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_locks, worker_id);
 		destroy_evicted_file(evicted_file);
 	}
 
@@ -1375,12 +2263,14 @@ int write_file_handler(storage_t* storage,
 						int master_fd,
 						int client_fd,
 						int worker_id, 
+						int req_id, 
 						char* file_path, 
 						void* content, 
 						size_t content_size, 
+						size_t offset, 
 						request_code_t mode) {
 	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0 ||
-		(mode != WRITE && mode != APPEND))
+		(mode != WRITE && mode != APPEND && mode != OPEN_WRITE_CLOSE && mode != WRITE_AT))
 		return -1;
 
 	int r;
@@ -1392,18 +2282,31 @@ int write_file_handler(storage_t* storage,
 	EQM1_DO(conc_hasht_lock(storage->files_ht, file_path), r, EXTF);
 	ERRNOSET_DO(conc_hasht_get_value(storage->files_ht, file_path), file, EXTF);
 
-	// controllo se il file esiste
-	if (file == NULL) {
+	// controllo se il file esiste
+	if (file == NULL && mode != OPEN_WRITE_CLOSE) {
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
+			worker_id, req_code_to_str(mode), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
+		/* rispondo al client che il file non esiste
+		   (in caso di errore chiudo la connessione del client) */
+		if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+		free(file_path);
+		free(content);
+		return 0;
+	}
+
+	// controllo, in caso di OPEN_WRITE_CLOSE, che il file non esista
+	if (file != NULL && mode == OPEN_WRITE_CLOSE) {
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
-			worker_id, req_code_to_str(mode), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-		/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+			worker_id, req_code_to_str(mode), resp_code_to_str(FILE_ALREADY_EXISTS), client_fd, file_path, 0));
+		/* rispondo al client che il file già esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+		if (send_response_code(storage, client_fd, req_id, FILE_ALREADY_EXISTS) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		free(content);
 		return 0;
@@ -1415,49 +2318,63 @@ int write_file_handler(storage_t* storage,
 		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 			worker_id, req_code_to_str(mode), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		free(content);
 		return 0;
 	}
 
-	if (mode == APPEND) {
-		// in caso di append controllo se il client ha aperto il file e se il file è bloccato da un altro client
+	if (mode == APPEND || mode == WRITE_AT) {
+		// in caso di append o write_at controllo se il client ha aperto il file e se il file è bloccato da un altro client
 		EQM1_DO(int_list_contains(file->open_by_fds, client_fd), r, EXTF);
 		if (!r || (file->locked_by_fd != -1 && file->locked_by_fd != client_fd)) {
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 			NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 				worker_id, req_code_to_str(mode), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-			/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+			/* rispondo al client che l'operazione non è consentita
 			(in caso di errore chiudo la connessione del client) */
-			if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+			if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 				close_client_connection(storage, master_fd, client_fd, worker_id);
-			else
-				EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 			free(file_path);
 			free(content);
 			return 0;
 		}
 	}
 
+	// controllo, in caso di write_at, che l'offset non superi la size del file
+	if (mode == WRITE_AT && offset > file->content_size) {
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
+			worker_id, req_code_to_str(mode), resp_code_to_str(INVALID_OFFSET), client_fd, file_path, 0));
+		/* rispondo al client che l'offset non è valido
+		   (in caso di errore chiudo la connessione del client) */
+		if (send_response_code(storage, client_fd, req_id, INVALID_OFFSET) == -1)
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+		free(file_path);
+		free(content);
+		return 0;
+	}
+
+	// bytes di cui aumenta la size del file (in caso di write_at solo la parte che eccede la size attuale)
+	size_t added_size = content_size;
+	if (mode == WRITE_AT)
+		added_size = (offset + content_size > file->content_size) ? offset + content_size - file->content_size : 0;
+
 	// controllo se la dimensione del file a seguito dell'operazione è maggiore della capacità in bytes dello storage
-	if (file->content_size + content_size > storage->max_bytes) {
+	if ((file ? file->content_size : 0) + added_size > storage->max_bytes) {
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 			worker_id, req_code_to_str(mode), resp_code_to_str(TOO_LONG_CONTENT), client_fd, file_path, 0));
-		/* rispondo al client che il contenuto del file è troppo grande e comunico al master di aver servito il client
+		/* rispondo al client che il contenuto del file è troppo grande
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, TOO_LONG_CONTENT) == -1)
+		if (send_response_code(storage, client_fd, req_id, TOO_LONG_CONTENT) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		free(content);
 		return 0;
@@ -1468,27 +2385,32 @@ int write_file_handler(storage_t* storage,
 	EQNULL_DO(list_create(cmp_evicted_file,(void (*)(void*)) destroy_evicted_file), evicted_files, EXTF);
 	int evicted_files_num = 0;
 
+	// flag che indica se, in caso di OPEN_WRITE_CLOSE, è necessario espellere un file per poter creare il file
+	bool no_file_slot = (mode == OPEN_WRITE_CLOSE && storage->curr_file_num >= storage->max_files);
+
 	// se necessario espello dei file
-	if (storage->curr_bytes + content_size > storage->max_bytes) {
+	if (storage->curr_bytes + added_size > storage->max_bytes || no_file_slot) {
 		/* rilascio la lock sulla tabella hash di files ma mantengo la lock sullo storage
 		   (per cui l'operazione rimane serializzata) */
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 	}
 
-	while (storage->curr_bytes + content_size > storage->max_bytes) {
-		// invoco l'algoritmo di sostituzione
-		evicted_file_t* evicted_file = evict_file(storage, file_path);
+	while (storage->curr_bytes + added_size > storage->max_bytes || no_file_slot) {
+		/* invoco l'algoritmo di sostituzione
+		   (se è necessario solo liberare il posto per il nuovo file può essere espulso un file qualsiasi) */
+		evicted_file_t* evicted_file = evict_file(storage, 
+			storage->curr_bytes + added_size > storage->max_bytes ? file_path : NULL);
 		// controllo se è stato possibile espellere il file
 		if (evicted_file == NULL) {
 			NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 			LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 				worker_id, req_code_to_str(mode), resp_code_to_str(COULD_NOT_EVICT), client_fd, file_path, 0));
-			/* rispondo al client che non è stato possibile espellere file e comunico al master di aver servito il client
+			// notifico le espulsioni già effettuate ai client che hanno in cache i file espulsi
+			push_invalidations(storage);
+			/* rispondo al client che non è stato possibile espellere file
 			   (in caso di errore chiudo la connessione del client) */
-			if (send_response_code(client_fd, COULD_NOT_EVICT) == -1)
+			if (send_response_code(storage, client_fd, req_id, COULD_NOT_EVICT) == -1)
 				close_client_connection(storage, master_fd, client_fd, worker_id);
-			else
-				EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 			list_destroy(evicted_files, LIST_FREE_DATA);
 			free(file_path);
 			free(content);
@@ -1507,40 +2429,79 @@ int write_file_handler(storage_t* storage,
 			storage->curr_bytes));
 		
 		evicted_files_num ++;
+		no_file_slot = false;
 	}
 
 	if (evicted_files_num > 0)
 		EQM1_DO(conc_hasht_lock(storage->files_ht, file_path), r, EXTF);
 
+	if (mode == OPEN_WRITE_CLOSE) {
+		// creo il file e lo aggiungo allo storage
+		EQNULL_DO(init_file(file_path), file, EXTF);
+		EQM1_DO(conc_hasht_insert(storage->files_ht, file_path, file), r, EXTF);
+		EQM1_DO(list_tail_insert(storage->files_queue, file), r, EXTF);
+		file->seq = ++(storage->last_file_seq);
+
+		(storage->curr_file_num) ++;
+
+		if (storage->curr_file_num > storage->max_files_stored)
+			storage->max_files_stored = storage->curr_file_num;
+	}
+
+	// aggiorno la versione del file
+	file->version = ++(storage->last_file_version);
+
+	// notifico la modifica del file ai client che lo hanno in cache (prima di rispondere al client che l'ha modificato)
+	invalidate_cached_file(storage, file, -1);
+
 	// aggiorno i dati dello storage
-	storage->curr_bytes += content_size;
+	storage->curr_bytes += added_size;
 	if (storage->curr_bytes > storage->max_bytes_stored)
 		storage->max_bytes_stored = storage->curr_bytes;
 
 	LOG(log_record(storage->logger, 
-		"%d,%s,%s,%d,%s,%d,,%zu",
+		"%d,%s,%s,%d,%s,%d,%zu,%zu",
 		worker_id, 
 		req_code_to_str(mode), 
 		resp_code_to_str(OK), 
 		client_fd, 
 		file_path, 
 		content_size, 
+		storage->curr_file_num, 
 		storage->curr_bytes));
 
 	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 
 	if (content_size != 0) {
-		// aggiorno il contenuto e la size del file
-		if (mode == WRITE) {
+		// aggiorno il contenuto, la size e il checksum del file
+		if (mode == WRITE || mode == OPEN_WRITE_CLOSE) {
 			file->content = content;
 			file->content_size = content_size;
+			file->checksum = crc32c(0, content, content_size);
 		}
-		else {
+		else if (mode == APPEND) {
 			EQNULL_DO(realloc(file->content, file->content_size + content_size), file->content, EXTF);
 			memcpy(file->content + file->content_size, content, content_size);
 			file->content_size += content_size;
+			// il checksum viene aggiornato incrementalmente con i soli bytes aggiunti
+			file->checksum = crc32c(file->checksum, content, content_size);
 			free(content);
 		}
+		else {
+			// in caso di write_at estendo il file solo se necessario
+			size_t old_size = file->content_size;
+			if (added_size != 0) {
+				EQNULL_DO(realloc(file->content, file->content_size + added_size), file->content, EXTF);
+				file->content_size += added_size;
+			}
+			memcpy(file->content + offset, content, content_size);
+			free(content);
+			// se la scrittura è in coda al file aggiorno il checksum incrementalmente, altrimenti lo ricalcolo
+			if (offset == old_size)
+				file->checksum = crc32c(file->checksum, (char*) file->content + offset, content_size);
+			else
+				file->checksum = crc32c(0, file->content, file->content_size);
+		}
 		// elimino la possibilità del client di effettuare una write sul file
 		file->can_write_fd = -1;
 	}
@@ -1551,44 +2512,40 @@ int write_file_handler(storage_t* storage,
 	
 	EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 
-	/* invio l'esito positivo al client
-	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1) {
-		close_client_connection(storage, master_fd, client_fd, worker_id);
-		goto write_exit;
-	}
+	// notifico la modifica e le eventuali espulsioni ai client che hanno in cache i file
+	push_invalidations(storage);
 
-	/* invio al client il numero di file espulsi
+	/* invio al client l'esito positivo, il numero di file espulsi e i file espulsi
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_size(client_fd, evicted_files_num) == -1) {
-		close_client_connection(storage, master_fd, client_fd, worker_id);
-		goto write_exit;
-	}
-
+	int err = 0;
 	evicted_file_t* evicted_file;
-	// invio al client i file espulsi
-	for (int i = 0; i < evicted_files_num; i ++) {
-		EQNULL_DO(list_head_remove(evicted_files), evicted_file, EXTF);
-		// notifico ai client in attesa di acquisire la lock sul file rimosso che il file espulso non esiste
-		notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_lock_fds, worker_id);
-		// invio il nome del file
-		if (send_file_name(client_fd, evicted_file->path_size, evicted_file->path) == -1) {
-			close_client_connection(storage, master_fd, client_fd, worker_id);
-			goto write_exit;
-		}
-		// invio il contenuto del file
-		if (send_file_content(client_fd, evicted_file->content_size, evicted_file->content) == -1) {
-			close_client_connection(storage, master_fd, client_fd, worker_id);
-			goto write_exit;
+	client_t* client = begin_response(storage, client_fd, req_id, OK);
+	if (client == NULL)
+		err = 1;
+	if (!err) {
+		if (send_size(client_fd, evicted_files_num) == -1)
+			err = 1;
+		list_for_each(evicted_files, evicted_file) {
+			if (err)
+				break;
+			// invio il nome e il contenuto del file
+			if (send_file_name(client_fd, evicted_file->path_size, evicted_file->path) == -1 ||
+				send_file_content(storage, client_fd, evicted_file->content_size, evicted_file->content) == -1)
+				err = 1;
 		}
-		destroy_evicted_file(evicted_file);
+		end_response(storage, client);
 	}
+	if (err)
+		close_client_connection(storage, master_fd, client_fd, worker_id);
 
-	// comunico al master di aver servito il client
-	EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
+	// notifico ai client in attesa di acquisire la lock sui file espulsi che i file non esistono
+	list_for_each(evicted_files, evicted_file) {
+		notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_locks, worker_id);
+	}
 
-write_exit:
-	free(file_path);
+	// in caso di OPEN_WRITE_CLOSE il path è stato assegnato al file creato
+	if (mode != OPEN_WRITE_CLOSE)
+		free(file_path);
 	list_destroy(evicted_files, LIST_FREE_DATA);
 	return 0;
 }
@@ -1597,8 +2554,14 @@ int read_file_handler(storage_t* storage,
 						int master_fd,
 						int client_fd,
 						int worker_id,
-						char* file_path) {
-	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0)
+						int req_id,
+						char* file_path,
+						size_t offset,
+						size_t length,
+						size_t version,
+						request_code_t mode) {
+	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0 ||
+		(mode != READ && mode != OPEN_READ_CLOSE && mode != READ_RANGE && mode != READ_IF_NEWER))
 		return -1;
 	
 	int r;
@@ -1612,29 +2575,27 @@ int read_file_handler(storage_t* storage,
 	if (file == NULL) {
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
-			worker_id, req_code_to_str(READ), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-		/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+			worker_id, req_code_to_str(mode), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
+		/* rispondo al client che il file non esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+		if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
 
-	// controllo se il client ha aperto il file
-	EQM1_DO(int_list_contains(file->open_by_fds, client_fd), r, EXTF);
+	// controllo, in caso di READ, READ_RANGE o READ_IF_NEWER, se il client ha aperto il file
+	r = 1;
+	if (mode != OPEN_READ_CLOSE)
+		EQM1_DO(int_list_contains(file->open_by_fds, client_fd), r, EXTF);
 	if (!r) {
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
-			worker_id, req_code_to_str(READ), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+			worker_id, req_code_to_str(mode), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -1643,47 +2604,91 @@ int read_file_handler(storage_t* storage,
 	if (file->locked_by_fd != -1 && file->locked_by_fd != client_fd) {
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
-			worker_id, req_code_to_str(READ), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+			worker_id, req_code_to_str(mode), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
+		/* rispondo al client che l'operazione non è consentita
+		   (in caso di errore chiudo la connessione del client) */
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+		free(file_path);
+		return 0;
+	}
+
+	if (mode != READ_RANGE) {
+		// viene letto l'intero file
+		offset = 0;
+		length = file->content_size;
+	}
+	// controllo che l'offset non superi la size del file
+	else if (offset > file->content_size) {
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
+			worker_id, req_code_to_str(mode), resp_code_to_str(INVALID_OFFSET), client_fd, file_path, 0));
+		/* rispondo al client che l'offset non è valido
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, INVALID_OFFSET) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
+	// limito i bytes da leggere a quelli presenti nel file a partire da offset
+	if (length > file->content_size - offset)
+		length = file->content_size - offset;
 
 	// aggiorno i metadati del file necessari per il caching
-	update_file_usage_counter(file, READ, storage->eviction_policy);
-	update_file_usage_time(file, READ, storage->eviction_policy);
+	update_file_usage_counter(file, mode, storage->eviction_policy);
+	update_file_usage_time(file, mode, storage->eviction_policy);
+
+	/* controllo se il client possiede già la versione corrente del file (in caso di READ e OPEN_READ_CLOSE la versione 
+	   è diversa da 0 solo se il client ha il file in cache) */
+	if ((mode == READ_IF_NEWER || (mode != READ_RANGE && version != 0)) && version == file->version) {
+		// registro, se la connessione lo prevede, che la copia in cache del client è stata verificata
+		register_cached_file(storage, file, client_fd);
+		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
+			worker_id, req_code_to_str(mode), resp_code_to_str(NOT_MODIFIED), client_fd, file_path, 0));
+		/* rispondo al client che il file non è stato modificato, mantenendo la lock sul file così che una notifica di 
+		   invalidazione non possa precedere la risposta (in caso di errore chiudo la connessione del client) */
+		int err = send_response_code(storage, client_fd, req_id, NOT_MODIFIED);
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		if (err == -1)
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+		free(file_path);
+		return 0;
+	}
+
+	// registro, se la connessione lo prevede, che il client avrà in cache il contenuto dell'intero file
+	bool send_version = mode == READ_IF_NEWER;
+	if (mode != READ_RANGE && register_cached_file(storage, file, client_fd))
+		send_version = true;
 
 	LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%zu",
-		worker_id, req_code_to_str(READ), resp_code_to_str(OK), client_fd, file_path, file->content_size));
+		worker_id, req_code_to_str(mode), resp_code_to_str(OK), client_fd, file_path, length));
 
 	/* invio l'esito positivo al client
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1) {
+	client_t* client = begin_response(storage, client_fd, req_id, OK);
+	if (client == NULL) {
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		close_client_connection(storage, master_fd, client_fd, worker_id);
 		free(file_path);
 		return 0;
 	}
 	
-	/* invio il contenuto del file al client
-	   (in caso di errore chiudo la connessione del client) */
-	if (send_file_content(client_fd, file->content_size, file->content) == -1) {
+	/* invio, in caso di READ_IF_NEWER o se la connessione ha la capacità CAP_INVALIDATION, la versione del file, il 
+	   contenuto del file e, se non si tratta di READ_RANGE, il suo checksum al client (in caso di errore chiudo la 
+	   connessione del client) */
+	if ((send_version && send_size(client_fd, file->version) == -1) ||
+		send_file_content(storage, client_fd, length, (char*) file->content + offset) == -1 ||
+		(mode != READ_RANGE && send_file_checksum(storage, client_fd, file->checksum) == -1)) {
+		end_response(storage, client);
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		close_client_connection(storage, master_fd, client_fd, worker_id);
 		free(file_path);
 		return 0;
 	}
+	end_response(storage, client);
 
 	EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 
-	// comunico al master di aver servito il client
-	EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
-
 	free(file_path);
 	return 0;
 }
@@ -1692,12 +2697,22 @@ int readn_file_handler(storage_t* storage,
 						int master_fd, 
 						int client_fd, 
 						int worker_id, 
-						int n) {
-	if (storage == NULL || master_fd < 0 || client_fd < 0)
+						int req_id, 
+						int n,
+						size_t cursor,
+						size_t max_bytes,
+						request_code_t mode) {
+	if (storage == NULL || master_fd < 0 || client_fd < 0 || (mode != READN && mode != READN_CURSOR))
 		return -1;
 	
 	int r;
 
+	// la READN considera tutti i file senza limiti sui bytes
+	if (mode == READN) {
+		cursor = 0;
+		max_bytes = 0;
+	}
+
 	NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
 
 	int file_to_send = n;
@@ -1706,31 +2721,51 @@ int readn_file_handler(storage_t* storage,
 
 	list_t* files_to_read;
 	size_t file_sendable = 0;
+	size_t bytes_to_send = 0;
+	// cursore da cui il client potrà riprendere la scansione (0 se non ci sono altri file da visitare)
+	size_t next_cursor = 0;
+	size_t last_seq = cursor;
 	
 	// creo una lista per memorizzare i file che possono essere letti al client
 	EQNULL_DO(list_create(cmp_file, (void (*)(void*)) destroy_file), files_to_read, EXTF);
 
 	file_t* file;
 	list_for_each(storage->files_queue, file) {
-		if (file_sendable == file_to_send)
+		// salto i file già visitati nei batch precedenti (la coda è ordinata per numero d'ordine di inserimento)
+		if (file->seq <= cursor)
+			continue;
+		// termino il batch se ho raggiunto il numero di file o, avendo già un file da inviare, il numero di bytes
+		if (file_sendable == file_to_send ||
+			(max_bytes != 0 && file_sendable != 0 && bytes_to_send + file->content_size > max_bytes)) {
+			next_cursor = last_seq;
 			break;
+		}
 		// conto i file che possono essere inviati acquisendo la lock sulla tabella hash e li memorizzo nella lista
 		EQM1_DO(conc_hasht_lock(storage->files_ht, file->path), r, EXTF);
 		if (file->locked_by_fd == client_fd || file->locked_by_fd == -1) {
 			file_sendable ++;
+			bytes_to_send += file->content_size;
 			EQM1_DO(list_tail_insert(files_to_read, file), r, EXTF);
 		}
 		else // rilascio la lock sui file che non posso inviare
 			EQM1_DO(conc_hasht_unlock(storage->files_ht, file->path), r, EXTF);
+		last_seq = file->seq;
 	}
 
 	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 
 	// invio l'esito positivo al client
 	int err = 0;
-	if (send_response_code(client_fd, OK) == -1)
+	client_t* client = begin_response(storage, client_fd, req_id, OK);
+	if (client == NULL)
 		err = 1;
 
+	// invio al client, in caso di READN_CURSOR, il cursore per il batch successivo
+	if (!err && mode == READN_CURSOR) {
+		if (send_size(client_fd, next_cursor) == -1)
+			err = 1;
+	}
+
 	// invio al client il numero di file che verranno inviati
 	if (!err) {
 		if (send_size(client_fd, file_sendable) == -1)
@@ -1739,7 +2774,7 @@ int readn_file_handler(storage_t* storage,
 
 	if (file_sendable == 0) {
 		LOG(log_record(storage->logger, "%d,%s 0/0,%s,%d,,%d",
-			worker_id, req_code_to_str(READN), resp_code_to_str(OK), client_fd, 0));
+			worker_id, req_code_to_str(mode), resp_code_to_str(OK), client_fd, 0));
 	}
 
 	int file_sent = 0;
@@ -1752,14 +2787,14 @@ int readn_file_handler(storage_t* storage,
 		}
 		if (!err) {
 			// invio al client il contenuto del file
-			if (send_file_content(client_fd, file->content_size, file->content) == -1)
+			if (send_file_content(storage, client_fd, file->content_size, file->content) == -1)
 				err = 1;
 		}
 		if (!err) {
 			LOG(log_record(storage->logger, 
 				"%d,%s %d/%zu,%s,%d,%s,%zu",
 				worker_id, 
-				req_code_to_str(READN), 
+				req_code_to_str(mode), 
 				file_sent + 1, 
 				file_sendable, 
 				resp_code_to_str(OK), 
@@ -1767,20 +2802,20 @@ int readn_file_handler(storage_t* storage,
 				file->content_size));
 
 			// aggiorno i metadati del file necessari per il caching
-			update_file_usage_counter(file, READN, storage->eviction_policy);
-			update_file_usage_time(file, READN, storage->eviction_policy);
+			update_file_usage_counter(file, mode, storage->eviction_policy);
+			update_file_usage_time(file, mode, storage->eviction_policy);
 
 			file_sent ++;
 		}
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file->path), r, EXTF);
 	}
 
-	/* se si è verificato un errore chiudo la connessione del client
-	   altrimenti comunico al master di aver servito il client */
+	if (client != NULL)
+		end_response(storage, client);
+
+	// se si è verificato un errore chiudo la connessione del client
 	if (err)
 		close_client_connection(storage, master_fd, client_fd, worker_id);
-	else
-		EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 
 	list_destroy(files_to_read, LIST_DO_NOT_FREE_DATA);
 	return 0;
@@ -1790,6 +2825,7 @@ int lock_file_handler(storage_t* storage,
 						int master_fd, 
 						int client_fd, 
 						int worker_id, 
+						int req_id, 
 						char* file_path) {
 	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0)
 		return -1;
@@ -1806,12 +2842,10 @@ int lock_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 			worker_id, req_code_to_str(LOCK), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-		/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+		/* rispondo al client che il file non esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+		if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -1822,12 +2856,10 @@ int lock_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 			worker_id, req_code_to_str(LOCK), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -1837,12 +2869,25 @@ int lock_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 			worker_id, req_code_to_str(LOCK), resp_code_to_str(FILE_ALREADY_LOCKED), client_fd, file_path, 0));
-		/* rispondo al client che ha già acquisito la lock e comunico al master di aver servito il client
+		/* rispondo al client che ha già acquisito la lock
+		   (in caso di errore chiudo la connessione del client) */
+		if (send_response_code(storage, client_fd, req_id, FILE_ALREADY_LOCKED) == -1)
+			close_client_connection(storage, master_fd, client_fd, worker_id);
+		free(file_path);
+		return 0;
+	}
+
+	// controllo se il client è già in attesa di acquisire la lock (con una richiesta precedente)
+	pending_lock_t key = { client_fd, NO_REQ_ID };
+	EQM1_DO(list_contains(file->pending_locks, &key), r, EXTF);
+	if (r) {
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
+			worker_id, req_code_to_str(LOCK), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_ALREADY_LOCKED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -1853,8 +2898,10 @@ int lock_file_handler(storage_t* storage,
 
 	// controllo se il file è bloccato da un altro client
 	if (file->locked_by_fd != -1) {
-		// inserisco il client che ne ha fatto richiesta nella lista di attesa
-		EQM1_DO(int_list_tail_insert(file->pending_lock_fds, client_fd), r, EXTF);
+		// inserisco la richiesta nella lista di attesa (le verrà risposto quando il client acquisirà la lock)
+		pending_lock_t* pending_lock = NULL;
+		EQNULL_DO(init_pending_lock(client_fd, req_id), pending_lock, EXTF);
+		EQM1_DO(list_tail_insert(file->pending_locks, pending_lock), r, EXTF);
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 			worker_id, req_code_to_str(LOCK), CLIENT_IS_WAITING, client_fd, file_path, 0));
@@ -1862,27 +2909,37 @@ int lock_file_handler(storage_t* storage,
 		return 0;
 	}
 
-	file->locked_by_fd = client_fd;
-
 	// recupero il client richiedente
 	client_t* client;
 	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
-	EQNULL_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	if (client == NULL) {
+		// il client si è disconnesso mentre la richiesta era in corso, non gli rispondo
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		free(file_path);
+		return 0;
+	}
+	file->locked_by_fd = client_fd;
 	// inserisco il file nella lista di file bloccati dal client
 	EQM1_DO(list_tail_insert(client->locked_files, file), r, EXTF);
 	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
 
+	// gli altri client non possono più leggere il file, le loro copie in cache non possono più essere utilizzate
+	invalidate_cached_file(storage, file, client_fd);
+
 	EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 
 	LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 		worker_id, req_code_to_str(LOCK), resp_code_to_str(OK), client_fd, file_path, 0));
 
-	/* invio l'esito positivo al client e comunico al master di aver servito il client
+	// notifico l'acquisizione della lock ai client che hanno in cache il file
+	push_invalidations(storage);
+
+	/* invio l'esito positivo al client
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1)
+	if (send_response_code(storage, client_fd, req_id, OK) == -1)
 		close_client_connection(storage, master_fd, client_fd, worker_id);
-	else
-		EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 	
 	free(file_path);
 	return 0;
@@ -1892,6 +2949,7 @@ int unlock_file_handler(storage_t* storage,
 						int master_fd, 
 						int client_fd, 
 						int worker_id, 
+						int req_id, 
 						char* file_path) {
 	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0)
 		return -1;
@@ -1908,12 +2966,10 @@ int unlock_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 			worker_id, req_code_to_str(UNLOCK), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-		/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+		/* rispondo al client che il file non esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+		if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -1923,12 +2979,10 @@ int unlock_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 			worker_id, req_code_to_str(UNLOCK), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -1937,7 +2991,15 @@ int unlock_file_handler(storage_t* storage,
 	client_t* client;
 	file_t* not_used;
 	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
-	EQNULL_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	if (client == NULL) {
+		/* il client si è disconnesso mentre la richiesta era in corso (la lock sul file è stata già rilasciata alla 
+		   disconnessione), non gli rispondo */
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		free(file_path);
+		return 0;
+	}
 	// rimuovo il file dalla lista di file bloccati dal client
 	EQNULL_DO(list_remove_and_get(client->locked_files, file), not_used, EXTF);
 	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
@@ -1946,7 +3008,7 @@ int unlock_file_handler(storage_t* storage,
 		worker_id, req_code_to_str(UNLOCK), resp_code_to_str(OK), client_fd, file_path, 0));
 
 	// passo la lock sul file a un eventuale client in attesa
-	int fd = give_lock_to_waiting_client(storage, file, worker_id, master_fd);
+	pending_lock_t* granted = give_lock_to_waiting_client(storage, file, worker_id);
 
 	// elimino la possibilità del client di effettuare una write sul file
 	if (file->can_write_fd == client_fd)
@@ -1957,13 +3019,14 @@ int unlock_file_handler(storage_t* storage,
 	update_file_usage_time(file, UNLOCK, storage->eviction_policy);
 
 	EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+
+	// rispondo all'eventuale client a cui è stata passata la lock
+	int fd = send_lock_granted(storage, granted);
 	
-	/* invio l'esito positivo al client e comunico al master di aver servito il client
+	/* invio l'esito positivo al client
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1)
+	if (send_response_code(storage, client_fd, req_id, OK) == -1)
 		close_client_connection(storage, master_fd, client_fd, worker_id);
-	else
-		EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 
 	// se nel contattare il client in attesa della lock ho riscontrato che si è disconnesso chiudo la connessione
 	if (fd != -1)
@@ -1977,6 +3040,7 @@ int remove_file_handler(storage_t* storage,
 						int master_fd, 
 						int client_fd, 
 						int worker_id, 
+						int req_id, 
 						char* file_path) {
 	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0)
 		return -1;
@@ -1996,12 +3060,10 @@ int remove_file_handler(storage_t* storage,
 		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 			worker_id, req_code_to_str(REMOVE), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-		/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+		/* rispondo al client che il file non esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+		if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -2012,19 +3074,17 @@ int remove_file_handler(storage_t* storage,
 		NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d",
 			worker_id, req_code_to_str(REMOVE), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
 
-	// memorizzo la lista di client in attesa di acquisire la lock sul file per poterli contattare in seguito
-	int_list_t* waiting_clients = file->pending_lock_fds;
-	file->pending_lock_fds = NULL;
+	// memorizzo la lista di richieste di lock in attesa sul file per poter rispondere in seguito
+	list_t* pending_locks = file->pending_locks;
+	file->pending_locks = NULL;
 	// memorizzo la size del file per effettuare il logging in seguito alla rimozione
 	size_t file_content_size = file->content_size;
 
@@ -2046,17 +3106,18 @@ int remove_file_handler(storage_t* storage,
 
 	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, errno = r; EXTF);
 
-	/* invio l'esito positivo al client e comunico al master di aver servito il client
+	// notifico la rimozione ai client che hanno in cache il file
+	push_invalidations(storage);
+
+	/* invio l'esito positivo al client
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1)
+	if (send_response_code(storage, client_fd, req_id, OK) == -1)
 		close_client_connection(storage, master_fd, client_fd, worker_id);
-	else
-		EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 
 	// notifico ai client in attesa di acquisire la lock sul file rimosso che il file non esiste
-	notify_clients_file_not_exists(storage, file_path, master_fd, waiting_clients, worker_id);
+	notify_clients_file_not_exists(storage, file_path, master_fd, pending_locks, worker_id);
 
-	int_list_destroy(waiting_clients);
+	list_destroy(pending_locks, LIST_FREE_DATA);
 	free(file_path);
 	return 0;
 }
@@ -2065,6 +3126,7 @@ int close_file_handler(storage_t* storage,
 						int master_fd, 
 						int client_fd, 
 						int worker_id, 
+						int req_id, 
 						char* file_path) {
 	if (storage == NULL || master_fd < 0 || client_fd < 0 || file_path == NULL || strlen(file_path) == 0)
 		return -1;
@@ -2081,12 +3143,10 @@ int close_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 			worker_id, req_code_to_str(CLOSE), resp_code_to_str(FILE_NOT_EXISTS), client_fd, file_path, 0));
-		/* rispondo al client che il file non esiste e comunico al master di aver servito il client
+		/* rispondo al client che il file non esiste
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, FILE_NOT_EXISTS) == -1)
+		if (send_response_code(storage, client_fd, req_id, FILE_NOT_EXISTS) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -2098,12 +3158,10 @@ int close_file_handler(storage_t* storage,
 		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 		LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
 			worker_id, req_code_to_str(CLOSE), resp_code_to_str(OPERATION_NOT_PERMITTED), client_fd, file_path, 0));
-		/* rispondo al client che l'operazione non è consentita e comunico al master di aver servito il client
+		/* rispondo al client che l'operazione non è consentita
 		   (in caso di errore chiudo la connessione del client) */
-		if (send_response_code(client_fd, OPERATION_NOT_PERMITTED) == -1)
+		if (send_response_code(storage, client_fd, req_id, OPERATION_NOT_PERMITTED) == -1)
 			close_client_connection(storage, master_fd, client_fd, worker_id);
-		else
-			EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 		free(file_path);
 		return 0;
 	}
@@ -2112,7 +3170,15 @@ int close_file_handler(storage_t* storage,
 	client_t* client;
 	file_t* not_used;
 	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
-	EQNULL_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	if (client == NULL) {
+		/* il client si è disconnesso mentre la richiesta era in corso (il file è stato già chiuso alla 
+		   disconnessione), non gli rispondo */
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
+		free(file_path);
+		return 0;
+	}
 
 	// rimuovo il file dalla lista di file aperti dal client
 	EQNULL_DO(list_remove_and_get(client->opened_files, file), not_used, EXTF);
@@ -2125,10 +3191,10 @@ int close_file_handler(storage_t* storage,
 	
 	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
 
-	int fd = -1;
+	pending_lock_t* granted = NULL;
 	if (file->locked_by_fd == client_fd) {
 		// passo la lock sul file a un eventuale client in attesa
-		fd = give_lock_to_waiting_client(storage, file, worker_id, master_fd);
+		granted = give_lock_to_waiting_client(storage, file, worker_id);
 	}
 
 	LOG(log_record(storage->logger, "%d,%s,%s,%d,%s,%d", 
@@ -2144,12 +3210,13 @@ int close_file_handler(storage_t* storage,
 
 	EQM1_DO(conc_hasht_unlock(storage->files_ht, file_path), r, EXTF);
 
-	/* invio l'esito positivo al client e comunico al master di aver servito il client
+	// rispondo all'eventuale client a cui è stata passata la lock
+	int fd = send_lock_granted(storage, granted);
+
+	/* invio l'esito positivo al client
 	   (in caso di errore chiudo la connessione del client) */
-	if (send_response_code(client_fd, OK) == -1)
+	if (send_response_code(storage, client_fd, req_id, OK) == -1)
 		close_client_connection(storage, master_fd, client_fd, worker_id);
-	else
-		EQM1_DO(writen(master_fd, &client_fd, sizeof(int)), r, EXTF);
 
 	// se nel contattare il client in attesa della lock ho notato che si è disconnesso chiudo la connessione
 	if (fd != -1)
@@ -2159,6 +3226,184 @@ int close_file_handler(storage_t* storage,
 	return 0;
 }
 
+int negotiate_handler(storage_t* storage, 
+						int master_fd, 
+						int client_fd, 
+						int worker_id, 
+						int req_id, 
+						int capabilities) {
+	if (storage == NULL || master_fd < 0 || client_fd < 0)
+		return -1;
+	
+	int r;
+
+	// accetto le capacità supportate dal server
+	int accepted = capabilities & (CAP_COMPRESSION | CAP_CHECKSUM | CAP_INVALIDATION);
+
+	// aggiorno le capacità della connessione con il client
+	client_t* client;
+	EQM1_DO(conc_hasht_lock(storage->connected_clients, &client_fd), r, EXTF);
+	ERRNOSET_DO(conc_hasht_get_value(storage->connected_clients, &client_fd), client, EXTF);
+	if (client == NULL) {
+		// il client si è disconnesso mentre la richiesta era in corso, non gli rispondo
+		EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+		return 0;
+	}
+	client->capabilities = accepted;
+	EQM1_DO(conc_hasht_unlock(storage->connected_clients, &client_fd), r, EXTF);
+
+	LOG(log_record(storage->logger, "%d,%s,%s,%d,,%d", 
+		worker_id, req_code_to_str(NEGOTIATE), resp_code_to_str(OK), client_fd, 0));
+
+	/* invio l'esito positivo e le capacità accettate al client
+	   (in caso di errore chiudo la connessione del client) */
+	int err = 0;
+	client = begin_response(storage, client_fd, req_id, OK);
+	if (client == NULL)
+		err = 1;
+	else {
+		WRITE_TO_CLIENT(client_fd, &accepted, sizeof(int), r);
+		if (r == -1 || r == 0)
+			err = 1;
+		end_response(storage, client);
+	}
+	if (err)
+		close_client_connection(storage, master_fd, client_fd, worker_id);
+
+	return 0;
+}
+
+int storage_set_capacity(storage_t* storage, size_t max_files, size_t max_bytes) {
+	if (storage == NULL || max_files == 0 || max_bytes == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int r;
+
+	NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
+	// i file in eccesso vengono espulsi gradualmente da storage_evict_excess()
+	storage->max_files = max_files;
+	storage->max_bytes = max_bytes;
+	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+
+	return 0;
+}
+
+int storage_evict_excess(storage_t* storage, int master_fd, int worker_id, size_t max_evictions) {
+	if (storage == NULL || master_fd < 0 || max_evictions == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int r;
+
+	// lista di file espulsi
+	list_t* evicted_files = NULL;
+	EQNULL_DO(list_create(cmp_evicted_file,(void (*)(void*)) destroy_evicted_file), evicted_files, EXTF);
+	int evicted_files_num = 0;
+
+	NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
+	while (evicted_files_num < max_evictions &&
+		(storage->curr_bytes > storage->max_bytes || storage->curr_file_num > storage->max_files)) {
+		// invoco l'algoritmo di sostituzione (può essere espulso un file qualsiasi)
+		evicted_file_t* evicted_file = evict_file(storage, NULL);
+		if (evicted_file == NULL)
+			break;
+		// inserisco nella lista il file espulso
+		EQM1_DO(list_tail_insert(evicted_files, evicted_file), r, EXTF);
+		LOG(log_record(storage->logger, 
+			"%d,%s,%s,,%s,%d,%zu,%zu", 
+			worker_id, 
+			EVICTION, 
+			resp_code_to_str(OK), 
+			evicted_file->path, 
+			evicted_file->content_size, 
+			storage->curr_file_num, 
+			storage->curr_bytes));
+		evicted_files_num ++;
+	}
+	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+
+	// notifico le espulsioni ai client che hanno in cache i file espulsi
+	push_invalidations(storage);
+
+	// notifico ai client in attesa di acquisire la lock sui file espulsi che i file non esistono
+	evicted_file_t* evicted_file;
+	list_for_each(evicted_files, evicted_file) {
+		notify_clients_file_not_exists(storage, evicted_file->path, master_fd, evicted_file->pending_locks, worker_id);
+	}
+	list_destroy(evicted_files, LIST_FREE_DATA);
+
+	return evicted_files_num;
+}
+
+int storage_set_eviction_policy(storage_t* storage, eviction_policy_t policy) {
+	if (storage == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int r;
+
+	NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
+	eviction_policy_t old_policy = storage->eviction_policy;
+	storage->eviction_policy = policy;
+	/* se la politica LW viene abilitata o disabilitata i contatori degli utilizzi dei file memorizzati vanno ricostruiti, 
+	   la ricostruzione viene effettuata a blocchi da storage_rebuild_usage_counters() */
+	if (old_policy != policy && (old_policy == LW || policy == LW))
+		storage->usage_rebuild_node = storage->files_queue->head;
+	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+
+	return 0;
+}
+
+int storage_rebuild_usage_counters(storage_t* storage, size_t max_files) {
+	if (storage == NULL || max_files == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	int r;
+	int rebuilt = 0;
+
+	NEQ0_DO(pthread_mutex_lock(&storage->mutex), r, EXTF);
+	// riprendo la ricostruzione dal file in cui era stata interrotta
+	node_t* node = storage->usage_rebuild_node;
+	while (node != NULL && (size_t) rebuilt < max_files) {
+		file_t* file = node->data;
+		EQM1_DO(conc_hasht_lock(storage->files_ht, file->path), r, EXTF);
+		rebuild_file_usage_counter(file, storage->eviction_policy);
+		EQM1_DO(conc_hasht_unlock(storage->files_ht, file->path), r, EXTF);
+		node = node->next;
+		rebuilt ++;
+	}
+	storage->usage_rebuild_node = node;
+	NEQ0_DO(pthread_mutex_unlock(&storage->mutex), r, EXTF);
+
+	return rebuilt;
+}
+
+int storage_lock_stats(storage_t* storage, size_t* acquisitions, size_t* contentions) {
+	if (storage == NULL || acquisitions == NULL || contentions == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return conc_hasht_lock_stats(storage->files_ht, acquisitions, contentions);
+}
+
+int storage_restripe(storage_t* storage, size_t max_locks) {
+	if (storage == NULL || max_locks == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	// converto il numero di lock come in storage_create()
+	size_t n_segments = max_locks / LOAD_FACTOR;
+	return conc_hasht_restripe(storage->files_ht, n_segments);
+}
+
 int print_statistics(storage_t* storage) {
 	if (storage == NULL)
 		return -1;
@@ -7,10 +7,20 @@
 #include <assert.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 
 #include <threadpool.h>
 #include <util.h>
 
+/**
+ * @function    elapsed_usec
+ * @brief       Ritorna i microsecondi trascorsi da start a end.
+ */
+static uint64_t elapsed_usec(const struct timespec* start, const struct timespec* end) {
+	int64_t usec = (int64_t)(end->tv_sec - start->tv_sec) * 1000000 + (end->tv_nsec - start->tv_nsec) / 1000;
+	return usec > 0 ? (uint64_t) usec : 0;
+}
+
 /**
  * @function    workerpool_thread
  * @brief       Funzione eseguita dal thread worker che appartiene al pool.
@@ -26,8 +36,21 @@ static void *workerpool_thread(void *arguments) {
 	LOCK_DO(&(pool->lock), r, goto workerpool_thread_exit);
 	for (;;) {
 
-		// in attesa di un messaggio, controllo spurious wakeups
-		while ((pool->count == 0) && (!pool->exiting)) {
+		// se il pool è stato ridimensionato escludendo il thread attendo che venga riattivato
+		while (myid > pool->activethreads && !pool->exiting) {
+			// il segnale per un task pendente potrebbe essere stato ricevuto da questo thread, lo inoltro
+			if (pool->count > 0) {
+				SIGNAL(&(pool->cond), r);
+			}
+			WAIT(&(pool->park_cond), &(pool->lock), r);
+			if (r != 0) {
+				UNLOCK_DO(&(pool->lock), r, goto workerpool_thread_exit);
+				goto workerpool_thread_exit;
+			}
+		}
+
+		// in attesa di un messaggio (o della ripresa del pool sospeso), controllo spurious wakeups
+		while ((pool->count == 0 || pool->paused) && (!pool->exiting) && myid <= pool->activethreads) {
 			WAIT(&(pool->cond), &(pool->lock), r);
 			if (r != 0) {
 				UNLOCK_DO(&(pool->lock), r, goto workerpool_thread_exit);
@@ -35,6 +58,9 @@ static void *workerpool_thread(void *arguments) {
 			}
 		}
 
+		if (myid > pool->activethreads && !pool->exiting) // il thread è stato disattivato durante l'attesa
+			continue;
+
 		if (pool->exiting && !pool->count) // termino
 			break; 
 
@@ -47,15 +73,26 @@ static void *workerpool_thread(void *arguments) {
 
 		pool->count--;
 		pool->taskonthefly++;
+		// aggiorno il tempo di attesa in coda dei task
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		pool->wait_usec += elapsed_usec(&taskfun->enqueue_time, &start);
 		UNLOCK_DO(&(pool->lock), r, goto workerpool_thread_exit);
 
 		// eseguo la funzione 
 		(*(taskfun->fun))(taskfun->arg, myid);
 		free(taskfun);
 		taskfun = NULL;
+		clock_gettime(CLOCK_MONOTONIC, &end);
 
 		LOCK_DO(&(pool->lock), r, goto workerpool_thread_exit);
 		pool->taskonthefly--;
+		pool->completed++;
+		pool->busy_usec += elapsed_usec(&start, &end);
+		// se il pool è sospeso e non ci sono più task in esecuzione lo notifico a threadpool_pause()
+		if (pool->paused && pool->taskonthefly == 0) {
+			SIGNAL(&(pool->idle_cond), r);
+		}
 	}
 	UNLOCK_DO(&(pool->lock), r, goto workerpool_thread_exit);
 
@@ -84,6 +121,8 @@ void free_pool_resources(threadpool_t *pool) {
 	free_task_list(pool->lhead);
 	pthread_mutex_destroy(&(pool->lock));
 	pthread_cond_destroy(&(pool->cond));
+	pthread_cond_destroy(&(pool->park_cond));
+	pthread_cond_destroy(&(pool->idle_cond));
 	free(pool);
 }
 
@@ -100,10 +139,15 @@ threadpool_t* threadpool_create(size_t numthreads, size_t pending_size) {
 
 	// condizioni iniziali
 	pool->numthreads   = 0;
+	pool->activethreads = numthreads;
 	pool->taskonthefly = 0;
 	pool->queue_size = pending_size;
 	pool->count = 0;
 	pool->exiting = false;
+	pool->paused = false;
+	pool->completed = 0;
+	pool->wait_usec = 0;
+	pool->busy_usec = 0;
 
 	// alloco i thread
 	pool->threads = malloc(sizeof(pthread_t)*numthreads);
@@ -126,9 +170,30 @@ threadpool_t* threadpool_create(size_t numthreads, size_t pending_size) {
 
 	r = pthread_cond_init(&(pool->cond), NULL);
 	if (r != 0)  {
+		pthread_mutex_destroy(&(pool->lock));
 		free(pool->threads);
 		free(pool);
+		errno = r;
+		return NULL;
+	}
+
+	r = pthread_cond_init(&(pool->park_cond), NULL);
+	if (r != 0)  {
+		pthread_cond_destroy(&(pool->cond));
+		pthread_mutex_destroy(&(pool->lock));
+		free(pool->threads);
+		free(pool);
+		errno = r;
+		return NULL;
+	}
+
+	r = pthread_cond_init(&(pool->idle_cond), NULL);
+	if (r != 0)  {
+		pthread_cond_destroy(&(pool->park_cond));
+		pthread_cond_destroy(&(pool->cond));
 		pthread_mutex_destroy(&(pool->lock));
+		free(pool->threads);
+		free(pool);
 		errno = r;
 		return NULL;
 	}
@@ -166,6 +231,8 @@ int threadpool_destroy(threadpool_t *pool) {
 	pool->exiting = true;
 
 	BCAST(&(pool->cond), r);
+	if (r == 0)
+		BCAST(&(pool->park_cond), r);
 	if (r != 0) {
 		UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
 		errno = r;
@@ -214,6 +281,7 @@ int threadpool_add(threadpool_t *pool, void (*f)(void *, int), void *arg) {
 	task_node->fun = f;
 	task_node->arg = arg;
 	task_node->next = NULL;
+	clock_gettime(CLOCK_MONOTONIC, &task_node->enqueue_time);
 	if (!pool->lhead) {
 		pool->lhead = task_node;
 		pool->ltail = task_node;
@@ -234,4 +302,145 @@ int threadpool_add(threadpool_t *pool, void (*f)(void *, int), void *arg) {
 
 	UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
 	return 0;
-}
\ No newline at end of file
+}
+
+int threadpool_resize(threadpool_t *pool, size_t numthreads, size_t pending_size) {
+	if (!pool || numthreads == 0 || pending_size == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	int r, errnosv;
+	LOCK_DO(&(pool->lock), r, errno = r; return -1);
+
+	if (pool->exiting) {
+		UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+		errno = EINVAL;
+		return -1;
+	}
+
+	// i task già in coda oltre la nuova dimensione vengono comunque eseguiti
+	pool->queue_size = pending_size;
+
+	// creo i thread mancanti (i thread già creati e disattivati vengono riattivati)
+	if (numthreads > pool->numthreads) {
+		pthread_t* threads = realloc(pool->threads, sizeof(pthread_t)*numthreads);
+		if (!threads) {
+			errnosv = errno;
+			UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+			errno = errnosv;
+			return -1;
+		}
+		pool->threads = threads;
+		for (size_t i = pool->numthreads; i < numthreads; i++) {
+			worker_args_t* worker_args = malloc(sizeof(worker_args_t));
+			if (!worker_args) {
+				errnosv = errno;
+				UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+				errno = errnosv;
+				return -1;
+			}
+			worker_args->id = i+1;
+			worker_args->pool = pool;
+			r = pthread_create(&(pool->threads[i]), NULL, workerpool_thread, (void*)worker_args);
+			if (r != 0) {
+				free(worker_args);
+				errnosv = r;
+				UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+				errno = errnosv;
+				return -1;
+			}
+			pool->numthreads++;
+		}
+	}
+	pool->activethreads = numthreads;
+
+	// risveglio i thread affinché quelli disattivati si sospendano e quelli riattivati riprendano a servire i task
+	BCAST(&(pool->cond), r);
+	if (r == 0)
+		BCAST(&(pool->park_cond), r);
+	if (r != 0) {
+		errnosv = r;
+		UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+		errno = errnosv;
+		return -1;
+	}
+
+	UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+	return 0;
+}
+
+int threadpool_get_stats(threadpool_t *pool, threadpool_stats_t *stats) {
+	if (!pool || !stats) {
+		errno = EINVAL;
+		return -1;
+	}
+	int r;
+	LOCK_DO(&(pool->lock), r, errno = r; return -1);
+	stats->activethreads = pool->activethreads;
+	stats->pending = pool->count;
+	stats->completed = pool->completed;
+	stats->wait_usec = pool->wait_usec;
+	stats->busy_usec = pool->busy_usec;
+	UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+	return 0;
+}
+
+int threadpool_pause(threadpool_t *pool, long timeout_msec) {
+	if (!pool || timeout_msec < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	int r, errnosv;
+
+	// calcolo l'istante entro cui i task in esecuzione devono terminare
+	struct timespec abstime;
+	clock_gettime(CLOCK_REALTIME, &abstime);
+	abstime.tv_sec += timeout_msec / 1000;
+	abstime.tv_nsec += (timeout_msec % 1000) * 1000000;
+	if (abstime.tv_nsec >= 1000000000) {
+		abstime.tv_sec ++;
+		abstime.tv_nsec -= 1000000000;
+	}
+
+	LOCK_DO(&(pool->lock), r, errno = r; return -1);
+	if (pool->exiting || pool->paused) {
+		UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+		errno = EINVAL;
+		return -1;
+	}
+	pool->paused = true;
+	r = 0;
+	while (pool->taskonthefly > 0 && r == 0)
+		r = pthread_cond_timedwait(&(pool->idle_cond), &(pool->lock), &abstime);
+	if (pool->taskonthefly > 0) {
+		// i task non sono terminati entro il tempo limite (o l'attesa è fallita), riprendo l'esecuzione dei task
+		errnosv = r != 0 ? r : ETIMEDOUT;
+		pool->paused = false;
+		BCAST(&(pool->cond), r);
+		UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+		errno = errnosv;
+		return -1;
+	}
+	UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+	return 0;
+}
+
+int threadpool_resume(threadpool_t *pool) {
+	if (!pool) {
+		errno = EINVAL;
+		return -1;
+	}
+	int r, errnosv;
+	LOCK_DO(&(pool->lock), r, errno = r; return -1);
+	pool->paused = false;
+	// risveglio i thread affinché riprendano a servire i task accodati durante la sospensione
+	BCAST(&(pool->cond), r);
+	if (r != 0) {
+		errnosv = r;
+		UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+		errno = errnosv;
+		return -1;
+	}
+	UNLOCK_DO(&(pool->lock), r, errno = r; return -1);
+	return 0;
+}
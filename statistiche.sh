@@ -13,6 +13,12 @@ if [ ! -f "$LOGFILE" ];
     exit 1
 fi
 
+# Se è stato compilato utilizzo bin/fsslogstat, che calcola le stesse statistiche con un'unica lettura del log
+FSSLOGSTAT="$(dirname "$0")"/bin/fsslogstat
+if [ -x "$FSSLOGSTAT" ]; then
+    exec "$FSSLOGSTAT" "$LOGFILE"
+fi
+
 echo "========================= OPERAZIONI ========================="
 
 awk -F"," '$3 ~ /OPEN_NO_FLAGS/ {SUM+=1} END {print "Numero di open senza flag: " SUM+0}' $LOGFILE
@@ -27,6 +33,10 @@ awk -F"," '$3 ~ /UNLOCK/ {SUM+=1} END {print "Numero di unlock: " SUM+0}' $LOGFI
 
 awk -F"," '$3 ~ /^CLOSE$/ {SUM+=1} END {print "Numero di close: " SUM+0}' $LOGFILE
 
+awk -F"," '$3 ~ /OPEN_WRITE_CLOSE/ {SUM+=1} END {print "Numero di open-write-close: " SUM+0}' $LOGFILE
+
+awk -F"," '$3 ~ /OPEN_READ_CLOSE/ {SUM+=1} END {print "Numero di open-read-close: " SUM+0}' $LOGFILE
+
 awk -F"," '$3 ~ /READ|READN/ {SUM+=1} END {print "Numero di file letti: " SUM+0}' $LOGFILE
 
 awk -F"," '$3 ~ /WRITE|APPEND/ {SUM+=1} END {print "Numero di file scritti (con write o append): " SUM+0}' $LOGFILE
@@ -55,7 +65,7 @@ awk -F"," '$3 ~ /NEW_CONNECTION/ {SUM+=1} END {print "Numero di clienti serviti
 echo "=========================== THREADS =========================="
 
 awk -F"," 'NR>1 &&
-$3 ~ /OPEN|WRITE|APPEND|LOCK|UNLOCK|REMOVE|^CLOSE$|READN 1\/|^READ$|TEMPORARILY_UNAVAILABLE/ \
+$3 ~ /OPEN|WRITE|APPEND|LOCK|UNLOCK|REMOVE|^CLOSE$|READN 1\/|READN_CURSOR 1\/|^READ$|^READ_RANGE$|^READ_IF_NEWER$|TEMPORARILY_UNAVAILABLE/ \
 {match_found=1; count[$2]++} 
 END {
   if (match_found == 0) 
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+if [ $# -lt 2 ]
+  then
+    echo "usage: $0 base.csv new.csv [soglia%]"
+    exit 1
+fi
+
+BASE=$1
+NEW=$2
+THRESHOLD=${3:-10}
+for f in "$BASE" "$NEW"; do
+  if [ ! -f "$f" ];
+    then
+      echo "Specifica un file regolare esistente"
+      exit 1
+  fi
+done
+
+# confronta i ns/op delle misurazioni presenti in entrambi i file (stesso benchmark, operazione, size e numero di
+# thread) e segnala quelle peggiorate o migliorate di più della soglia; se una misurazione è stata ripetuta (-r)
+# considera il risultato migliore
+awk -F"," -v threshold="$THRESHOLD" '
+  FNR == 1 { next }
+  {
+    key = $2","$3","$4","$5
+    if (NR == FNR) {
+      if (!(key in base) || $7 < base[key]) base[key] = $7
+      next
+    }
+    if (!(key in base)) next
+    if (!(key in new)) order[n++] = key
+    if (!(key in new) || $7 < new[key]) new[key] = $7
+  }
+  END {
+    printf "%-22s %-14s %8s %3s %12s %12s %9s\n", "benchmark", "op", "size", "thr", "base ns/op", "new ns/op", "delta"
+    for (i = 0; i < n; i++) {
+      key = order[i]
+      split(key, f, ",")
+      delta = base[key] > 0 ? (new[key] - base[key]) * 100 / base[key] : 0
+      mark = delta > threshold ? "REGRESSIONE" : (delta < -threshold ? "miglioramento" : "")
+      if (mark != "") changed++
+      if (delta > threshold) regressions++
+      printf "%-22s %-14s %8s %3s %12.1f %12.1f %+8.1f%% %s\n", f[1], f[2], f[3], f[4], base[key], new[key], delta, mark
+    }
+    print "Misurazioni variate oltre il " threshold "%: " changed+0 ", di cui regressioni: " regressions+0
+    exit regressions > 0
+  }
+' "$BASE" "$NEW"
@@ -0,0 +1,114 @@
+#!/bin/bash
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 output.json baseline.json [tolleranza%]"
+    exit 1
+fi
+
+OUTPUT=$1
+BASELINE=$2
+TOLERANCE=${3:-15}
+OUTDIR=test/perf/output
+SOCKET="$OUTDIR"/storage_socket
+
+# Carico di lavoro fisso: 4 thread eseguono 20000 operazioni su 2000 file (il doppio di quelli memorizzabili dallo
+# storage) con popolarità Zipf e seme prefissato, in modo che le esecuzioni siano confrontabili tra loro
+WORKLOAD="-t 4 -c 4 -o 20000 -n 2000 -m read=60,write=25,append=10,readn=5 -s 1024:1,4096:2,8192:1 -Z 0.99 -S 42 -x /perf"
+
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+if ! git diff --quiet HEAD 2>/dev/null; then
+    COMMIT="$COMMIT"-dirty
+fi
+
+# Avvio il server con ciascuna politica di espulsione e misuro il carico di lavoro
+
+RESULTS=""
+for POLICY in FIFO LFU LRU LW; do
+    LOWER=$(echo $POLICY | tr A-Z a-z)
+    rm -f "$SOCKET" "$OUTDIR"/log_"$LOWER".csv
+    echo "======= $POLICY ======="
+    bin/server -c test/perf/config_"$LOWER".txt &>"$OUTDIR"/serverout_"$LOWER".txt &
+    SERVER_PID=$!
+    bin/fssbench -f "$SOCKET" $WORKLOAD &>"$OUTDIR"/fssbench_"$LOWER".txt
+    BENCH_STATUS=$?
+    # il picco di memoria residente va letto prima di terminare il server
+    PEAK_RSS=$(awk '/^VmHWM:/ {print $2}' /proc/"$SERVER_PID"/status 2>/dev/null)
+    kill -HUP $SERVER_PID
+    wait $SERVER_PID 2>/dev/null
+    if [ $BENCH_STATUS -ne 0 ]; then
+        echo "fssbench è terminato con errore, vedi $OUTDIR/fssbench_$LOWER.txt"
+        exit 1
+    fi
+
+    read THROUGHPUT P99 ERRORS <<<$(awk '$1 == "total" {print $4, $8, $3}' "$OUTDIR"/fssbench_"$LOWER".txt)
+    EVICTIONS=$(awk -F"," '$3 == "EVICTION" {SUM+=1} END {print SUM+0}' "$OUTDIR"/log_"$LOWER".csv)
+    echo "throughput $THROUGHPUT op/s, p99 $P99 us, errori $ERRORS, espulsioni $EVICTIONS, picco RSS ${PEAK_RSS:-0} kB"
+
+    if [ -n "$RESULTS" ]; then
+        RESULTS="$RESULTS,"$'\n'
+    fi
+    RESULTS="$RESULTS    \"$POLICY\": {\"throughput\": $THROUGHPUT, \"p99_us\": $P99, \"errors\": $ERRORS, \
+\"evictions\": $EVICTIONS, \"peak_rss_kb\": ${PEAK_RSS:-0}}"
+done
+
+# Salvo i risultati in formato JSON, un oggetto per politica su una sola riga
+
+cat >"$OUTPUT" <<EOF
+{
+  "commit": "$COMMIT",
+  "date": "$(date -u +%Y-%m-%dT%H:%M:%SZ)",
+  "workload": "$WORKLOAD",
+  "policies": {
+$RESULTS
+  }
+}
+EOF
+echo "Risultati salvati in $OUTPUT"
+
+if [ ! -f "$BASELINE" ]; then
+    echo "Nessuna baseline in $BASELINE (make perf_baseline per salvare i risultati correnti come baseline)"
+    exit 0
+fi
+
+# Confronto con la baseline: è una regressione un calo del throughput o un aumento della latenza p99, delle
+# espulsioni o del picco di memoria oltre la tolleranza
+
+echo "======= Confronto con la baseline $(awk -F'"' '/"commit"/ {print $4}' "$BASELINE") (tolleranza $TOLERANCE%) ======="
+awk -v tolerance="$TOLERANCE" '
+  function parse(line, values,    policy, n, fields, i, kv) {
+    policy = line
+    sub(/^ *"/, "", policy)
+    sub(/".*/, "", policy)
+    sub(/^[^{]*\{/, "", line)
+    sub(/\}.*/, "", line)
+    n = split(line, fields, ",")
+    for (i = 1; i <= n; i++) {
+      split(fields[i], kv, ":")
+      gsub(/[ "]/, "", kv[1])
+      values[policy "," kv[1]] = kv[2] + 0
+    }
+    return policy
+  }
+  /^ *"(FIFO|LRU|LFU|LW)": \{/ {
+    if (NR == FNR) parse($0, base)
+    else order[n++] = parse($0, new)
+  }
+  END {
+    split("throughput p99_us evictions peak_rss_kb", metrics, " ")
+    printf "%-6s %-12s %12s %12s %9s\n", "policy", "metric", "baseline", "corrente", "delta"
+    for (i = 0; i < n; i++) {
+      for (m = 1; m <= 4; m++) {
+        key = order[i] "," metrics[m]
+        if (!(key in base)) continue
+        delta = base[key] > 0 ? (new[key] - base[key]) * 100 / base[key] : 0
+        # per il throughput il peggioramento è un calo, per le altre metriche un aumento
+        worse = metrics[m] == "throughput" ? -delta : delta
+        mark = worse > tolerance ? "REGRESSIONE" : ""
+        if (mark != "") regressions++
+        printf "%-6s %-12s %12.1f %12.1f %+8.1f%% %s\n", order[i], metrics[m], base[key], new[key], delta, mark
+      }
+    }
+    print "Regressioni: " regressions+0
+    exit regressions > 0
+  }
+' "$BASELINE" "$OUTPUT"